@@ -808,6 +808,18 @@ AC_DEFUN([CS_ENABLE_CONFERENCE], [
 	AC_MSG_RESULT([--enable-conference: ${ac_cv_use_conference}])
 ])
 
+AC_DEFUN([CS_ENABLE_STANDALONE], [
+	AC_ARG_ENABLE(standalone, 
+		[AC_HELP_STRING([--enable-standalone], [build the standalone hosts against the null pbx backend (>ast 13)])], 
+		[ac_cv_use_standalone=$enableval], 
+		[ac_cv_use_standalone=no]
+	)
+	AS_IF([test "_${ac_cv_use_standalone}" == "_yes" && test "_${ac_cv_use_conference}" == "_yes"], [AC_MSG_ERROR([--enable-standalone cannot be combined with --enable-conference])])
+	AM_CONDITIONAL([BUILD_STANDALONE], [test "_${ac_cv_use_standalone}" == "_yes"])
+	AM_COND_IF([BUILD_STANDALONE],[AC_CONFIG_FILES([src/pbx_impl/null/Makefile src/standalone/Makefile])])
+	AC_MSG_RESULT([--enable-standalone: ${ac_cv_use_standalone}])
+])
+
 AC_DEFUN([CS_DISABLE_MANAGER], [
 	AC_ARG_ENABLE(manager, 
 		[AC_HELP_STRING([--disable-manager], [disabled ast manager events])], 
@@ -1011,6 +1023,7 @@ AC_DEFUN([CS_PARSE_WITH_AND_ENABLE], [
 	CS_DISABLE_DIRTRFR
 	CS_DISABLE_MONITOR
 	CS_ENABLE_CONFERENCE
+	CS_ENABLE_STANDALONE
 	CS_DISABLE_MANAGER
 	CS_DISABLE_FUNCTIONS
 	CS_DISABLE_REALTIME
@@ -0,0 +1,1020 @@
+/*!
+ * \file        sccp_loadgen.c
+ * \brief       Simulated Skinny Phone Fleet / Load Generator
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * Opens one tcp session per simulated phone against a running chan-sccp listener and drives it through one of the scenarios below,
+ * reporting latency percentiles per protocol step. Only the message layouts from sccp_protocol.h are used, nothing is linked from the
+ * channel driver, so the tool runs next to (not inside) the asterisk process under test.
+ *
+ * Scenarios:
+ *  - register   : registration storm, every phone registers once (rate limited by -r), ends when all phones are done
+ *  - keepalive  : phones register and keep their sessions alive for -d seconds
+ *  - calls      : phones are paired, the even phone calls the odd one (extension = -x + index of the callee), which answers after -a ms,
+ *                 the caller hangs up after -l ms and calls again after -P ms
+ *  - blf        : phones go offhook / onhook in a loop, feature status updates received for the monitored lines are counted
+ *
+ * The devices SEP<mac> (-m, incremented per phone) have to be present in sccp.conf, with the extensions used by the call scenario
+ * routed to the line of the paired phone.
+ */
+
+#include "config.h"
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include "define.h"
+#include "forward_declarations.h"
+#include "sccp_protocol.h"
+#include "sccp_labels.h"
+
+#define LOADGEN_SUBBUCKETS 4											/*!< Histogram resolution per power of two (same scheme as "sccp show message stats") */
+#define LOADGEN_BUCKETS (LOADGEN_SUBBUCKETS + 40 * LOADGEN_SUBBUCKETS)
+#define LOADGEN_WBUF_SIZE 16384
+#define LOADGEN_POLL_MS 10
+
+/*!
+ * \brief Load Generator Scenario
+ */
+typedef enum {
+	LOADGEN_SCENARIO_REGISTER,
+	LOADGEN_SCENARIO_KEEPALIVE,
+	LOADGEN_SCENARIO_CALLS,
+	LOADGEN_SCENARIO_BLF,
+	LOADGEN_SCENARIO_SENTINEL,
+} loadgen_scenario_t;
+
+static const char *const loadgen_scenario_names[LOADGEN_SCENARIO_SENTINEL] = { "register", "keepalive", "calls", "blf" };
+
+/*!
+ * \brief Measured Protocol Steps
+ */
+typedef enum {
+	LOADGEN_STEP_CONNECT,											/*!< connect() -> socket writable */
+	LOADGEN_STEP_REGISTER_ACK,										/*!< RegisterMessage -> RegisterAckMessage */
+	LOADGEN_STEP_REGISTERED,										/*!< RegisterMessage -> DefineTimeDate (registration finished) */
+	LOADGEN_STEP_KEEPALIVE,											/*!< KeepAliveMessage -> KeepAliveAckMessage */
+	LOADGEN_STEP_OFFHOOK,											/*!< OffHookMessage -> CallState OFFHOOK */
+	LOADGEN_STEP_RINGOUT,											/*!< last digit -> CallState RINGOUT / PROCEED on the caller */
+	LOADGEN_STEP_RINGIN,											/*!< last digit -> CallState RINGIN on the callee */
+	LOADGEN_STEP_ANSWER,											/*!< SoftKeyEvent Answer -> CallState CONNECTED on the callee */
+	LOADGEN_STEP_ONHOOK,											/*!< OnHookMessage -> CallState ONHOOK */
+	LOADGEN_STEP_SENTINEL,
+} loadgen_step_t;
+
+static const char *const loadgen_step_names[LOADGEN_STEP_SENTINEL] = { "connect", "register-ack", "registered", "keepalive", "offhook", "dial-ringout", "dial-ringin", "answer-connected", "onhook" };
+
+typedef enum {
+	PHONE_IDLE,
+	PHONE_CONNECTING,
+	PHONE_REGISTERING,
+	PHONE_REGISTERED,
+	PHONE_DONE,
+	PHONE_FAILED,
+} phone_regstate_t;
+
+typedef enum {
+	CALL_NONE,
+	CALL_OFFHOOK,
+	CALL_DIALING,
+	CALL_CONNECTED,
+	CALL_RINGIN,
+	CALL_ANSWERING,
+	CALL_HANGUP,
+} phone_callstate_t;
+
+/*!
+ * \brief Latency Histogram (microseconds)
+ */
+typedef struct loadgen_hist {
+	uint64_t count;
+	uint64_t timeouts;
+	uint64_t sumUs;
+	uint64_t maxUs;
+	uint64_t buckets[LOADGEN_BUCKETS];
+} loadgen_hist_t;
+
+/*!
+ * \brief Simulated Phone
+ */
+typedef struct loadgen_phone {
+	int index;												/*!< Fleet wide index */
+	int fd;
+	char deviceName[StationMaxDeviceNameSize];
+	phone_regstate_t regState;
+	phone_callstate_t callState;
+	struct loadgen_phone *peer;										/*!< Call partner (calls scenario) */
+	boolean_t caller;											/*!< Places the calls (calls scenario) */
+	boolean_t templateDone;
+	uint32_t lineInstance;											/*!< First line on the button template */
+	uint32_t numLines;
+	uint32_t callReference;
+	uint64_t keepaliveUs;
+	uint64_t nextKeepaliveUs;
+	uint64_t nextActionUs;
+	uint64_t pending[LOADGEN_STEP_SENTINEL];								/*!< Start of the outstanding step (0 = none) */
+	size_t rlen;
+	size_t wlen;
+	union {
+		sccp_msg_t msg;											/*!< keeps the frame at offset 0 aligned */
+		unsigned char raw[SCCP_MAX_PACKET * 2];
+	} rbuf;
+	unsigned char wbuf[LOADGEN_WBUF_SIZE];
+} loadgen_phone_t;
+
+/*!
+ * \brief Worker Thread, owns a slice of the fleet and its own statistics
+ */
+typedef struct loadgen_worker {
+	pthread_t thread;
+	loadgen_phone_t *phones;
+	int numPhones;
+	int started;
+	struct pollfd *pfds;
+	loadgen_phone_t **pfdPhones;
+	uint64_t messagesIn;
+	uint64_t messagesOut;
+	uint64_t registered;
+	uint64_t failures;
+	uint64_t rejects;
+	uint64_t resets;
+	uint64_t blfUpdates;
+	uint64_t calls;
+	loadgen_hist_t hist[LOADGEN_STEP_SENTINEL];
+} loadgen_worker_t;
+
+/*!
+ * \brief Load Generator Options
+ */
+static struct {
+	const char *host;
+	const char *port;
+	int numPhones;
+	int numThreads;
+	unsigned long long macBase;
+	uint8_t protocolVersion;
+	uint32_t deviceType;
+	loadgen_scenario_t scenario;
+	int durationSec;
+	int connectRate;											/*!< new connections per second (0 = unlimited) */
+	int keepaliveSec;											/*!< 0 = as announced by the RegisterAck */
+	unsigned long extensionBase;
+	int answerMs;
+	int holdMs;
+	int pauseMs;
+	int timeoutMs;
+	boolean_t csv;
+	struct sockaddr_storage addr;
+	socklen_t addrlen;
+} loadgen = {
+	.host = "127.0.0.1",
+	.port = "2000",
+	.numPhones = 100,
+	.numThreads = 1,
+	.macBase = 0x0000DEAD0000ULL,
+	.protocolVersion = 17,
+	.deviceType = SKINNY_DEVICETYPE_CISCO7962,
+	.scenario = LOADGEN_SCENARIO_REGISTER,
+	.durationSec = 60,
+	.extensionBase = 1000,
+	.answerMs = 500,
+	.holdMs = 2000,
+	.pauseMs = 1000,
+	.timeoutMs = 5000,
+};
+
+static volatile sig_atomic_t loadgen_stop = 0;
+static uint64_t loadgen_startUs;
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* histogram */
+static int hist_bucket(uint64_t us)
+{
+	int msb;
+
+	if (us < LOADGEN_SUBBUCKETS) {
+		return (int) us;
+	}
+	msb = 63 - __builtin_clzll(us);
+	if (msb > 41) {
+		return LOADGEN_BUCKETS - 1;
+	}
+	return LOADGEN_SUBBUCKETS + (msb - 2) * LOADGEN_SUBBUCKETS + (int) ((us >> (msb - 2)) & (LOADGEN_SUBBUCKETS - 1));
+}
+
+static uint64_t hist_bucketLimit(int bucket)
+{
+	int msb;
+
+	if (bucket < LOADGEN_SUBBUCKETS) {
+		return bucket;
+	}
+	bucket++;
+	msb = (bucket - LOADGEN_SUBBUCKETS) / LOADGEN_SUBBUCKETS + 2;
+	return ((uint64_t) (LOADGEN_SUBBUCKETS + (bucket - LOADGEN_SUBBUCKETS) % LOADGEN_SUBBUCKETS) << (msb - 2)) - 1;
+}
+
+static void hist_add(loadgen_hist_t *hist, uint64_t us)
+{
+	hist->count++;
+	hist->sumUs += us;
+	if (us > hist->maxUs) {
+		hist->maxUs = us;
+	}
+	hist->buckets[hist_bucket(us)]++;
+}
+
+static void hist_merge(loadgen_hist_t *dst, const loadgen_hist_t *src)
+{
+	int b;
+
+	dst->count += src->count;
+	dst->timeouts += src->timeouts;
+	dst->sumUs += src->sumUs;
+	if (src->maxUs > dst->maxUs) {
+		dst->maxUs = src->maxUs;
+	}
+	for (b = 0; b < LOADGEN_BUCKETS; b++) {
+		dst->buckets[b] += src->buckets[b];
+	}
+}
+
+static uint64_t hist_percentile(const loadgen_hist_t *hist, double pct)
+{
+	uint64_t rank = (uint64_t) (hist->count * pct / 100.0 + 0.5);
+	uint64_t seen = 0;
+	uint64_t limit;
+	int b;
+
+	if (!hist->count) {
+		return 0;
+	}
+	if (rank < 1) {
+		rank = 1;
+	}
+	for (b = 0; b < LOADGEN_BUCKETS; b++) {
+		seen += hist->buckets[b];
+		if (seen >= rank) {
+			limit = hist_bucketLimit(b);
+			return limit < hist->maxUs ? limit : hist->maxUs;
+		}
+	}
+	return hist->maxUs;
+}
+
+/* steps */
+static void step_start(loadgen_phone_t *p, loadgen_step_t step, uint64_t now)
+{
+	p->pending[step] = now ? now : 1;
+}
+
+static void step_done(loadgen_worker_t *w, loadgen_phone_t *p, loadgen_step_t step, uint64_t now)
+{
+	if (p->pending[step]) {
+		hist_add(&w->hist[step], now - p->pending[step]);
+		p->pending[step] = 0;
+	}
+}
+
+/* io */
+static void phone_close(loadgen_worker_t *w, loadgen_phone_t *p, phone_regstate_t regState)
+{
+	if (p->fd >= 0) {
+		close(p->fd);
+		p->fd = -1;
+	}
+	if (regState == PHONE_FAILED) {
+		w->failures++;
+	}
+	p->regState = regState;
+	p->callState = CALL_NONE;
+	p->rlen = p->wlen = 0;
+	memset(p->pending, 0, sizeof(p->pending));
+}
+
+static void phone_flush(loadgen_worker_t *w, loadgen_phone_t *p)
+{
+	ssize_t res;
+
+	while (p->wlen > 0) {
+		res = send(p->fd, p->wbuf, p->wlen, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (res < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+				return;
+			}
+			phone_close(w, p, PHONE_FAILED);
+			return;
+		}
+		memmove(p->wbuf, p->wbuf + res, p->wlen - res);
+		p->wlen -= res;
+	}
+}
+
+static void phone_send(loadgen_worker_t *w, loadgen_phone_t *p, sccp_mid_t mid, const void *data, size_t len)
+{
+	sccp_header_t hdr = {
+		.length = htolel(len + 4),
+		.lel_protocolVer = 0,
+		.lel_messageId = htolel(mid),
+	};
+
+	if (p->fd < 0) {
+		return;
+	}
+	if (p->wlen + sizeof(hdr) + len > sizeof(p->wbuf)) {
+		fprintf(stderr, "%s: send buffer overflow, server is not reading\n", p->deviceName);
+		phone_close(w, p, PHONE_FAILED);
+		return;
+	}
+	memcpy(p->wbuf + p->wlen, &hdr, sizeof(hdr));
+	if (len) {
+		memcpy(p->wbuf + p->wlen + sizeof(hdr), data, len);
+	}
+	p->wlen += sizeof(hdr) + len;
+	w->messagesOut++;
+	phone_flush(w, p);
+}
+
+static void phone_connect(loadgen_worker_t *w, loadgen_phone_t *p, uint64_t now)
+{
+	int on = 1;
+
+	if ((p->fd = socket(loadgen.addr.ss_family, SOCK_STREAM, 0)) < 0) {
+		fprintf(stderr, "%s: socket: %s\n", p->deviceName, strerror(errno));
+		phone_close(w, p, PHONE_FAILED);
+		return;
+	}
+	setsockopt(p->fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+	fcntl(p->fd, F_SETFL, fcntl(p->fd, F_GETFL) | O_NONBLOCK);
+	step_start(p, LOADGEN_STEP_CONNECT, now);
+	p->regState = PHONE_CONNECTING;
+	if (connect(p->fd, (struct sockaddr *) &loadgen.addr, loadgen.addrlen) < 0 && errno != EINPROGRESS) {
+		fprintf(stderr, "%s: connect: %s\n", p->deviceName, strerror(errno));
+		phone_close(w, p, PHONE_FAILED);
+	}
+}
+
+/* outbound messages */
+static void phone_register(loadgen_worker_t *w, loadgen_phone_t *p, uint64_t now)
+{
+	struct sockaddr_in local;
+	socklen_t locallen = sizeof(local);
+	sccp_data_t data;
+
+	memset(&data, 0, sizeof(data));
+	snprintf(data.RegisterMessage.sId.deviceName, sizeof(data.RegisterMessage.sId.deviceName), "%s", p->deviceName);
+	data.RegisterMessage.sId.lel_userid = 0;
+	data.RegisterMessage.sId.lel_instance = htolel(1);
+	if (getsockname(p->fd, (struct sockaddr *) &local, &locallen) == 0 && local.sin_family == AF_INET) {
+		memcpy(&data.RegisterMessage.stationIpAddr, &local.sin_addr, sizeof(data.RegisterMessage.stationIpAddr));
+	}
+	data.RegisterMessage.lel_deviceType = htolel(loadgen.deviceType);
+	data.RegisterMessage.lel_maxStreams = htolel(5);
+	data.RegisterMessage.phone_features = htolel(loadgen.protocolVersion | (loadgen.protocolVersion >= 17 ? (SKINNY_PHONE_FEATURES_DYNAMIC_MESSAGES) : 0));
+	data.RegisterMessage.lel_maxConferences = htolel(1);
+	memcpy(data.RegisterMessage.macAddress, p->deviceName + 3, sizeof(data.RegisterMessage.macAddress));
+	snprintf(data.RegisterMessage.loadInfo, sizeof(data.RegisterMessage.loadInfo), "sccp_loadgen");
+
+	phone_send(w, p, RegisterMessage, &data.RegisterMessage, sizeof(data.RegisterMessage));
+	p->regState = PHONE_REGISTERING;
+	step_start(p, LOADGEN_STEP_REGISTER_ACK, now);
+	step_start(p, LOADGEN_STEP_REGISTERED, now);
+}
+
+static void phone_offhook(loadgen_worker_t *w, loadgen_phone_t *p, uint64_t now)
+{
+	sccp_data_t data;
+
+	memset(&data, 0, sizeof(data));
+	data.OffHookMessage.lel_lineInstance = htolel(p->lineInstance);
+	phone_send(w, p, OffHookMessage, &data.OffHookMessage, sizeof(data.OffHookMessage));
+	p->callState = CALL_OFFHOOK;
+	step_start(p, LOADGEN_STEP_OFFHOOK, now);
+}
+
+static void phone_onhook(loadgen_worker_t *w, loadgen_phone_t *p, uint64_t now)
+{
+	sccp_data_t data;
+
+	memset(&data, 0, sizeof(data));
+	data.OnHookMessage.lel_buttonIndex = htolel(p->lineInstance);
+	data.OnHookMessage.lel_callReference = htolel(p->callReference);
+	phone_send(w, p, OnHookMessage, &data.OnHookMessage, sizeof(data.OnHookMessage));
+	p->callState = CALL_HANGUP;
+	step_start(p, LOADGEN_STEP_ONHOOK, now);
+}
+
+static void phone_dial(loadgen_worker_t *w, loadgen_phone_t *p, uint64_t now)
+{
+	char number[StationMaxDirnumSize];
+	sccp_data_t data;
+	int i;
+
+	snprintf(number, sizeof(number), "%lu#", loadgen.extensionBase + p->peer->index);
+	memset(&data, 0, sizeof(data));
+	data.KeypadButtonMessage.lel_lineInstance = htolel(p->lineInstance);
+	data.KeypadButtonMessage.lel_callReference = htolel(p->callReference);
+	for (i = 0; number[i]; i++) {
+		data.KeypadButtonMessage.lel_kpButton = htolel(number[i] == '#' ? 15 : number[i] == '*' ? 14 : number[i] - '0');
+		phone_send(w, p, KeypadButtonMessage, &data.KeypadButtonMessage, sizeof(data.KeypadButtonMessage));
+	}
+	p->callState = CALL_DIALING;
+	step_start(p, LOADGEN_STEP_RINGOUT, now);
+	step_start(p->peer, LOADGEN_STEP_RINGIN, now);
+	w->calls++;
+}
+
+static void phone_answer(loadgen_worker_t *w, loadgen_phone_t *p, uint64_t now)
+{
+	sccp_data_t data;
+
+	memset(&data, 0, sizeof(data));
+	data.SoftKeyEventMessage.lel_softKeyEvent = htolel(SKINNY_LBL_ANSWER);
+	data.SoftKeyEventMessage.lel_lineInstance = htolel(p->lineInstance);
+	data.SoftKeyEventMessage.lel_callReference = htolel(p->callReference);
+	phone_send(w, p, SoftKeyEventMessage, &data.SoftKeyEventMessage, sizeof(data.SoftKeyEventMessage));
+	p->callState = CALL_ANSWERING;
+	step_start(p, LOADGEN_STEP_ANSWER, now);
+}
+
+static void phone_unregister(loadgen_worker_t *w, loadgen_phone_t *p)
+{
+	sccp_data_t data;
+
+	if (p->fd >= 0 && p->regState == PHONE_REGISTERED) {
+		memset(&data, 0, sizeof(data));
+		phone_send(w, p, UnregisterMessage, &data.UnregisterMessage, sizeof(data.UnregisterMessage));
+	}
+	if (p->fd >= 0) {
+		phone_close(w, p, PHONE_DONE);
+	}
+}
+
+/* inbound messages */
+static void handle_buttonTemplate(loadgen_worker_t *w, loadgen_phone_t *p, const sccp_msg_t *msg)
+{
+	uint32_t offset = letohl(msg->data.ButtonTemplateMessage.lel_buttonOffset);
+	uint32_t count = letohl(msg->data.ButtonTemplateMessage.lel_buttonCount);
+	uint32_t total = letohl(msg->data.ButtonTemplateMessage.lel_totalButtonCount);
+	sccp_data_t data;
+	uint32_t i;
+
+	if (p->templateDone) {
+		return;
+	}
+	for (i = 0; i < count && i < StationMaxButtonTemplateSize; i++) {
+		if (msg->data.ButtonTemplateMessage.definition[i].buttonDefinition == SKINNY_BUTTONTYPE_LINE) {
+			if (!p->lineInstance) {
+				p->lineInstance = msg->data.ButtonTemplateMessage.definition[i].instanceNumber;
+			}
+			p->numLines++;
+		}
+	}
+	if (offset + count < total) {
+		return;
+	}
+	p->templateDone = TRUE;
+
+	/* same order as a real phone */
+	memset(&data, 0, sizeof(data));
+	phone_send(w, p, SoftKeyTemplateReqMessage, NULL, 0);
+	phone_send(w, p, SoftKeySetReqMessage, NULL, 0);
+	for (i = 1; i <= p->numLines; i++) {
+		data.LineStatReqMessage.lel_lineNumber = htolel(i);
+		phone_send(w, p, LineStatReqMessage, &data.LineStatReqMessage, sizeof(data.LineStatReqMessage));
+	}
+	data.RegisterAvailableLinesMessage.maxAvailLines = htolel(p->numLines);
+	phone_send(w, p, RegisterAvailableLinesMessage, &data.RegisterAvailableLinesMessage, sizeof(data.RegisterAvailableLinesMessage));
+	phone_send(w, p, TimeDateReqMessage, NULL, 0);
+}
+
+static void handle_callState(loadgen_worker_t *w, loadgen_phone_t *p, const sccp_msg_t *msg, uint64_t now)
+{
+	uint32_t callState = letohl(msg->data.CallStateMessage.lel_callState);
+	uint32_t callReference = letohl(msg->data.CallStateMessage.lel_callReference);
+
+	switch (callState) {
+		case SKINNY_CALLSTATE_OFFHOOK:
+			if (p->callState != CALL_OFFHOOK) {
+				break;
+			}
+			step_done(w, p, LOADGEN_STEP_OFFHOOK, now);
+			p->callReference = callReference;
+			if (loadgen.scenario == LOADGEN_SCENARIO_CALLS) {
+				phone_dial(w, p, now);
+			} else {
+				p->callState = CALL_CONNECTED;
+				p->nextActionUs = now + loadgen.holdMs * 1000ULL;
+			}
+			break;
+		case SKINNY_CALLSTATE_RINGOUT:
+		case SKINNY_CALLSTATE_PROCEED:
+			step_done(w, p, LOADGEN_STEP_RINGOUT, now);
+			break;
+		case SKINNY_CALLSTATE_RINGIN:
+			if (p->callState != CALL_NONE) {
+				break;
+			}
+			step_done(w, p, LOADGEN_STEP_RINGIN, now);
+			p->lineInstance = letohl(msg->data.CallStateMessage.lel_lineInstance);
+			p->callReference = callReference;
+			p->callState = CALL_RINGIN;
+			p->nextActionUs = now + loadgen.answerMs * 1000ULL;
+			break;
+		case SKINNY_CALLSTATE_CONNECTED:
+			if (p->callState == CALL_ANSWERING) {
+				step_done(w, p, LOADGEN_STEP_ANSWER, now);
+				p->callState = CALL_CONNECTED;
+				p->nextActionUs = UINT64_MAX;						/* the caller hangs up */
+			} else if (p->callState == CALL_DIALING) {
+				step_done(w, p, LOADGEN_STEP_RINGOUT, now);
+				p->callState = CALL_CONNECTED;
+				p->nextActionUs = now + loadgen.holdMs * 1000ULL;
+			}
+			break;
+		case SKINNY_CALLSTATE_ONHOOK:
+			if (p->callState == CALL_NONE || (callReference && callReference != p->callReference)) {
+				break;
+			}
+			step_done(w, p, LOADGEN_STEP_ONHOOK, now);
+			p->callState = CALL_NONE;
+			p->callReference = 0;
+			p->nextActionUs = now + loadgen.pauseMs * 1000ULL;
+			break;
+	}
+}
+
+static void phone_handle(loadgen_worker_t *w, loadgen_phone_t *p, const sccp_msg_t *msg, uint64_t now)
+{
+	sccp_data_t data;
+
+	w->messagesIn++;
+	switch (letohl(msg->header.lel_messageId)) {
+		case RegisterAckMessage:
+			step_done(w, p, LOADGEN_STEP_REGISTER_ACK, now);
+			if (!loadgen.keepaliveSec) {
+				p->keepaliveUs = letohl(msg->data.RegisterAckMessage.lel_keepAliveInterval) * 1000000ULL;
+			}
+			break;
+		case CapabilitiesReqMessage:
+			memset(&data, 0, sizeof(data));
+			data.CapabilitiesResMessage.lel_count = htolel(1);
+			data.CapabilitiesResMessage.caps[0].lel_payloadCapability = htolel(SKINNY_CODEC_G711_ULAW_64K);
+			data.CapabilitiesResMessage.caps[0].lel_maxFramesPerPacket = htolel(40);
+			phone_send(w, p, CapabilitiesResMessage, &data.CapabilitiesResMessage, sizeof(data.CapabilitiesResMessage));
+			memset(&data, 0, sizeof(data));
+			phone_send(w, p, ButtonTemplateReqMessage, &data.ButtonTemplateReqMessage, sizeof(data.ButtonTemplateReqMessage));
+			break;
+		case ButtonTemplateMessage:
+			handle_buttonTemplate(w, p, msg);
+			break;
+		case DefineTimeDate:
+			if (p->regState != PHONE_REGISTERING) {
+				break;
+			}
+			step_done(w, p, LOADGEN_STEP_REGISTERED, now);
+			w->registered++;
+			p->regState = PHONE_REGISTERED;
+			if (loadgen.scenario == LOADGEN_SCENARIO_REGISTER) {
+				phone_unregister(w, p);
+				break;
+			}
+			p->nextKeepaliveUs = now + (p->keepaliveUs ? p->keepaliveUs : 30000000ULL);
+			p->nextActionUs = now + (loadgen.pauseMs ? (uint64_t) (rand() % loadgen.pauseMs) * 1000ULL : 0);
+			if (loadgen.scenario == LOADGEN_SCENARIO_CALLS && !p->caller) {
+				p->nextActionUs = UINT64_MAX;
+			}
+			break;
+		case KeepAliveAckMessage:
+			step_done(w, p, LOADGEN_STEP_KEEPALIVE, now);
+			break;
+		case CallStateMessage:
+			handle_callState(w, p, msg, now);
+			break;
+		case FeatureStatMessage:
+		case FeatureStatDynamicMessage:
+		case SpeedDialStatDynamicMessage:
+			w->blfUpdates++;
+			break;
+		case RegisterRejectMessage:
+			w->rejects++;
+			phone_close(w, p, PHONE_FAILED);
+			break;
+		case Reset:
+			w->resets++;
+			phone_close(w, p, PHONE_FAILED);
+			break;
+	}
+}
+
+static void phone_read(loadgen_worker_t *w, loadgen_phone_t *p, uint64_t now)
+{
+	ssize_t res;
+	size_t frameLen;
+
+	res = recv(p->fd, p->rbuf.raw + p->rlen, sizeof(p->rbuf.raw) - p->rlen, MSG_DONTWAIT);
+	if (res <= 0) {
+		if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+			return;
+		}
+		fprintf(stderr, "%s: connection closed by server\n", p->deviceName);
+		phone_close(w, p, PHONE_FAILED);
+		return;
+	}
+	p->rlen += res;
+	while (p->fd >= 0 && p->rlen >= SCCP_PACKET_HEADER) {
+		frameLen = letohl(p->rbuf.msg.header.length) + 8;
+		if (frameLen > SCCP_MAX_PACKET) {
+			fprintf(stderr, "%s: oversized frame (%zu bytes)\n", p->deviceName, frameLen);
+			phone_close(w, p, PHONE_FAILED);
+			return;
+		}
+		if (p->rlen < frameLen) {
+			break;
+		}
+		phone_handle(w, p, &p->rbuf.msg, now);
+		if (p->fd < 0) {
+			return;
+		}
+		p->rlen -= frameLen;
+		memmove(p->rbuf.raw, p->rbuf.raw + frameLen, p->rlen);
+	}
+}
+
+/* timers */
+static void phone_timers(loadgen_worker_t *w, loadgen_phone_t *p, uint64_t now)
+{
+	uint64_t timeoutUs = loadgen.timeoutMs * 1000ULL;
+	boolean_t callTimedOut = FALSE;
+	int step;
+
+	for (step = 0; step < LOADGEN_STEP_SENTINEL; step++) {
+		if (p->pending[step] && now - p->pending[step] > timeoutUs) {
+			w->hist[step].timeouts++;
+			p->pending[step] = 0;
+			if (step <= LOADGEN_STEP_REGISTERED) {
+				fprintf(stderr, "%s: timeout waiting for %s\n", p->deviceName, loadgen_step_names[step]);
+				phone_close(w, p, PHONE_FAILED);
+				return;
+			}
+			if (step != LOADGEN_STEP_KEEPALIVE) {
+				callTimedOut = TRUE;
+			}
+		}
+	}
+	if (p->regState != PHONE_REGISTERED) {
+		return;
+	}
+	if (callTimedOut) {
+		/* give up on this call, hang up whatever is left of it */
+		if (p->callState != CALL_NONE && p->callState != CALL_RINGIN) {
+			phone_onhook(w, p, now);
+			p->pending[LOADGEN_STEP_ONHOOK] = 0;
+		}
+		p->callState = CALL_NONE;
+		p->nextActionUs = (p->caller || loadgen.scenario == LOADGEN_SCENARIO_BLF) ? now + loadgen.pauseMs * 1000ULL : UINT64_MAX;
+	}
+	if (now >= p->nextKeepaliveUs) {
+		phone_send(w, p, KeepAliveMessage, NULL, 0);
+		step_start(p, LOADGEN_STEP_KEEPALIVE, now);
+		p->nextKeepaliveUs = now + (p->keepaliveUs ? p->keepaliveUs : 30000000ULL);
+	}
+	if (now < p->nextActionUs || !p->lineInstance) {
+		return;
+	}
+	switch (loadgen.scenario) {
+		case LOADGEN_SCENARIO_CALLS:
+			if (p->caller && p->callState == CALL_NONE && p->peer->regState == PHONE_REGISTERED && p->peer->callState == CALL_NONE) {
+				phone_offhook(w, p, now);
+			} else if (p->callState == CALL_RINGIN) {
+				phone_answer(w, p, now);
+			} else if (p->caller && p->callState == CALL_CONNECTED) {
+				phone_onhook(w, p, now);
+			}
+			break;
+		case LOADGEN_SCENARIO_BLF:
+			if (p->callState == CALL_NONE) {
+				phone_offhook(w, p, now);
+			} else if (p->callState == CALL_CONNECTED) {
+				phone_onhook(w, p, now);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+/* worker */
+static void *loadgen_worker(void *arg)
+{
+	loadgen_worker_t *w = arg;
+	uint64_t endUs = loadgen_startUs + loadgen.durationSec * 1000000ULL;
+	uint64_t now, allowed;
+	loadgen_phone_t *p;
+	int i, n, res, active;
+
+	while (!loadgen_stop) {
+		now = now_us();
+		if (loadgen.scenario != LOADGEN_SCENARIO_REGISTER && now >= endUs) {
+			break;
+		}
+
+		/* start new connections, the connect rate is shared by all workers */
+		allowed = w->numPhones;
+		if (loadgen.connectRate > 0) {
+			allowed = (now - loadgen_startUs) * loadgen.connectRate / 1000000ULL / loadgen.numThreads + 1;
+		}
+		while (w->started < w->numPhones && (uint64_t) w->started < allowed) {
+			phone_connect(w, &w->phones[w->started++], now);
+		}
+
+		n = 0;
+		active = 0;
+		for (i = 0; i < w->numPhones; i++) {
+			p = &w->phones[i];
+			if (p->regState == PHONE_IDLE) {
+				active++;
+				continue;
+			}
+			phone_timers(w, p, now);
+			if (p->fd < 0) {
+				continue;
+			}
+			active++;
+			w->pfds[n].fd = p->fd;
+			w->pfds[n].events = POLLIN | ((p->wlen || p->regState == PHONE_CONNECTING) ? POLLOUT : 0);
+			w->pfds[n].revents = 0;
+			w->pfdPhones[n++] = p;
+		}
+		if (!active) {
+			break;											/* register scenario done, or every phone failed */
+		}
+
+		res = poll(w->pfds, n, LOADGEN_POLL_MS);
+		if (res <= 0) {
+			continue;
+		}
+		now = now_us();
+		for (i = 0; i < n; i++) {
+			p = w->pfdPhones[i];
+			if (!w->pfds[i].revents || p->fd < 0) {
+				continue;
+			}
+			if (p->regState == PHONE_CONNECTING) {
+				int err = 0;
+				socklen_t errlen = sizeof(err);
+
+				if (getsockopt(p->fd, SOL_SOCKET, SO_ERROR, &err, &errlen) < 0 || err) {
+					fprintf(stderr, "%s: connect: %s\n", p->deviceName, strerror(err ? err : errno));
+					phone_close(w, p, PHONE_FAILED);
+					continue;
+				}
+				step_done(w, p, LOADGEN_STEP_CONNECT, now);
+				phone_register(w, p, now);
+				continue;
+			}
+			if (w->pfds[i].revents & POLLOUT) {
+				phone_flush(w, p);
+			}
+			if (p->fd >= 0 && (w->pfds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+				phone_read(w, p, now);
+			}
+		}
+	}
+
+	for (i = 0; i < w->numPhones; i++) {
+		phone_unregister(w, &w->phones[i]);
+	}
+	return NULL;
+}
+
+/* reporting */
+static void loadgen_report(const loadgen_worker_t *workers, uint64_t elapsedUs)
+{
+	loadgen_worker_t total;
+	const loadgen_hist_t *hist;
+	int t, step;
+
+	memset(&total, 0, sizeof(total));
+	for (t = 0; t < loadgen.numThreads; t++) {
+		total.messagesIn += workers[t].messagesIn;
+		total.messagesOut += workers[t].messagesOut;
+		total.registered += workers[t].registered;
+		total.failures += workers[t].failures;
+		total.rejects += workers[t].rejects;
+		total.resets += workers[t].resets;
+		total.blfUpdates += workers[t].blfUpdates;
+		total.calls += workers[t].calls;
+		for (step = 0; step < LOADGEN_STEP_SENTINEL; step++) {
+			hist_merge(&total.hist[step], &workers[t].hist[step]);
+		}
+	}
+
+	if (loadgen.csv) {
+		printf("step,count,timeouts,avg_us,p50_us,p90_us,p99_us,max_us\n");
+	} else {
+		printf("scenario: %s, phones: %d, threads: %d, protocol: %d, elapsed: %.3f s\n", loadgen_scenario_names[loadgen.scenario], loadgen.numPhones, loadgen.numThreads, loadgen.protocolVersion, elapsedUs / 1e6);
+		printf("registered: %llu, failed: %llu (rejected: %llu, reset: %llu), calls: %llu, blf updates: %llu\n", (unsigned long long) total.registered, (unsigned long long) total.failures, (unsigned long long) total.rejects,
+		       (unsigned long long) total.resets, (unsigned long long) total.calls, (unsigned long long) total.blfUpdates);
+		printf("messages in: %llu (%.0f/s), out: %llu (%.0f/s)\n\n", (unsigned long long) total.messagesIn, total.messagesIn * 1e6 / (elapsedUs ? elapsedUs : 1), (unsigned long long) total.messagesOut, total.messagesOut * 1e6 / (elapsedUs ? elapsedUs : 1));
+		printf("%-18s %10s %9s %10s %10s %10s %10s %10s\n", "Step", "Count", "Timeouts", "Avg(us)", "p50(us)", "p90(us)", "p99(us)", "Max(us)");
+	}
+	for (step = 0; step < LOADGEN_STEP_SENTINEL; step++) {
+		hist = &total.hist[step];
+		if (!hist->count && !hist->timeouts) {
+			continue;
+		}
+		printf(loadgen.csv ? "%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n" : "%-18s %10llu %9llu %10llu %10llu %10llu %10llu %10llu\n", loadgen_step_names[step], (unsigned long long) hist->count, (unsigned long long) hist->timeouts,
+		       (unsigned long long) (hist->count ? hist->sumUs / hist->count : 0), (unsigned long long) hist_percentile(hist, 50), (unsigned long long) hist_percentile(hist, 90), (unsigned long long) hist_percentile(hist, 99),
+		       (unsigned long long) hist->maxUs);
+	}
+}
+
+static void loadgen_signal(int sig)
+{
+	loadgen_stop = 1;
+}
+
+static void usage(const char *progname)
+{
+	fprintf(stderr, "Usage: %s [options]\n", progname);
+	fprintf(stderr, "  -H host        chan-sccp listener (default %s)\n", loadgen.host);
+	fprintf(stderr, "  -p port        listener port (default %s)\n", loadgen.port);
+	fprintf(stderr, "  -n phones      number of simulated phones (default %d)\n", loadgen.numPhones);
+	fprintf(stderr, "  -t threads     worker threads (default %d)\n", loadgen.numThreads);
+	fprintf(stderr, "  -m mac         first mac address, device names are SEP<mac + index> (default %012llX)\n", loadgen.macBase);
+	fprintf(stderr, "  -V version     skinny protocol version to register with (default %d)\n", loadgen.protocolVersion);
+	fprintf(stderr, "  -T devicetype  skinny device type (default %u)\n", loadgen.deviceType);
+	fprintf(stderr, "  -s scenario    register | keepalive | calls | blf (default %s)\n", loadgen_scenario_names[loadgen.scenario]);
+	fprintf(stderr, "  -d seconds     duration of the keepalive, calls and blf scenarios (default %d)\n", loadgen.durationSec);
+	fprintf(stderr, "  -r rate        new connections per second (default unlimited)\n");
+	fprintf(stderr, "  -k seconds     keepalive interval (default: as announced by the server)\n");
+	fprintf(stderr, "  -x extension   extension of phone 0, the caller dials extension + index of the callee (default %lu)\n", loadgen.extensionBase);
+	fprintf(stderr, "  -a ms          answer delay (default %d)\n", loadgen.answerMs);
+	fprintf(stderr, "  -l ms          call / offhook hold time (default %d)\n", loadgen.holdMs);
+	fprintf(stderr, "  -P ms          pause between calls / offhooks (default %d)\n", loadgen.pauseMs);
+	fprintf(stderr, "  -w ms          step timeout (default %d)\n", loadgen.timeoutMs);
+	fprintf(stderr, "  -c             csv output\n");
+}
+
+int main(int argc, char *argv[])
+{
+	struct addrinfo hints = { .ai_socktype = SOCK_STREAM }, *ai = NULL;
+	loadgen_worker_t *workers;
+	loadgen_phone_t *phones;
+	int opt, i, t, res, perThread;
+
+	while ((opt = getopt(argc, argv, "H:p:n:t:m:V:T:s:d:r:k:x:a:l:P:w:ch")) != -1) {
+		switch (opt) {
+			case 'H':
+				loadgen.host = optarg;
+				break;
+			case 'p':
+				loadgen.port = optarg;
+				break;
+			case 'n':
+				loadgen.numPhones = (int) strtol(optarg, NULL, 10);
+				break;
+			case 't':
+				loadgen.numThreads = (int) strtol(optarg, NULL, 10);
+				break;
+			case 'm':
+				loadgen.macBase = strtoull(optarg, NULL, 16);
+				break;
+			case 'V':
+				loadgen.protocolVersion = (int) strtol(optarg, NULL, 10);
+				break;
+			case 'T':
+				loadgen.deviceType = (int) strtol(optarg, NULL, 10);
+				break;
+			case 's':
+				for (i = 0; i < LOADGEN_SCENARIO_SENTINEL && strcasecmp(optarg, loadgen_scenario_names[i]); i++);
+				if (i == LOADGEN_SCENARIO_SENTINEL) {
+					usage(argv[0]);
+					return 1;
+				}
+				loadgen.scenario = i;
+				break;
+			case 'd':
+				loadgen.durationSec = (int) strtol(optarg, NULL, 10);
+				break;
+			case 'r':
+				loadgen.connectRate = (int) strtol(optarg, NULL, 10);
+				break;
+			case 'k':
+				loadgen.keepaliveSec = (int) strtol(optarg, NULL, 10);
+				break;
+			case 'x':
+				loadgen.extensionBase = strtoul(optarg, NULL, 10);
+				break;
+			case 'a':
+				loadgen.answerMs = (int) strtol(optarg, NULL, 10);
+				break;
+			case 'l':
+				loadgen.holdMs = (int) strtol(optarg, NULL, 10);
+				break;
+			case 'P':
+				loadgen.pauseMs = (int) strtol(optarg, NULL, 10);
+				break;
+			case 'w':
+				loadgen.timeoutMs = (int) strtol(optarg, NULL, 10);
+				break;
+			case 'c':
+				loadgen.csv = TRUE;
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (loadgen.numPhones < 1 || loadgen.numThreads < 1 || loadgen.numThreads > loadgen.numPhones || loadgen.timeoutMs < 1) {
+		usage(argv[0]);
+		return 1;
+	}
+	if ((res = getaddrinfo(loadgen.host, loadgen.port, &hints, &ai)) != 0) {
+		fprintf(stderr, "%s: %s:%s: %s\n", argv[0], loadgen.host, loadgen.port, gai_strerror(res));
+		return 1;
+	}
+	memcpy(&loadgen.addr, ai->ai_addr, ai->ai_addrlen);
+	loadgen.addrlen = ai->ai_addrlen;
+	freeaddrinfo(ai);
+
+	workers = calloc(loadgen.numThreads, sizeof(*workers));
+	phones = calloc(loadgen.numPhones, sizeof(*phones));
+	if (!workers || !phones) {
+		fprintf(stderr, "%s: out of memory\n", argv[0]);
+		return 1;
+	}
+	for (i = 0; i < loadgen.numPhones; i++) {
+		phones[i].index = i;
+		phones[i].fd = -1;
+		phones[i].keepaliveUs = loadgen.keepaliveSec * 1000000ULL;
+		snprintf(phones[i].deviceName, sizeof(phones[i].deviceName), "SEP%012llX", (loadgen.macBase + i) & 0xFFFFFFFFFFFFULL);
+	}
+
+	/* phones are paired (even calls odd) inside a worker slice, so the slices are kept even sized */
+	perThread = loadgen.numPhones / loadgen.numThreads;
+	perThread += perThread & 1;
+	for (t = 0, i = 0; t < loadgen.numThreads; t++) {
+		workers[t].phones = &phones[i];
+		workers[t].numPhones = (t == loadgen.numThreads - 1 || i + perThread > loadgen.numPhones) ? loadgen.numPhones - i : perThread;
+		i += workers[t].numPhones;
+		workers[t].pfds = calloc(workers[t].numPhones + 1, sizeof(struct pollfd));
+		workers[t].pfdPhones = calloc(workers[t].numPhones + 1, sizeof(loadgen_phone_t *));
+		if (!workers[t].pfds || !workers[t].pfdPhones) {
+			fprintf(stderr, "%s: out of memory\n", argv[0]);
+			return 1;
+		}
+	}
+	for (i = 0; i + 1 < loadgen.numPhones; i += 2) {
+		phones[i].caller = TRUE;
+		phones[i].peer = &phones[i + 1];
+		phones[i + 1].peer = &phones[i];
+	}
+
+	signal(SIGINT, loadgen_signal);
+	signal(SIGTERM, loadgen_signal);
+	signal(SIGPIPE, SIG_IGN);
+
+	loadgen_startUs = now_us();
+	for (t = 0; t < loadgen.numThreads; t++) {
+		if ((res = pthread_create(&workers[t].thread, NULL, loadgen_worker, &workers[t])) != 0) {
+			fprintf(stderr, "%s: pthread_create: %s\n", argv[0], strerror(res));
+			return 1;
+		}
+	}
+	for (t = 0; t < loadgen.numThreads; t++) {
+		pthread_join(workers[t].thread, NULL);
+	}
+	loadgen_report(workers, now_us() - loadgen_startUs);
+
+	for (t = 0; t < loadgen.numThreads; t++) {
+		free(workers[t].pfds);
+		free(workers[t].pfdPhones);
+	}
+	free(phones);
+	free(workers);
+	return 0;
+}
+
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -33,6 +33,9 @@
 #include "sccp_devstate.h"
 #endif
 #include "sccp_management.h"	// use __constructor__ to remove this entry
+#ifdef CS_SCCP_REALTIME
+#include "sccp_realtime.h"
+#endif
 #include <signal.h>
 
 SCCP_FILE_VERSION(__FILE__, "");
@@ -117,6 +120,9 @@ boolean_t sccp_prePBXLoad(void)
 	sccp_devstate_module_start();
 #endif
 	sccp_mwi_module_start();
+#ifdef CS_SCCP_REALTIME
+	sccp_realtime_module_start();
+#endif
 	sccp_hint_module_start();
 	sccp_manager_module_start();
 #ifdef CS_SCCP_CONFERENCE
@@ -191,6 +197,11 @@ boolean_t sccp_postPBX_load(void)
 	GLOB(module_running) = TRUE;
 	pbx_rwlock_unlock(&GLOB(lock));
 
+#ifdef CS_SCCP_REALTIME
+	if (GLOB(realtimepreload)) {
+		sccp_realtime_preload();									/* before the first registration reaches us */
+	}
+#endif
 	return sccp_session_bind_and_listen(&GLOB(bindaddr));
 }
 
@@ -282,6 +293,9 @@ int sccp_preUnload(void)
 #endif
 	sccp_softkey_clear();
 	sccp_hint_module_stop();
+#ifdef CS_SCCP_REALTIME
+	sccp_realtime_module_stop();
+#endif
 	sccp_event_module_stop();
 	sccp_threadpool_destroy(GLOB(general_threadpool));
 	sccp_refcount_destroy();
@@ -337,6 +351,9 @@ int sccp_reload(void)
 			pbx_log(LOG_NOTICE, "SCCP reloading configuration.\n");
 			readingtype = SCCP_CONFIG_READRELOAD;
 			GLOB(reload_in_progress) = TRUE;
+#ifdef CS_SCCP_REALTIME
+			sccp_realtime_cache_flush();								/* realtime rows are reread during reload */
+#endif
 			if (!sccp_config_general(readingtype)) {
 				pbx_log(LOG_ERROR, "Unable to reload configuration.\n");
 				returnval = 3;
@@ -51,6 +51,9 @@ typedef struct sccp_private_channel_data sccp_private_channel_data_t;						/*!<
 typedef struct sccp_private_device_data sccp_private_device_data_t;						/*!< SCCP Private Device Data Structure */
 typedef struct sccp_cfwd_information sccp_cfwd_information_t;							/*!< SCCP CallForward information Structure */
 typedef struct sccp_buttonconfig_list sccp_buttonconfig_list_t;							/*!< SCCP ButtonConfig List Structure */
+typedef struct sccp_buttonindex sccp_buttonindex_t;								/*!< SCCP Button Index Structure */
+typedef struct sccp_buttonindex_service sccp_buttonindex_service_t;						/*!< SCCP Button Index Service Entry */
+typedef struct sccp_regcache sccp_regcache_t;									/*!< SCCP Registration Response Cache Structure */
 
 #ifndef SOLARIS
 #  if defined __STDC__ && defined __STDC_VERSION__ && __STDC_VERSION__ >= 199901L
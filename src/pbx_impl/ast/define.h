@@ -214,6 +214,8 @@ typedef struct ast_event pbx_event_t;
 #define pbx_io_wait ast_io_wait
 #define pbx_jb_read_conf ast_jb_read_conf
 #define pbx_load_realtime ast_load_realtime
+#define pbx_load_realtime_multientry ast_load_realtime_multientry
+#define pbx_check_realtime ast_check_realtime
 #define pbx_log ast_log
 #define pbx_malloc ast_malloc
 #define pbx_manager_register_xml ast_manager_register_xml
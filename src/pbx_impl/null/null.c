@@ -0,0 +1,2103 @@
+/*!
+ * \file        null.c
+ * \brief       SCCP PBX Null Backend
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * Implements iPbx and the pbx_impl/ast helpers the core depends on, without a running asterisk. Used to link the channel driver core
+ * into the standalone hosts (see null.h). The asterisk runtime functions the core calls directly (logging, locks, ao2, config,
+ * cli/manager registration, ...) are provided by null_runtime.c.
+ */
+#include "config.h"
+#include "common.h"
+#include "null.h"
+#include "chan_sccp.h"
+#include "sccp_channel.h"
+#include "sccp_codec.h"
+#include "sccp_device.h"
+#include "sccp_indicate.h"
+#include "sccp_line.h"
+#include "sccp_netsock.h"
+#include "sccp_pbx.h"
+#include "sccp_utils.h"
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#include <asterisk/devicestate.h>
+#include <libgen.h>
+
+#if ASTERISK_VERSION_GROUP < 113
+#error "the null pbx backend requires the asterisk-13 (or later) headers"
+#endif
+#ifdef CS_SCCP_CONFERENCE
+#error "the null pbx backend does not support conferences (configure without --enable-conference)"
+#endif
+
+#define NULL_RTP_PORT_BASE 16384										/*!< First (fake) rtp port handed out */
+#define NULL_RTP_PORT_RANGE 16384										/*!< Number of (fake) rtp ports */
+
+/*!
+ * \brief Null PBX Channel
+ * \note struct ast_channel is opaque in the asterisk headers, the null backend provides its own definition together with the
+ *       accessors the core uses.
+ */
+struct ast_channel {
+	char name[AST_CHANNEL_NAME];										/*!< Channel Name (SCCP/line-callid) */
+	char uniqueid[AST_MAX_UNIQUEID];									/*!< Unique ID */
+	char linkedid[AST_MAX_UNIQUEID];									/*!< Linked ID (uniqueid of the calling side) */
+	char context[AST_MAX_CONTEXT];										/*!< Dialplan Context */
+	char exten[AST_MAX_EXTENSION];										/*!< Dialplan Extension */
+	char macrocontext[AST_MAX_CONTEXT];									/*!< Macro Context */
+	char macroexten[AST_MAX_EXTENSION];									/*!< Macro Extension */
+	char call_forward[AST_MAX_EXTENSION];									/*!< Call Forward Destination */
+	char language[MAX_LANGUAGE];										/*!< Language */
+	char cid_name[SCCP_MAX_EXTENSION];									/*!< Caller Name */
+	char cid_num[SCCP_MAX_EXTENSION];									/*!< Caller Number */
+	char cid_ani[SCCP_MAX_EXTENSION];									/*!< Caller ANI */
+	char dialed[SCCP_MAX_EXTENSION];									/*!< Dialed Number */
+	int presentation;											/*!< Callerid Presentation (sccp_callerid_presentation_t) */
+	enum ast_channel_state state;										/*!< Channel State */
+	int hangupcause;											/*!< Hangup Cause */
+	int softhangup;												/*!< Hangup has been requested */
+	boolean_t hungup;											/*!< Hangup has been executed */
+	struct ast_flags flags;											/*!< AST_FLAG_* */
+	ast_group_t callgroup;											/*!< Call Group */
+	ast_group_t pickupgroup;										/*!< Pickup Group */
+	const struct ast_channel_tech *tech;									/*!< Channel Tech (type is used to recognise sccp channels) */
+	void *tech_pvt;												/*!< SCCP Channel (retained) */
+	struct ast_channel *peer;										/*!< Other leg of the built-in dialplan (referenced) */
+	struct ast_variable *vars;										/*!< Channel Variables */
+	SCCP_LIST_ENTRY (struct ast_channel) list;								/*!< Channel List Entry */
+};
+
+/*!
+ * \brief Null RTP Instance
+ * \note No media is sent, the instance only hands out a local address for the OpenReceiveChannelAck / StartMediaTransmission exchange
+ */
+struct ast_rtp_instance {
+	struct sockaddr_storage us;										/*!< Local Address */
+	struct sockaddr_storage peer;										/*!< Remote Address (phone) */
+};
+
+/*!
+ * \brief Null Scheduler Entry
+ */
+typedef struct sccp_null_sched sccp_null_sched_t;
+struct sccp_null_sched {
+	int id;													/*!< Schedule ID */
+	int interval;												/*!< Interval in milliseconds (reused when the callback returns non-zero) */
+	struct timeval when;											/*!< Time to run the callback */
+	sccp_sched_cb callback;											/*!< Callback */
+	const void *data;											/*!< Callback Data */
+	SCCP_LIST_ENTRY (sccp_null_sched_t) list;								/*!< Schedule List Entry */
+};
+
+/*!
+ * \brief Extension State Subscription (ast_extension_state_add)
+ */
+typedef struct sccp_null_extensionState sccp_null_extensionState_t;
+struct sccp_null_extensionState {
+	int id;													/*!< Subscription ID (0 for state only entries) */
+	char exten[AST_MAX_EXTENSION];										/*!< Extension */
+	char context[AST_MAX_CONTEXT];										/*!< Context */
+	skinny_busylampfield_state_t state;									/*!< Current State */
+	ast_state_cb_type callback;										/*!< Subscriber Callback */
+	void *data;												/*!< Subscriber Data */
+	SCCP_LIST_ENTRY (sccp_null_extensionState_t) list;							/*!< List Entry */
+};
+
+/*!
+ * \brief Database Entry (astdb replacement)
+ */
+typedef struct sccp_null_dbEntry sccp_null_dbEntry_t;
+struct sccp_null_dbEntry {
+	char *family;												/*!< Family */
+	char *key;												/*!< Key */
+	char *value;												/*!< Value */
+	SCCP_LIST_ENTRY (sccp_null_dbEntry_t) list;								/*!< List Entry */
+};
+
+static const struct ast_channel_tech null_tech = {
+	.type = SCCP_TECHTYPE_STR,
+	.description = "Skinny Client Control Protocol (SCCP) - null pbx",
+};
+
+static struct {
+	SCCP_LIST_HEAD (, sccp_null_sched_t) queue;								/*!< Pending Schedules, sorted by 'when' */
+	pbx_cond_t cond;											/*!< Signalled when the queue head changes */
+	pthread_t thread;											/*!< Scheduler Thread */
+	int nextId;												/*!< Next Schedule ID */
+	int runningId;												/*!< ID of the callback currently executing */
+	boolean_t running;											/*!< Scheduler Thread is running */
+} null_sched;
+
+static SCCP_LIST_HEAD (, struct ast_channel) null_channels;						/*!< Allocated PBX Channels */
+static SCCP_LIST_HEAD (, sccp_null_extensionState_t) null_extensionStates;				/*!< Extension States and Subscriptions */
+static SCCP_LIST_HEAD (, sccp_null_dbEntry_t) null_database;						/*!< In-memory astdb */
+static uint32_t null_channelSequence;									/*!< Uniqueid Sequence */
+static uint32_t null_rtpPort;										/*!< Next (fake) RTP port */
+static int null_extensionStateId;									/*!< Next Extension State Subscription ID */
+static boolean_t null_loaded;										/*!< sccp_null_load has been run */
+
+/* ============================================================================================================== channels */
+static void sccp_null_channel_destroy(void *obj)
+{
+	struct ast_channel *pbx_channel = obj;
+
+	ast_variables_destroy(pbx_channel->vars);
+	pbx_channel->vars = NULL;
+}
+
+static struct ast_channel *sccp_null_channel_alloc(const char *name, const char *context, const char *exten, const PBX_CHANNEL_TYPE * linkedChannel)
+{
+	struct ast_channel *pbx_channel = sccp_null_object_alloc(sizeof(struct ast_channel), sccp_null_channel_destroy);
+
+	if (!pbx_channel) {
+		return NULL;
+	}
+	sccp_copy_string(pbx_channel->name, name, sizeof(pbx_channel->name));
+	snprintf(pbx_channel->uniqueid, sizeof(pbx_channel->uniqueid), "null-%ld.%u", (long) time(NULL), ATOMIC_INCR(&null_channelSequence, 1, &null_channels.lock));
+	sccp_copy_string(pbx_channel->linkedid, linkedChannel ? linkedChannel->uniqueid : pbx_channel->uniqueid, sizeof(pbx_channel->linkedid));
+	sccp_copy_string(pbx_channel->context, S_OR(context, "default"), sizeof(pbx_channel->context));
+	sccp_copy_string(pbx_channel->exten, S_OR(exten, "s"), sizeof(pbx_channel->exten));
+	pbx_channel->presentation = CALLERID_PRESENTATION_ALLOWED;
+	pbx_channel->state = AST_STATE_DOWN;
+	pbx_channel->tech = &null_tech;
+
+	SCCP_LIST_LOCK(&null_channels);
+	SCCP_LIST_INSERT_TAIL(&null_channels, pbx_channel, list);					/* the list owns the allocation reference */
+	SCCP_LIST_UNLOCK(&null_channels);
+	return pbx_channel;
+}
+
+/*!
+ * \brief Remove the channel from the channel list, drop the peer link and the list reference (the equivalent of ast_hangup)
+ */
+static void sccp_null_channel_unlink(struct ast_channel *pbx_channel)
+{
+	struct ast_channel *peer = NULL;
+	boolean_t listed = FALSE;
+
+	ao2_lock(pbx_channel);
+	peer = pbx_channel->peer;
+	pbx_channel->peer = NULL;
+	ao2_unlock(pbx_channel);
+	if (peer) {
+		ast_channel_unref(peer);
+	}
+
+	SCCP_LIST_LOCK(&null_channels);
+	if (pbx_channel->list.prev || null_channels.first == pbx_channel) {
+		SCCP_LIST_REMOVE(&null_channels, pbx_channel, list);
+		listed = TRUE;
+	}
+	SCCP_LIST_UNLOCK(&null_channels);
+	if (listed) {
+		ast_channel_unref(pbx_channel);
+	}
+}
+
+static PBX_CHANNEL_TYPE *sccp_null_channel_getPeer(PBX_CHANNEL_TYPE * pbx_channel)
+{
+	PBX_CHANNEL_TYPE *peer = NULL;
+
+	if (pbx_channel) {
+		ao2_lock(pbx_channel);
+		if (pbx_channel->peer) {
+			peer = ast_channel_ref(pbx_channel->peer);
+		}
+		ao2_unlock(pbx_channel);
+	}
+	return peer;
+}
+
+/*!
+ * \brief Hang up a pbx channel: runs the sccp side of the hangup (what the channel tech hangup callback does) and unlinks the channel
+ * \note Hangs up the peer leg of the built-in dialplan as well
+ */
+static void sccp_null_channel_hangup(PBX_CHANNEL_TYPE * pbx_channel)
+{
+	PBX_CHANNEL_TYPE *peer = NULL;
+	sccp_channel_t *c = NULL;
+
+	ao2_lock(pbx_channel);
+	if (pbx_channel->hungup) {
+		ao2_unlock(pbx_channel);
+		return;
+	}
+	pbx_channel->hungup = TRUE;
+	pbx_channel->softhangup |= AST_SOFTHANGUP_DEV;
+	c = pbx_channel->tech_pvt;
+	pbx_channel->tech_pvt = NULL;										/* we take over the tech_pvt reference */
+	ao2_unlock(pbx_channel);
+
+	peer = sccp_null_channel_getPeer(pbx_channel);
+	if (c) {
+		if (pbx_channel->hangupcause == AST_CAUSE_ANSWERED_ELSEWHERE) {
+			c->answered_elsewhere = TRUE;
+		}
+		AUTO_RELEASE(sccp_channel_t, channel , sccp_pbx_hangup(c));					/* explicit release from unretained channel returned by sccp_pbx_hangup */
+		(void) channel;
+		sccp_channel_release(&c);									/* tech_pvt reference */
+	}
+	sccp_null_channel_unlink(pbx_channel);
+	if (peer) {
+		if (!ast_channel_hangupcause(peer)) {
+			ast_channel_hangupcause_set(peer, AST_CAUSE_NORMAL_CLEARING);
+		}
+		sccp_null_channel_hangup(peer);
+		ast_channel_unref(peer);
+	}
+}
+
+static int sccp_null_sched_hangup(const void *data)
+{
+	PBX_CHANNEL_TYPE *pbx_channel = (PBX_CHANNEL_TYPE *) data;
+
+	sccp_null_channel_hangup(pbx_channel);
+	ast_channel_unref(pbx_channel);
+	return 0;
+}
+
+/*!
+ * \brief Queue the hangup on the scheduler thread (the core may be holding channel/device locks when it asks)
+ */
+static boolean_t sccp_null_queueHangup(PBX_CHANNEL_TYPE * pbx_channel)
+{
+	if (!pbx_channel) {
+		return FALSE;
+	}
+	ast_channel_ref(pbx_channel);
+	if (iPbx.sched_add(0, sccp_null_sched_hangup, pbx_channel) < 0) {
+		sccp_null_channel_hangup(pbx_channel);
+		ast_channel_unref(pbx_channel);
+	}
+	return TRUE;
+}
+
+/* asterisk channel api used by the core */
+const char *ast_channel_name(const struct ast_channel *chan)
+{
+	return chan->name;
+}
+
+const char *ast_channel_uniqueid(const struct ast_channel *chan)
+{
+	return chan->uniqueid;
+}
+
+const char *ast_channel_linkedid(const struct ast_channel *chan)
+{
+	return chan->linkedid;
+}
+
+const char *ast_channel_context(const struct ast_channel *chan)
+{
+	return chan->context;
+}
+
+const char *ast_channel_exten(const struct ast_channel *chan)
+{
+	return chan->exten;
+}
+
+const char *ast_channel_language(const struct ast_channel *chan)
+{
+	return chan->language;
+}
+
+const char *ast_channel_appl(const struct ast_channel *chan)
+{
+	return chan->state == AST_STATE_UP ? "Dial" : NULL;
+}
+
+const char *ast_channel_call_forward(const struct ast_channel *chan)
+{
+	return chan->call_forward;
+}
+
+void ast_channel_call_forward_set(struct ast_channel *chan, const char *value)
+{
+	sccp_copy_string(chan->call_forward, S_OR(value, ""), sizeof(chan->call_forward));
+}
+
+enum ast_channel_state ast_channel_state(const struct ast_channel *chan)
+{
+	return chan->state;
+}
+
+struct ast_flags *ast_channel_flags(struct ast_channel *chan)
+{
+	return &chan->flags;
+}
+
+int ast_channel_hangupcause(const struct ast_channel *chan)
+{
+	return chan->hangupcause;
+}
+
+void ast_channel_hangupcause_set(struct ast_channel *chan, int value)
+{
+	chan->hangupcause = value;
+}
+
+void ast_channel_callgroup_set(struct ast_channel *chan, ast_group_t value)
+{
+	chan->callgroup = value;
+}
+
+void ast_channel_pickupgroup_set(struct ast_channel *chan, ast_group_t value)
+{
+	chan->pickupgroup = value;
+}
+
+void *ast_channel_tech_pvt(const struct ast_channel *chan)
+{
+	return chan->tech_pvt;
+}
+
+const struct ast_channel_tech *ast_channel_tech(const struct ast_channel *chan)
+{
+	return chan->tech;
+}
+
+struct ast_format_cap *ast_channel_nativeformats(const struct ast_channel *chan)
+{
+	return NULL;
+}
+
+struct ast_cdr *ast_channel_cdr(const struct ast_channel *chan)
+{
+	return NULL;
+}
+
+struct ast_pbx *ast_channel_pbx(const struct ast_channel *chan)
+{
+	return NULL;
+}
+
+void ast_channel_set_connected_line(struct ast_channel *chan, const struct ast_party_connected_line *connected, const struct ast_set_party_connected_line *update)
+{
+}
+
+struct ast_channel *ast_channel_get_by_name(const char *name)
+{
+	struct ast_channel *pbx_channel = NULL;
+
+	if (sccp_strlen_zero(name)) {
+		return NULL;
+	}
+	SCCP_LIST_LOCK(&null_channels);
+	SCCP_LIST_TRAVERSE(&null_channels, pbx_channel, list) {
+		if (!strcasecmp(pbx_channel->name, name) || !strcasecmp(pbx_channel->uniqueid, name)) {
+			ast_channel_ref(pbx_channel);
+			break;
+		}
+	}
+	SCCP_LIST_UNLOCK(&null_channels);
+	return pbx_channel;
+}
+
+int ast_check_hangup(struct ast_channel *chan)
+{
+	return (chan->softhangup || chan->hungup) ? 1 : 0;
+}
+
+int ast_softhangup(struct ast_channel *chan, int reason)
+{
+	chan->softhangup |= reason;
+	sccp_null_queueHangup(chan);
+	return 0;
+}
+
+int ast_hangup(struct ast_channel *chan)
+{
+	sccp_null_channel_hangup(chan);
+	return 0;
+}
+
+int ast_setstate(struct ast_channel *chan, enum ast_channel_state state)
+{
+	chan->state = state;
+	return 0;
+}
+
+const char *ast_state2str(enum ast_channel_state state)
+{
+	switch (state) {
+		case AST_STATE_DOWN:
+			return "Down";
+		case AST_STATE_RESERVED:
+			return "Rsrvd";
+		case AST_STATE_OFFHOOK:
+			return "OffHook";
+		case AST_STATE_DIALING:
+			return "Dialing";
+		case AST_STATE_RING:
+			return "Ring";
+		case AST_STATE_RINGING:
+			return "Ringing";
+		case AST_STATE_UP:
+			return "Up";
+		case AST_STATE_BUSY:
+			return "Busy";
+		case AST_STATE_DIALING_OFFHOOK:
+			return "Dialing Offhook";
+		case AST_STATE_PRERING:
+			return "Pre-ring";
+		default:
+			return "Unknown";
+	}
+}
+
+int ast_indicate(struct ast_channel *chan, int condition)
+{
+	AUTO_RELEASE(sccp_channel_t, c , get_sccp_channel_from_pbx_channel(chan));
+	AUTO_RELEASE(sccp_device_t, d , c ? sccp_channel_getDevice(c) : NULL);
+
+	if (!c || !d) {
+		return 0;
+	}
+	switch (condition) {
+		case AST_CONTROL_RINGING:
+			if (SKINNY_CALLTYPE_OUTBOUND == c->calltype) {
+				sccp_indicate(d, c, SCCP_CHANNELSTATE_RINGOUT);
+			}
+			break;
+		case AST_CONTROL_BUSY:
+			sccp_indicate(d, c, SCCP_CHANNELSTATE_BUSY);
+			chan->state = AST_STATE_BUSY;
+			break;
+		case AST_CONTROL_CONGESTION:
+			sccp_indicate(d, c, SCCP_CHANNELSTATE_CONGESTION);
+			break;
+		default:
+			break;
+	}
+	return 0;
+}
+
+int pbx_builtin_setvar_helper(struct ast_channel *chan, const char *name, const char *value)
+{
+	struct ast_variable *var = NULL, *prev = NULL;
+
+	if (!chan || sccp_strlen_zero(name)) {
+		return 0;
+	}
+	while (*name == '_') {											/* inheritance markers */
+		name++;
+	}
+	ao2_lock(chan);
+	for (var = chan->vars; var; prev = var, var = var->next) {
+		if (!strcasecmp(var->name, name)) {
+			if (prev) {
+				prev->next = var->next;
+			} else {
+				chan->vars = var->next;
+			}
+			var->next = NULL;
+			ast_variables_destroy(var);
+			break;
+		}
+	}
+	if (value && (var = ast_variable_new(name, value, ""))) {
+		var->next = chan->vars;
+		chan->vars = var;
+	}
+	ao2_unlock(chan);
+	return 0;
+}
+
+const char *pbx_builtin_getvar_helper(struct ast_channel *chan, const char *name)
+{
+	const struct ast_variable *var = NULL;
+
+	if (!chan || sccp_strlen_zero(name)) {
+		return NULL;
+	}
+	for (var = chan->vars; var; var = var->next) {
+		if (!strcasecmp(var->name, name)) {
+			return var->value;
+		}
+	}
+	return NULL;
+}
+
+/* ============================================================================================================= scheduler */
+static void sccp_null_sched_insert(sccp_null_sched_t * entry)
+{
+	sccp_null_sched_t *cur = NULL, *prev = NULL;
+
+	SCCP_LIST_TRAVERSE(&null_sched.queue, cur, list) {
+		if (ast_tvcmp(entry->when, cur->when) < 0) {
+			break;
+		}
+		prev = cur;
+	}
+	if (prev) {
+		SCCP_LIST_INSERT_AFTER(&null_sched.queue, prev, entry, list);
+	} else {
+		SCCP_LIST_INSERT_HEAD(&null_sched.queue, entry, list);
+		pbx_cond_signal(&null_sched.cond);
+	}
+}
+
+static void *sccp_null_sched_thread(void *data)
+{
+	sccp_null_sched_t *entry = NULL;
+	struct timespec ts;
+	int res;
+
+	SCCP_LIST_LOCK(&null_sched.queue);
+	while (null_sched.running) {
+		if (!(entry = SCCP_LIST_FIRST(&null_sched.queue))) {
+			pbx_cond_wait(&null_sched.cond, &null_sched.queue.lock);
+			continue;
+		}
+		if (ast_tvcmp(entry->when, ast_tvnow()) > 0) {
+			ts.tv_sec = entry->when.tv_sec;
+			ts.tv_nsec = entry->when.tv_usec * 1000;
+			pbx_cond_timedwait(&null_sched.cond, &null_sched.queue.lock, &ts);
+			continue;
+		}
+		entry = SCCP_LIST_REMOVE_HEAD(&null_sched.queue, list);
+		null_sched.runningId = entry->id;
+		SCCP_LIST_UNLOCK(&null_sched.queue);
+
+		res = entry->callback(entry->data);
+
+		SCCP_LIST_LOCK(&null_sched.queue);
+		null_sched.runningId = -1;
+		if (res && entry->interval > 0 && null_sched.running) {						/* reschedule using the same interval (like ast_sched_add) */
+			entry->when = ast_tvadd(ast_tvnow(), ast_samp2tv(entry->interval, 1000));
+			sccp_null_sched_insert(entry);
+		} else {
+			sccp_free(entry);
+		}
+	}
+	SCCP_LIST_UNLOCK(&null_sched.queue);
+	return NULL;
+}
+
+static boolean_t sccp_null_sched_start(void)
+{
+	SCCP_LIST_HEAD_INIT(&null_sched.queue);
+	pbx_cond_init(&null_sched.cond, NULL);
+	null_sched.nextId = 1;
+	null_sched.runningId = -1;
+	null_sched.running = TRUE;
+	if (pbx_pthread_create(&null_sched.thread, NULL, sccp_null_sched_thread, NULL)) {
+		null_sched.running = FALSE;
+		pbx_cond_destroy(&null_sched.cond);
+		SCCP_LIST_HEAD_DESTROY(&null_sched.queue);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*!
+ * \brief Run the remaining (due) schedules, stop the scheduler thread and drop whatever is still pending
+ */
+static void sccp_null_sched_stop(void)
+{
+	sccp_null_sched_t *entry = NULL;
+
+	if (!null_sched.running) {
+		return;
+	}
+	while (sccp_null_sched_pending() && iPbx.sched_wait(0) == 0) {
+		usleep(1000);
+	}
+	SCCP_LIST_LOCK(&null_sched.queue);
+	null_sched.running = FALSE;
+	pbx_cond_signal(&null_sched.cond);
+	SCCP_LIST_UNLOCK(&null_sched.queue);
+	pthread_join(null_sched.thread, NULL);
+
+	SCCP_LIST_LOCK(&null_sched.queue);
+	while ((entry = SCCP_LIST_REMOVE_HEAD(&null_sched.queue, list))) {
+		sccp_free(entry);
+	}
+	SCCP_LIST_UNLOCK(&null_sched.queue);
+	pbx_cond_destroy(&null_sched.cond);
+	SCCP_LIST_HEAD_DESTROY(&null_sched.queue);
+}
+
+static int sccp_null_sched_add(int when, sccp_sched_cb callback, const void *data)
+{
+	sccp_null_sched_t *entry = NULL;
+	int id = -1;
+
+	if (!null_sched.running || !callback || !(entry = sccp_calloc(1, sizeof(sccp_null_sched_t)))) {
+		return -1;
+	}
+	entry->interval = when;
+	entry->when = ast_tvadd(ast_tvnow(), ast_samp2tv(when, 1000));
+	entry->callback = callback;
+	entry->data = data;
+
+	SCCP_LIST_LOCK(&null_sched.queue);
+	id = entry->id = null_sched.nextId++;
+	if (null_sched.nextId < 0) {
+		null_sched.nextId = 1;
+	}
+	sccp_null_sched_insert(entry);
+	SCCP_LIST_UNLOCK(&null_sched.queue);
+	return id;
+}
+
+/*!
+ * \return 0 when the schedule was removed before it ran, -1 otherwise (like ast_sched_del)
+ */
+static int sccp_null_sched_del(int id)
+{
+	sccp_null_sched_t *entry = NULL;
+
+	if (!null_sched.running || id < 0) {
+		return -1;
+	}
+	SCCP_LIST_LOCK(&null_sched.queue);
+	SCCP_LIST_TRAVERSE_SAFE_BEGIN(&null_sched.queue, entry, list) {
+		if (entry->id == id) {
+			SCCP_LIST_REMOVE_CURRENT(list);
+			break;
+		}
+	}
+	SCCP_LIST_TRAVERSE_SAFE_END;
+	SCCP_LIST_UNLOCK(&null_sched.queue);
+	if (entry) {
+		sccp_free(entry);
+		return 0;
+	}
+	return -1;
+}
+
+static int sccp_null_sched_add_ref(int *id, int when, sccp_sched_cb callback, sccp_channel_t * channel)
+{
+	if (null_sched.running && channel) {
+		sccp_channel_t *c = sccp_channel_retain(channel);
+
+		if (c) {
+			if ((*id = sccp_null_sched_add(when, callback, c)) < 0) {
+				sccp_log(DEBUGCAT_CORE) (VERBOSE_PREFIX_3 "%s: sched add id:%d, when:%d, failed\n", c->designator, *id, when);
+				sccp_channel_release(&channel);						/* explicit release during failure */
+			}
+			return *id;
+		}
+	}
+	return -2;
+}
+
+static int sccp_null_sched_del_ref(int *id, sccp_channel_t * channel)
+{
+	if (null_sched.running) {
+		if (*id > -1 && sccp_null_sched_del(*id) == 0) {
+			sccp_channel_release(&channel);								/* reference held by the removed schedule */
+		}
+		*id = -1;
+		return *id;
+	}
+	return -2;
+}
+
+static int sccp_null_sched_replace_ref(int *id, int when, ast_sched_cb callback, sccp_channel_t * channel)
+{
+	if (null_sched.running) {
+		sccp_channel_t *c = NULL;
+
+		if (*id > -1 && sccp_null_sched_del(*id) == 0) {
+			c = channel;
+			sccp_channel_release(&c);								/* reference held by the replaced schedule */
+		}
+		*id = -1;
+		if ((c = sccp_channel_retain(channel))) {
+			if ((*id = sccp_null_sched_add(when, callback, c)) < 0) {
+				sccp_channel_release(&c);
+			}
+		}
+		return *id;
+	}
+	return -2;
+}
+
+/*!
+ * \return seconds until the schedule runs (like ast_sched_when)
+ */
+static long sccp_null_sched_when(int id)
+{
+	sccp_null_sched_t *entry = NULL;
+	long secs = -1;
+
+	if (!null_sched.running) {
+		return FALSE;
+	}
+	SCCP_LIST_LOCK(&null_sched.queue);
+	SCCP_LIST_TRAVERSE(&null_sched.queue, entry, list) {
+		if (entry->id == id) {
+			secs = (long) (ast_tvdiff_ms(entry->when, ast_tvnow()) / 1000);
+			break;
+		}
+	}
+	SCCP_LIST_UNLOCK(&null_sched.queue);
+	return secs < 0 ? 0 : secs;
+}
+
+/*!
+ * \return milliseconds until the next schedule is due, -1 when nothing is pending (like ast_sched_wait)
+ */
+static int sccp_null_sched_wait(int id)
+{
+	sccp_null_sched_t *entry = NULL;
+	int64_t ms = -1;
+
+	if (!null_sched.running) {
+		return FALSE;
+	}
+	SCCP_LIST_LOCK(&null_sched.queue);
+	if ((entry = SCCP_LIST_FIRST(&null_sched.queue))) {
+		ms = ast_tvdiff_ms(entry->when, ast_tvnow());
+		if (ms < 0) {
+			ms = 0;
+		}
+	}
+	SCCP_LIST_UNLOCK(&null_sched.queue);
+	return (int) ms;
+}
+
+int sccp_null_sched_pending(void)
+{
+	int pending = 0;
+
+	if (null_sched.running) {
+		SCCP_LIST_LOCK(&null_sched.queue);
+		pending = SCCP_LIST_GETSIZE(&null_sched.queue) + (null_sched.runningId != -1 ? 1 : 0);
+		SCCP_LIST_UNLOCK(&null_sched.queue);
+	}
+	return pending;
+}
+
+/* ===================================================================================================== built-in dialplan */
+/*!
+ * \brief Dial the line named by the extension of the calling channel (the null replacement of Dial(SCCP/exten))
+ * \note runs on the scheduler thread, data is the retained calling sccp channel
+ */
+static int sccp_null_dial(const void *data)
+{
+	sccp_channel_t *caller = (sccp_channel_t *) data;
+	sccp_channel_t *callee = NULL;
+	PBX_CHANNEL_TYPE *callerOwner = NULL;
+	skinny_codec_t capabilities[SKINNY_MAX_CAPABILITIES] = { 0 };
+	char exten[SCCP_MAX_EXTENSION];
+	int condition = AST_CONTROL_CONGESTION;
+
+	if (!caller->owner || ast_check_hangup(caller->owner)) {
+		sccp_channel_release(&caller);
+		return 0;
+	}
+	callerOwner = ast_channel_ref(caller->owner);
+	sccp_copy_string(exten, S_OR(callerOwner->dialed, callerOwner->exten), sizeof(exten));
+	memcpy(capabilities, caller->preferences.audio, sizeof(capabilities));
+
+	switch (sccp_requestChannel(exten, capabilities[0], capabilities, ARRAY_LEN(capabilities), SCCP_AUTOANSWER_NONE, 0, GLOB(ringtype), &callee)) {
+		case SCCP_REQUEST_STATUS_SUCCESS:
+			if (!sccp_pbx_channel_allocate(callee, NULL, callerOwner)) {
+				break;
+			}
+			iPbx.set_callerid_name(callee->owner, caller->line ? caller->line->cid_name : NULL);
+			iPbx.set_callerid_number(callee->owner, caller->line ? caller->line->cid_num : NULL);
+			ao2_lock(callerOwner);
+			callerOwner->peer = ast_channel_ref(callee->owner);
+			ao2_unlock(callerOwner);
+			ao2_lock(callee->owner);
+			callee->owner->peer = ast_channel_ref(callerOwner);
+			ao2_unlock(callee->owner);
+
+			if (sccp_pbx_call(callee, exten, 0) == 0) {
+				condition = AST_CONTROL_RINGING;
+			} else {
+				condition = AST_CONTROL_BUSY;
+			}
+			break;
+		case SCCP_REQUEST_STATUS_LINEUNAVAIL:
+			condition = AST_CONTROL_BUSY;
+			break;
+		default:
+			break;
+	}
+	sccp_log(DEBUGCAT_PBX) (VERBOSE_PREFIX_3 "%s: (null_dial) dialed '%s' -> %s\n", caller->designator, exten, condition == AST_CONTROL_RINGING ? "ringing" : condition == AST_CONTROL_BUSY ? "busy" : "congestion");
+	ast_indicate(callerOwner, condition);
+	if (callee) {
+		if (condition != AST_CONTROL_RINGING && callee->owner) {
+			sccp_null_queueHangup(callee->owner);
+		}
+		sccp_channel_release(&callee);
+	}
+	ast_channel_unref(callerOwner);
+	sccp_channel_release(&caller);
+	return 0;
+}
+
+/*!
+ * \brief Answer the calling leg once the called leg has answered (what the Dial application does)
+ */
+static int sccp_null_answerPeer(const void *data)
+{
+	PBX_CHANNEL_TYPE *pbx_channel = (PBX_CHANNEL_TYPE *) data;
+	PBX_CHANNEL_TYPE *peer = sccp_null_channel_getPeer(pbx_channel);
+
+	if (peer) {
+		if (peer->state != AST_STATE_UP && !ast_check_hangup(peer)) {
+			AUTO_RELEASE(sccp_channel_t, c , get_sccp_channel_from_pbx_channel(peer));
+			peer->state = AST_STATE_UP;
+			if (c) {
+				sccp_pbx_answered(c);
+			}
+		}
+		ast_channel_unref(peer);
+	}
+	ast_channel_unref(pbx_channel);
+	return 0;
+}
+
+enum ast_pbx_result pbx_pbx_start(struct ast_channel *pbx_channel)
+{
+	if (!pbx_channel) {
+		pbx_log(LOG_ERROR, "SCCP: (pbx_pbx_start) called without pbx channel\n");
+		return AST_PBX_FAILED;
+	}
+	sccp_channel_t *c = get_sccp_channel_from_pbx_channel(pbx_channel);				/* released by sccp_null_dial */
+	if (!c) {
+		return AST_PBX_FAILED;
+	}
+	c->hangupRequest = sccp_wrapper_asterisk_requestQueueHangup;
+	if (iPbx.sched_add(0, sccp_null_dial, c) < 0) {
+		sccp_channel_release(&c);
+		return AST_PBX_FAILED;
+	}
+	return AST_PBX_SUCCESS;
+}
+
+static sccp_extension_status_t sccp_null_extensionStatus(constChannelPtr channel)
+{
+	sccp_extension_status_t result = SCCP_EXTENSION_NOTEXISTS;
+	sccp_line_t *l = NULL;
+	size_t len = sccp_strlen(channel->dialedNumber);
+
+	SCCP_RWLIST_RDLOCK(&GLOB(lines));
+	SCCP_RWLIST_TRAVERSE(&GLOB(lines), l, list) {
+		if (!strcasecmp(l->name, channel->dialedNumber)) {
+			result = SCCP_EXTENSION_EXACTMATCH;
+			break;
+		}
+		if (len && !strncasecmp(l->name, channel->dialedNumber, len)) {
+			result = SCCP_EXTENSION_MATCHMORE;
+		}
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(lines));
+	return result;
+}
+
+/*!
+ * \brief Built-in dialplan: every configured line name exists (in any context)
+ */
+int ast_exists_extension(struct ast_channel *c, const char *context, const char *exten, int priority, const char *callerid)
+{
+	sccp_line_t *l = NULL;
+
+	if (sccp_strlen_zero(exten) || priority != 1) {
+		return 0;
+	}
+	SCCP_RWLIST_RDLOCK(&GLOB(lines));
+	SCCP_RWLIST_TRAVERSE(&GLOB(lines), l, list) {
+		if (!strcasecmp(l->name, exten)) {
+			break;
+		}
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(lines));
+	return l ? 1 : 0;
+}
+
+/* =============================================================================================================== iPbx */
+static boolean_t sccp_null_allocPBXChannel(sccp_channel_t * channel, const void *ids, const PBX_CHANNEL_TYPE * pbxSrcChannel, PBX_CHANNEL_TYPE ** _pbxDstChannel)
+{
+	PBX_CHANNEL_TYPE *pbxDstChannel = NULL;
+
+	if (!channel || !channel->line) {
+		return FALSE;
+	}
+	AUTO_RELEASE(sccp_line_t, line , sccp_line_retain(channel->line));
+	if (!line) {
+		return FALSE;
+	}
+	if (!(pbxDstChannel = sccp_null_channel_alloc(channel->designator, line->context, line->name, pbxSrcChannel))) {
+		pbx_log(LOG_ERROR, "SCCP: (allocPBXChannel) channel alloc failed\n");
+		return FALSE;
+	}
+	iPbx.set_owner(channel, pbxDstChannel);
+	pbxDstChannel->tech_pvt = sccp_channel_retain(channel);
+	if (!sccp_strlen_zero(line->language)) {
+		sccp_copy_string(pbxDstChannel->language, line->language, sizeof(pbxDstChannel->language));
+	}
+	pbxDstChannel->callgroup = line->callgroup;
+#if CS_SCCP_PICKUP
+	pbxDstChannel->pickupgroup = line->pickupgroup;
+#endif
+	(*_pbxDstChannel) = pbxDstChannel;
+	return TRUE;
+}
+
+static int sccp_null_setCallState(constChannelPtr channel, int state)
+{
+	sccp_pbx_setcallstate((sccp_channel_t *) channel, state);
+	return 0;
+}
+
+static boolean_t sccp_null_checkHangup(constChannelPtr channel)
+{
+	return (channel->owner && !ast_check_hangup(channel->owner)) ? TRUE : FALSE;
+}
+
+static void sccp_null_setPBXChannelLinkedId(PBX_CHANNEL_TYPE * pbxchannel, const char *linkedid)
+{
+	if (pbxchannel && linkedid) {
+		sccp_copy_string(pbxchannel->linkedid, linkedid, sizeof(pbxchannel->linkedid));
+	}
+}
+
+static const char *sccp_null_getChannelName(const sccp_channel_t * channel)
+{
+	return channel->owner ? channel->owner->name : "--";
+}
+
+static void sccp_null_setChannelName(const sccp_channel_t * channel, const char *name)
+{
+	if (channel->owner && name) {
+		sccp_copy_string(channel->owner->name, name, sizeof(channel->owner->name));
+	}
+}
+
+static const char *sccp_null_getChannelUniqueID(const sccp_channel_t * channel)
+{
+	return channel->owner ? channel->owner->uniqueid : "--";
+}
+
+static const char *sccp_null_getChannelAppl(const sccp_channel_t * channel)
+{
+	return channel->owner ? S_OR(ast_channel_appl(channel->owner), "(null)") : "--";
+}
+
+static const char *sccp_null_getChannelExten(const sccp_channel_t * channel)
+{
+	return channel->owner ? channel->owner->exten : "--";
+}
+
+static void sccp_null_setChannelExten(const sccp_channel_t * channel, const char *exten)
+{
+	if (channel->owner && exten) {
+		sccp_copy_string(channel->owner->exten, exten, sizeof(channel->owner->exten));
+	}
+}
+
+static const char *sccp_null_getChannelLinkedId(const sccp_channel_t * channel)
+{
+	return channel->owner ? channel->owner->linkedid : "--";
+}
+
+static void sccp_null_setChannelLinkedId(const sccp_channel_t * channel, const char *linkedid)
+{
+	if (channel->owner) {
+		sccp_null_setPBXChannelLinkedId(channel->owner, linkedid);
+	}
+}
+
+static enum ast_channel_state sccp_null_getChannelState(const sccp_channel_t * channel)
+{
+	return channel->owner ? channel->owner->state : AST_STATE_DOWN;
+}
+
+static const struct ast_pbx *sccp_null_getChannelPbx(const sccp_channel_t * channel)
+{
+	return NULL;
+}
+
+static const char *sccp_null_getChannelContext(const sccp_channel_t * channel)
+{
+	return channel->owner ? channel->owner->context : "--";
+}
+
+static void sccp_null_setChannelContext(const sccp_channel_t * channel, const char *context)
+{
+	if (channel->owner && context) {
+		sccp_copy_string(channel->owner->context, context, sizeof(channel->owner->context));
+	}
+}
+
+static const char *sccp_null_getChannelMacroExten(const sccp_channel_t * channel)
+{
+	return channel->owner ? channel->owner->macroexten : "--";
+}
+
+static void sccp_null_setChannelMacroExten(const sccp_channel_t * channel, const char *macroexten)
+{
+	if (channel->owner && macroexten) {
+		sccp_copy_string(channel->owner->macroexten, macroexten, sizeof(channel->owner->macroexten));
+	}
+}
+
+static const char *sccp_null_getChannelMacroContext(const sccp_channel_t * channel)
+{
+	return channel->owner ? channel->owner->macrocontext : "--";
+}
+
+static void sccp_null_setChannelMacroContext(const sccp_channel_t * channel, const char *macrocontext)
+{
+	if (channel->owner && macrocontext) {
+		sccp_copy_string(channel->owner->macrocontext, macrocontext, sizeof(channel->owner->macrocontext));
+	}
+}
+
+static const char *sccp_null_getChannelCallForward(const sccp_channel_t * channel)
+{
+	return channel->owner ? channel->owner->call_forward : "--";
+}
+
+static void sccp_null_setChannelCallForward(const sccp_channel_t * channel, const char *fwdnum)
+{
+	if (channel->owner) {
+		ast_channel_call_forward_set(channel->owner, fwdnum);
+	}
+}
+
+static boolean_t sccp_null_getChannelByName(const char *name, PBX_CHANNEL_TYPE ** pbx_channel)
+{
+	PBX_CHANNEL_TYPE *ast = ast_channel_get_by_name(name);
+
+	if (!ast) {
+		return FALSE;
+	}
+	*pbx_channel = ast;
+	return TRUE;
+}
+
+static boolean_t sccp_null_getRemoteChannel(const sccp_channel_t * channel, PBX_CHANNEL_TYPE ** pbx_channel)
+{
+	PBX_CHANNEL_TYPE *peer = sccp_null_channel_getPeer(channel->owner);
+
+	if (!peer) {
+		return FALSE;
+	}
+	*pbx_channel = peer;
+	return TRUE;
+}
+
+static PBX_CHANNEL_TYPE *sccp_null_findChannelWithCallback(int (*const found_cb) (PBX_CHANNEL_TYPE * c, void *data), void *data, boolean_t lock)
+{
+	PBX_CHANNEL_TYPE *pbx_channel = NULL;
+
+	SCCP_LIST_LOCK(&null_channels);
+	SCCP_LIST_TRAVERSE(&null_channels, pbx_channel, list) {
+		if (found_cb(pbx_channel, data)) {
+			ast_channel_ref(pbx_channel);
+			if (lock) {
+				ao2_lock(pbx_channel);
+			}
+			break;
+		}
+	}
+	SCCP_LIST_UNLOCK(&null_channels);
+	return pbx_channel;
+}
+
+static int sccp_null_setNativeAudioFormats(constChannelPtr channel, skinny_codec_t codec[], int length)
+{
+	return 1;
+}
+
+static int sccp_null_setNativeVideoFormats(constChannelPtr channel, uint32_t formats)
+{
+	return 1;
+}
+
+static int sccp_null_sendDigits(const sccp_channel_t * channel, const char *digits)
+{
+	return 0;
+}
+
+static int sccp_null_sendDigit(const sccp_channel_t * channel, const char digit)
+{
+	return 0;
+}
+
+/* rtp */
+static boolean_t sccp_null_createRtpInstance(constDevicePtr d, constChannelPtr c, sccp_rtp_t * rtp)
+{
+	struct ast_rtp_instance *instance = NULL;
+	uint16_t port;
+
+	if (!c || !d || !(instance = sccp_calloc(1, sizeof(struct ast_rtp_instance)))) {
+		return FALSE;
+	}
+	memcpy(&instance->us, &GLOB(bindaddr), sizeof(struct sockaddr_storage));
+	if (sccp_netsock_is_any_addr(&instance->us)) {
+		sccp_session_getOurIP(d->session, &instance->us, 0);
+	}
+	port = NULL_RTP_PORT_BASE + ((ATOMIC_INCR(&null_rtpPort, 2, &null_channels.lock)) % NULL_RTP_PORT_RANGE);
+	sccp_netsock_setPort(&instance->us, port);
+	rtp->instance = instance;
+	sccp_log(DEBUGCAT_RTP) (VERBOSE_PREFIX_3 "%s: (null) rtp instance created at port %d\n", c->designator, port);
+	return TRUE;
+}
+
+static boolean_t sccp_null_destroyRTP(PBX_RTP_TYPE * rtp)
+{
+	sccp_free(rtp);
+	return TRUE;
+}
+
+static void sccp_null_stopRTP(PBX_RTP_TYPE * rtp)
+{
+}
+
+static boolean_t sccp_null_rtpGetPeer(PBX_RTP_TYPE * rtp, struct sockaddr_storage *address)
+{
+	memcpy(address, &rtp->peer, sizeof(struct sockaddr_storage));
+	return TRUE;
+}
+
+static boolean_t sccp_null_rtpGetUs(PBX_RTP_TYPE * rtp, struct sockaddr_storage *address)
+{
+	memcpy(address, &rtp->us, sizeof(struct sockaddr_storage));
+	return TRUE;
+}
+
+static int sccp_null_setPhoneRTPAddress(const struct sccp_rtp *rtp, const struct sockaddr_storage *new_peer, int nat_active)
+{
+	if (!rtp->instance || !new_peer) {
+		return -1;
+	}
+	memcpy(&rtp->instance->peer, new_peer, sizeof(struct sockaddr_storage));
+	return 0;
+}
+
+static boolean_t sccp_null_setWriteFormat(constChannelPtr channel, skinny_codec_t codec)
+{
+	((sccp_channel_t *) channel)->rtp.audio.writeFormat = codec;
+	return TRUE;
+}
+
+static boolean_t sccp_null_setReadFormat(constChannelPtr channel, skinny_codec_t codec)
+{
+	((sccp_channel_t *) channel)->rtp.audio.readFormat = codec;
+	return TRUE;
+}
+
+static uint8_t sccp_null_get_payloadType(const struct sccp_rtp *rtp, skinny_codec_t codec)
+{
+	uint8_t i;
+
+	for (i = 0; i < sccp_codec_getArrayLen(); i++) {
+		if (skinny_codecs[i].codec == codec) {
+			return (uint8_t) skinny_codecs[i].rtp_payload_type;
+		}
+	}
+	return 0;
+}
+
+static int sccp_null_get_sampleRate(skinny_codec_t codec)
+{
+	uint8_t i;
+
+	for (i = 0; i < sccp_codec_getArrayLen(); i++) {
+		if (skinny_codecs[i].codec == codec) {
+			return (int) skinny_codecs[i].sample_rate;
+		}
+	}
+	return 8000;
+}
+
+/* callerid */
+static int sccp_null_calleridString(const char *value, char **result)
+{
+	if (!sccp_strlen_zero(value)) {
+		*result = pbx_strdup(value);
+		return 1;
+	}
+	return 0;
+}
+
+static int sccp_null_callerid_name(PBX_CHANNEL_TYPE * pbx_chan, char **cid_name)
+{
+	return pbx_chan ? sccp_null_calleridString(pbx_chan->cid_name, cid_name) : 0;
+}
+
+static int sccp_null_callerid_number(PBX_CHANNEL_TYPE * pbx_chan, char **cid_number)
+{
+	return pbx_chan ? sccp_null_calleridString(pbx_chan->cid_num, cid_number) : 0;
+}
+
+static int sccp_null_callerid_ton(PBX_CHANNEL_TYPE * pbx_chan, int *ton)
+{
+	return 0;
+}
+
+static int sccp_null_callerid_ani(PBX_CHANNEL_TYPE * pbx_chan, char **ani)
+{
+	return pbx_chan ? sccp_null_calleridString(pbx_chan->cid_ani, ani) : 0;
+}
+
+static int sccp_null_callerid_subaddr(PBX_CHANNEL_TYPE * pbx_chan, char **subaddr)
+{
+	return 0;
+}
+
+static int sccp_null_callerid_dnid(PBX_CHANNEL_TYPE * pbx_chan, char **dnid)
+{
+	return pbx_chan ? sccp_null_calleridString(pbx_chan->dialed, dnid) : 0;
+}
+
+static int sccp_null_callerid_rdnis(PBX_CHANNEL_TYPE * pbx_chan, char **rdnis)
+{
+	return 0;
+}
+
+static int sccp_null_callerid_presentation(PBX_CHANNEL_TYPE * pbx_chan)
+{
+	return (pbx_chan && pbx_chan->presentation == CALLERID_PRESENTATION_FORBIDDEN) ? CALLERID_PRESENTATION_FORBIDDEN : CALLERID_PRESENTATION_ALLOWED;
+}
+
+static void sccp_null_setCalleridName(PBX_CHANNEL_TYPE * pbx_channel, const char *name)
+{
+	if (pbx_channel && name) {
+		sccp_copy_string(pbx_channel->cid_name, name, sizeof(pbx_channel->cid_name));
+	}
+}
+
+static void sccp_null_setCalleridNumber(PBX_CHANNEL_TYPE * pbx_channel, const char *number)
+{
+	if (pbx_channel && number) {
+		sccp_copy_string(pbx_channel->cid_num, number, sizeof(pbx_channel->cid_num));
+	}
+}
+
+static void sccp_null_setCalleridAni(PBX_CHANNEL_TYPE * pbx_channel, const char *ani)
+{
+	if (pbx_channel && ani) {
+		sccp_copy_string(pbx_channel->cid_ani, ani, sizeof(pbx_channel->cid_ani));
+	}
+}
+
+static void sccp_null_setRedirectingParty(PBX_CHANNEL_TYPE * pbx_channel, const char *number, const char *name)
+{
+}
+
+static void sccp_null_setRedirectedParty(PBX_CHANNEL_TYPE * pbx_channel, const char *number, const char *name)
+{
+}
+
+static void sccp_null_setCalleridPresentation(PBX_CHANNEL_TYPE * pbx_channel, sccp_callerid_presentation_t presentation)
+{
+	if (pbx_channel) {
+		pbx_channel->presentation = presentation;
+	}
+}
+
+static void sccp_null_setDialedNumber(const sccp_channel_t * channel, const char *number)
+{
+	if (channel->owner && number) {
+		sccp_copy_string(channel->owner->dialed, number, sizeof(channel->owner->dialed));
+		sccp_copy_string(channel->owner->exten, number, sizeof(channel->owner->exten));
+	}
+}
+
+static void sccp_null_updateConnectedLine(constChannelPtr channel, const char *number, const char *name, uint8_t reason)
+{
+}
+
+static void sccp_null_sendRedirectedUpdate(const sccp_channel_t * channel, const char *fromNumber, const char *fromName, const char *toNumber, const char *toName, uint8_t reason)
+{
+}
+
+/* features */
+static sccp_parkresult_t sccp_null_park(constChannelPtr hostChannel)
+{
+	return PARK_RESULT_FAIL;
+}
+
+static boolean_t sccp_null_featureMonitor(const sccp_channel_t * channel)
+{
+	return FALSE;
+}
+
+static boolean_t sccp_null_getFeatureExtension(constChannelPtr channel, const char *featureName, char extension[SCCP_MAX_EXTENSION])
+{
+	return FALSE;
+}
+
+static boolean_t sccp_null_getPickupExtension(constChannelPtr channel, char extension[SCCP_MAX_EXTENSION])
+{
+	return FALSE;
+}
+
+/* database */
+static sccp_null_dbEntry_t *sccp_null_db_find(const char *family, const char *key)
+{
+	sccp_null_dbEntry_t *entry = NULL;
+
+	SCCP_LIST_TRAVERSE(&null_database, entry, list) {
+		if (!strcmp(entry->family, family) && !strcmp(entry->key, key)) {
+			break;
+		}
+	}
+	return entry;
+}
+
+static boolean_t sccp_null_addToDatabase(const char *family, const char *key, const char *value)
+{
+	sccp_null_dbEntry_t *entry = NULL;
+	char *newValue = NULL;
+
+	if (sccp_strlen_zero(family) || sccp_strlen_zero(key) || sccp_strlen_zero(value) || !(newValue = pbx_strdup(value))) {
+		return FALSE;
+	}
+	SCCP_LIST_LOCK(&null_database);
+	if ((entry = sccp_null_db_find(family, key))) {
+		sccp_free(entry->value);
+		entry->value = newValue;
+	} else if ((entry = sccp_calloc(1, sizeof(sccp_null_dbEntry_t)))) {
+		entry->family = pbx_strdup(family);
+		entry->key = pbx_strdup(key);
+		entry->value = newValue;
+		SCCP_LIST_INSERT_TAIL(&null_database, entry, list);
+	} else {
+		sccp_free(newValue);
+	}
+	SCCP_LIST_UNLOCK(&null_database);
+	return entry ? TRUE : FALSE;
+}
+
+static boolean_t sccp_null_getFromDatabase(const char *family, const char *key, char *out, int outlen)
+{
+	sccp_null_dbEntry_t *entry = NULL;
+
+	if (sccp_strlen_zero(family) || sccp_strlen_zero(key)) {
+		return FALSE;
+	}
+	SCCP_LIST_LOCK(&null_database);
+	if ((entry = sccp_null_db_find(family, key))) {
+		sccp_copy_string(out, entry->value, outlen);
+	}
+	SCCP_LIST_UNLOCK(&null_database);
+	return entry ? TRUE : FALSE;
+}
+
+static void sccp_null_db_free(sccp_null_dbEntry_t * entry)
+{
+	sccp_free(entry->family);
+	sccp_free(entry->key);
+	sccp_free(entry->value);
+	sccp_free(entry);
+}
+
+static boolean_t sccp_null_removeFromDatabase(const char *family, const char *key)
+{
+	sccp_null_dbEntry_t *entry = NULL;
+
+	if (sccp_strlen_zero(family) || sccp_strlen_zero(key)) {
+		return FALSE;
+	}
+	SCCP_LIST_LOCK(&null_database);
+	if ((entry = sccp_null_db_find(family, key))) {
+		SCCP_LIST_REMOVE(&null_database, entry, list);
+	}
+	SCCP_LIST_UNLOCK(&null_database);
+	if (entry) {
+		sccp_null_db_free(entry);
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static boolean_t sccp_null_removeTreeFromDatabase(const char *family, const char *key)
+{
+	sccp_null_dbEntry_t *entry = NULL;
+	size_t keylen = sccp_strlen(key);
+	boolean_t res = FALSE;
+
+	if (sccp_strlen_zero(family)) {
+		return FALSE;
+	}
+	SCCP_LIST_LOCK(&null_database);
+	SCCP_LIST_TRAVERSE_SAFE_BEGIN(&null_database, entry, list) {
+		if (!strcmp(entry->family, family) && (!keylen || !strncmp(entry->key, key, keylen))) {
+			SCCP_LIST_REMOVE_CURRENT(list);
+			sccp_null_db_free(entry);
+			res = TRUE;
+		}
+	}
+	SCCP_LIST_TRAVERSE_SAFE_END;
+	SCCP_LIST_UNLOCK(&null_database);
+	return res;
+}
+
+/* music on hold / control frames */
+static int sccp_null_moh_start(PBX_CHANNEL_TYPE * pbx_channel, const char *mclass, const char *interpclass)
+{
+	return 0;
+}
+
+static void sccp_null_moh_stop(PBX_CHANNEL_TYPE * pbx_channel)
+{
+}
+
+static int sccp_null_queue_control(const PBX_CHANNEL_TYPE * pbx_channel, enum ast_control_frame_type control)
+{
+	PBX_CHANNEL_TYPE *chan = (PBX_CHANNEL_TYPE *) pbx_channel;
+
+	if (!chan) {
+		return -1;
+	}
+	if (control == AST_CONTROL_ANSWER) {
+		chan->state = AST_STATE_UP;
+		ast_channel_ref(chan);
+		if (iPbx.sched_add(0, sccp_null_answerPeer, chan) < 0) {
+			ast_channel_unref(chan);
+		}
+	}
+	return 0;
+}
+
+static int sccp_null_queue_control_data(const PBX_CHANNEL_TYPE * pbx_channel, enum ast_control_frame_type control, const void *data, size_t datalen)
+{
+	return sccp_null_queue_control(pbx_channel, control);
+}
+
+static boolean_t sccp_null_setLanguage(PBX_CHANNEL_TYPE * pbxChannel, const char *language)
+{
+	if (pbxChannel && language) {
+		sccp_copy_string(pbxChannel->language, language, sizeof(pbxChannel->language));
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/* extension state */
+static sccp_null_extensionState_t *sccp_null_extensionState_find(const char *exten, const char *context)
+{
+	sccp_null_extensionState_t *entry = NULL;
+
+	SCCP_LIST_TRAVERSE(&null_extensionStates, entry, list) {
+		if (!entry->id && !strcmp(entry->exten, exten) && !strcmp(entry->context, context)) {
+			break;
+		}
+	}
+	return entry;
+}
+
+static skinny_busylampfield_state_t sccp_null_getExtensionState(const char *extension, const char *context)
+{
+	skinny_busylampfield_state_t result = SKINNY_BLF_STATUS_UNKNOWN;
+	sccp_null_extensionState_t *entry = NULL;
+
+	if (sccp_strlen_zero(extension) || sccp_strlen_zero(context)) {
+		pbx_log(LOG_ERROR, "SCCP: iPbx.getExtensionState: Either extension:'%s' or context:;%s' provided is empty\n", extension, context);
+		return result;
+	}
+	SCCP_LIST_LOCK(&null_extensionStates);
+	if ((entry = sccp_null_extensionState_find(extension, context))) {
+		result = entry->state;
+	}
+	SCCP_LIST_UNLOCK(&null_extensionStates);
+	return result;
+}
+
+static enum ast_extension_states sccp_null_blf2extensionState(skinny_busylampfield_state_t state)
+{
+	switch (state) {
+		case SKINNY_BLF_STATUS_IDLE:
+			return AST_EXTENSION_NOT_INUSE;
+		case SKINNY_BLF_STATUS_INUSE:
+			return AST_EXTENSION_INUSE;
+		case SKINNY_BLF_STATUS_ALERTING:
+			return AST_EXTENSION_RINGING;
+		default:
+			return AST_EXTENSION_UNAVAILABLE;
+	}
+}
+
+int ast_extension_state(struct ast_channel *c, const char *context, const char *exten)
+{
+	return sccp_null_blf2extensionState(sccp_null_getExtensionState(exten, context));
+}
+
+int ast_extension_state_add(const char *context, const char *exten, ast_state_cb_type change_cb, void *data)
+{
+	sccp_null_extensionState_t *entry = NULL;
+
+	if (sccp_strlen_zero(context) || sccp_strlen_zero(exten) || !change_cb || !(entry = sccp_calloc(1, sizeof(sccp_null_extensionState_t)))) {
+		return -1;
+	}
+	sccp_copy_string(entry->exten, exten, sizeof(entry->exten));
+	sccp_copy_string(entry->context, context, sizeof(entry->context));
+	entry->callback = change_cb;
+	entry->data = data;
+	SCCP_LIST_LOCK(&null_extensionStates);
+	entry->id = ++null_extensionStateId;
+	SCCP_LIST_INSERT_TAIL(&null_extensionStates, entry, list);
+	SCCP_LIST_UNLOCK(&null_extensionStates);
+	return entry->id;
+}
+
+int ast_extension_state_del(int id, ast_state_cb_type change_cb)
+{
+	sccp_null_extensionState_t *entry = NULL;
+
+	SCCP_LIST_LOCK(&null_extensionStates);
+	SCCP_LIST_TRAVERSE_SAFE_BEGIN(&null_extensionStates, entry, list) {
+		if (entry->id && (entry->id == id || (change_cb && entry->callback == change_cb))) {
+			SCCP_LIST_REMOVE_CURRENT(list);
+			sccp_free(entry);
+		}
+	}
+	SCCP_LIST_TRAVERSE_SAFE_END;
+	SCCP_LIST_UNLOCK(&null_extensionStates);
+	return 0;
+}
+
+void sccp_null_setExtensionState(const char *extension, const char *context, skinny_busylampfield_state_t state)
+{
+	sccp_null_extensionState_t *entry = NULL;
+	struct ast_state_cb_info info = { 0 };
+	ast_state_cb_type callbacks[16];
+	void *callbackData[16];
+	int numCallbacks = 0, i;
+
+	if (sccp_strlen_zero(extension) || sccp_strlen_zero(context)) {
+		return;
+	}
+	SCCP_LIST_LOCK(&null_extensionStates);
+	if (!(entry = sccp_null_extensionState_find(extension, context)) && (entry = sccp_calloc(1, sizeof(sccp_null_extensionState_t)))) {
+		sccp_copy_string(entry->exten, extension, sizeof(entry->exten));
+		sccp_copy_string(entry->context, context, sizeof(entry->context));
+		SCCP_LIST_INSERT_TAIL(&null_extensionStates, entry, list);
+	}
+	if (entry) {
+		entry->state = state;
+	}
+	SCCP_LIST_TRAVERSE(&null_extensionStates, entry, list) {
+		if (entry->id && numCallbacks < (int) ARRAY_LEN(callbacks) && !strcmp(entry->exten, extension) && !strcmp(entry->context, context)) {
+			callbacks[numCallbacks] = entry->callback;
+			callbackData[numCallbacks++] = entry->data;
+		}
+	}
+	SCCP_LIST_UNLOCK(&null_extensionStates);
+
+	info.exten_state = sccp_null_blf2extensionState(state);
+	info.reason = AST_HINT_UPDATE_DEVICE;
+	for (i = 0; i < numCallbacks; i++) {
+		callbacks[i]((char *) context, (char *) extension, &info, callbackData[i]);
+	}
+}
+
+/* pickup / endpoints */
+static PBX_CHANNEL_TYPE *sccp_null_findPickupChannelByExtenLocked(PBX_CHANNEL_TYPE * chan, const char *exten, const char *context)
+{
+	return NULL;
+}
+
+static PBX_CHANNEL_TYPE *sccp_null_findPickupChannelByGroupLocked(PBX_CHANNEL_TYPE * chan)
+{
+	return NULL;
+}
+
+static PBX_ENDPOINT_TYPE *sccp_null_endpoint_create(const char *tech, const char *resource)
+{
+	return NULL;
+}
+
+static void sccp_null_endpoint_online(PBX_ENDPOINT_TYPE * endpoint, const char *address)
+{
+}
+
+static void sccp_null_endpoint_offline(PBX_ENDPOINT_TYPE * endpoint, const char *cause)
+{
+}
+
+static void sccp_null_endpoint_shutdown(PBX_ENDPOINT_TYPE ** endpoint)
+{
+}
+
+/* channel helpers */
+static void sccp_null_setOwner(sccp_channel_t * channel, PBX_CHANNEL_TYPE * pbx_channel)
+{
+	PBX_CHANNEL_TYPE *prev_owner = channel->owner;
+
+	if (pbx_channel) {
+		channel->owner = ast_channel_ref(pbx_channel);
+	} else {
+		channel->owner = NULL;
+	}
+	if (prev_owner) {
+		ast_channel_unref(prev_owner);
+	}
+}
+
+static void sccp_null_removeTimingFD(PBX_CHANNEL_TYPE * pbx_channel)
+{
+}
+
+static int sccp_null_dumpchan(PBX_CHANNEL_TYPE * c, char *buf, size_t size)
+{
+	if (!c) {
+		return -1;
+	}
+	snprintf(buf, size, "Name=               %s\nUniqueID=           %s\nLinkedID=           %s\nContext=            %s\nExtension=          %s\nState=              %s (%d)\nCallerIDNum=        %s\nCallerIDName=       %s\nHangupCause=        %d\n",
+		 c->name, c->uniqueid, c->linkedid, c->context, c->exten, ast_state2str(c->state), c->state, c->cid_num, c->cid_name, c->hangupcause);
+	return 0;
+}
+
+static boolean_t sccp_null_channelIsBridged(sccp_channel_t * channel)
+{
+	PBX_CHANNEL_TYPE *peer = sccp_null_channel_getPeer(channel->owner);
+	boolean_t res = FALSE;
+
+	if (peer) {
+		res = (peer->state == AST_STATE_UP && channel->owner->state == AST_STATE_UP) ? TRUE : FALSE;
+		ast_channel_unref(peer);
+	}
+	return res;
+}
+
+static PBX_CHANNEL_TYPE *sccp_null_getBridgeChannel(PBX_CHANNEL_TYPE * pbx_channel)
+{
+	return sccp_null_channel_getPeer(pbx_channel);
+}
+
+static boolean_t sccp_null_attendedTransfer(sccp_channel_t * destination_channel, sccp_channel_t * source_channel)
+{
+	return FALSE;
+}
+
+static void sccp_null_setCallgroup(sccp_channel_t * channel, ast_group_t value)
+{
+	if (channel && channel->owner) {
+		channel->owner->callgroup = value;
+	}
+}
+
+static void sccp_null_setPickupgroup(sccp_channel_t * channel, ast_group_t value)
+{
+	if (channel && channel->owner) {
+		channel->owner->pickupgroup = value;
+	}
+}
+
+static int sccp_null_registerApplication(const char *app_name, int (*execute) (struct ast_channel *, const char *))
+{
+	return 0;
+}
+
+static int sccp_null_unregisterApplication(const char *app_name)
+{
+	return 0;
+}
+
+static int sccp_null_registerFunction(struct pbx_custom_function *custom_function)
+{
+	return 0;
+}
+
+static int sccp_null_unregisterFunction(struct pbx_custom_function *custom_function)
+{
+	return 0;
+}
+
+static uint sccp_null_getCodecFraming(constChannelPtr c)
+{
+	return 20;
+}
+
+static uint sccp_null_getDtmfPayloadCode(constChannelPtr c)
+{
+	return 101;
+}
+
+const PbxInterface iPbx = {
+	/* *INDENT-OFF* */
+
+	/* channel */
+	.alloc_pbxChannel 		= sccp_null_allocPBXChannel,
+	.extension_status 		= sccp_null_extensionStatus,
+	.setPBXChannelLinkedId		= sccp_null_setPBXChannelLinkedId,
+
+	.getChannelByName 		= sccp_null_getChannelByName,
+	.getChannelLinkedId		= sccp_null_getChannelLinkedId,
+	.setChannelLinkedId		= sccp_null_setChannelLinkedId,
+	.getChannelName			= sccp_null_getChannelName,
+	.setChannelName			= sccp_null_setChannelName,
+	.getChannelUniqueID		= sccp_null_getChannelUniqueID,
+	.getChannelExten		= sccp_null_getChannelExten,
+	.setChannelExten		= sccp_null_setChannelExten,
+	.getChannelContext		= sccp_null_getChannelContext,
+	.setChannelContext		= sccp_null_setChannelContext,
+	.getChannelMacroExten		= sccp_null_getChannelMacroExten,
+	.setChannelMacroExten		= sccp_null_setChannelMacroExten,
+	.getChannelMacroContext		= sccp_null_getChannelMacroContext,
+	.setChannelMacroContext		= sccp_null_setChannelMacroContext,
+	.getChannelCallForward		= sccp_null_getChannelCallForward,
+	.setChannelCallForward		= sccp_null_setChannelCallForward,
+
+	.getChannelAppl			= sccp_null_getChannelAppl,
+	.getChannelState		= sccp_null_getChannelState,
+	.getChannelPbx			= sccp_null_getChannelPbx,
+
+	.getRemoteChannel		= sccp_null_getRemoteChannel,
+	.checkhangup			= sccp_null_checkHangup,
+
+	/* digits */
+	.send_digits 			= sccp_null_sendDigits,
+	.send_digit 			= sccp_null_sendDigit,
+
+	/* schedulers */
+	.sched_add			= sccp_null_sched_add,
+	.sched_del			= sccp_null_sched_del,
+	.sched_add_ref			= sccp_null_sched_add_ref,
+	.sched_del_ref			= sccp_null_sched_del_ref,
+	.sched_replace_ref		= sccp_null_sched_replace_ref,
+	.sched_when 			= sccp_null_sched_when,
+	.sched_wait 			= sccp_null_sched_wait,
+
+	/* callstate / indicate */
+	.set_callstate 			= sccp_null_setCallState,
+
+	/* codecs */
+	.set_nativeAudioFormats 	= sccp_null_setNativeAudioFormats,
+	.set_nativeVideoFormats 	= sccp_null_setNativeVideoFormats,
+
+	/* rtp */
+	.rtp_getPeer			= sccp_null_rtpGetPeer,
+	.rtp_getUs 			= sccp_null_rtpGetUs,
+	.rtp_stop			= sccp_null_stopRTP,
+	.rtp_create_instance		= sccp_null_createRtpInstance,
+	.rtp_get_payloadType 		= sccp_null_get_payloadType,
+	.rtp_get_sampleRate 		= sccp_null_get_sampleRate,
+	.rtp_destroy 			= sccp_null_destroyRTP,
+	.rtp_setWriteFormat 		= sccp_null_setWriteFormat,
+	.rtp_setReadFormat 		= sccp_null_setReadFormat,
+	.rtp_setPhoneAddress		= sccp_null_setPhoneRTPAddress,
+
+	/* callerid */
+	.get_callerid_name 		= sccp_null_callerid_name,
+	.get_callerid_number 		= sccp_null_callerid_number,
+	.get_callerid_ton 		= sccp_null_callerid_ton,
+	.get_callerid_ani 		= sccp_null_callerid_ani,
+	.get_callerid_subaddr 		= sccp_null_callerid_subaddr,
+	.get_callerid_dnid 		= sccp_null_callerid_dnid,
+	.get_callerid_rdnis 		= sccp_null_callerid_rdnis,
+	.get_callerid_presentation 	= sccp_null_callerid_presentation,
+
+	.set_callerid_name 		= sccp_null_setCalleridName,
+	.set_callerid_number 		= sccp_null_setCalleridNumber,
+	.set_callerid_ani 		= sccp_null_setCalleridAni,
+	.set_callerid_dnid 		= NULL,
+	.set_callerid_redirectingParty 	= sccp_null_setRedirectingParty,
+	.set_callerid_redirectedParty 	= sccp_null_setRedirectedParty,
+	.set_callerid_presentation 	= sccp_null_setCalleridPresentation,
+	.set_dialed_number		= sccp_null_setDialedNumber,
+	.set_connected_line		= sccp_null_updateConnectedLine,
+	.sendRedirectedUpdate		= sccp_null_sendRedirectedUpdate,
+
+	/* database */
+	.feature_addToDatabase 		= sccp_null_addToDatabase,
+	.feature_getFromDatabase 	= sccp_null_getFromDatabase,
+	.feature_removeFromDatabase     = sccp_null_removeFromDatabase,
+	.feature_removeTreeFromDatabase = sccp_null_removeTreeFromDatabase,
+	.feature_monitor		= sccp_null_featureMonitor,
+
+	.feature_park			= sccp_null_park,
+	.getFeatureExtension		= sccp_null_getFeatureExtension,
+	.getPickupExtension		= sccp_null_getPickupExtension,
+
+	.findChannelByCallback		= sccp_null_findChannelWithCallback,
+
+	.moh_start			= sccp_null_moh_start,
+	.moh_stop			= sccp_null_moh_stop,
+	.queue_control			= sccp_null_queue_control,
+	.queue_control_data		= sccp_null_queue_control_data,
+
+	.allocTempPBXChannel		= NULL,
+	.masqueradeHelper		= NULL,
+	.requestAnnouncementChannel	= NULL,
+
+	.set_language			= sccp_null_setLanguage,
+
+	.getExtensionState		= sccp_null_getExtensionState,
+	.findPickupChannelByExtenLocked	= sccp_null_findPickupChannelByExtenLocked,
+	.findPickupChannelByGroupLocked	= sccp_null_findPickupChannelByGroupLocked,
+
+	.endpoint_create		= sccp_null_endpoint_create,
+	.endpoint_online		= sccp_null_endpoint_online,
+	.endpoint_offline		= sccp_null_endpoint_offline,
+	.endpoint_shutdown		= sccp_null_endpoint_shutdown,
+
+	.set_owner			= sccp_null_setOwner,
+	.removeTimingFD			= sccp_null_removeTimingFD,
+	.dumpchan			= sccp_null_dumpchan,
+	.channel_is_bridged		= sccp_null_channelIsBridged,
+	.get_bridged_channel		= sccp_null_getBridgeChannel,
+	.get_underlying_channel		= sccp_null_getBridgeChannel,
+	.attended_transfer		= sccp_null_attendedTransfer,
+
+	.set_callgroup			= sccp_null_setCallgroup,
+	.set_pickupgroup		= sccp_null_setPickupgroup,
+	.set_named_callgroups		= NULL,
+	.set_named_pickupgroups		= NULL,
+
+	.register_application		= sccp_null_registerApplication,
+	.unregister_application		= sccp_null_unregisterApplication,
+	.register_function		= sccp_null_registerFunction,
+	.unregister_function		= sccp_null_unregisterFunction,
+
+	.get_codec_framing		= sccp_null_getCodecFraming,
+	.get_dtmf_payload_code		= sccp_null_getDtmfPayloadCode,
+	/* *INDENT-ON* */
+};
+
+/* ============================================================================================ pbx_impl/ast replacements */
+#if DEBUG
+sccp_channel_t *__get_sccp_channel_from_pbx_channel(const PBX_CHANNEL_TYPE * pbx_channel, const char *filename, int lineno, const char *func)
+#else
+sccp_channel_t *get_sccp_channel_from_pbx_channel(const PBX_CHANNEL_TYPE * pbx_channel)
+#endif
+{
+	sccp_channel_t *c = NULL;
+
+	if (pbx_channel && pbx_channel->tech == &null_tech && (c = pbx_channel->tech_pvt)) {
+#if DEBUG
+		return sccp_refcount_retain(c, filename, lineno, func);
+#else
+		return sccp_channel_retain(c);
+#endif
+	}
+	return NULL;
+}
+
+boolean_t sccp_wrapper_asterisk_requestQueueHangup(sccp_channel_t * c)
+{
+	AUTO_RELEASE(sccp_channel_t, channel , sccp_channel_retain(c));
+
+	if (!channel) {
+		return FALSE;
+	}
+	if (ATOMIC_FETCH(&channel->scheduler.deny, &channel->scheduler.lock) == 0) {
+		sccp_channel_stop_and_deny_scheduled_tasks(channel);
+	}
+	if (!channel->owner || ast_check_hangup(channel->owner)) {
+		AUTO_RELEASE(sccp_device_t, d , sccp_channel_getDevice(channel));
+
+		if (d) {
+			sccp_indicate(d, channel, SCCP_CHANNELSTATE_ONHOOK);
+		}
+		return FALSE;
+	}
+	channel->owner->softhangup |= AST_SOFTHANGUP_DEV;
+	return sccp_null_queueHangup(channel->owner);
+}
+
+boolean_t sccp_wrapper_asterisk_requestHangup(sccp_channel_t * c)
+{
+	return sccp_wrapper_asterisk_requestQueueHangup(c);
+}
+
+int sccp_parse_alertinfo(PBX_CHANNEL_TYPE * pbx_channel, skinny_ringtype_t * ringermode)
+{
+	return 0;
+}
+
+gcc_inline const char *pbxsccp_devicestate2str(uint32_t value)
+{
+	return ast_devstate_str((enum ast_device_state) value);
+}
+
+struct ast_context *pbx_context_find_or_create(struct ast_context **extcontexts, struct ast_hashtab *exttable, const char *name, const char *registrar)
+{
+	return NULL;
+}
+
+struct ast_config *pbx_config_load(const char *filename, const char *who_asked, struct ast_flags flags)
+{
+	return ast_config_load2(filename, who_asked, flags);
+}
+
+const char *pbx_inet_ntoa(struct in_addr ia)
+{
+	static __thread char buf[INET_ADDRSTRLEN];
+
+	return inet_ntop(AF_INET, &ia, buf, sizeof(buf));
+}
+
+int pbx_str2tos(const char *value, uint8_t * tos)
+{
+	int fval = 0;
+
+	*tos = (sscanf(value, "%30i", &fval) == 1) ? (uint8_t) (fval & 0xFF) : 0;
+	return *tos;
+}
+
+int pbx_str2cos(const char *value, uint8_t * cos)
+{
+	int fval = 0;
+
+	*cos = (sscanf(value, "%30d", &fval) == 1 && fval < 8) ? (uint8_t) fval : 0;
+	return *cos;
+}
+
+void pbxman_send_listack(struct mansession *s, const struct message *m, char *msg, char *listflag)
+{
+	astman_send_listack(s, m, msg, listflag);
+}
+
+const char *pbx_getformatname_multiple(char *buf, size_t size, struct ast_format_cap *format)
+{
+	sccp_copy_string(buf, "(none)", size);
+	return buf;
+}
+
+int pbx_manager_register(const char *action, int authority, int (*func) (struct mansession * s, const struct message * m), const char *synopsis, const char *description)
+{
+	return 0;
+}
+
+/* ================================================================================================================= host */
+static void sccp_null_destroyLists(void)
+{
+	sccp_null_extensionState_t *state = NULL;
+	sccp_null_dbEntry_t *entry = NULL;
+
+	SCCP_LIST_LOCK(&null_extensionStates);
+	while ((state = SCCP_LIST_REMOVE_HEAD(&null_extensionStates, list))) {
+		sccp_free(state);
+	}
+	SCCP_LIST_UNLOCK(&null_extensionStates);
+	SCCP_LIST_HEAD_DESTROY(&null_extensionStates);
+
+	SCCP_LIST_LOCK(&null_database);
+	while ((entry = SCCP_LIST_REMOVE_HEAD(&null_database, list))) {
+		sccp_null_db_free(entry);
+	}
+	SCCP_LIST_UNLOCK(&null_database);
+	SCCP_LIST_HEAD_DESTROY(&null_database);
+	SCCP_LIST_HEAD_DESTROY(&null_channels);
+}
+
+/*!
+ * \brief Load the channel driver core on top of the null backend (the equivalent of load_module)
+ * \param configfile Path to sccp.conf, its directory is used as the asterisk config directory
+ * \param listen Bind the skinny listener (FALSE for hosts feeding the session layer themselves, like sccp_replay)
+ */
+boolean_t sccp_null_load(const char *configfile, boolean_t listen)
+{
+	char *path = NULL;
+
+	if (null_loaded) {
+		return FALSE;
+	}
+	SCCP_LIST_HEAD_INIT(&null_channels);
+	SCCP_LIST_HEAD_INIT(&null_extensionStates);
+	SCCP_LIST_HEAD_INIT(&null_database);
+	null_loaded = TRUE;
+
+	do {
+		if (!sccp_null_sched_start()) {
+			pbx_log(LOG_ERROR, "Unable to start scheduler\n");
+			break;
+		}
+		if (!sccp_prePBXLoad()) {
+			pbx_log(LOG_ERROR, "SCCP: prePBXLoad Failed\n");
+			break;
+		}
+		if (!sccp_strlen_zero(configfile) && (path = pbx_strdup(configfile))) {
+			char *dir = pbx_strdup(path);
+
+			sccp_null_setPaths(dirname(dir), NULL);
+			GLOB(config_file_name) = pbx_strdup(basename(path));
+			sccp_free(dir);
+			sccp_free(path);
+		}
+		if (!load_config()) {
+			pbx_log(LOG_ERROR, "SCCP: config file could not be parsed\n");
+			break;
+		}
+		if (sccp_register_management()) {
+			pbx_log(LOG_ERROR, "Unable to register management functions");
+			break;
+		}
+		if (sccp_register_cli()) {
+			pbx_log(LOG_ERROR, "Unable to register CLI functions");
+			break;
+		}
+		if (sccp_register_dialplan_functions()) {
+			pbx_log(LOG_ERROR, "Unable to register dialplan functions");
+			break;
+		}
+		if (listen && !sccp_postPBX_load()) {
+			pbx_log(LOG_ERROR, "SCCP: postPBXLoad Failed\n");
+			break;
+		}
+		return TRUE;
+	} while (0);
+
+	pbx_log(LOG_ERROR, "SCCP: Null PBX Load Failed, unloading...\n");
+	sccp_null_unload();
+	return FALSE;
+}
+
+/*!
+ * \brief Unload the channel driver core (the equivalent of unload_module)
+ */
+void sccp_null_unload(void)
+{
+	struct ast_channel *pbx_channel = NULL;
+
+	if (!null_loaded) {
+		return;
+	}
+	pbx_log(LOG_NOTICE, "SCCP: Null PBX Unload\n");
+	if (sccp_globals) {
+		sccp_preUnload();
+		sccp_unregister_dialplan_functions();
+		sccp_unregister_cli();
+		sccp_mwi_module_stop();
+#ifdef CS_SCCP_MANAGER
+		sccp_unregister_management();
+#endif
+		while (SCCP_REF_DESTROYED != sccp_refcount_isRunning()) {
+			usleep(SCCP_TIME_TO_KEEP_REFCOUNTEDOBJECT);						// give enough time for all schedules to end and refcounted object to be cleanup completely
+		}
+	}
+	sccp_null_sched_stop();
+
+	/* channels left behind by calls that never got hungup */
+	SCCP_LIST_LOCK(&null_channels);
+	while ((pbx_channel = SCCP_LIST_REMOVE_HEAD(&null_channels, list))) {
+		ast_channel_unref(pbx_channel);
+	}
+	SCCP_LIST_UNLOCK(&null_channels);
+	sccp_null_destroyLists();
+
+	if (sccp_globals) {
+		sccp_free(sccp_globals);
+	}
+	null_loaded = FALSE;
+}
+
+int sccp_null_channel_count(void)
+{
+	int count;
+
+	SCCP_LIST_LOCK(&null_channels);
+	count = SCCP_LIST_GETSIZE(&null_channels);
+	SCCP_LIST_UNLOCK(&null_channels);
+	return count;
+}
+
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
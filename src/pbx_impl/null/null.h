@@ -0,0 +1,32 @@
+/*!
+ * \file        null.h
+ * \brief       SCCP PBX Null Backend Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * The null backend implements iPbx without a running asterisk: channels live in memory, the scheduler is a single thread, the
+ * configuration is read from a file on disk and device/extension states are kept in a table the host program can update. It is
+ * compiled against the same asterisk headers as the real backend (only the types are used), and is linked together with libsccp
+ * into the standalone benchmark and test hosts under src/standalone.
+ *
+ * Built-in dialplan: an outbound channel dialing the name of a configured line rings that line, everything else is answered as
+ * congested. This is enough to drive register / call / hold / hangup flows from simulated phones.
+ */
+#pragma once
+
+#include "config.h"
+#include "common.h"
+
+__BEGIN_C_EXTERN__
+/* host api */
+SCCP_API boolean_t SCCP_CALL sccp_null_load(const char *configfile, boolean_t listen);
+SCCP_API void SCCP_CALL sccp_null_unload(void);
+SCCP_API void SCCP_CALL sccp_null_setExtensionState(const char *extension, const char *context, skinny_busylampfield_state_t state);
+SCCP_API int SCCP_CALL sccp_null_sched_pending(void);
+SCCP_API int SCCP_CALL sccp_null_channel_count(void);
+
+/* shared between null.c and null_runtime.c */
+SCCP_API void * SCCP_CALL sccp_null_object_alloc(size_t size, void (*destructor)(void *obj));
+SCCP_API void SCCP_CALL sccp_null_setPaths(const char *configDir, const char *varDir);
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
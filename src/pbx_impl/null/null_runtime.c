@@ -0,0 +1,1675 @@
+/*!
+ * \file        null_runtime.c
+ * \brief       SCCP PBX Null Backend Runtime
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * Provides the part of the asterisk runtime the channel driver core calls directly (outside of iPbx): logging, locks, a minimal
+ * astobj2, memory and ast_str helpers, the config file parser, cli/manager/stasis registration and a couple of utility functions.
+ * The signatures follow the asterisk 13 - 15 headers the core is compiled against, see the ASTERISK_VERSION_GROUP guards.
+ *
+ * AST_API_MODULE makes the AST_INLINE_API functions from the asterisk headers (ast_copy_string, ast_tvnow, ast_str_*, ...) available
+ * as out-of-line symbols for unoptimized builds, in the same way main/utils.c does for asterisk itself.
+ */
+#define AST_API_MODULE
+#define ASTMM_LIBC ASTMM_IGNORE
+
+#include <execinfo.h>
+#include <netdb.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "config.h"
+#include "common.h"
+#include "null.h"
+#include "sccp_utils.h"
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#include <asterisk/cli.h>
+#include <asterisk/devicestate.h>
+#include <asterisk/manager.h>
+#include <asterisk/stasis.h>
+#include <asterisk/app.h>
+#include <asterisk/astdb.h>
+#include <asterisk/backtrace.h>
+#undef pthread_create
+
+#define NULL_AO2_MAGIC 0xa70b123
+
+/* runtime services the null backend does not provide: say so on the first call instead of silently changing behaviour */
+#define NULL_UNSUPPORTED(_consequence) do {												\
+	static int _warned = 0;															\
+	if (!__sync_lock_test_and_set(&_warned, 1)) {												\
+		pbx_log(LOG_WARNING, "SCCP: (null runtime) %s is not supported by the null pbx backend, %s\n", __func__, _consequence);		\
+	}																	\
+} while (0)
+
+/* ================================================================================================================ globals */
+static char null_configDir[PATH_MAX] = ".";
+static char null_varDir[PATH_MAX] = ".";
+
+const char *ast_config_AST_CONFIG_DIR = null_configDir;
+const char *ast_config_AST_LOG_DIR = ".";
+const char *ast_config_AST_DATA_DIR = ".";
+const char *ast_config_AST_VAR_DIR = null_varDir;
+
+struct ast_flags ast_options = { 0 };
+int option_verbose = 0;
+int option_debug = 0;
+struct ast_eid ast_eid_default = { {0x00, 0x00, 0x5e, 0x00, 0x53, 0x00} };
+
+void sccp_null_setPaths(const char *configDir, const char *varDir)
+{
+	if (!sccp_strlen_zero(configDir)) {
+		sccp_copy_string(null_configDir, configDir, sizeof(null_configDir));
+	}
+	if (!sccp_strlen_zero(varDir)) {
+		sccp_copy_string(null_varDir, varDir, sizeof(null_varDir));
+	}
+}
+
+#ifdef AST_MODULE_SELF_SYM
+struct ast_module *AST_MODULE_SELF_SYM(void)
+{
+	return NULL;
+}
+#endif
+
+#if ASTERISK_VERSION_GROUP < 114
+void ast_register_file_version(const char *file, const char *version)
+{
+}
+
+void ast_unregister_file_version(const char *file)
+{
+}
+#endif
+
+/* ================================================================================================================ logging */
+static pthread_mutex_t null_log_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *const null_log_levels[] = { "DEBUG", "TRACE", "NOTICE", "WARNING", "ERROR", "VERBOSE", "DTMF" };
+
+static void null_vlog(int level, const char *file, int line, const char *function, const char *fmt, va_list ap)
+{
+	if (level == __LOG_DEBUG && !option_debug) {
+		return;
+	}
+	pthread_mutex_lock(&null_log_lock);
+	if (!sccp_strlen_zero(file)) {
+		fprintf(stderr, "[%s] %s:%d %s: ", (level >= 0 && level < (int) ARRAY_LEN(null_log_levels)) ? null_log_levels[level] : "LOG", file, line, function);
+	}
+	vfprintf(stderr, fmt, ap);
+	pthread_mutex_unlock(&null_log_lock);
+}
+
+void ast_log(int level, const char *file, int line, const char *function, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	null_vlog(level, file, line, function, fmt, ap);
+	va_end(ap);
+}
+
+void __ast_verbose(const char *file, int line, const char *func, int level, const char *fmt, ...)
+{
+	va_list ap;
+
+	if (level > option_verbose) {
+		return;
+	}
+	va_start(ap, fmt);
+	null_vlog(__LOG_VERBOSE, "", 0, "", fmt, ap);
+	va_end(ap);
+}
+
+unsigned int ast_debug_get_by_module(const char *module)
+{
+	return 0;
+}
+
+/* ================================================================================================================== locks */
+int __ast_pthread_mutex_init(int tracking, const char *filename, int lineno, const char *func, const char *mutex_name, ast_mutex_t * t)
+{
+	pthread_mutexattr_t attr;
+	int res;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);						/* asterisk mutexes are recursive */
+	res = pthread_mutex_init(&t->mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+	return res;
+}
+
+int __ast_pthread_mutex_destroy(const char *filename, int lineno, const char *func, const char *mutex_name, ast_mutex_t * t)
+{
+	return pthread_mutex_destroy(&t->mutex);
+}
+
+int __ast_pthread_mutex_lock(const char *filename, int lineno, const char *func, const char *mutex_name, ast_mutex_t * t)
+{
+	return pthread_mutex_lock(&t->mutex);
+}
+
+int __ast_pthread_mutex_trylock(const char *filename, int lineno, const char *func, const char *mutex_name, ast_mutex_t * t)
+{
+	return pthread_mutex_trylock(&t->mutex);
+}
+
+int __ast_pthread_mutex_unlock(const char *filename, int lineno, const char *func, const char *mutex_name, ast_mutex_t * t)
+{
+	return pthread_mutex_unlock(&t->mutex);
+}
+
+int __ast_cond_init(const char *filename, int lineno, const char *func, const char *cond_name, ast_cond_t * cond, pthread_condattr_t * cond_attr)
+{
+	return pthread_cond_init(cond, cond_attr);
+}
+
+int __ast_cond_signal(const char *filename, int lineno, const char *func, const char *cond_name, ast_cond_t * cond)
+{
+	return pthread_cond_signal(cond);
+}
+
+int __ast_cond_broadcast(const char *filename, int lineno, const char *func, const char *cond_name, ast_cond_t * cond)
+{
+	return pthread_cond_broadcast(cond);
+}
+
+int __ast_cond_destroy(const char *filename, int lineno, const char *func, const char *cond_name, ast_cond_t * cond)
+{
+	return pthread_cond_destroy(cond);
+}
+
+int __ast_cond_wait(const char *filename, int lineno, const char *func, const char *cond_name, const char *mutex_name, ast_cond_t * cond, ast_mutex_t * t)
+{
+	return pthread_cond_wait(cond, &t->mutex);
+}
+
+int __ast_cond_timedwait(const char *filename, int lineno, const char *func, const char *cond_name, const char *mutex_name, ast_cond_t * cond, ast_mutex_t * t, const struct timespec *abstime)
+{
+	return pthread_cond_timedwait(cond, &t->mutex, abstime);
+}
+
+int __ast_rwlock_init(int tracking, const char *filename, int lineno, const char *func, const char *rwlock_name, ast_rwlock_t * t)
+{
+	return pthread_rwlock_init(&t->lock, NULL);
+}
+
+int __ast_rwlock_destroy(const char *filename, int lineno, const char *func, const char *rwlock_name, ast_rwlock_t * t)
+{
+	return pthread_rwlock_destroy(&t->lock);
+}
+
+int __ast_rwlock_unlock(const char *filename, int lineno, const char *func, ast_rwlock_t * t, const char *name)
+{
+	return pthread_rwlock_unlock(&t->lock);
+}
+
+int __ast_rwlock_rdlock(const char *filename, int lineno, const char *func, ast_rwlock_t * t, const char *name)
+{
+	return pthread_rwlock_rdlock(&t->lock);
+}
+
+int __ast_rwlock_wrlock(const char *filename, int lineno, const char *func, ast_rwlock_t * t, const char *name)
+{
+	return pthread_rwlock_wrlock(&t->lock);
+}
+
+int __ast_rwlock_tryrdlock(const char *filename, int lineno, const char *func, ast_rwlock_t * t, const char *name)
+{
+	return pthread_rwlock_tryrdlock(&t->lock);
+}
+
+int __ast_rwlock_trywrlock(const char *filename, int lineno, const char *func, ast_rwlock_t * t, const char *name)
+{
+	return pthread_rwlock_trywrlock(&t->lock);
+}
+
+int __ast_rwlock_timedrdlock(const char *filename, int lineno, const char *func, ast_rwlock_t * t, const char *name, const struct timespec *abs_timeout)
+{
+	return pthread_rwlock_timedrdlock(&t->lock, abs_timeout);
+}
+
+int __ast_rwlock_timedwrlock(const char *filename, int lineno, const char *func, ast_rwlock_t * t, const char *name, const struct timespec *abs_timeout)
+{
+	return pthread_rwlock_timedwrlock(&t->lock, abs_timeout);
+}
+
+/* ================================================================================================================ astobj2 */
+/*!
+ * \brief Null astobj2 object header, placed in front of the user data
+ */
+struct null_ao2_header {
+	uint32_t magic;
+	volatile int ref;
+	unsigned int options;											/* AO2_ALLOC_OPT_LOCK_* */
+	union {
+		pthread_mutex_t mutex;
+		pthread_rwlock_t rwlock;
+	} lock;
+	void (*destructor) (void *obj);
+	union {
+		long double ld;
+		void *p;
+		uint64_t u;
+	} data[];												/* keep the user data maximally aligned */
+};
+
+static struct null_ao2_header *null_ao2_header(void *obj)
+{
+	struct null_ao2_header *hdr = NULL;
+
+	if (!obj) {
+		return NULL;
+	}
+	hdr = (struct null_ao2_header *) ((char *) obj - offsetof(struct null_ao2_header, data));
+	if (hdr->magic != NULL_AO2_MAGIC) {
+		pbx_log(LOG_ERROR, "SCCP: (null ao2) bad magic for object %p\n", obj);
+		return NULL;
+	}
+	return hdr;
+}
+
+static void *null_ao2_alloc(size_t size, void (*destructor) (void *obj), unsigned int options)
+{
+	pthread_mutexattr_t attr;
+	struct null_ao2_header *hdr = NULL;
+
+	switch (options & AO2_ALLOC_OPT_LOCK_MASK) {
+		case AO2_ALLOC_OPT_LOCK_MUTEX:
+		case AO2_ALLOC_OPT_LOCK_RWLOCK:
+		case AO2_ALLOC_OPT_LOCK_NOLOCK:
+			break;
+		default:
+			pbx_log(LOG_ERROR, "SCCP: (null ao2) unsupported allocation options 0x%x\n", options);
+			return NULL;
+	}
+	if (!(hdr = calloc(1, sizeof(struct null_ao2_header) + size))) {
+		return NULL;
+	}
+	hdr->magic = NULL_AO2_MAGIC;
+	hdr->ref = 1;
+	hdr->options = options & AO2_ALLOC_OPT_LOCK_MASK;
+	hdr->destructor = destructor;
+	if (hdr->options == AO2_ALLOC_OPT_LOCK_MUTEX) {							/* recursive, like astobj2 */
+		pthread_mutexattr_init(&attr);
+		pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+		pthread_mutex_init(&hdr->lock.mutex, &attr);
+		pthread_mutexattr_destroy(&attr);
+	} else if (hdr->options == AO2_ALLOC_OPT_LOCK_RWLOCK) {
+		pthread_rwlock_init(&hdr->lock.rwlock, NULL);
+	}
+	return hdr->data;
+}
+
+void *sccp_null_object_alloc(size_t size, void (*destructor) (void *obj))
+{
+	return null_ao2_alloc(size, destructor, AO2_ALLOC_OPT_LOCK_MUTEX);
+}
+
+static int null_ao2_ref(void *o, int delta)
+{
+	struct null_ao2_header *hdr = null_ao2_header(o);
+	int prev;
+
+	if (!hdr) {
+		return -1;
+	}
+	if (!delta) {
+		return hdr->ref;
+	}
+	prev = __sync_fetch_and_add(&hdr->ref, delta);
+	if (prev + delta == 0) {
+		if (hdr->destructor) {
+			hdr->destructor(o);
+		}
+		if (hdr->options == AO2_ALLOC_OPT_LOCK_MUTEX) {
+			pthread_mutex_destroy(&hdr->lock.mutex);
+		} else if (hdr->options == AO2_ALLOC_OPT_LOCK_RWLOCK) {
+			pthread_rwlock_destroy(&hdr->lock.rwlock);
+		}
+		hdr->magic = 0;
+		free(hdr);
+	} else if (prev + delta < 0) {
+		pbx_log(LOG_ERROR, "SCCP: (null ao2) refcount of %p dropped below zero\n", o);
+	}
+	return prev;
+}
+
+/* there are no containers in the null runtime (stasis_cache_dump returns NULL), only an iterator without container is empty */
+static void *null_ao2_iterator_next(struct ao2_iterator *iter)
+{
+	if (iter && iter->c) {
+		NULL_UNSUPPORTED("ao2 containers cannot be iterated, returning no objects");
+	}
+	return NULL;
+}
+
+#if ASTERISK_VERSION_GROUP >= 114
+int __ao2_ref(void *o, int delta, const char *tag, const char *file, int line, const char *func)
+{
+	return null_ao2_ref(o, delta);
+}
+
+void *__ao2_alloc(size_t data_size, ao2_destructor_fn destructor_fn, unsigned int options, const char *tag, const char *file, int line, const char *func)
+{
+	return null_ao2_alloc(data_size, destructor_fn, options);
+}
+
+void *__ao2_iterator_next(struct ao2_iterator *iter, const char *tag, const char *file, int line, const char *func)
+{
+	return null_ao2_iterator_next(iter);
+}
+#else
+int __ao2_ref(void *o, int delta)
+{
+	return null_ao2_ref(o, delta);
+}
+
+int __ao2_ref_debug(void *o, int delta, const char *tag, const char *file, int line, const char *func)
+{
+	return null_ao2_ref(o, delta);
+}
+
+void *__ao2_alloc(size_t data_size, ao2_destructor_fn destructor_fn, unsigned int options)
+{
+	return null_ao2_alloc(data_size, destructor_fn, options);
+}
+
+void *__ao2_iterator_next(struct ao2_iterator *iter)
+{
+	return null_ao2_iterator_next(iter);
+}
+
+void *__ao2_iterator_next_debug(struct ao2_iterator *iter, const char *tag, const char *file, int line, const char *func)
+{
+	return null_ao2_iterator_next(iter);
+}
+#endif
+
+void __ao2_cleanup(void *obj)
+{
+	if (obj) {
+		null_ao2_ref(obj, -1);
+	}
+}
+
+void __ao2_cleanup_debug(void *obj, const char *tag, const char *file, int line, const char *function)
+{
+	__ao2_cleanup(obj);
+}
+
+int __ao2_lock(void *a, enum ao2_lock_req lock_how, const char *file, const char *func, int line, const char *var)
+{
+	struct null_ao2_header *hdr = null_ao2_header(a);
+
+	if (!hdr) {
+		return -1;
+	}
+	switch (hdr->options) {
+		case AO2_ALLOC_OPT_LOCK_MUTEX:
+			return pthread_mutex_lock(&hdr->lock.mutex);
+		case AO2_ALLOC_OPT_LOCK_RWLOCK:
+			return (lock_how == AO2_LOCK_REQ_RDLOCK) ? pthread_rwlock_rdlock(&hdr->lock.rwlock) : pthread_rwlock_wrlock(&hdr->lock.rwlock);
+		default:
+			return 0;
+	}
+}
+
+int __ao2_trylock(void *a, enum ao2_lock_req lock_how, const char *file, const char *func, int line, const char *var)
+{
+	struct null_ao2_header *hdr = null_ao2_header(a);
+
+	if (!hdr) {
+		return -1;
+	}
+	switch (hdr->options) {
+		case AO2_ALLOC_OPT_LOCK_MUTEX:
+			return pthread_mutex_trylock(&hdr->lock.mutex);
+		case AO2_ALLOC_OPT_LOCK_RWLOCK:
+			return (lock_how == AO2_LOCK_REQ_RDLOCK) ? pthread_rwlock_tryrdlock(&hdr->lock.rwlock) : pthread_rwlock_trywrlock(&hdr->lock.rwlock);
+		default:
+			return 0;
+	}
+}
+
+int __ao2_unlock(void *a, const char *file, const char *func, int line, const char *var)
+{
+	struct null_ao2_header *hdr = null_ao2_header(a);
+
+	if (!hdr) {
+		return -1;
+	}
+	switch (hdr->options) {
+		case AO2_ALLOC_OPT_LOCK_MUTEX:
+			return pthread_mutex_unlock(&hdr->lock.mutex);
+		case AO2_ALLOC_OPT_LOCK_RWLOCK:
+			return pthread_rwlock_unlock(&hdr->lock.rwlock);
+		default:
+			return 0;
+	}
+}
+
+struct ao2_iterator ao2_iterator_init(struct ao2_container *c, int flags)
+{
+	struct ao2_iterator iter;
+
+	if (c) {
+		NULL_UNSUPPORTED("ao2 containers cannot be iterated");
+	}
+	memset(&iter, 0, sizeof(iter));
+	iter.c = c;
+	iter.flags = flags;
+	return iter;
+}
+
+void ao2_iterator_destroy(struct ao2_iterator *iter)
+{
+}
+
+/* ================================================================================================================= memory */
+#if ASTERISK_VERSION_GROUP >= 115
+void *__ast_malloc(size_t size, const char *file, int lineno, const char *func)
+{
+	return malloc(size);
+}
+
+void *__ast_calloc(size_t nmemb, size_t size, const char *file, int lineno, const char *func)
+{
+	return calloc(nmemb, size);
+}
+
+void *__ast_calloc_cache(size_t nmemb, size_t size, const char *file, int lineno, const char *func)
+{
+	return calloc(nmemb, size);
+}
+
+void *__ast_realloc(void *ptr, size_t size, const char *file, int lineno, const char *func)
+{
+	return realloc(ptr, size);
+}
+
+char *__ast_strdup(const char *s, const char *file, int lineno, const char *func)
+{
+	return s ? strdup(s) : NULL;
+}
+
+char *__ast_strndup(const char *s, size_t n, const char *file, int lineno, const char *func)
+{
+	return s ? strndup(s, n) : NULL;
+}
+
+int __ast_vasprintf(char **strp, const char *format, va_list ap, const char *file, int lineno, const char *func)
+{
+	int res = vasprintf(strp, format, ap);
+
+	if (res < 0) {
+		*strp = NULL;
+	}
+	return res;
+}
+
+int __ast_asprintf(const char *file, int lineno, const char *func, char **strp, const char *format, ...)
+{
+	va_list ap;
+	int res;
+
+	va_start(ap, format);
+	res = __ast_vasprintf(strp, format, ap, file, lineno, func);
+	va_end(ap);
+	return res;
+}
+
+void __ast_free(void *ptr, const char *file, int lineno, const char *func)
+{
+	free(ptr);
+}
+
+void ast_std_free(void *ptr)
+{
+	free(ptr);
+}
+#endif
+
+/* ================================================================================================================ strings */
+#if ASTERISK_VERSION_GROUP >= 115
+int __ast_str_helper(struct ast_str **buf, ssize_t max_len, int append, const char *fmt, va_list ap, const char *file, int lineno, const char *function)
+#else
+int __ast_str_helper(struct ast_str **buf, ssize_t max_len, int append, const char *fmt, va_list ap)
+#endif
+{
+	int res;
+	int need;
+	int offset = (append && (*buf)->__AST_STR_LEN) ? (*buf)->__AST_STR_USED : 0;
+	va_list aq;
+
+	if (max_len < 0) {
+		max_len = (*buf)->__AST_STR_LEN;							/* don't exceed the allocated space */
+	}
+	do {
+		va_copy(aq, ap);
+		res = vsnprintf((*buf)->__AST_STR_STR + offset, (*buf)->__AST_STR_LEN - offset, fmt, aq);
+		va_end(aq);
+
+		if (res < 0) {
+			return AST_DYNSTR_BUILD_FAILED;
+		}
+		need = res + offset + 1;
+		if (need > (int) (*buf)->__AST_STR_LEN && (max_len == 0 || (int) (*buf)->__AST_STR_LEN < max_len)) {
+			if (max_len && max_len < need) {
+				need = max_len;
+			} else if (max_len == 0) {
+				need += 16 + need / 4;
+			}
+			if (ast_str_make_space(buf, need)) {
+				return AST_DYNSTR_BUILD_FAILED;
+			}
+			(*buf)->__AST_STR_STR[offset] = '\0';
+			continue;										/* try again with the larger buffer */
+		}
+		break;
+	} while (1);
+	if (res > (int) (*buf)->__AST_STR_LEN - offset - 1) {
+		res = (*buf)->__AST_STR_LEN - offset - 1;
+	}
+	(*buf)->__AST_STR_USED = res + offset;
+	return res;
+}
+
+char *__ast_str_helper2(struct ast_str **buf, ssize_t maxlen, const char *src, size_t maxsrc, int append, int escapecommas)
+{
+	int dynamic = 0;
+	char *ptr = append ? &((*buf)->__AST_STR_STR[(*buf)->__AST_STR_USED]) : (*buf)->__AST_STR_STR;
+
+	if (maxlen < 1) {
+		if (maxlen == 0) {
+			dynamic = 1;
+		}
+		maxlen = (*buf)->__AST_STR_LEN;
+	}
+	while (*src && maxsrc && maxlen && (!escapecommas || (maxlen - 1))) {
+		if (escapecommas && (*src == '\\' || *src == ',')) {
+			*ptr++ = '\\';
+			maxlen--;
+			(*buf)->__AST_STR_USED++;
+		}
+		*ptr++ = *src++;
+		maxsrc--;
+		maxlen--;
+		(*buf)->__AST_STR_USED++;
+
+		if ((ptr >= (*buf)->__AST_STR_STR + (*buf)->__AST_STR_LEN - 3) || (dynamic && (!maxlen || (escapecommas && !(maxlen - 1))))) {
+			char *oldbase = (*buf)->__AST_STR_STR;
+			size_t old = (*buf)->__AST_STR_LEN;
+
+			if (ast_str_make_space(buf, (*buf)->__AST_STR_LEN * 2)) {
+				break;
+			}
+			maxlen = old;
+			ptr += (*buf)->__AST_STR_STR - oldbase;
+		}
+	}
+	if (!maxlen) {
+		ptr--;
+	}
+	*ptr = '\0';
+	return (*buf)->__AST_STR_STR;
+}
+
+int ast_build_string_va(char **buffer, size_t * space, const char *fmt, va_list ap)
+{
+	int result;
+
+	if (!buffer || !*buffer || !space || !*space) {
+		return -1;
+	}
+	result = vsnprintf(*buffer, *space, fmt, ap);
+	if (result < 0) {
+		return -1;
+	} else if (result > (int) *space) {
+		result = *space;
+	}
+	*buffer += result;
+	*space -= result;
+	return 0;
+}
+
+int ast_build_string(char **buffer, size_t * space, const char *fmt, ...)
+{
+	va_list ap;
+	int result;
+
+	va_start(ap, fmt);
+	result = ast_build_string_va(buffer, space, fmt, ap);
+	va_end(ap);
+	return result;
+}
+
+int ast_true(const char *s)
+{
+	if (sccp_strlen_zero(s)) {
+		return 0;
+	}
+	if (!strcasecmp(s, "yes") || !strcasecmp(s, "true") || !strcasecmp(s, "y") || !strcasecmp(s, "t") || !strcasecmp(s, "1") || !strcasecmp(s, "on")) {
+		return -1;
+	}
+	return 0;
+}
+
+int ast_false(const char *s)
+{
+	if (sccp_strlen_zero(s)) {
+		return 0;
+	}
+	if (!strcasecmp(s, "no") || !strcasecmp(s, "false") || !strcasecmp(s, "n") || !strcasecmp(s, "f") || !strcasecmp(s, "0") || !strcasecmp(s, "off")) {
+		return -1;
+	}
+	return 0;
+}
+
+char *ast_print_group(char *buf, int buflen, ast_group_t group)
+{
+	unsigned int i;
+	int len = 0;
+
+	buf[0] = '\0';
+	for (i = 0; i <= 63 && len < buflen; i++) {
+		if (group & ((ast_group_t) 1 << i)) {
+			len += snprintf(buf + len, buflen - len, "%s%u", len ? ", " : "", i);
+		}
+	}
+	return buf;
+}
+
+int ast_callerid_parse(char *instr, char **name, char **location)
+{
+	char *ls = NULL, *le = NULL;
+
+	*name = *location = NULL;
+	if ((ls = strrchr(instr, '<')) && (le = strrchr(ls, '>'))) {
+		*le = '\0';
+		*ls = '\0';
+		*location = ls + 1;
+		*name = ast_strip_quoted(ast_strip(instr), "\"", "\"");
+		if (sccp_strlen_zero(*name)) {
+			*name = NULL;
+		}
+	} else {
+		*location = ast_strip(instr);
+	}
+	return 0;
+}
+
+/* ============================================================================================================ time/thread */
+struct timeval ast_tvadd(struct timeval a, struct timeval b)
+{
+	a.tv_sec += b.tv_sec;
+	a.tv_usec += b.tv_usec;
+	if (a.tv_usec >= 1000000) {
+		a.tv_sec++;
+		a.tv_usec -= 1000000;
+	}
+	return a;
+}
+
+struct timeval ast_tvsub(struct timeval a, struct timeval b)
+{
+	a.tv_sec -= b.tv_sec;
+	a.tv_usec -= b.tv_usec;
+	if (a.tv_usec < 0) {
+		a.tv_sec--;
+		a.tv_usec += 1000000;
+	}
+	return a;
+}
+
+long int ast_random(void)
+{
+	static pthread_mutex_t randomlock = PTHREAD_MUTEX_INITIALIZER;
+	long int res;
+
+	pthread_mutex_lock(&randomlock);
+	res = random();
+	pthread_mutex_unlock(&randomlock);
+	return res;
+}
+
+int ast_get_tid(void)
+{
+	return (int) syscall(SYS_gettid);
+}
+
+static int null_pthread_create(pthread_t * thread, pthread_attr_t * attr, void *(*start_routine) (void *), void *data, size_t stacksize, boolean_t detached)
+{
+	pthread_attr_t lattr;
+	int res;
+
+	if (!attr) {
+		pthread_attr_init(&lattr);
+		attr = &lattr;
+	}
+	if (stacksize) {
+		pthread_attr_setstacksize(attr, stacksize < PTHREAD_STACK_MIN ? PTHREAD_STACK_MIN : stacksize);
+	}
+	if (detached) {
+		pthread_attr_setdetachstate(attr, PTHREAD_CREATE_DETACHED);
+	}
+	res = pthread_create(thread, attr, start_routine, data);
+	if (attr == &lattr) {
+		pthread_attr_destroy(&lattr);
+	}
+	return res;
+}
+
+int ast_pthread_create_stack(pthread_t * thread, pthread_attr_t * attr, void *(*start_routine) (void *), void *data, size_t stacksize, const char *file, const char *caller, int line, const char *start_fn)
+{
+	return null_pthread_create(thread, attr, start_routine, data, stacksize, FALSE);
+}
+
+int ast_pthread_create_detached_stack(pthread_t * thread, pthread_attr_t * attr, void *(*start_routine) (void *), void *data, size_t stacksize, const char *file, const char *caller, int line, const char *start_fn)
+{
+	return null_pthread_create(thread, attr, start_routine, data, stacksize, TRUE);
+}
+
+char *ast_utils_which(const char *binary, char *fullpath, size_t fullpath_size)
+{
+	const char *envPATH = getenv("PATH");
+	char *tpath = NULL, *path = NULL, *saveptr = NULL;
+	struct stat unused;
+
+	if (!envPATH || !(tpath = pbx_strdup(envPATH))) {
+		return NULL;
+	}
+	for (path = strtok_r(tpath, ":", &saveptr); path; path = strtok_r(NULL, ":", &saveptr)) {
+		snprintf(fullpath, fullpath_size, "%s/%s", path, binary);
+		if (!stat(fullpath, &unused) && !access(fullpath, X_OK)) {
+			sccp_free(tpath);
+			return fullpath;
+		}
+	}
+	sccp_free(tpath);
+	return NULL;
+}
+
+#ifdef ast_bt_get_symbols
+char **__ast_bt_get_symbols(void **addresses, size_t num_frames)
+#else
+char **ast_bt_get_symbols(void **addresses, size_t num_frames)
+#endif
+{
+	return backtrace_symbols(addresses, num_frames);
+}
+
+struct hostent *ast_gethostbyname(const char *host, struct ast_hostent *hp)
+{
+	struct hostent *result = NULL;
+	int herrno = 0;
+
+	if (gethostbyname_r(host, &hp->hp, hp->buf, sizeof(hp->buf), &result, &herrno) || !result || !hp->hp.h_addr_list[0]) {
+		return NULL;
+	}
+	return &hp->hp;
+}
+
+char *ast_eid_to_str(char *s, int maxlen, struct ast_eid *eid)
+{
+	snprintf(s, maxlen, "%02hhx:%02hhx:%02hhx:%02hhx:%02hhx:%02hhx", eid->eid[0], eid->eid[1], eid->eid[2], eid->eid[3], eid->eid[4], eid->eid[5]);
+	return s;
+}
+
+int ast_eid_cmp(const struct ast_eid *eid1, const struct ast_eid *eid2)
+{
+	return memcmp(eid1, eid2, sizeof(*eid1));
+}
+
+const char *ast_get_version(void)
+{
+	return "null";
+}
+
+void ast_update_use_count(void)
+{
+}
+
+/* ================================================================================================================= config */
+/*!
+ * \brief Config Category (opaque in the asterisk headers)
+ */
+struct ast_category {
+	char name[80];												/*!< Category Name */
+	int ignored;												/*!< Template (!) */
+	int lineno;												/*!< Line Number */
+	char *file;												/*!< File the category was read from */
+	struct ast_variable *root;										/*!< First Variable */
+	struct ast_variable *last;										/*!< Last Variable */
+	struct ast_category *next;										/*!< Next Category */
+};
+
+/*!
+ * \brief Config (opaque in the asterisk headers)
+ */
+struct ast_config {
+	struct ast_category *root;										/*!< First Category */
+	struct ast_category *last;										/*!< Last Category */
+	struct ast_category *current;										/*!< Category being parsed */
+	int include_level;											/*!< Current #include depth */
+	int max_include_level;											/*!< Maximum #include depth */
+};
+
+/*!
+ * \brief Last modification time seen by ast_config_load2, per file and requester (for CONFIG_FLAG_FILEUNCHANGED)
+ */
+struct null_config_mtime {
+	char *filename;
+	char *who_asked;
+	time_t mtime;
+	struct null_config_mtime *next;
+};
+
+static struct null_config_mtime *null_config_mtimes;
+static pthread_mutex_t null_config_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#ifdef ast_variable_new
+struct ast_variable *_ast_variable_new(const char *name, const char *value, const char *filename, const char *file, const char *func, int lineno)
+#else
+struct ast_variable *ast_variable_new(const char *name, const char *value, const char *filename)
+#endif
+{
+	struct ast_variable *variable = NULL;
+	size_t name_len = strlen(name) + 1;
+	size_t val_len = strlen(value) + 1;
+	size_t fn_len = strlen(filename) + 1;
+	char *dst = NULL;
+
+	if ((variable = calloc(1, sizeof(struct ast_variable) + name_len + val_len + fn_len))) {
+		dst = variable->stuff;
+		memcpy(dst, name, name_len);
+		variable->name = dst;
+		dst += name_len;
+		memcpy(dst, value, val_len);
+		variable->value = dst;
+		dst += val_len;
+		memcpy(dst, filename, fn_len);
+		variable->file = dst;
+	}
+	return variable;
+}
+
+void ast_variables_destroy(struct ast_variable *var)
+{
+	struct ast_variable *vn = NULL;
+
+	while (var) {
+		vn = var;
+		var = var->next;
+		free(vn);
+	}
+}
+
+void ast_variable_append(struct ast_category *category, struct ast_variable *variable)
+{
+	if (!variable) {
+		return;
+	}
+	if (category->last) {
+		category->last->next = variable;
+	} else {
+		category->root = variable;
+	}
+	category->last = variable;
+	while (category->last->next) {
+		category->last = category->last->next;
+	}
+}
+
+struct ast_config *ast_config_new(void)
+{
+	struct ast_config *config = calloc(1, sizeof(struct ast_config));
+
+	if (config) {
+		config->max_include_level = 10;
+	}
+	return config;
+}
+
+struct ast_category *ast_category_new(const char *name, const char *in_file, int lineno)
+{
+	struct ast_category *category = calloc(1, sizeof(struct ast_category));
+
+	if (category) {
+		sccp_copy_string(category->name, name, sizeof(category->name));
+		category->file = strdup(S_OR(in_file, ""));
+		category->lineno = lineno;
+	}
+	return category;
+}
+
+void ast_category_append(struct ast_config *config, struct ast_category *category)
+{
+	if (config->last) {
+		config->last->next = category;
+	} else {
+		config->root = category;
+	}
+	config->last = category;
+	config->current = category;
+}
+
+static struct ast_category *null_category_get(const struct ast_config *config, const char *category_name, boolean_t templates)
+{
+	struct ast_category *cat = NULL;
+
+	for (cat = config->root; cat; cat = cat->next) {
+		if ((templates || !cat->ignored) && !strcasecmp(cat->name, category_name)) {
+			return cat;
+		}
+	}
+	return NULL;
+}
+
+static void null_category_destroy(struct ast_category *cat)
+{
+	ast_variables_destroy(cat->root);
+	free(cat->file);
+	free(cat);
+}
+
+void ast_config_destroy(struct ast_config *config)
+{
+	struct ast_category *cat = NULL, *catn = NULL;
+
+	if (!config) {
+		return;
+	}
+	for (cat = config->root; cat; cat = catn) {
+		catn = cat->next;
+		null_category_destroy(cat);
+	}
+	free(config);
+}
+
+char *ast_category_browse(struct ast_config *config, const char *prev_name)
+{
+	struct ast_category *cat = config->root;
+
+	if (prev_name) {
+		for (; cat && (cat->name != prev_name && strcasecmp(cat->name, prev_name)); cat = cat->next);
+		if (cat) {
+			cat = cat->next;
+		}
+	}
+	for (; cat && cat->ignored; cat = cat->next);
+	return cat ? cat->name : NULL;
+}
+
+struct ast_variable *ast_variable_browse(const struct ast_config *config, const char *category_name)
+{
+	struct ast_category *cat = null_category_get(config, category_name, FALSE);
+
+	return cat ? cat->root : NULL;
+}
+
+const char *ast_variable_retrieve(struct ast_config *config, const char *category, const char *variable)
+{
+	struct ast_variable *v = NULL;
+	struct ast_category *cat = NULL;
+
+	if (category) {
+		for (v = ast_variable_browse(config, category); v; v = v->next) {
+			if (!strcasecmp(variable, v->name)) {
+				return v->value;
+			}
+		}
+		return NULL;
+	}
+	for (cat = config->root; cat; cat = cat->next) {
+		for (v = cat->root; v; v = v->next) {
+			if (!strcasecmp(variable, v->name)) {
+				return v->value;
+			}
+		}
+	}
+	return NULL;
+}
+
+static void null_config_path(const char *filename, char *path, size_t pathlen)
+{
+	if (filename[0] == '/') {
+		sccp_copy_string(path, filename, pathlen);
+	} else {
+		snprintf(path, pathlen, "%s/%s", ast_config_AST_CONFIG_DIR, filename);
+	}
+}
+
+/*!
+ * \brief Strip ';' comments (unless escaped as '\;') and handle ';-- --;' block comments
+ */
+static char *null_config_strip_comments(char *line, int *comment_level)
+{
+	char *src = line, *dst = line;
+
+	while (*src) {
+		if (*comment_level) {
+			if (src[0] == '-' && src[1] == '-' && src[2] == ';') {
+				(*comment_level)--;
+				src += 3;
+			} else {
+				src++;
+			}
+			continue;
+		}
+		if (src[0] == ';') {
+			if (src[1] == '-' && src[2] == '-') {
+				(*comment_level)++;
+				src += 3;
+				continue;
+			}
+			break;
+		}
+		if (src[0] == '\\' && src[1] == ';') {
+			src++;
+		}
+		*dst++ = *src++;
+	}
+	*dst = '\0';
+	return ast_strip(line);
+}
+
+static int null_config_text_file_load(struct ast_config *cfg, const char *filename);
+
+/*!
+ * \brief Handle a [category](options) line
+ */
+static int null_config_category(struct ast_config *cfg, char *cur, const char *file, int lineno)
+{
+	struct ast_category *newcat = NULL, *base = NULL;
+	struct ast_variable *var = NULL, *tail = NULL;
+	char *catname = cur + 1, *options = NULL, *c = NULL, *cur2 = NULL;
+
+	if (!(c = strchr(catname, ']'))) {
+		pbx_log(LOG_WARNING, "parse error: no closing ']', line %d of %s\n", lineno, file);
+		return -1;
+	}
+	*c++ = '\0';
+	if (*c == '(' && (options = c + 1) && (c = strchr(options, ')'))) {
+		*c = '\0';
+	} else {
+		options = NULL;
+	}
+	if (options && strchr(options, '+')) {									/* append to an existing category */
+		if (!(newcat = null_category_get(cfg, catname, TRUE))) {
+			pbx_log(LOG_WARNING, "Unable to append to non-existent category '%s', line %d of %s\n", catname, lineno, file);
+			return -1;
+		}
+		cfg->current = newcat;
+		return 0;
+	}
+	if (!(newcat = ast_category_new(catname, file, lineno))) {
+		return -1;
+	}
+	ast_category_append(cfg, newcat);
+	while (options && (cur2 = strsep(&options, ","))) {
+		cur2 = ast_strip(cur2);
+		if (!strcasecmp(cur2, "!")) {
+			newcat->ignored = 1;
+		} else if (!sccp_strlen_zero(cur2)) {							/* inherit the variables of a (template) category */
+			if (!(base = null_category_get(cfg, cur2, TRUE))) {
+				pbx_log(LOG_WARNING, "Inheritance requested, but category '%s' does not exist, line %d of %s\n", cur2, lineno, file);
+				return -1;
+			}
+			for (var = base->root; var; var = var->next) {
+				if ((tail = ast_variable_new(var->name, var->value, var->file))) {
+					tail->lineno = var->lineno;
+					tail->object = var->object;
+					tail->inherited = 1;
+					ast_variable_append(newcat, tail);
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+/*!
+ * \brief Handle a #include directive
+ */
+static int null_config_directive(struct ast_config *cfg, char *cur, const char *file, int lineno)
+{
+	char *arg = cur + 1, *c = NULL;
+
+	for (c = arg; *c && !isspace(*c); c++);
+	if (*c) {
+		*c++ = '\0';
+	}
+	c = ast_strip_quoted(ast_strip(c), "\"<", "\">");
+	if (!strcasecmp(arg, "include") || !strcasecmp(arg, "tryinclude")) {
+		if (sccp_strlen_zero(c)) {
+			pbx_log(LOG_WARNING, "Directive '#%s' needs an argument, line %d of %s\n", arg, lineno, file);
+			return 0;
+		}
+		if (cfg->include_level >= cfg->max_include_level) {
+			pbx_log(LOG_WARNING, "Maximum Include level (%d) exceeded, line %d of %s\n", cfg->max_include_level, lineno, file);
+			return -1;
+		}
+		cfg->include_level++;
+		if (null_config_text_file_load(cfg, c) < 0 && !strcasecmp(arg, "include")) {
+			cfg->include_level--;
+			return -1;
+		}
+		cfg->include_level--;
+		return 0;
+	}
+	pbx_log(LOG_WARNING, "Unsupported directive '#%s' (null pbx), line %d of %s\n", arg, lineno, file);
+	return 0;
+}
+
+/*!
+ * \brief Handle a name = value or name => value line
+ */
+static int null_config_variable(struct ast_config *cfg, char *cur, const char *file, int lineno)
+{
+	struct ast_variable *v = NULL;
+	char *c = NULL;
+	int object = 0;
+
+	if (!cfg->current) {
+		pbx_log(LOG_WARNING, "parse error: No category context for line %d of %s\n", lineno, file);
+		return -1;
+	}
+	if (!(c = strchr(cur, '='))) {
+		pbx_log(LOG_WARNING, "No '=' (equal sign) in line %d of %s\n", lineno, file);
+		return 0;
+	}
+	*c++ = '\0';
+	if (*c == '>') {
+		object = 1;
+		c++;
+	}
+	if ((v = ast_variable_new(ast_strip(cur), ast_strip(c), file))) {
+		v->lineno = lineno;
+		v->object = object;
+		ast_variable_append(cfg->current, v);
+		return 0;
+	}
+	return -1;
+}
+
+static int null_config_text_file_load(struct ast_config *cfg, const char *filename)
+{
+	char path[PATH_MAX];
+	char buf[8192];
+	char *cur = NULL;
+	FILE *f = NULL;
+	int lineno = 0, comment_level = 0, res = 0;
+
+	null_config_path(filename, path, sizeof(path));
+	if (!(f = fopen(path, "r"))) {
+		return -1;
+	}
+	while (!res && fgets(buf, sizeof(buf), f)) {
+		lineno++;
+		cur = null_config_strip_comments(buf, &comment_level);
+		if (sccp_strlen_zero(cur)) {
+			continue;
+		}
+		if (*cur == '[') {
+			res = null_config_category(cfg, cur, path, lineno);
+		} else if (*cur == '#') {
+			res = null_config_directive(cfg, cur, path, lineno);
+		} else {
+			res = null_config_variable(cfg, cur, path, lineno);
+		}
+	}
+	fclose(f);
+	return res ? -2 : 0;
+}
+
+/*!
+ * \brief check (and record) the modification time of a config file
+ * \return TRUE when the file did not change since the previous load by the same requester
+ */
+static boolean_t null_config_unchanged(const char *path, const char *who_asked, time_t mtime, boolean_t update)
+{
+	struct null_config_mtime *entry = NULL;
+	boolean_t unchanged = FALSE;
+
+	pthread_mutex_lock(&null_config_lock);
+	for (entry = null_config_mtimes; entry; entry = entry->next) {
+		if (!strcmp(entry->filename, path) && !strcmp(entry->who_asked, who_asked)) {
+			break;
+		}
+	}
+	if (entry) {
+		unchanged = (entry->mtime == mtime) ? TRUE : FALSE;
+		if (update) {
+			entry->mtime = mtime;
+		}
+	} else if (update && (entry = calloc(1, sizeof(struct null_config_mtime)))) {
+		entry->filename = strdup(path);
+		entry->who_asked = strdup(who_asked);
+		entry->mtime = mtime;
+		entry->next = null_config_mtimes;
+		null_config_mtimes = entry;
+	}
+	pthread_mutex_unlock(&null_config_lock);
+	return unchanged;
+}
+
+struct ast_config *ast_config_load2(const char *filename, const char *who_asked, struct ast_flags flags)
+{
+	struct ast_config *cfg = NULL;
+	struct stat statbuf;
+	char path[PATH_MAX];
+	int res;
+
+	null_config_path(filename, path, sizeof(path));
+	if (stat(path, &statbuf)) {
+		return CONFIG_STATUS_FILEMISSING;
+	}
+	if (ast_test_flag(&flags, CONFIG_FLAG_FILEUNCHANGED) && null_config_unchanged(path, S_OR(who_asked, ""), statbuf.st_mtime, FALSE)) {
+		return CONFIG_STATUS_FILEUNCHANGED;
+	}
+	if (!(cfg = ast_config_new())) {
+		return NULL;
+	}
+	if ((res = null_config_text_file_load(cfg, filename)) < 0) {
+		ast_config_destroy(cfg);
+		return (res == -1) ? CONFIG_STATUS_FILEMISSING : CONFIG_STATUS_FILEINVALID;
+	}
+	null_config_unchanged(path, S_OR(who_asked, ""), statbuf.st_mtime, TRUE);
+	return cfg;
+}
+
+/* realtime is not available */
+int ast_check_realtime(const char *family)
+{
+	return 0;
+}
+
+struct ast_variable *ast_load_realtime(const char *family, ...)
+{
+	NULL_UNSUPPORTED("realtime lookups find nothing");
+	return NULL;
+}
+
+struct ast_config *ast_load_realtime_multientry(const char *family, ...)
+{
+	NULL_UNSUPPORTED("realtime lookups find nothing");
+	return NULL;
+}
+
+/* ==================================================================================================================== cli */
+void ast_cli(int fd, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vdprintf(fd, fmt, ap);
+	va_end(ap);
+}
+
+#ifdef ast_cli_register
+int __ast_cli_register(struct ast_cli_entry *e, struct ast_module *mod)
+#else
+int ast_cli_register(struct ast_cli_entry *e)
+#endif
+{
+	NULL_UNSUPPORTED("cli commands are not reachable");
+	return 0;
+}
+
+int ast_cli_unregister(struct ast_cli_entry *e)
+{
+	return 0;
+}
+
+/* ================================================================================================================ manager */
+void astman_append(struct mansession *s, const char *fmt, ...)
+{
+}
+
+const char *astman_get_header(const struct message *m, char *var)
+{
+	size_t len = strlen(var);
+	unsigned int x;
+	const char *value = NULL;
+
+	for (x = 0; x < m->hdrcount; x++) {
+		const char *h = m->headers[x];
+
+		if (!strncasecmp(var, h, len) && h[len] == ':') {
+			value = ast_skip_blanks(h + len + 1);
+			return value;
+		}
+	}
+	return "";
+}
+
+void astman_send_ack(struct mansession *s, const struct message *m, char *msg)
+{
+}
+
+void astman_send_error(struct mansession *s, const struct message *m, char *error)
+{
+}
+
+void astman_send_error_va(struct mansession *s, const struct message *m, const char *fmt, ...)
+{
+}
+
+void astman_send_listack(struct mansession *s, const struct message *m, char *msg, char *listflag)
+{
+}
+
+void __ast_manager_event_multichan(int category, const char *event, int chancount, struct ast_channel **chans, const char *file, int line, const char *func, const char *contents, ...)
+{
+	NULL_UNSUPPORTED("manager events are dropped");
+}
+
+void ast_manager_register_hook(struct manager_custom_hook *hook)
+{
+	NULL_UNSUPPORTED("manager actions cannot be sent");
+}
+
+void ast_manager_unregister_hook(struct manager_custom_hook *hook)
+{
+}
+
+int ast_hook_send_action(struct manager_custom_hook *hook, const char *msg)
+{
+	NULL_UNSUPPORTED("manager actions cannot be sent");
+	return -1;
+}
+
+int ast_manager_unregister(const char *action)
+{
+	return 0;
+}
+
+/* ================================================================================================================= stasis */
+/* there is no message bus, subscriptions succeed but never deliver */
+static int null_subscription;
+
+#ifdef stasis_subscribe
+struct stasis_subscription *__stasis_subscribe(struct stasis_topic *topic, stasis_subscription_cb callback, void *data, const char *file, int lineno, const char *func)
+#else
+struct stasis_subscription *stasis_subscribe(struct stasis_topic *topic, stasis_subscription_cb callback, void *data)
+#endif
+{
+	NULL_UNSUPPORTED("subscriptions never deliver");
+	return (struct stasis_subscription *) &null_subscription;
+}
+
+struct stasis_subscription *stasis_unsubscribe_and_join(struct stasis_subscription *subscription)
+{
+	return NULL;
+}
+
+void *stasis_message_data(const struct stasis_message *msg)
+{
+	return NULL;
+}
+
+struct stasis_message_type *stasis_message_type(const struct stasis_message *msg)
+{
+	return NULL;
+}
+
+struct ao2_container *stasis_cache_dump(struct stasis_cache *cache, struct stasis_message_type *type)
+{
+	NULL_UNSUPPORTED("the stasis cache is always empty");
+	return NULL;
+}
+
+struct stasis_topic *ast_device_state_topic(const char *device)
+{
+	return NULL;
+}
+
+struct stasis_message_type *ast_device_state_message_type(void)
+{
+	return NULL;
+}
+
+struct stasis_topic *ast_mwi_topic(const char *uniqueid)
+{
+	return NULL;
+}
+
+struct stasis_topic *ast_mwi_topic_all(void)
+{
+	return NULL;
+}
+
+struct stasis_message_type *ast_mwi_state_type(void)
+{
+	return NULL;
+}
+
+struct stasis_cache *ast_mwi_state_cache(void)
+{
+	return NULL;
+}
+
+int ast_app_inboxcount(const char *mailboxes, int *newmsgs, int *oldmsgs)
+{
+	NULL_UNSUPPORTED("all mailboxes are reported empty");
+	*newmsgs = *oldmsgs = 0;
+	return 0;
+}
+
+/* ============================================================================================================ devicestate */
+/*!
+ * \brief Device State Entry (ast_devstate_changed)
+ */
+struct null_devstate {
+	char *device;
+	enum ast_device_state state;
+	struct null_devstate *next;
+};
+
+static struct null_devstate *null_devstates;
+static pthread_mutex_t null_devstate_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int ast_devstate_changed_literal(enum ast_device_state state, enum ast_devstate_cache cachable, const char *device)
+{
+	struct null_devstate *entry = NULL;
+
+	pthread_mutex_lock(&null_devstate_lock);
+	for (entry = null_devstates; entry && strcasecmp(entry->device, device); entry = entry->next);
+	if (!entry && (entry = calloc(1, sizeof(struct null_devstate)))) {
+		entry->device = strdup(device);
+		entry->next = null_devstates;
+		null_devstates = entry;
+	}
+	if (entry) {
+		entry->state = state;
+	}
+	pthread_mutex_unlock(&null_devstate_lock);
+	return 0;
+}
+
+int ast_devstate_changed(enum ast_device_state state, enum ast_devstate_cache cachable, const char *fmt, ...)
+{
+	char buf[AST_MAX_EXTENSION];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+	return ast_devstate_changed_literal(state, cachable, buf);
+}
+
+enum ast_device_state ast_device_state(const char *device)
+{
+	struct null_devstate *entry = NULL;
+	enum ast_device_state state = AST_DEVICE_UNKNOWN;
+
+	pthread_mutex_lock(&null_devstate_lock);
+	for (entry = null_devstates; entry && strcasecmp(entry->device, device); entry = entry->next);
+	if (entry) {
+		state = entry->state;
+	}
+	pthread_mutex_unlock(&null_devstate_lock);
+	return state;
+}
+
+const char *ast_devstate_str(enum ast_device_state state)
+{
+	switch (state) {
+		case AST_DEVICE_NOT_INUSE:
+			return "NOT_INUSE";
+		case AST_DEVICE_INUSE:
+			return "INUSE";
+		case AST_DEVICE_BUSY:
+			return "BUSY";
+		case AST_DEVICE_INVALID:
+			return "INVALID";
+		case AST_DEVICE_UNAVAILABLE:
+			return "UNAVAILABLE";
+		case AST_DEVICE_RINGING:
+			return "RINGING";
+		case AST_DEVICE_RINGINUSE:
+			return "RINGINUSE";
+		case AST_DEVICE_ONHOLD:
+			return "ONHOLD";
+		default:
+			return "UNKNOWN";
+	}
+}
+
+const char *ast_extension_state2str(int extension_state)
+{
+	switch (extension_state) {
+		case AST_EXTENSION_REMOVED:
+			return "Removed";
+		case AST_EXTENSION_DEACTIVATED:
+			return "Deactivated";
+		case AST_EXTENSION_NOT_INUSE:
+			return "Idle";
+		case AST_EXTENSION_INUSE:
+			return "InUse";
+		case AST_EXTENSION_BUSY:
+			return "Busy";
+		case AST_EXTENSION_UNAVAILABLE:
+			return "Unavailable";
+		case AST_EXTENSION_RINGING:
+			return "Ringing";
+		case AST_EXTENSION_INUSE | AST_EXTENSION_RINGING:
+			return "InUse&Ringing";
+		case AST_EXTENSION_ONHOLD:
+			return "Hold";
+		case AST_EXTENSION_INUSE | AST_EXTENSION_ONHOLD:
+			return "InUse&Hold";
+		default:
+			return "Unknown";
+	}
+}
+
+/* ============================================================================================================== dialplan */
+/* the null pbx has no contexts, the built-in dialplan lives in null.c (see pbx_pbx_start / ast_exists_extension) */
+struct ast_context *ast_context_find(const char *name)
+{
+	NULL_UNSUPPORTED("dialplan contexts do not exist");
+	return NULL;
+}
+
+void ast_context_destroy(struct ast_context *con, const char *registrar)
+{
+}
+
+int ast_context_remove_extension(const char *context, const char *extension, int priority, const char *registrar)
+{
+	NULL_UNSUPPORTED("dialplan extensions do not exist");
+	return 0;
+}
+
+int ast_add_extension(const char *context, int replace, const char *extension, int priority, const char *label, const char *callerid, const char *application, void *data, void (*datad) (void *), const char *registrar)
+{
+	NULL_UNSUPPORTED("the extension is not added");
+	if (data && datad) {
+		datad(data);											/* the data is owned by the (non-existent) extension */
+	}
+	return 0;
+}
+
+int ast_get_hint(char *hint, int hintsize, char *name, int namesize, struct ast_channel *c, const char *context, const char *exten)
+{
+	NULL_UNSUPPORTED("dialplan hints do not exist");
+	return 0;
+}
+
+struct ast_exten *pbx_find_extension(struct ast_channel *chan, struct ast_context *bypass, struct pbx_find_info *q, const char *context, const char *exten, int priority, const char *label, const char *callerid, enum ext_match_t action)
+{
+	NULL_UNSUPPORTED("dialplan extensions do not exist");
+	return NULL;
+}
+
+struct ast_app *pbx_findapp(const char *app)
+{
+	NULL_UNSUPPORTED("dialplan applications do not exist");
+	return NULL;
+}
+
+enum ast_pbx_result ast_pbx_run(struct ast_channel *c)
+{
+	NULL_UNSUPPORTED("the built-in dialplan is started through pbx_pbx_start");
+	return AST_PBX_FAILED;
+}
+
+int ast_do_pickup(struct ast_channel *chan, struct ast_channel *target)
+{
+	NULL_UNSUPPORTED("pickup fails");
+	return -1;
+}
+
+void ast_jb_configure(struct ast_channel *chan, const struct ast_jb_conf *conf)
+{
+	NULL_UNSUPPORTED("there is no jitterbuffer");
+}
+
+void ast_party_connected_line_init(struct ast_party_connected_line *init)
+{
+	memset(init, 0, sizeof(*init));
+}
+
+void ast_set_party_id_all(struct ast_set_party_id *update_id)
+{
+	update_id->name = 1;
+	update_id->number = 1;
+	update_id->subaddress = 1;
+}
+
+void ast_db_freetree(struct ast_db_entry *entry)
+{
+	struct ast_db_entry *last = NULL;
+
+	while (entry) {
+		last = entry;
+		entry = entry->next;
+		sccp_free(last);
+	}
+}
+
+#if CS_TEST_FRAMEWORK
+int ast_test_register(ast_test_cb_t * cb)
+{
+	NULL_UNSUPPORTED("the test framework cannot run tests");
+	return 0;
+}
+
+int ast_test_unregister(ast_test_cb_t * cb)
+{
+	return 0;
+}
+
+int __ast_test_status_update(const char *file, const char *func, int line, struct ast_test *test, const char *fmt, ...)
+{
+	return 0;
+}
+#endif
+
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -204,6 +204,184 @@ static const struct messageMap_cb spcpMessagesCbMap[SPCP_MESSAGE_HIGH_BOUNDARY +
 	//[UnknownVGMessage - SPCP_MESSAGE_OFFSET] = {NULL, FALSE},
 };
 
+/* =================================================================================================== Message Dispatch Statistics */
+/*
+ * Log-linear latency histogram: values below SCCP_MESSAGE_STATS_SUBBUCKETS microseconds get their own bucket, every following power
+ * of two is split in SCCP_MESSAGE_STATS_SUBBUCKETS equal buckets, the last bucket collects everything above ~7 seconds.
+ */
+#define SCCP_MESSAGE_STATS_SUBBUCKETS_BITS 2
+#define SCCP_MESSAGE_STATS_SUBBUCKETS (1 << SCCP_MESSAGE_STATS_SUBBUCKETS_BITS)
+#define SCCP_MESSAGE_STATS_MAJORS 22
+#define SCCP_MESSAGE_STATS_BUCKETS (SCCP_MESSAGE_STATS_MAJORS * SCCP_MESSAGE_STATS_SUBBUCKETS)
+#define SCCP_MESSAGE_STATS_SPCP_INDEX (SCCP_MESSAGE_HIGH_BOUNDARY + 1)
+#define SCCP_MESSAGE_STATS_SIZE (SCCP_MESSAGE_STATS_SPCP_INDEX + SPCP_MESSAGE_HIGH_BOUNDARY + 1 - SPCP_MESSAGE_OFFSET)
+
+typedef struct sccp_message_stats {
+	uint32_t count;												/*!< Messages dispatched */
+	uint32_t maxUs;												/*!< Slowest dispatch */
+	uint64_t totalUs;											/*!< Sum of all dispatch times */
+	uint32_t buckets[SCCP_MESSAGE_STATS_BUCKETS];								/*!< Latency Histogram */
+} sccp_message_stats_t;
+
+AST_MUTEX_DEFINE_STATIC(sccp_message_stats_lock);
+static sccp_message_stats_t sccp_message_stats[SCCP_MESSAGE_STATS_SIZE];					/*!< Indexed by message id, spcp messages follow the sccp ones */
+static struct timeval sccp_message_stats_since;									/*!< Last reset, zero means module load */
+
+static inline unsigned int sccp_message_stats_bucket(uint64_t us)
+{
+	unsigned int msb = SCCP_MESSAGE_STATS_SUBBUCKETS_BITS;
+	unsigned int bucket = 0;
+
+	if (us < SCCP_MESSAGE_STATS_SUBBUCKETS) {
+		return (unsigned int) us;
+	}
+	while ((us >> (msb + 1))) {
+		msb++;
+	}
+	bucket = ((msb - SCCP_MESSAGE_STATS_SUBBUCKETS_BITS + 1) << SCCP_MESSAGE_STATS_SUBBUCKETS_BITS) + ((us >> (msb - SCCP_MESSAGE_STATS_SUBBUCKETS_BITS)) & (SCCP_MESSAGE_STATS_SUBBUCKETS - 1));
+	return (bucket < SCCP_MESSAGE_STATS_BUCKETS) ? bucket : SCCP_MESSAGE_STATS_BUCKETS - 1;
+}
+
+/* exclusive upper bound of a bucket in microseconds */
+static inline uint64_t sccp_message_stats_bucketLimit(unsigned int bucket)
+{
+	unsigned int major = bucket >> SCCP_MESSAGE_STATS_SUBBUCKETS_BITS;
+	unsigned int sub = bucket & (SCCP_MESSAGE_STATS_SUBBUCKETS - 1);
+
+	if (major == 0) {
+		return sub + 1;
+	}
+	return (uint64_t) (SCCP_MESSAGE_STATS_SUBBUCKETS + sub + 1) << (major - 1);
+}
+
+static inline int sccp_message_stats_index(uint32_t mid)
+{
+	if (mid <= SCCP_MESSAGE_HIGH_BOUNDARY) {
+		return mid;
+	} else if (mid >= SPCP_MESSAGE_LOW_BOUNDARY && mid <= SPCP_MESSAGE_HIGH_BOUNDARY) {
+		return SCCP_MESSAGE_STATS_SPCP_INDEX + mid - SPCP_MESSAGE_OFFSET;
+	}
+	return -1;
+}
+
+static inline uint32_t sccp_message_stats_mid(int idx)
+{
+	return (idx < SCCP_MESSAGE_STATS_SPCP_INDEX) ? (uint32_t) idx : (uint32_t) (idx - SCCP_MESSAGE_STATS_SPCP_INDEX + SPCP_MESSAGE_OFFSET);
+}
+
+static void sccp_message_stats_record(uint32_t mid, const struct timeval start)
+{
+	struct timeval elapsed = ast_tvsub(pbx_tvnow(), start);
+	int64_t us = (int64_t) elapsed.tv_sec * 1000000 + elapsed.tv_usec;
+	int idx = sccp_message_stats_index(mid);
+
+	if (idx < 0) {
+		return;
+	}
+	if (us < 0) {												/* clock stepped backwards */
+		us = 0;
+	}
+	sccp_mutex_lock(&sccp_message_stats_lock);
+	sccp_message_stats_t *stats = &sccp_message_stats[idx];
+	stats->count++;
+	stats->totalUs += us;
+	if (us > stats->maxUs) {
+		stats->maxUs = (us > UINT32_MAX) ? UINT32_MAX : (uint32_t) us;
+	}
+	stats->buckets[sccp_message_stats_bucket(us)]++;
+	sccp_mutex_unlock(&sccp_message_stats_lock);
+}
+
+static uint64_t sccp_message_stats_percentile(const sccp_message_stats_t * stats, unsigned int percentile)
+{
+	uint64_t wanted = ((uint64_t) stats->count * percentile + 99) / 100;
+	uint64_t seen = 0;
+	unsigned int bucket = 0;
+
+	for (bucket = 0; bucket < SCCP_MESSAGE_STATS_BUCKETS; bucket++) {
+		seen += stats->buckets[bucket];
+		if (seen >= wanted && seen) {
+			uint64_t limit = sccp_message_stats_bucketLimit(bucket);
+			return (limit < stats->maxUs) ? limit : stats->maxUs;
+		}
+	}
+	return stats->maxUs;
+}
+
+/*!
+ * \brief Reset the Message Dispatch Statistics
+ */
+void sccp_message_stats_reset(void)
+{
+	sccp_mutex_lock(&sccp_message_stats_lock);
+	memset(sccp_message_stats, 0, sizeof(sccp_message_stats));
+	sccp_message_stats_since = pbx_tvnow();
+	sccp_mutex_unlock(&sccp_message_stats_lock);
+}
+
+/*!
+ * \brief Show Message Dispatch Statistics
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_show_message_stats(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	int local_table_total = 0;
+	int idx = 0;
+	sccp_message_stats_t *stats = NULL;
+	sccp_message_stats_t *snapshot = NULL;
+	struct timeval since;
+
+	/* take a copy, so that dispatching is not held up while the table is being written out */
+	if (!(snapshot = sccp_malloc(sizeof(sccp_message_stats)))) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return RESULT_FAILURE;
+	}
+	sccp_mutex_lock(&sccp_message_stats_lock);
+	memcpy(snapshot, sccp_message_stats, sizeof(sccp_message_stats));
+	since = sccp_message_stats_since;
+	sccp_mutex_unlock(&sccp_message_stats_lock);
+
+	if (!s) {
+		if (ast_tvzero(since)) {
+			CLI_AMI_OUTPUT(fd, s, "\n--- SCCP message dispatch statistics (microseconds, since module load) ---\n");
+		} else {
+			CLI_AMI_OUTPUT(fd, s, "\n--- SCCP message dispatch statistics (microseconds, reset %ld seconds ago) ---\n", (long) (ast_tvdiff_ms(pbx_tvnow(), since) / 1000));
+		}
+	}
+
+#define CLI_AMI_TABLE_NAME MessageStats
+#define CLI_AMI_TABLE_PER_ENTRY_NAME MessageStat
+#define CLI_AMI_TABLE_ITERATOR for (idx = 0; idx < SCCP_MESSAGE_STATS_SIZE; idx++) if (snapshot[idx].count)
+#define CLI_AMI_TABLE_BEFORE_ITERATION stats = &snapshot[idx];
+#define CLI_AMI_TABLE_FIELDS 																\
+		CLI_AMI_TABLE_FIELD(Id,			"-6",		X,	6,	sccp_message_stats_mid(idx))					\
+		CLI_AMI_TABLE_FIELD(Message,		"-40.40",	s,	40,	msgtype2str(sccp_message_stats_mid(idx)))			\
+		CLI_AMI_TABLE_FIELD(Count,		"8",		u,	8,	stats->count)							\
+		CLI_AMI_TABLE_FIELD(Avg,		"8",		lu,	8,	(unsigned long) (stats->totalUs / stats->count))		\
+		CLI_AMI_TABLE_FIELD(P50,		"8",		lu,	8,	(unsigned long) sccp_message_stats_percentile(stats, 50))	\
+		CLI_AMI_TABLE_FIELD(P90,		"8",		lu,	8,	(unsigned long) sccp_message_stats_percentile(stats, 90))	\
+		CLI_AMI_TABLE_FIELD(P99,		"8",		lu,	8,	(unsigned long) sccp_message_stats_percentile(stats, 99))	\
+		CLI_AMI_TABLE_FIELD(Max,		"8",		u,	8,	stats->maxUs)
+#include "sccp_cli_table.h"
+	local_table_total++;
+	sccp_free(snapshot);
+
+	if (s) {
+		totals->lines = local_line_total;
+		totals->tables = local_table_total;
+	}
+	return RESULT_SUCCESS;
+}
+
 /*!
  * \brief       Controller function to handle Received Messages
  * \param       msg Message as sccp_msg_t
@@ -213,6 +391,7 @@ int sccp_handle_message(constMessagePtr msg, constSessionPtr s)
 {
 	const struct messageMap_cb *messageMap_cb = NULL;
 	uint32_t mid = 0;
+	struct timeval dispatchStart;
 	AUTO_RELEASE(sccp_device_t, device , NULL);
 
 	if (!s) {
@@ -240,10 +419,12 @@ int sccp_handle_message(constMessagePtr msg, constSessionPtr s)
 	}
 	sccp_log((DEBUGCAT_MESSAGE)) (VERBOSE_PREFIX_3 "%s: >> Got message %s (0x%X)\n", sccp_session_getDesignator(s), msgtype2str(mid), mid);
 
+	dispatchStart = pbx_tvnow();
 	device = check_session_message_device(s, msg, msgtype2str(mid), messageMap_cb->deviceIsNecessary);	/* retained device returned */
 
 	if (messageMap_cb->messageHandler_cb && messageMap_cb->deviceIsNecessary == TRUE && !device) {
 		pbx_log(LOG_ERROR, "SCCP: Device is required to handle this message %s(%x), but none is provided. Exiting sccp_handle_message\n", msgtype2str(mid), mid);
+		sccp_message_stats_record(mid, dispatchStart);
 		return -3;
 	}
 	if (messageMap_cb->messageHandler_cb) {
@@ -257,6 +438,7 @@ int sccp_handle_message(constMessagePtr msg, constSessionPtr s)
 		snprintf(servername, sizeof(servername), "%s %s", GLOB(servername), SKINNY_DISP_CONNECTED);
 		sccp_dev_displaynotify(device, servername, 5);
 	}
+	sccp_message_stats_record(mid, dispatchStart);
 	return 0;
 }
 
@@ -1394,6 +1576,30 @@ void sccp_handle_button_template_req(constSessionPtr s, devicePtr d, constMessag
 		return;
 	}
 
+	/* set speeddial for older devices like 7912 */
+	uint32_t speeddialInstance = 0;
+	sccp_buttonconfig_t *config;
+
+	//sccp_log((DEBUGCAT_BUTTONTEMPLATE + DEBUGCAT_SPEEDDIAL)) (VERBOSE_PREFIX_3 "%s: configure unconfigured speeddialbuttons \n", d->id);
+	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+		/* we found an unconfigured speeddial */
+		if (config->type == SPEEDDIAL && config->instance == 0) {
+			config->instance = speeddialInstance++;
+		} else if (config->type == SPEEDDIAL && config->instance != 0) {
+			speeddialInstance = config->instance + 1;
+		}
+	}
+	/* done */
+
+	/* instances are final now, build the speeddial/feature/service button index */
+	sccp_dev_buildButtonIndex(d);
+
+	/* the encoded template only depends on the device configuration, serve it from the registration cache when possible */
+	if ((msg_out = sccp_dev_regcache_get(d, SCCP_REGCACHE_BUTTONTEMPLATE, 0))) {
+		sccp_dev_send(d, msg_out);
+		return;
+	}
+
 	REQ(msg_out, ButtonTemplateMessage);
 	for (i = 0; i < StationMaxButtonTemplateSize; i++) {
 		msg_out->data.ButtonTemplateMessage.definition[i].instanceNumber = btn[i].instance;
@@ -1452,21 +1658,7 @@ void sccp_handle_button_template_req(constSessionPtr s, devicePtr d, constMessag
 	msg_out->data.ButtonTemplateMessage.lel_buttonCount = htolel(buttonCount);
 	/* buttonCount is already in a little endian format so don't need to convert it now */
 	msg_out->data.ButtonTemplateMessage.lel_totalButtonCount = htolel(lastUsedButtonPosition + 1);
-
-	/* set speeddial for older devices like 7912 */
-	uint32_t speeddialInstance = 0;
-	sccp_buttonconfig_t *config;
-
-	//sccp_log((DEBUGCAT_BUTTONTEMPLATE + DEBUGCAT_SPEEDDIAL)) (VERBOSE_PREFIX_3 "%s: configure unconfigured speeddialbuttons \n", d->id);
-	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
-		/* we found an unconfigured speeddial */
-		if (config->type == SPEEDDIAL && config->instance == 0) {
-			config->instance = speeddialInstance++;
-		} else if (config->type == SPEEDDIAL && config->instance != 0) {
-			speeddialInstance = config->instance + 1;
-		}
-	}
-	/* done */
+	sccp_dev_regcache_store(d, SCCP_REGCACHE_BUTTONTEMPLATE, 0, msg_out);
 
 	sccp_dev_send(d, msg_out);
 }
@@ -1555,6 +1747,11 @@ void handle_speed_dial_stat_req(constSessionPtr s, devicePtr d, constMessagePtr
 
 	sccp_log((DEBUGCAT_ACTION)) (VERBOSE_PREFIX_3 "%s: Speed Dial Request for Button %d\n", sccp_session_getDesignator(s), wanted);
 
+	if (wanted >= 0 && wanted <= UINT16_MAX && (msg_out = sccp_dev_regcache_get(d, SCCP_REGCACHE_SPEEDDIALSTAT, wanted))) {
+		sccp_dev_send(d, msg_out);
+		return;
+	}
+
 	REQ(msg_out, SpeedDialStatMessage);
 	msg_out->data.SpeedDialStatMessage.lel_speedDialNumber = htolel(wanted);
 
@@ -1562,6 +1759,9 @@ void handle_speed_dial_stat_req(constSessionPtr s, devicePtr d, constMessagePtr
 	if (k.valid) {
 		d->copyStr2Locale(d, msg_out->data.SpeedDialStatMessage.speedDialDirNumber, k.ext, sizeof(msg_out->data.SpeedDialStatMessage.speedDialDirNumber));
 		d->copyStr2Locale(d, msg_out->data.SpeedDialStatMessage.speedDialDisplayName, k.name, sizeof(msg_out->data.SpeedDialStatMessage.speedDialDisplayName));
+		if (wanted >= 0 && wanted <= UINT16_MAX) {
+			sccp_dev_regcache_store(d, SCCP_REGCACHE_SPEEDDIALSTAT, wanted, msg_out);
+		}
 	} else {
 		sccp_log((DEBUGCAT_ACTION | DEBUGCAT_BUTTONTEMPLATE)) (VERBOSE_PREFIX_3 "%s: speeddial %d unknown\n", sccp_session_getDesignator(s), wanted);
 	}
@@ -2349,6 +2549,7 @@ void handle_stimulus(constSessionPtr s, devicePtr d, constMessagePtr msg_in)
 	}
 
 	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "%s: Got stimulus=%s (%d) for instance=%d, callreference=%d, status=%d\n", d->id, skinny_stimulus2str(stimulus), stimulus, instance, callId, stimulusStatus);
+	sccp_dev_shadow_reset(d, TRUE);										/* the phone may have changed speaker/keyset on its own */
 	
 	if(!instance && stimulus == SKINNY_STIMULUS_LASTNUMBERREDIAL && d->redialInformation.lineInstance > 0) {
 		instance = d->redialInformation.lineInstance;
@@ -2399,6 +2600,7 @@ void handle_stimulus(constSessionPtr s, devicePtr d, constMessagePtr msg_in)
  */
 void handle_offhook(constSessionPtr s, devicePtr d, constMessagePtr msg_in)
 {
+	sccp_dev_shadow_reset(d, TRUE);										/* the phone switched speaker/keyset on its own */
 	if (d->isAnonymous) {
 		sccp_feat_adhocDial(d, GLOB(hotline)->line);
 		return;
@@ -2474,6 +2676,7 @@ void handle_onhook(constSessionPtr s, devicePtr d, constMessagePtr msg_in)
 	uint32_t buttonIndex = letohl(msg_in->data.OnHookMessage.lel_buttonIndex);
 	uint32_t callid = letohl(msg_in->data.OnHookMessage.lel_callReference);
 
+	sccp_dev_shadow_reset(d, TRUE);										/* the phone switched speaker/keyset on its own */
 	if (!(d->lineButtons.size > SCCP_FIRST_LINEINSTANCE)) {
 		pbx_log(LOG_NOTICE, "No lines registered on %s to put OnHook\n", DEV_ID_LOG(d));
 		sccp_dev_displayprompt(d, 0, 0, SKINNY_DISP_NO_LINES_REGISTERED, SCCP_DISPLAYSTATUS_TIMEOUT);
@@ -2544,6 +2747,7 @@ void handle_headset(constSessionPtr s, devicePtr d, constMessagePtr msg_in)
 	 * it has been included in 0x004A AccessoryStatusMessage
 	 */
 	uint32_t headsetmode = letohl(msg_in->data.HeadsetStatusMessage.lel_hsMode);
+	sccp_dev_shadow_reset(d, TRUE);
 	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "%s: Accessory '%s' is '%s' (%u)\n", sccp_session_getDesignator(s), sccp_accessory2str(SCCP_ACCESSORY_HEADSET), sccp_accessorystate2str(headsetmode), 0);
 }
 
@@ -2617,6 +2821,12 @@ void sccp_handle_soft_key_template_req(constSessionPtr s, devicePtr d, constMess
 	int dummy_len = arrayLen * (sizeof(StationSoftKeyDefinition));
 	int hdr_len = sizeof(msg_out->data.SoftKeyTemplateResMessage);
 
+	/* the template only depends on the device configuration, serve it from the registration cache when possible */
+	if ((msg_out = sccp_dev_regcache_get(d, SCCP_REGCACHE_SOFTKEYTEMPLATE, 0))) {
+		sccp_dev_send(d, msg_out);
+		return;
+	}
+
 	/* create message */
 	msg_out = sccp_build_packet(SoftKeyTemplateResMessage, hdr_len + dummy_len);
 	msg_out->data.SoftKeyTemplateResMessage.lel_softKeyOffset = 0;
@@ -2654,6 +2864,7 @@ void sccp_handle_soft_key_template_req(constSessionPtr s, devicePtr d, constMess
 
 	msg_out->data.SoftKeyTemplateResMessage.lel_softKeyCount = htolel(arrayLen);
 	msg_out->data.SoftKeyTemplateResMessage.lel_totalSoftKeyCount = htolel(arrayLen);
+	sccp_dev_regcache_store(d, SCCP_REGCACHE_SOFTKEYTEMPLATE, 0, msg_out);
 	sccp_dev_send(d, msg_out);
 }
 
@@ -2716,6 +2927,17 @@ void handle_soft_key_set_req(constSessionPtr s, devicePtr d, constMessagePtr msg
 	const uint8_t v_count = d->softKeyConfiguration.size;
 	const uint8_t *b;
 
+	/* the softkey set only depends on the device and line configuration, serve it from the registration cache when possible */
+	if ((msg_out = sccp_dev_regcache_get(d, SCCP_REGCACHE_SOFTKEYSET, 0))) {
+		for (i = 0; i < KEYMODE_ONHOOKSTEALABLE; i++) {
+			sccp_softkey_setSoftkeyState(d, i, SKINNY_LBL_VIDEO_MODE, FALSE);
+			sccp_softkey_setSoftkeyState(d, i, SKINNY_LBL_JOIN, FALSE);
+		}
+		sccp_dev_send(d, msg_out);
+		sccp_dev_set_keyset(d, 0, 0, KEYMODE_ONHOOK);
+		return;
+	}
+
 	REQ(msg_out, SoftKeySetResMessage);
 	msg_out->data.SoftKeySetResMessage.lel_softKeySetOffset = htolel(0);
 
@@ -2864,6 +3086,7 @@ void handle_soft_key_set_req(constSessionPtr s, devicePtr d, constMessagePtr msg
 
 	msg_out->data.SoftKeySetResMessage.lel_softKeySetCount = htolel(iKeySetCount);
 	msg_out->data.SoftKeySetResMessage.lel_totalSoftKeySetCount = htolel(iKeySetCount);			// <<-- for now, but should be: iTotalKeySetCount;
+	sccp_dev_regcache_store(d, SCCP_REGCACHE_SOFTKEYSET, 0, msg_out);
 
 	sccp_dev_send(d, msg_out);
 	sccp_dev_set_keyset(d, 0, 0, KEYMODE_ONHOOK);
@@ -3987,7 +4210,7 @@ void handle_forward_stat_req(constSessionPtr s, devicePtr d, constMessagePtr msg
  */
 void handle_feature_stat_req(constSessionPtr s, devicePtr d, constMessagePtr msg_in)
 {
-	sccp_buttonconfig_t *config = NULL;
+	sccp_feature_type_t featureID = SCCP_FEATURE_UNKNOWN;
 
 	int featureIndex = letohl(msg_in->data.FeatureStatReqMessage.lel_featureIndex);
 	int capabilities = letohl(msg_in->data.FeatureStatReqMessage.lel_featureCapabilities);
@@ -4002,11 +4225,15 @@ void handle_feature_stat_req(constSessionPtr s, devicePtr d, constMessagePtr msg
 	sccp_speed_t k;
 
 	if ((capabilities == 1 && d->inuseprotocolversion >= 15)) {
+		sccp_msg_t *msg_out = NULL;
+
+		if (featureIndex >= 0 && featureIndex <= UINT16_MAX && (msg_out = sccp_dev_regcache_get(d, SCCP_REGCACHE_FEATURESTATDYNAMIC, featureIndex))) {
+			sccp_dev_send(d, msg_out);
+			return;
+		}
 		sccp_dev_speed_find_byindex(d, featureIndex, TRUE, &k);
 
 		if (k.valid) {
-			sccp_msg_t *msg_out = NULL;
-
 			REQ(msg_out, FeatureStatDynamicMessage);
 			msg_out->data.FeatureStatDynamicMessage.lel_featureIndex = htolel(featureIndex);
 			msg_out->data.FeatureStatDynamicMessage.lel_featureID = htolel(SKINNY_BUTTONTYPE_BLFSPEEDDIAL);
@@ -4014,16 +4241,17 @@ void handle_feature_stat_req(constSessionPtr s, devicePtr d, constMessagePtr msg
 
 			//sccp_copy_string(msg_out->data.FeatureStatDynamicMessage.DisplayName, k.name, sizeof(msg_out->data.FeatureStatDynamicMessage.DisplayName));
 			d->copyStr2Locale(d, msg_out->data.FeatureStatDynamicMessage.featureTextLabel, k.name, sizeof(msg_out->data.FeatureStatDynamicMessage.featureTextLabel));
+			if (featureIndex >= 0 && featureIndex <= UINT16_MAX) {
+				sccp_dev_regcache_store(d, SCCP_REGCACHE_FEATURESTATDYNAMIC, featureIndex, msg_out);
+			}
 			sccp_dev_send(d, msg_out);
 			return;
 		}
 	}
 #endif
 
-	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
-		if (config->instance == featureIndex && config->type == FEATURE) {
-			sccp_feat_changed(d, NULL, config->button.feature.id);
-		}
+	if ((featureID = sccp_dev_featureID_find_byindex(d, featureIndex)) != SCCP_FEATURE_UNKNOWN) {
+		sccp_feat_changed(d, NULL, featureID);
 	}
 }
 
@@ -4036,23 +4264,24 @@ void handle_feature_stat_req(constSessionPtr s, devicePtr d, constMessagePtr msg
 void handle_services_stat_req(constSessionPtr s, devicePtr d, constMessagePtr msg_in)
 {
 	sccp_msg_t *msg_out = NULL;
-	sccp_buttonconfig_t *config = NULL;
+	const sccp_buttonindex_service_t *service = NULL;
 
 	int urlIndex = letohl(msg_in->data.ServiceURLStatReqMessage.lel_serviceURLIndex);
 
 	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "%s: Got ServiceURL Status Request.  Index = %d\n", d->id, urlIndex);
 
-	if ((config = sccp_dev_serviceURL_find_byindex(d, urlIndex))) {
+	AUTO_RELEASE(sccp_buttonindex_t, buttonIndex , sccp_dev_getButtonIndex(d));
+	if ((service = sccp_dev_serviceURL_find_byindex(d, buttonIndex, urlIndex))) {
 		/* \todo move ServiceURLStatMessage impl to sccp_protocol.c */
 		if (d->inuseprotocolversion < 7) {
 			REQ(msg_out, ServiceURLStatMessage);
 			msg_out->data.ServiceURLStatMessage.lel_serviceURLIndex = htolel(urlIndex);
-			sccp_copy_string(msg_out->data.ServiceURLStatMessage.URL, config->button.service.url, sccp_strlen(config->button.service.url) + 1);
-			//sccp_copy_string(msg_out->data.ServiceURLStatMessage.label, config->label, sccp_strlen(config->label) + 1);
-			d->copyStr2Locale(d, msg_out->data.ServiceURLStatMessage.label, config->label, sccp_strlen(config->label) + 1);
+			sccp_copy_string(msg_out->data.ServiceURLStatMessage.URL, service->url, sccp_strlen(service->url) + 1);
+			//sccp_copy_string(msg_out->data.ServiceURLStatMessage.label, service->label, sccp_strlen(service->label) + 1);
+			d->copyStr2Locale(d, msg_out->data.ServiceURLStatMessage.label, service->label, sccp_strlen(service->label) + 1);
 		} else {
-			int URL_len = sccp_strlen(config->button.service.url);
-			int label_len = sccp_strlen(config->label);
+			int URL_len = sccp_strlen(service->url);
+			int label_len = sccp_strlen(service->label);
 			int dummy_len = URL_len + label_len;
 
 			int hdr_len = sizeof(msg_in->data.ServiceURLStatDynamicMessage) - 1;
@@ -4065,10 +4294,10 @@ void handle_services_stat_req(constSessionPtr s, devicePtr d, constMessagePtr ms
 
 				memset(&buffer[0], 0, dummy_len + 2);
 				if (URL_len) {
-					memcpy(&buffer[0], config->button.service.url, URL_len);
+					memcpy(&buffer[0], service->url, URL_len);
 				}
 				if (label_len) {
-					memcpy(&buffer[URL_len + 1], config->label, label_len);
+					memcpy(&buffer[URL_len + 1], service->label, label_len);
 				}
 				memcpy(&msg_out->data.ServiceURLStatDynamicMessage.dummy, &buffer[0], dummy_len + 2);
 			}
@@ -4739,4 +4968,64 @@ void handle_miscellaneousCommandMessage(constSessionPtr s, devicePtr d, constMes
 	pbx_log(LOG_WARNING, "%s: Channel with passthrupartyid %u could not be found (callRef: %u/ confId: %u)\n", DEV_ID_LOG(d), passThruPartyId, callReference, conferenceId);
 	return;
 }
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+AST_TEST_DEFINE(sccp_message_stats_histogram)
+{
+	sccp_message_stats_t stats = {0};
+	uint64_t us = 0;
+	unsigned int bucket = 0, previous = 0;
+	int loop = 0;
+
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "message_stats_histogram";
+			info->category = "/channels/chan_sccp/actions/";
+			info->summary = "chan-sccp-b message dispatch latency histogram";
+			info->description = "checks the log-linear bucket boundaries and the percentile estimate";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	pbx_test_status_update(test, "Every value lands in the bucket covering it, buckets never go backwards...\n");
+	for (us = 0; us < 20000000; us += (us < 4096) ? 1 : us / 64) {
+		bucket = sccp_message_stats_bucket(us);
+		pbx_test_validate(test, bucket >= previous && bucket < SCCP_MESSAGE_STATS_BUCKETS);
+		if (bucket < SCCP_MESSAGE_STATS_BUCKETS - 1) {
+			pbx_test_validate(test, us < sccp_message_stats_bucketLimit(bucket));
+			pbx_test_validate(test, bucket == 0 || us >= sccp_message_stats_bucketLimit(bucket - 1));
+		}
+		previous = bucket;
+	}
+
+	pbx_test_status_update(test, "Percentiles stay within one bucket width (25%%) of the recorded values...\n");
+	for (loop = 1; loop <= 100; loop++) {
+		us = loop * 100;
+		stats.count++;
+		stats.totalUs += us;
+		stats.maxUs = us;
+		stats.buckets[sccp_message_stats_bucket(us)]++;
+	}
+	pbx_test_validate(test, sccp_message_stats_percentile(&stats, 50) >= 5000 && sccp_message_stats_percentile(&stats, 50) <= 6250);
+	pbx_test_validate(test, sccp_message_stats_percentile(&stats, 99) >= 9900 && sccp_message_stats_percentile(&stats, 99) <= 10000);
+	pbx_test_validate(test, sccp_message_stats_percentile(&stats, 100) == 10000);
+
+	pbx_test_status_update(test, "Message id mapping...\n");
+	pbx_test_validate(test, sccp_message_stats_mid(sccp_message_stats_index(KeepAliveMessage)) == KeepAliveMessage);
+	pbx_test_validate(test, sccp_message_stats_mid(sccp_message_stats_index(SPCPRegisterTokenRequest)) == SPCPRegisterTokenRequest);
+	pbx_test_validate(test, sccp_message_stats_index(SCCP_MESSAGE_HIGH_BOUNDARY + 1) == -1);
+	return AST_TEST_PASS;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_message_stats_histogram);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_message_stats_histogram);
+}
+#endif
 // kate: indent-width 4; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets on;
@@ -10,9 +10,13 @@
  * 
  */
 #pragma once
+#include "sccp_cli.h"
+
 __BEGIN_C_EXTERN__
 
 SCCP_API int SCCP_CALL sccp_handle_message(constMessagePtr msg, constSessionPtr s);
+SCCP_API void SCCP_CALL sccp_message_stats_reset(void);
+SCCP_API int SCCP_CALL sccp_show_message_stats(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
 
 /* externally used handlers */
 SCCP_API void SCCP_CALL sccp_handle_backspace(constDevicePtr d, const uint8_t lineInstance, const uint32_t callid)	__NONNULL(1);
@@ -22,6 +22,8 @@ SCCP_FILE_VERSION(__FILE__, "");
 #include <stdarg.h>
 
 /* local definitions */
+#define SCCP_CALLINFO_MAX_RECIPIENTS 8										/*!< Devices remembered per callinfo, enough for a normal shared line */
+
 typedef struct callinfo_entry {
 	char Name[StationMaxNameSize];
 	char Number[StationMaxDirnumSize];
@@ -30,64 +32,124 @@ typedef struct callinfo_entry {
 	uint16_t VoiceMailboxValid;
 } callinfo_entry_t;
 
-enum callinfo_groups {
-	CALLED_PARTY,
-	CALLING_PARTY,
-	ORIG_CALLED_PARTY,
-	ORIG_CALLING_PARTY,
-	LAST_REDIRECTING_PARTY,
-	HUNT_PILOT,
-};
-
-enum callinfo_types {
-	NAME,
-	NUMBER,
-	VOICEMAILBOX,
-};
-
 /*!
  * \brief SCCP CallInfo Structure
  */
 struct sccp_callinfo {
 	pbx_rwlock_t lock;
 	struct ci_content {
-		callinfo_entry_t entries[HUNT_PILOT + 1];
+		callinfo_entry_t entries[SCCP_CALLINFO_PARTY_SENTINEL];
 		uint32_t originalCdpnRedirectReason;								/*!< Original Called Party Redirect Reason */
 		uint32_t lastRedirectingReason;									/*!< Last Redirecting Reason */
 		sccp_callerid_presentation_t presentation;							/*!< Should this callerinfo be shown (privacy) */
-		boolean_t changed;										/*! Changes since last send */
+		uint32_t generation;										/*!< Bumped on every change, compared against the generation last sent to a device */
 		uint8_t callInstance;
 	} content;
+	struct ci_recipient {
+		char deviceId[StationMaxDeviceNameSize];							/*!< Device Name, empty when unused */
+		skinny_calltype_t calltype;									/*!< CallType last sent to this device */
+		uint32_t generation;										/*!< Generation last sent to this device */
+	} recipients[SCCP_CALLINFO_MAX_RECIPIENTS];
+	uint8_t nextRecipient;											/*!< Round robin slot to reuse when recipients is full */
+	struct ci_encoded {
+		uint32_t generation;										/*!< Generation the payload was encoded from */
+		sccp_msg_t *msg;										/*!< Encoded payload, only the strings and ci derived fields are valid */
+	} encoded[SCCP_CALLINFO_ENCODING_SENTINEL];
+	uint32_t sent;												/*!< Number of callinfo messages sent */
+	uint32_t suppressed;											/*!< Number of sends skipped because the device already had this generation */
+	uint32_t reused;											/*!< Number of sends served from the encoded payload */
 };														/*!< SCCP CallInfo Structure */
 
 #define sccp_callinfo_wrlock(x) pbx_rwlock_wrlock(&((sccp_callinfo_t * const)(x))->lock)				/* discard const */
 #define sccp_callinfo_rdlock(x) pbx_rwlock_rdlock(&((sccp_callinfo_t * const)(x))->lock)				/* discard const */
 #define sccp_callinfo_unlock(x) pbx_rwlock_unlock(&((sccp_callinfo_t * const)(x))->lock)				/* discard const */
 
-struct callinfo_lookup {
-	const enum callinfo_groups group;
-	const enum callinfo_types type;
-} static const callinfo_lookup[] = {
+/*!
+ * \brief Location of each string key inside struct ci_content, so the accessors do not need to switch on group and type
+ */
+struct callinfo_field {
+	const size_t offset;											/*!< Offset of the string */
+	const size_t size;											/*!< Size of the string buffer */
+	const ssize_t validOffset;										/*!< Offset of the matching Valid flag, -1 when the field has none */
+};
+
+#define CALLINFO_FIELD(_party, _member) {offsetof(struct ci_content, entries[_party]._member), sizeof(((callinfo_entry_t *) 0)->_member), -1}
+#define CALLINFO_VALID_FIELD(_party, _member) {offsetof(struct ci_content, entries[_party]._member), sizeof(((callinfo_entry_t *) 0)->_member), offsetof(struct ci_content, entries[_party]._member##Valid)}
+#define CALLINFO_STRPTR(_content, _key) ((char *) (_content) + callinfo_fields[_key].offset)					/* discard const */
+#define CALLINFO_VALIDPTR(_content, _key) (callinfo_fields[_key].validOffset < 0 ? NULL : (uint16_t *) ((char *) (_content) + callinfo_fields[_key].validOffset))
+#define CALLINFO_IS_STRING_KEY(_key) ((_key) >= SCCP_CALLINFO_CALLEDPARTY_NAME && (_key) <= SCCP_CALLINFO_HUNT_PILOT_NUMBER)
+
+static const struct callinfo_field callinfo_fields[] = {
 	/* *INDENT-OFF* */
-	[SCCP_CALLINFO_CALLEDPARTY_NAME]		= {CALLED_PARTY, NAME},
-	[SCCP_CALLINFO_CALLEDPARTY_NUMBER]		= {CALLED_PARTY, NUMBER},
-	[SCCP_CALLINFO_CALLEDPARTY_VOICEMAIL]		= {CALLED_PARTY, VOICEMAILBOX},
-	[SCCP_CALLINFO_CALLINGPARTY_NAME]		= {CALLING_PARTY, NAME},
-	[SCCP_CALLINFO_CALLINGPARTY_NUMBER]		= {CALLING_PARTY, NUMBER},
-	[SCCP_CALLINFO_CALLINGPARTY_VOICEMAIL]		= {CALLING_PARTY, VOICEMAILBOX},
-	[SCCP_CALLINFO_ORIG_CALLEDPARTY_NAME]		= {ORIG_CALLED_PARTY, NAME},
-	[SCCP_CALLINFO_ORIG_CALLEDPARTY_NUMBER]		= {ORIG_CALLED_PARTY, NUMBER},
-	[SCCP_CALLINFO_ORIG_CALLEDPARTY_VOICEMAIL]	= {ORIG_CALLED_PARTY, VOICEMAILBOX},
-	[SCCP_CALLINFO_ORIG_CALLINGPARTY_NAME]		= {ORIG_CALLING_PARTY, NAME},
-	[SCCP_CALLINFO_ORIG_CALLINGPARTY_NUMBER]	= {ORIG_CALLING_PARTY, NUMBER},
-	[SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NAME]	= {LAST_REDIRECTING_PARTY, NAME},
-	[SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NUMBER]	= {LAST_REDIRECTING_PARTY, NUMBER},
-	[SCCP_CALLINFO_LAST_REDIRECTINGPARTY_VOICEMAIL]	= {LAST_REDIRECTING_PARTY, VOICEMAILBOX},
-	[SCCP_CALLINFO_HUNT_PILOT_NAME]			= {HUNT_PILOT, NAME},
-	[SCCP_CALLINFO_HUNT_PILOT_NUMBER]		= {HUNT_PILOT, NUMBER},
+	[SCCP_CALLINFO_CALLEDPARTY_NAME]		= CALLINFO_FIELD(SCCP_CALLINFO_PARTY_CALLED, Name),
+	[SCCP_CALLINFO_CALLEDPARTY_NUMBER]		= CALLINFO_VALID_FIELD(SCCP_CALLINFO_PARTY_CALLED, Number),
+	[SCCP_CALLINFO_CALLEDPARTY_VOICEMAIL]		= CALLINFO_VALID_FIELD(SCCP_CALLINFO_PARTY_CALLED, VoiceMailbox),
+	[SCCP_CALLINFO_CALLINGPARTY_NAME]		= CALLINFO_FIELD(SCCP_CALLINFO_PARTY_CALLING, Name),
+	[SCCP_CALLINFO_CALLINGPARTY_NUMBER]		= CALLINFO_VALID_FIELD(SCCP_CALLINFO_PARTY_CALLING, Number),
+	[SCCP_CALLINFO_CALLINGPARTY_VOICEMAIL]		= CALLINFO_VALID_FIELD(SCCP_CALLINFO_PARTY_CALLING, VoiceMailbox),
+	[SCCP_CALLINFO_ORIG_CALLEDPARTY_NAME]		= CALLINFO_FIELD(SCCP_CALLINFO_PARTY_ORIG_CALLED, Name),
+	[SCCP_CALLINFO_ORIG_CALLEDPARTY_NUMBER]		= CALLINFO_VALID_FIELD(SCCP_CALLINFO_PARTY_ORIG_CALLED, Number),
+	[SCCP_CALLINFO_ORIG_CALLEDPARTY_VOICEMAIL]	= CALLINFO_VALID_FIELD(SCCP_CALLINFO_PARTY_ORIG_CALLED, VoiceMailbox),
+	[SCCP_CALLINFO_ORIG_CALLINGPARTY_NAME]		= CALLINFO_FIELD(SCCP_CALLINFO_PARTY_ORIG_CALLING, Name),
+	[SCCP_CALLINFO_ORIG_CALLINGPARTY_NUMBER]	= CALLINFO_VALID_FIELD(SCCP_CALLINFO_PARTY_ORIG_CALLING, Number),
+	[SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NAME]	= CALLINFO_FIELD(SCCP_CALLINFO_PARTY_LAST_REDIRECTING, Name),
+	[SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NUMBER]	= CALLINFO_VALID_FIELD(SCCP_CALLINFO_PARTY_LAST_REDIRECTING, Number),
+	[SCCP_CALLINFO_LAST_REDIRECTINGPARTY_VOICEMAIL]	= CALLINFO_VALID_FIELD(SCCP_CALLINFO_PARTY_LAST_REDIRECTING, VoiceMailbox),
+	[SCCP_CALLINFO_HUNT_PILOT_NAME]			= CALLINFO_FIELD(SCCP_CALLINFO_PARTY_HUNT_PILOT, Name),
+	[SCCP_CALLINFO_HUNT_PILOT_NUMBER]		= CALLINFO_VALID_FIELD(SCCP_CALLINFO_PARTY_HUNT_PILOT, Number),
 	/* *INDENT-ON* */
 };
 
+/* content helpers, the caller holds the callinfo lock */
+static inline const char *callinfo_peekString(const struct ci_content *const content, sccp_callinfo_key_t key)
+{
+	const uint16_t *validPtr = CALLINFO_VALIDPTR(content, key);
+
+	return (validPtr && !*validPtr) ? "" : CALLINFO_STRPTR(content, key);
+}
+
+static inline int callinfo_storeString(struct ci_content *const content, sccp_callinfo_key_t key, const char *const value)
+{
+	char *dstPtr = CALLINFO_STRPTR(content, key);
+	uint16_t *validPtr = CALLINFO_VALIDPTR(content, key);
+
+	if (sccp_strequals(dstPtr, value)) {
+		return 0;
+	}
+	sccp_copy_string(dstPtr, value, callinfo_fields[key].size);
+	if (validPtr) {
+		*validPtr = sccp_strlen_zero(value) ? 0 : 1;
+	}
+	return 1;
+}
+
+static inline int callinfo_storeValue(struct ci_content *const content, sccp_callinfo_key_t key, const int value)
+{
+	switch (key) {
+		case SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON:
+			if ((uint32_t) value != content->originalCdpnRedirectReason) {
+				content->originalCdpnRedirectReason = value;
+				return 1;
+			}
+			break;
+		case SCCP_CALLINFO_LAST_REDIRECT_REASON:
+			if ((uint32_t) value != content->lastRedirectingReason) {
+				content->lastRedirectingReason = value;
+				return 1;
+			}
+			break;
+		case SCCP_CALLINFO_PRESENTATION:
+			if ((sccp_callerid_presentation_t) value != content->presentation) {
+				content->presentation = (sccp_callerid_presentation_t) value;
+				return 1;
+			}
+			break;
+		default:
+			break;
+	}
+	return 0;
+}
+
 static sccp_callinfo_t * const callinfo_Constructor(uint8_t callInstance)
 {
 	sccp_callinfo_t *const ci = sccp_calloc(sizeof *ci, 1);
@@ -100,7 +162,7 @@ static sccp_callinfo_t * const callinfo_Constructor(uint8_t callInstance)
 
 	/* by default we allow callerid presentation */
 	ci->content.presentation = CALLERID_PRESENTATION_ALLOWED;
-	ci->content.changed = TRUE;
+	ci->content.generation = 1;
 	ci->content.callInstance = callInstance;
 
 	sccp_log(DEBUGCAT_CALLINFO) (VERBOSE_PREFIX_1 "SCCP: callinfo constructor: %p\n", ci);
@@ -110,8 +172,14 @@ static sccp_callinfo_t * const callinfo_Constructor(uint8_t callInstance)
 static sccp_callinfo_t * const callinfo_Destructor(sccp_callinfo_t * * const ci)
 {
 	pbx_assert(ci != NULL && *ci != NULL);
+	uint8_t encoding;
 	//sccp_callinfo_wrlock(ci);
 	//sccp_callinfo_unlock(ci);
+	for (encoding = 0; encoding < SCCP_CALLINFO_ENCODING_SENTINEL; encoding++) {
+		if ((*ci)->encoded[encoding].msg) {
+			sccp_free((*ci)->encoded[encoding].msg);
+		}
+	}
 	pbx_rwlock_destroy(&(*ci)->lock);
 	sccp_free(*ci);
 	*ci = NULL;
@@ -129,7 +197,7 @@ static sccp_callinfo_t * callinfo_CopyConstructor(const sccp_callinfo_t * const
 		}
 		sccp_callinfo_rdlock(src_ci);
 		memcpy(&tmp_ci->content, &src_ci->content, sizeof(struct ci_content));
-		tmp_ci->content.changed = TRUE;
+		tmp_ci->content.generation++;
 		sccp_callinfo_unlock(src_ci);
 
 		return tmp_ci;
@@ -150,8 +218,8 @@ static boolean_t callinfo_Copy(const sccp_callinfo_t * const src_ci, sccp_callin
 		sccp_callinfo_unlock(src_ci);
 
 		sccp_callinfo_wrlock(dst_ci);
+		tmp_ci_content.generation = dst_ci->content.generation + 1;
 		memcpy(&dst_ci->content, &tmp_ci_content, sizeof(struct ci_content));
-		dst_ci->content.changed = TRUE;
 		sccp_callinfo_unlock(dst_ci);
 
 		return TRUE;
@@ -185,66 +253,17 @@ static int callinfo_Setter(sccp_callinfo_t * const ci, int key, ...)							// ke
 		//sccp_log(DEBUGCAT_CALLINFO)(VERBOSE_PREFIX_3 "SCCP: curkey:%s (%d)\n", sccp_callinfo_key2str(curkey), curkey);
 		switch (curkey) {
 		case SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON:
-			{
-				uint new_value = va_arg(ap, uint);
-				if (new_value != ci->content.originalCdpnRedirectReason) {
-					ci->content.originalCdpnRedirectReason = new_value;
-					changes++;
-				}
-			}
-			break;
 		case SCCP_CALLINFO_LAST_REDIRECT_REASON:
-			{
-				uint new_value = va_arg(ap, uint);
-				if (new_value != ci->content.lastRedirectingReason) {
-					ci->content.lastRedirectingReason = new_value;
-					changes++;
-				}
-			}
+			changes += callinfo_storeValue(&ci->content, curkey, va_arg(ap, uint));
 			break;
 		case SCCP_CALLINFO_PRESENTATION:
-			{
-				sccp_callerid_presentation_t new_value = va_arg(ap, sccp_callerid_presentation_t);
-				if (new_value != ci->content.presentation) {
-					ci->content.presentation = new_value;
-					changes++;
-				}
-			}
+			changes += callinfo_storeValue(&ci->content, curkey, va_arg(ap, sccp_callerid_presentation_t));
 			break;
 		case SCCP_CALLINFO_CALLEDPARTY_NAME...SCCP_CALLINFO_HUNT_PILOT_NUMBER:
 			{
 				char *new_value = va_arg(ap, char *);
 				if (new_value) {
-					size_t size = 0;
-					char *dstPtr = NULL;
-					uint16_t *validPtr = NULL;
-					struct callinfo_lookup entry = callinfo_lookup[curkey];
-					callinfo_entry_t *callinfo = &ci->content.entries[entry.group];
-
-					switch(entry.type) {
-						case NAME:
-							size = StationMaxNameSize;
-							dstPtr = callinfo->Name;
-							validPtr = NULL;
-							break;
-						case NUMBER:
-							size = StationMaxDirnumSize;
-							dstPtr = callinfo->Number;
-							validPtr = &callinfo->NumberValid;
-							break;
-						case VOICEMAILBOX:
-							size = StationMaxDirnumSize;
-							dstPtr = callinfo->VoiceMailbox;
-							validPtr = &callinfo->VoiceMailboxValid;
-							break;
-					}
-					if (!sccp_strequals(dstPtr, new_value)) {
-						sccp_copy_string(dstPtr, new_value, size);
-						changes++;
-						if (validPtr) {
-							*validPtr = sccp_strlen_zero(new_value) ? 0 : 1;
-						}
-					}
+					changes += callinfo_storeString(&ci->content, curkey, new_value);
 				}
 			}
 			break;
@@ -255,7 +274,7 @@ static int callinfo_Setter(sccp_callinfo_t * const ci, int key, ...)							// ke
 
 	va_end(ap);
 	if (changes) {
-		ci->content.changed = TRUE;
+		ci->content.generation++;
 	}
 	sccp_callinfo_unlock(ci);
 
@@ -335,50 +354,17 @@ static int callinfo_CopyByKey(const sccp_callinfo_t * const src_ci, sccp_callinf
 			break;
 		case SCCP_CALLINFO_CALLEDPARTY_NAME...SCCP_CALLINFO_HUNT_PILOT_NUMBER:
 			{
-				struct callinfo_lookup src_entry = callinfo_lookup[srckey];
-				struct callinfo_lookup tmp_entry = callinfo_lookup[dstkey];
-				callinfo_entry_t *src_callinfo = (callinfo_entry_t *const) &src_ci->content.entries[src_entry.group];
-				callinfo_entry_t *tmp_callinfo = &tmp_ci_content.entries[tmp_entry.group];
-				
-				char *srcPtr = NULL;
-				uint16_t *validPtr = NULL;
-				switch(src_entry.type) {
-					case NAME:
-						srcPtr = src_callinfo->Name;
-						validPtr = NULL;
-						break;
-					case NUMBER:
-						srcPtr = src_callinfo->Number;
-						validPtr = &src_callinfo->NumberValid;
-						break;
-					case VOICEMAILBOX:
-						srcPtr = src_callinfo->VoiceMailbox;
-						validPtr = &src_callinfo->VoiceMailboxValid;
-						break;
-				}
-				char *tmpPtr = NULL;
-				uint16_t *tmpValidPtr = NULL;
-				size_t size = 0;
-				switch(tmp_entry.type) {
-					case NAME:
-						size = StationMaxNameSize;
-						tmpPtr = tmp_callinfo->Name;
-						tmpValidPtr = NULL;
-						break;
-					case NUMBER:
-						size = StationMaxDirnumSize;
-						tmpPtr = tmp_callinfo->Number;
-						tmpValidPtr = &(tmp_callinfo->NumberValid);
-						break;
-					case VOICEMAILBOX:
-						size = StationMaxDirnumSize;
-						tmpPtr = tmp_callinfo->VoiceMailbox;
-						tmpValidPtr = &(tmp_callinfo->VoiceMailboxValid);
-						break;
+				if (!CALLINFO_IS_STRING_KEY(dstkey)) {
+					pbx_log(LOG_WARNING, "SCCP: can only assign src string to a dst string\n");
+					break;
 				}
+				const uint16_t *validPtr = CALLINFO_VALIDPTR(&src_ci->content, srckey);
+				uint16_t *tmpValidPtr = CALLINFO_VALIDPTR(&tmp_ci_content, dstkey);
+				char *tmpPtr = CALLINFO_STRPTR(&tmp_ci_content, dstkey);
+
 				if (validPtr) {
 					if (*validPtr) {
-						sccp_copy_string(tmpPtr, srcPtr, size);
+						sccp_copy_string(tmpPtr, CALLINFO_STRPTR(&src_ci->content, srckey), callinfo_fields[dstkey].size);
 						if (tmpValidPtr) {
 							*tmpValidPtr = 1;
 						}
@@ -387,7 +373,7 @@ static int callinfo_CopyByKey(const sccp_callinfo_t * const src_ci, sccp_callinf
 						tmpPtr[0] = '\0';
 					}
 				} else {
-					sccp_copy_string(tmpPtr, srcPtr, size);
+					sccp_copy_string(tmpPtr, CALLINFO_STRPTR(&src_ci->content, srckey), callinfo_fields[dstkey].size);
 					changes++;
 				}
 			}
@@ -400,8 +386,8 @@ static int callinfo_CopyByKey(const sccp_callinfo_t * const src_ci, sccp_callinf
 	sccp_callinfo_unlock(src_ci);
 	
 	sccp_callinfo_wrlock(dst_ci);
+	tmp_ci_content.generation = dst_ci->content.generation + 1;
 	memcpy(&dst_ci->content, &tmp_ci_content, sizeof(struct ci_content));
-	dst_ci->content.changed = TRUE;
 	sccp_callinfo_unlock(dst_ci);
 	
 	if ((GLOB(debug) & (DEBUGCAT_CALLINFO)) != 0) {
@@ -459,41 +445,10 @@ static int callinfo_Getter(const sccp_callinfo_t * const ci, int key, ...)
 			{
 				char *dstPtr = va_arg(ap, char *);
 				if (dstPtr) {
-					size_t size = 0;
-					char *srcPtr = NULL;
-					uint16_t *validPtr = NULL;
-					struct callinfo_lookup entry = callinfo_lookup[curkey];
-					callinfo_entry_t *callinfo = (callinfo_entry_t *const) &(ci->content.entries[entry.group]);
-
-					switch(entry.type) {
-						case NAME:
-							size = StationMaxNameSize;
-							srcPtr = callinfo->Name;
-							validPtr = NULL;
-							break;
-						case NUMBER:
-							size = StationMaxDirnumSize;
-							srcPtr = callinfo->Number;
-							validPtr = &callinfo->NumberValid;
-							break;
-						case VOICEMAILBOX:
-							size = StationMaxDirnumSize;
-							srcPtr = callinfo->VoiceMailbox;
-							validPtr = &callinfo->VoiceMailboxValid;
-							break;
-					}
-					if (validPtr) {
-						if (!*validPtr) {
-							if (dstPtr[0] != '\0') {
-								dstPtr[0] = '\0';
-								entries++;
-							}
-							break;
-						}
-					}
+					const char *srcPtr = callinfo_peekString(&ci->content, curkey);
 					if (!sccp_strequals(dstPtr, srcPtr)) {
 						entries++;
-						sccp_copy_string(dstPtr, srcPtr, size);
+						sccp_copy_string(dstPtr, srcPtr, callinfo_fields[curkey].size);
 					}
 				}
 			}
@@ -516,27 +471,216 @@ static int callinfo_Getter(const sccp_callinfo_t * const ci, int key, ...)
 	return entries;
 }
 
+/* typed accessors */
+static int callinfo_SetString(sccp_callinfo_t * const ci, sccp_callinfo_key_t key, const char *value)
+{
+	pbx_assert(ci != NULL);
+	int changes = 0;
+
+	if (!CALLINFO_IS_STRING_KEY(key) || !value) {
+		return 0;
+	}
+	sccp_callinfo_wrlock(ci);
+	if ((changes = callinfo_storeString(&ci->content, key, value))) {
+		ci->content.generation++;
+	}
+	sccp_callinfo_unlock(ci);
+	return changes;
+}
+
+static int callinfo_SetValue(sccp_callinfo_t * const ci, sccp_callinfo_key_t key, int value)
+{
+	pbx_assert(ci != NULL);
+	int changes = 0;
+
+	sccp_callinfo_wrlock(ci);
+	if ((changes = callinfo_storeValue(&ci->content, key, value))) {
+		ci->content.generation++;
+	}
+	sccp_callinfo_unlock(ci);
+	return changes;
+}
+
+static int callinfo_GetValue(const sccp_callinfo_t * const ci, sccp_callinfo_key_t key)
+{
+	pbx_assert(ci != NULL);
+	int value = 0;
+
+	sccp_callinfo_rdlock(ci);
+	switch (key) {
+		case SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON:
+			value = ci->content.originalCdpnRedirectReason;
+			break;
+		case SCCP_CALLINFO_LAST_REDIRECT_REASON:
+			value = ci->content.lastRedirectingReason;
+			break;
+		case SCCP_CALLINFO_PRESENTATION:
+			value = ci->content.presentation;
+			break;
+		default:
+			break;
+	}
+	sccp_callinfo_unlock(ci);
+	return value;
+}
+
+/*!
+ * \brief Copy name and number of one party, and optionally the presentation, under a single read lock
+ * \return number of non empty strings copied
+ */
+static int callinfo_GetParty(const sccp_callinfo_t * const ci, sccp_callinfo_party_t party, char name[StationMaxNameSize], char number[StationMaxDirnumSize], sccp_callerid_presentation_t *presentation)
+{
+	pbx_assert(ci != NULL && party < SCCP_CALLINFO_PARTY_SENTINEL);
+	const callinfo_entry_t *entry = &ci->content.entries[party];
+	int entries = 0;
+
+	sccp_callinfo_rdlock(ci);
+	if (name) {
+		sccp_copy_string(name, entry->Name, StationMaxNameSize);
+		entries += name[0] ? 1 : 0;
+	}
+	if (number) {
+		sccp_copy_string(number, entry->NumberValid ? entry->Number : "", StationMaxDirnumSize);
+		entries += number[0] ? 1 : 0;
+	}
+	if (presentation) {
+		*presentation = ci->content.presentation;
+	}
+	sccp_callinfo_unlock(ci);
+	return entries;
+}
+
+/* zero-copy access, only valid between RdLock and Unlock */
+static void callinfo_RdLock(const sccp_callinfo_t * const ci)
+{
+	sccp_callinfo_rdlock(ci);
+}
+
+static const char *callinfo_PeekString(const sccp_callinfo_t * const ci, sccp_callinfo_key_t key)
+{
+	if (!CALLINFO_IS_STRING_KEY(key)) {
+		return "";
+	}
+	return callinfo_peekString(&ci->content, key);
+}
+
+static void callinfo_Unlock(const sccp_callinfo_t * const ci)
+{
+	sccp_callinfo_unlock(ci);
+}
+
+/*!
+ * \brief Send callinfo to a device, skipping the send when this device already received the current generation
+ * \note the generation is tracked per device, so every device on a shared line gets its own copy
+ */
 static int callinfo_Send(sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const sccp_device_t * const device, boolean_t force)
 {
-	if (ci->content.changed || force) {
-		/* dependency on sccp_device.h should be fixed */
-		if (device && device->protocol && device->protocol->sendCallInfo) {
-			// using for to set the callsecuritystate is a temporary solution
-			// when indicating ringout the security state should be SKINNY_CALLSECURITYSTATE_UNKNOWN
-			// when indicating connected it should change to SKINNY_CALLSECURITYSTATE_NOTAUTHENTICATED
-			device->protocol->sendCallInfo(ci, callid, calltype, lineInstance, ci->content.callInstance, force ? SKINNY_CALLSECURITYSTATE_NOTAUTHENTICATED : SKINNY_CALLSECURITYSTATE_UNKNOWN, device);
-			sccp_callinfo_wrlock(ci);
-			ci->content.changed = FALSE;
-			sccp_callinfo_unlock(ci);
-			return 1;
+	struct ci_recipient *recipient = NULL;
+	uint32_t generation = 0;
+	uint8_t callInstance = 0;
+	uint8_t idx = 0;
+
+	/* dependency on sccp_device.h should be fixed */
+	if (!device || !device->protocol || !device->protocol->sendCallInfo) {
+		return 0;
+	}
+
+	sccp_callinfo_wrlock(ci);
+	generation = ci->content.generation;
+	callInstance = ci->content.callInstance;
+	for (idx = 0; idx < SCCP_CALLINFO_MAX_RECIPIENTS; idx++) {
+		if (sccp_strequals(ci->recipients[idx].deviceId, device->id)) {
+			recipient = &ci->recipients[idx];
+			break;
+		}
+	}
+	if (!force && recipient && recipient->generation == generation && recipient->calltype == calltype) {
+		ci->suppressed++;
+		sccp_callinfo_unlock(ci);
+		sccp_log(DEBUGCAT_CALLINFO) ("%p: (sccp_callinfo_send) ci has not changed since last send to %s. Skipped sending\n", ci, device->id);
+		return 0;
+	}
+	if (!recipient) {
+		recipient = &ci->recipients[ci->nextRecipient];
+		ci->nextRecipient = (ci->nextRecipient + 1) % SCCP_CALLINFO_MAX_RECIPIENTS;
+		sccp_copy_string(recipient->deviceId, device->id, sizeof(recipient->deviceId));
+	}
+	recipient->generation = generation;
+	recipient->calltype = calltype;
+	ci->sent++;
+	sccp_callinfo_unlock(ci);
+
+	// using for to set the callsecuritystate is a temporary solution
+	// when indicating ringout the security state should be SKINNY_CALLSECURITYSTATE_UNKNOWN
+	// when indicating connected it should change to SKINNY_CALLSECURITYSTATE_NOTAUTHENTICATED
+	device->protocol->sendCallInfo(ci, callid, calltype, lineInstance, callInstance, force ? SKINNY_CALLSECURITYSTATE_NOTAUTHENTICATED : SKINNY_CALLSECURITYSTATE_UNKNOWN, device);
+	return 1;
+}
+
+/*!
+ * \brief Get a copy of the payload encoded for this protocol family, if it is still current
+ * \param ci SCCP CallInfo
+ * \param encoding Protocol Family
+ * \param generation Returns the current generation, to be handed to StoreEncoded on a miss
+ * \return copy of the cached message (caller fills in the per send fields) or NULL
+ */
+static sccp_msg_t *callinfo_GetEncoded(const sccp_callinfo_t * const ci, sccp_callinfo_encoding_t encoding, uint32_t *generation)
+{
+	sccp_callinfo_t *const cache_ci = (sccp_callinfo_t * const) ci;					/* discard const, the cache is not part of the content */
+	const sccp_msg_t *cached = NULL;
+	sccp_msg_t *msg = NULL;
+	size_t len = 0;
+
+	if (encoding >= SCCP_CALLINFO_ENCODING_SENTINEL) {
+		return NULL;
+	}
+	sccp_callinfo_wrlock(ci);
+	*generation = ci->content.generation;
+	cached = ci->encoded[encoding].msg;
+	if (cached && ci->encoded[encoding].generation == *generation) {
+		len = letohl(cached->header.length) + 8;							/* see sccp_build_packet */
+		if ((msg = sccp_malloc(len))) {
+			memcpy(msg, cached, len);
+			cache_ci->reused++;
 		}
-	} else {
-		sccp_log(DEBUGCAT_CALLINFO) ("%p: (sccp_callinfo_send) ci has not changed since last send. Skipped sending\n", ci);
 	}
-	
-	return 0;
+	sccp_callinfo_unlock(ci);
+	return msg;
 }
 
+/*!
+ * \brief Remember the payload encoded from generation, unless the callinfo has changed since
+ */
+static void callinfo_StoreEncoded(const sccp_callinfo_t * const ci, sccp_callinfo_encoding_t encoding, uint32_t generation, const sccp_msg_t * const msg)
+{
+	sccp_callinfo_t *const cache_ci = (sccp_callinfo_t * const) ci;					/* discard const, the cache is not part of the content */
+	sccp_msg_t *copy = NULL;
+	size_t len = 0;
+
+	if (encoding >= SCCP_CALLINFO_ENCODING_SENTINEL || !msg) {
+		return;
+	}
+	len = letohl(msg->header.length) + 8;									/* see sccp_build_packet */
+	sccp_callinfo_wrlock(ci);
+	if (ci->content.generation == generation && (copy = sccp_malloc(len))) {
+		memcpy(copy, msg, len);
+		if (cache_ci->encoded[encoding].msg) {
+			sccp_free(cache_ci->encoded[encoding].msg);
+		}
+		cache_ci->encoded[encoding].msg = copy;
+		cache_ci->encoded[encoding].generation = generation;
+	}
+	sccp_callinfo_unlock(ci);
+}
+
+static void callinfo_GetStats(const sccp_callinfo_t * const ci, uint32_t *sent, uint32_t *suppressed, uint32_t *reused)
+{
+	sccp_callinfo_rdlock(ci);
+	*sent = ci->sent;
+	*suppressed = ci->suppressed;
+	*reused = ci->reused;
+	sccp_callinfo_unlock(ci);
+}
 
 static int callinfo_SetCalledParty(sccp_callinfo_t * const ci, const char name[StationMaxNameSize], const char number[StationMaxDirnumSize], const char voicemail[StationMaxDirnumSize])
 {
@@ -573,33 +717,33 @@ static gcc_inline boolean_t __GetCallInfoStr(const sccp_callinfo_t * const ci, p
 	pbx_assert(ci != NULL);
 	sccp_callinfo_rdlock(ci);
 	pbx_str_append(buf, 0, "%p: (getCallInfoStr):\n", ci);
-	if (ci->content.entries[CALLED_PARTY].NumberValid || ci->content.entries[CALLED_PARTY].VoiceMailboxValid) {
-		pbx_str_append(buf, 0, " - calledParty: %s <%s>%s%s%s\n", ci->content.entries[CALLED_PARTY].Name, ci->content.entries[CALLED_PARTY].Number, 
-			(ci->content.entries[CALLED_PARTY].VoiceMailboxValid) ? " voicemail: " : "", ci->content.entries[CALLED_PARTY].VoiceMailbox, 
-			(ci->content.entries[CALLED_PARTY].NumberValid) ? ", valid" : ", invalid");
-	}
-	if (ci->content.entries[CALLING_PARTY].NumberValid || ci->content.entries[CALLING_PARTY].VoiceMailboxValid) {
-		pbx_str_append(buf, 0, " - callingParty: %s <%s>%s%s%s\n", ci->content.entries[CALLING_PARTY].Name, ci->content.entries[CALLING_PARTY].Number, 
-			(ci->content.entries[CALLING_PARTY].VoiceMailboxValid) ? " voicemail: " : "", ci->content.entries[CALLING_PARTY].VoiceMailbox, 
-			(ci->content.entries[CALLING_PARTY].NumberValid) ? ", valid" : ", invalid");
-	}
-	if (ci->content.entries[ORIG_CALLED_PARTY].NumberValid || ci->content.entries[ORIG_CALLED_PARTY].VoiceMailboxValid) {
-		pbx_str_append(buf, 0, " - originalCalledParty: %s <%s>%s%s%s, reason: %d\n", ci->content.entries[ORIG_CALLED_PARTY].Name, ci->content.entries[ORIG_CALLED_PARTY].Number, 
-			(ci->content.entries[ORIG_CALLED_PARTY].VoiceMailboxValid) ? " voicemail: " : "", ci->content.entries[ORIG_CALLED_PARTY].VoiceMailbox, 
-			(ci->content.entries[ORIG_CALLED_PARTY].NumberValid) ? ", valid" : ", invalid",
+	if (ci->content.entries[SCCP_CALLINFO_PARTY_CALLED].NumberValid || ci->content.entries[SCCP_CALLINFO_PARTY_CALLED].VoiceMailboxValid) {
+		pbx_str_append(buf, 0, " - calledParty: %s <%s>%s%s%s\n", ci->content.entries[SCCP_CALLINFO_PARTY_CALLED].Name, ci->content.entries[SCCP_CALLINFO_PARTY_CALLED].Number, 
+			(ci->content.entries[SCCP_CALLINFO_PARTY_CALLED].VoiceMailboxValid) ? " voicemail: " : "", ci->content.entries[SCCP_CALLINFO_PARTY_CALLED].VoiceMailbox, 
+			(ci->content.entries[SCCP_CALLINFO_PARTY_CALLED].NumberValid) ? ", valid" : ", invalid");
+	}
+	if (ci->content.entries[SCCP_CALLINFO_PARTY_CALLING].NumberValid || ci->content.entries[SCCP_CALLINFO_PARTY_CALLING].VoiceMailboxValid) {
+		pbx_str_append(buf, 0, " - callingParty: %s <%s>%s%s%s\n", ci->content.entries[SCCP_CALLINFO_PARTY_CALLING].Name, ci->content.entries[SCCP_CALLINFO_PARTY_CALLING].Number, 
+			(ci->content.entries[SCCP_CALLINFO_PARTY_CALLING].VoiceMailboxValid) ? " voicemail: " : "", ci->content.entries[SCCP_CALLINFO_PARTY_CALLING].VoiceMailbox, 
+			(ci->content.entries[SCCP_CALLINFO_PARTY_CALLING].NumberValid) ? ", valid" : ", invalid");
+	}
+	if (ci->content.entries[SCCP_CALLINFO_PARTY_ORIG_CALLED].NumberValid || ci->content.entries[SCCP_CALLINFO_PARTY_ORIG_CALLED].VoiceMailboxValid) {
+		pbx_str_append(buf, 0, " - originalCalledParty: %s <%s>%s%s%s, reason: %d\n", ci->content.entries[SCCP_CALLINFO_PARTY_ORIG_CALLED].Name, ci->content.entries[SCCP_CALLINFO_PARTY_ORIG_CALLED].Number, 
+			(ci->content.entries[SCCP_CALLINFO_PARTY_ORIG_CALLED].VoiceMailboxValid) ? " voicemail: " : "", ci->content.entries[SCCP_CALLINFO_PARTY_ORIG_CALLED].VoiceMailbox, 
+			(ci->content.entries[SCCP_CALLINFO_PARTY_ORIG_CALLED].NumberValid) ? ", valid" : ", invalid",
 			ci->content.originalCdpnRedirectReason);
 	}
-	if (ci->content.entries[ORIG_CALLING_PARTY].NumberValid) {
-		pbx_str_append(buf, 0, " - originalCallingParty: %s <%s>, valid\n", ci->content.entries[ORIG_CALLING_PARTY].Name, ci->content.entries[ORIG_CALLING_PARTY].Number);
+	if (ci->content.entries[SCCP_CALLINFO_PARTY_ORIG_CALLING].NumberValid) {
+		pbx_str_append(buf, 0, " - originalCallingParty: %s <%s>, valid\n", ci->content.entries[SCCP_CALLINFO_PARTY_ORIG_CALLING].Name, ci->content.entries[SCCP_CALLINFO_PARTY_ORIG_CALLING].Number);
 	}
-	if (ci->content.entries[LAST_REDIRECTING_PARTY].NumberValid || ci->content.entries[LAST_REDIRECTING_PARTY].VoiceMailboxValid) {
-		pbx_str_append(buf, 0, " - lastRedirectingParty: %s <%s>%s%s%s, reason: %d\n", ci->content.entries[LAST_REDIRECTING_PARTY].Name, ci->content.entries[LAST_REDIRECTING_PARTY].Number, 
-			(ci->content.entries[LAST_REDIRECTING_PARTY].VoiceMailboxValid) ? " voicemail: " : "", ci->content.entries[LAST_REDIRECTING_PARTY].VoiceMailbox, 
-			(ci->content.entries[LAST_REDIRECTING_PARTY].NumberValid) ? ", valid" : ", invalid",
+	if (ci->content.entries[SCCP_CALLINFO_PARTY_LAST_REDIRECTING].NumberValid || ci->content.entries[SCCP_CALLINFO_PARTY_LAST_REDIRECTING].VoiceMailboxValid) {
+		pbx_str_append(buf, 0, " - lastRedirectingParty: %s <%s>%s%s%s, reason: %d\n", ci->content.entries[SCCP_CALLINFO_PARTY_LAST_REDIRECTING].Name, ci->content.entries[SCCP_CALLINFO_PARTY_LAST_REDIRECTING].Number, 
+			(ci->content.entries[SCCP_CALLINFO_PARTY_LAST_REDIRECTING].VoiceMailboxValid) ? " voicemail: " : "", ci->content.entries[SCCP_CALLINFO_PARTY_LAST_REDIRECTING].VoiceMailbox, 
+			(ci->content.entries[SCCP_CALLINFO_PARTY_LAST_REDIRECTING].NumberValid) ? ", valid" : ", invalid",
 			ci->content.lastRedirectingReason);
 	}
-	if (ci->content.entries[HUNT_PILOT].NumberValid) {
-		pbx_str_append(buf, 0, " - huntPilot: %s <%s>, valid\n", ci->content.entries[HUNT_PILOT].Name, ci->content.entries[HUNT_PILOT].Number);
+	if (ci->content.entries[SCCP_CALLINFO_PARTY_HUNT_PILOT].NumberValid) {
+		pbx_str_append(buf, 0, " - huntPilot: %s <%s>, valid\n", ci->content.entries[SCCP_CALLINFO_PARTY_HUNT_PILOT].Name, ci->content.entries[SCCP_CALLINFO_PARTY_HUNT_PILOT].Number);
 	}
 	pbx_str_append(buf, 0, " - presentation: %s\n\n", sccp_callerid_presentation2str(ci->content.presentation));
 	sccp_callinfo_unlock(ci);
@@ -627,6 +771,16 @@ const CallInfoInterface iCallInfo = {
 	callinfo_CopyByKey,
 	callinfo_Send,
 	callinfo_Getter,
+	callinfo_SetString,
+	callinfo_SetValue,
+	callinfo_GetValue,
+	callinfo_GetParty,
+	callinfo_RdLock,
+	callinfo_PeekString,
+	callinfo_Unlock,
+	callinfo_GetEncoded,
+	callinfo_StoreEncoded,
+	callinfo_GetStats,
 	callinfo_SetCalledParty,
 	callinfo_SetCallingParty,
 	callinfo_SetOrigCalledParty,
@@ -637,6 +791,7 @@ const CallInfoInterface iCallInfo = {
 
 #if CS_TEST_FRAMEWORK
 #include <asterisk/test.h>
+#define NUM_BENCHMARK_LOOPS 100000
 AST_TEST_DEFINE(sccp_callinfo_tests)
 {
 	switch(cmd) {
@@ -769,6 +924,59 @@ AST_TEST_DEFINE(sccp_callinfo_tests)
 	citest2 = iCallInfo.Destructor(&citest2);
 	pbx_test_validate(test, citest2 == NULL);
 	
+	pbx_test_status_update(test, "Callinfo typed accessors...\n");
+	name[0]='\0'; number[0]='\0'; voicemail[0]='\0'; nullstr[0]='\0'; changes = 0; reason = 0; presentation = CALLERID_PRESENTATION_ALLOWED;
+	pbx_test_validate(test, iCallInfo.SetString(citest, SCCP_CALLINFO_CALLINGPARTY_NAME, "calling") == 1);
+	pbx_test_validate(test, iCallInfo.SetString(citest, SCCP_CALLINFO_CALLINGPARTY_NAME, "calling") == 0);
+	pbx_test_validate(test, iCallInfo.SetString(citest, SCCP_CALLINFO_PRESENTATION, "calling") == 0);
+	pbx_test_validate(test, iCallInfo.SetValue(citest, SCCP_CALLINFO_LAST_REDIRECT_REASON, 5) == 1);
+	pbx_test_validate(test, iCallInfo.GetValue(citest, SCCP_CALLINFO_LAST_REDIRECT_REASON) == 5);
+	changes = iCallInfo.GetParty(citest, SCCP_CALLINFO_PARTY_CALLED, name, number, &presentation);
+	pbx_test_validate(test, changes == 2);
+	pbx_test_validate(test, !strcmp(name, "name"));
+	pbx_test_validate(test, !strcmp(number, "number"));
+	pbx_test_validate(test, presentation == CALLERID_PRESENTATION_FORBIDDEN);
+	changes = iCallInfo.GetParty(citest, SCCP_CALLINFO_PARTY_CALLING, name, number, NULL);
+	pbx_test_validate(test, changes == 1);
+	pbx_test_validate(test, !strcmp(name, "calling") && sccp_strlen_zero(number));
+
+	iCallInfo.RdLock(citest);
+	boolean_t peekVoicemail = sccp_strequals(iCallInfo.PeekString(citest, SCCP_CALLINFO_CALLEDPARTY_VOICEMAIL), "voicemail");
+	boolean_t peekInvalid = sccp_strlen_zero(iCallInfo.PeekString(citest, SCCP_CALLINFO_CALLINGPARTY_NUMBER));
+	iCallInfo.Unlock(citest);
+	pbx_test_validate(test, peekVoicemail && peekInvalid);
+
+	pbx_test_status_update(test, "Callinfo getter microbenchmark...\n");
+	struct timeval start = pbx_tvnow();
+	size_t total = 0;
+	long ms = 0;
+	int loop = 0;
+	for (loop = 0; loop < NUM_BENCHMARK_LOOPS; loop++) {
+		name[0] = '\0'; number[0] = '\0';
+		iCallInfo.Getter(citest, SCCP_CALLINFO_CALLEDPARTY_NAME, &name, SCCP_CALLINFO_CALLEDPARTY_NUMBER, &number, SCCP_CALLINFO_PRESENTATION, &presentation, SCCP_CALLINFO_KEY_SENTINEL);
+		total += strlen(name) + strlen(number);
+	}
+	ms = ast_tvdiff_ms(pbx_tvnow(), start);
+	pbx_test_status_update(test, "%-12s %d calls in %ld ms\n", "Getter", NUM_BENCHMARK_LOOPS, ms);
+
+	start = pbx_tvnow();
+	for (loop = 0; loop < NUM_BENCHMARK_LOOPS; loop++) {
+		iCallInfo.GetParty(citest, SCCP_CALLINFO_PARTY_CALLED, name, number, &presentation);
+		total += strlen(name) + strlen(number);
+	}
+	ms = ast_tvdiff_ms(pbx_tvnow(), start);
+	pbx_test_status_update(test, "%-12s %d calls in %ld ms\n", "GetParty", NUM_BENCHMARK_LOOPS, ms);
+
+	start = pbx_tvnow();
+	for (loop = 0; loop < NUM_BENCHMARK_LOOPS; loop++) {
+		iCallInfo.RdLock(citest);
+		total += strlen(iCallInfo.PeekString(citest, SCCP_CALLINFO_CALLEDPARTY_NAME)) + strlen(iCallInfo.PeekString(citest, SCCP_CALLINFO_CALLEDPARTY_NUMBER));
+		iCallInfo.Unlock(citest);
+	}
+	ms = ast_tvdiff_ms(pbx_tvnow(), start);
+	pbx_test_status_update(test, "%-12s %d calls in %ld ms\n", "PeekString", NUM_BENCHMARK_LOOPS, ms);
+	pbx_test_validate(test, total == (size_t) NUM_BENCHMARK_LOOPS * 3 * (strlen("name") + strlen("number")));
+
 	pbx_test_status_update(test, "Callinfo Test Destructor...\n");
 	citest = iCallInfo.Destructor(&citest);
 	pbx_test_validate(test, citest == NULL);
@@ -778,14 +986,105 @@ AST_TEST_DEFINE(sccp_callinfo_tests)
 	return AST_TEST_PASS;
 }
 
+static int test_sendCallInfo_count = 0;
+static void test_sendCallInfo(const sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const uint8_t callInstance, const skinny_callsecuritystate_t callsecurityState, constDevicePtr device)
+{
+	test_sendCallInfo_count++;
+}
+
+AST_TEST_DEFINE(sccp_callinfo_send_cache)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "callinfo_send_cache";
+			info->category = "/channels/chan_sccp/";
+			info->summary = "chan-sccp-b callinfo send suppression and encoding cache";
+			info->description = "chan-sccp-b callinfo generation, per device suppression and encoded payload cache tests";
+			return AST_TEST_NOT_RUN;
+	        case TEST_EXECUTE:
+	        	break;
+	}
+
+	enum ast_test_result_state res = AST_TEST_PASS;
+	const sccp_deviceProtocol_t testProtocol = {.type = SCCP_PROTOCOL, .version = 16, .sendCallInfo = test_sendCallInfo};
+	sccp_device_t *d1 = sccp_calloc(2, sizeof(sccp_device_t));
+	sccp_device_t *d2 = d1 ? &d1[1] : NULL;
+	sccp_callinfo_t *citest = iCallInfo.Constructor(1);
+	sccp_msg_t *msg = NULL;
+	uint32_t generation = 0, sent = 0, suppressed = 0, reused = 0;
+
+	pbx_test_validate_cleanup(test, d1 != NULL && citest != NULL, res, cleanup);
+	d1->protocol = &testProtocol;
+	d2->protocol = &testProtocol;
+	sccp_copy_string(d1->id, "SEP000000000001", sizeof(d1->id));
+	sccp_copy_string(d2->id, "SEP000000000002", sizeof(d2->id));
+	iCallInfo.SetCalledParty(citest, "name", "100", NULL);
+	test_sendCallInfo_count = 0;
+
+	pbx_test_status_update(test, "Each device on a shared line receives the callinfo once...\n");
+	pbx_test_validate_cleanup(test, iCallInfo.Send(citest, 1, SKINNY_CALLTYPE_INBOUND, 1, d1, FALSE) == 1, res, cleanup);
+	pbx_test_validate_cleanup(test, iCallInfo.Send(citest, 1, SKINNY_CALLTYPE_INBOUND, 1, d2, FALSE) == 1, res, cleanup);
+	pbx_test_validate_cleanup(test, iCallInfo.Send(citest, 1, SKINNY_CALLTYPE_INBOUND, 1, d1, FALSE) == 0, res, cleanup);
+	pbx_test_validate_cleanup(test, iCallInfo.Send(citest, 1, SKINNY_CALLTYPE_INBOUND, 1, d2, FALSE) == 0, res, cleanup);
+	pbx_test_validate_cleanup(test, iCallInfo.Send(citest, 1, SKINNY_CALLTYPE_INBOUND, 1, d1, TRUE) == 1, res, cleanup);
+	pbx_test_validate_cleanup(test, test_sendCallInfo_count == 3, res, cleanup);
+
+	pbx_test_status_update(test, "Setting an unchanged value keeps the generation, a changed one resends...\n");
+	pbx_test_validate_cleanup(test, iCallInfo.SetCalledParty(citest, "name", "100", NULL) == 0, res, cleanup);
+	pbx_test_validate_cleanup(test, iCallInfo.Send(citest, 1, SKINNY_CALLTYPE_INBOUND, 1, d2, FALSE) == 0, res, cleanup);
+	pbx_test_validate_cleanup(test, iCallInfo.SetCalledParty(citest, "other", "101", NULL) > 0, res, cleanup);
+	pbx_test_validate_cleanup(test, iCallInfo.Send(citest, 1, SKINNY_CALLTYPE_INBOUND, 1, d2, FALSE) == 1, res, cleanup);
+	pbx_test_validate_cleanup(test, iCallInfo.Send(citest, 1, SKINNY_CALLTYPE_OUTBOUND, 1, d2, FALSE) == 1, res, cleanup);
+
+	pbx_test_status_update(test, "Encoded payload is reused until the callinfo changes...\n");
+	pbx_test_validate_cleanup(test, iCallInfo.GetEncoded(citest, SCCP_CALLINFO_ENCODING_V16, &generation) == NULL, res, cleanup);
+	REQ(msg, CallInfoDynamicMessage);
+	pbx_test_validate_cleanup(test, msg != NULL, res, cleanup);
+	msg->data.CallInfoDynamicMessage.lel_originalCdpnRedirectReason = htolel(4);
+	iCallInfo.StoreEncoded(citest, SCCP_CALLINFO_ENCODING_V16, generation, msg);
+	sccp_free(msg);
+	msg = iCallInfo.GetEncoded(citest, SCCP_CALLINFO_ENCODING_V16, &generation);
+	pbx_test_validate_cleanup(test, msg != NULL && letohl(msg->data.CallInfoDynamicMessage.lel_originalCdpnRedirectReason) == 4, res, cleanup);
+	sccp_free(msg);
+	pbx_test_validate_cleanup(test, iCallInfo.GetEncoded(citest, SCCP_CALLINFO_ENCODING_V7, &generation) == NULL, res, cleanup);
+	iCallInfo.SetCallingParty(citest, "caller", "200", NULL);
+	pbx_test_validate_cleanup(test, (msg = iCallInfo.GetEncoded(citest, SCCP_CALLINFO_ENCODING_V16, &generation)) == NULL, res, cleanup);
+
+	pbx_test_status_update(test, "A payload encoded from a stale generation is not stored...\n");
+	REQ(msg, CallInfoDynamicMessage);
+	pbx_test_validate_cleanup(test, msg != NULL, res, cleanup);
+	iCallInfo.SetCallingParty(citest, "caller2", "201", NULL);
+	iCallInfo.StoreEncoded(citest, SCCP_CALLINFO_ENCODING_V16, generation, msg);
+	sccp_free(msg);
+	pbx_test_validate_cleanup(test, (msg = iCallInfo.GetEncoded(citest, SCCP_CALLINFO_ENCODING_V16, &generation)) == NULL, res, cleanup);
+
+	iCallInfo.GetStats(citest, &sent, &suppressed, &reused);
+	pbx_test_status_update(test, "sent:%d, suppressed:%d, reused:%d\n", sent, suppressed, reused);
+	pbx_test_validate_cleanup(test, sent == 5 && suppressed == 3 && reused == 1, res, cleanup);
+
+cleanup:
+	if (msg) {
+		sccp_free(msg);
+	}
+	if (citest) {
+		iCallInfo.Destructor(&citest);
+	}
+	if (d1) {
+		sccp_free(d1);
+	}
+	return res;
+}
+
 static void __attribute__((constructor)) sccp_register_tests(void)
 {
         AST_TEST_REGISTER(sccp_callinfo_tests);
+        AST_TEST_REGISTER(sccp_callinfo_send_cache);
 }
 
 static void __attribute__((destructor)) sccp_unregister_tests(void)
 {
         AST_TEST_UNREGISTER(sccp_callinfo_tests);
+        AST_TEST_UNREGISTER(sccp_callinfo_send_cache);
 }
 #endif
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
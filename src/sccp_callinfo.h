@@ -23,6 +23,28 @@ __BEGIN_C_EXTERN__
 /* forward declaration */
 struct sccp_callinfo;
 
+/*!
+ * \brief CallInfo Parties, each holding a name, number and (mostly) a voicemailbox
+ */
+typedef enum {
+	SCCP_CALLINFO_PARTY_CALLED,
+	SCCP_CALLINFO_PARTY_CALLING,
+	SCCP_CALLINFO_PARTY_ORIG_CALLED,
+	SCCP_CALLINFO_PARTY_ORIG_CALLING,
+	SCCP_CALLINFO_PARTY_LAST_REDIRECTING,
+	SCCP_CALLINFO_PARTY_HUNT_PILOT,
+	SCCP_CALLINFO_PARTY_SENTINEL,
+} sccp_callinfo_party_t;
+
+/*!
+ * \brief Protocol families sharing the same encoded CallInfo payload
+ */
+typedef enum {
+	SCCP_CALLINFO_ENCODING_V7,
+	SCCP_CALLINFO_ENCODING_V16,
+	SCCP_CALLINFO_ENCODING_SENTINEL,
+} sccp_callinfo_encoding_t;
+
 /* Definition of the functions associated with this type. */
 typedef struct tagCallInfo {
 	sccp_callinfo_t * const (*Constructor)(uint8_t callInstance);
@@ -54,6 +76,33 @@ typedef struct tagCallInfo {
 	 */
 	int (*Getter)(const sccp_callinfo_t * const ci, int key, ...);						// key is a va_arg of type sccp_callinfo_key_t
 
+	/*
+	 * \brief typed accessors, without the varargs walk, for the hot paths (hint notify / indicate)
+	 * SetString / SetValue return the number of changed fields (0 or 1), a NULL string is ignored
+	 * GetParty copies name and number of one party (presentation may be NULL) under a single read lock
+	 */
+	int (*SetString)(sccp_callinfo_t * const ci, sccp_callinfo_key_t key, const char *value);
+	int (*SetValue)(sccp_callinfo_t * const ci, sccp_callinfo_key_t key, int value);
+	int (*GetValue)(const sccp_callinfo_t * const ci, sccp_callinfo_key_t key);
+	int (*GetParty)(const sccp_callinfo_t * const ci, sccp_callinfo_party_t party, char name[StationMaxNameSize], char number[StationMaxDirnumSize], sccp_callerid_presentation_t *presentation);
+
+	/*
+	 * \brief zero-copy getter, the returned string stays valid until Unlock
+	 * iCallInfo.RdLock(ci); name = iCallInfo.PeekString(ci, SCCP_CALLINFO_CALLEDPARTY_NAME); ...; iCallInfo.Unlock(ci);
+	 */
+	void (*RdLock)(const sccp_callinfo_t * const ci);
+	const char *(*PeekString)(const sccp_callinfo_t * const ci, sccp_callinfo_key_t key);
+	void (*Unlock)(const sccp_callinfo_t * const ci);
+
+	/*
+	 * \brief cached encoding of the callinfo payload, shared by all devices using the same protocol family
+	 * GetEncoded returns a copy of the cached message, or NULL and the generation to pass to StoreEncoded
+	 * StoreEncoded drops the message when the callinfo changed in between
+	 */
+	sccp_msg_t *(*GetEncoded)(const sccp_callinfo_t * const ci, sccp_callinfo_encoding_t encoding, uint32_t *generation);
+	void (*StoreEncoded)(const sccp_callinfo_t * const ci, sccp_callinfo_encoding_t encoding, uint32_t generation, const sccp_msg_t * const msg);
+	void (*GetStats)(const sccp_callinfo_t * const ci, uint32_t *sent, uint32_t *suppressed, uint32_t *reused);
+
 	/* helpers */
 	int (*SetCalledParty)(sccp_callinfo_t * const ci, const char name[StationMaxDirnumSize], const char number[StationMaxDirnumSize], const char voicemail[StationMaxDirnumSize]);
 	int (*SetCallingParty)(sccp_callinfo_t * const ci, const char name[StationMaxDirnumSize], const char number[StationMaxDirnumSize], const char voicemail[StationMaxDirnumSize]);
@@ -0,0 +1,425 @@
+/*!
+ * \file        sccp_capture.c
+ * \brief       SCCP Session Capture and Replay
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * While a capture is running, every session accepted from then on writes the raw frames it receives and sends to its own capture
+ * file (see sccp_capture.h for the layout). sccp_capture_replay() feeds the inbound frames of one or more capture files back
+ * through the session layer, so that a registration storm recorded on a live system can be repeated as a benchmark.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_capture.h"
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#include "sccp_netsock.h"
+#include "sccp_session.h"
+#include "sccp_utils.h"
+#include <netinet/in.h>
+#include <sys/stat.h>
+
+/*!
+ * \brief SCCP Session Capture Structure
+ */
+struct sccp_capture {
+	sccp_mutex_t lock;											/*!< Serializes the session thread and the senders */
+	FILE *file;												/*!< Capture File, NULL when only counting (replay / stopped capture) */
+	uint32_t epoch;												/*!< Capture run this file belongs to */
+	uint32_t frames[SCCP_CAPTURE_DIRECTION_SENTINEL];							/*!< Frames per direction */
+	uint64_t bytes[SCCP_CAPTURE_DIRECTION_SENTINEL];							/*!< Bytes per direction */
+	uint32_t messages[SCCP_CAPTURE_MESSAGE_SLOTS];								/*!< Outbound frames per message type */
+};
+
+AST_MUTEX_DEFINE_STATIC(sccp_capture_lock);									/*!< Protects the capture run below */
+static volatile boolean_t sccp_capture_running = FALSE;
+static volatile uint32_t sccp_capture_epoch = 0;								/*!< Incremented on every start / stop */
+static uint32_t sccp_capture_files = 0;										/*!< Files opened during the current run */
+static char sccp_capture_directory[SCCP_PATH_MAX] = "";
+
+static int sccp_capture_messageSlot(sccp_mid_t mid)
+{
+	if (mid <= SCCP_MESSAGE_HIGH_BOUNDARY) {
+		return mid;
+	} else if (mid >= SPCP_MESSAGE_LOW_BOUNDARY && mid <= SPCP_MESSAGE_HIGH_BOUNDARY) {
+		return SCCP_MESSAGE_HIGH_BOUNDARY + 1 + mid - SPCP_MESSAGE_LOW_BOUNDARY;
+	}
+	return -1;
+}
+
+/*!
+ * \brief Convert a slot of sccp_capture_replay_stats_t->outMessages back into the message id
+ */
+sccp_mid_t sccp_capture_messageId(int slot)
+{
+	return (slot <= SCCP_MESSAGE_HIGH_BOUNDARY) ? (sccp_mid_t) slot : (sccp_mid_t) (slot - (SCCP_MESSAGE_HIGH_BOUNDARY + 1) + SPCP_MESSAGE_LOW_BOUNDARY);
+}
+
+/*!
+ * \brief Start capturing the sessions accepted from now on
+ * \param directory Directory the capture files are written to (created if necessary)
+ * \return TRUE on success
+ */
+boolean_t sccp_capture_start(const char *directory)
+{
+	if (sccp_strlen_zero(directory)) {
+		return FALSE;
+	}
+	if (mkdir(directory, 0750) && errno != EEXIST) {
+		pbx_log(LOG_ERROR, "SCCP: (sccp_capture_start) Could not create capture directory '%s': %s\n", directory, strerror(errno));
+		return FALSE;
+	}
+	sccp_mutex_lock(&sccp_capture_lock);
+	sccp_copy_string(sccp_capture_directory, directory, sizeof(sccp_capture_directory));
+	sccp_capture_files = 0;
+	sccp_capture_epoch++;
+	sccp_capture_running = TRUE;
+	sccp_mutex_unlock(&sccp_capture_lock);
+	pbx_log(LOG_NOTICE, "SCCP: Capturing new sessions to '%s'\n", directory);
+	return TRUE;
+}
+
+/*!
+ * \brief Stop capturing, open capture files are closed by their session on the next frame
+ */
+void sccp_capture_stop(void)
+{
+	sccp_mutex_lock(&sccp_capture_lock);
+	if (sccp_capture_running) {
+		pbx_log(LOG_NOTICE, "SCCP: Stopped capturing sessions to '%s' (%u files)\n", sccp_capture_directory, sccp_capture_files);
+	}
+	sccp_capture_epoch++;
+	sccp_capture_running = FALSE;
+	sccp_mutex_unlock(&sccp_capture_lock);
+}
+
+boolean_t sccp_capture_isRunning(char *directory, size_t directoryLen, uint32_t *files)
+{
+	boolean_t running;
+
+	sccp_mutex_lock(&sccp_capture_lock);
+	running = sccp_capture_running;
+	if (directory) {
+		sccp_copy_string(directory, sccp_capture_directory, directoryLen);
+	}
+	if (files) {
+		*files = sccp_capture_files;
+	}
+	sccp_mutex_unlock(&sccp_capture_lock);
+	return running;
+}
+
+static sccp_capture_t *sccp_capture_new(FILE *file, uint32_t epoch)
+{
+	sccp_capture_t *capture;
+
+	if (!(capture = sccp_calloc(sizeof *capture, 1))) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return NULL;
+	}
+	sccp_mutex_init(&capture->lock);
+	capture->file = file;
+	capture->epoch = epoch;
+	return capture;
+}
+
+/*!
+ * \brief Open the capture file for a new session
+ * \param peer Address of the device
+ * \param protocolType Session Protocol Type
+ * \return Capture or NULL when no capture is running
+ */
+sccp_capture_t *sccp_capture_open(const struct sockaddr_storage *peer, uint32_t protocolType)
+{
+	char filename[SCCP_PATH_MAX];
+	char addrStr[INET6_ADDRSTRLEN];
+	sccp_capture_file_header_t fileHeader = { SCCP_CAPTURE_MAGIC };
+	struct timeval now = pbx_tvnow();
+	sccp_capture_t *capture = NULL;
+	FILE *file = NULL;
+	uint32_t epoch;
+
+	if (!sccp_capture_running || !peer) {
+		return NULL;
+	}
+
+	sccp_copy_string(addrStr, sccp_netsock_stringify_addr(peer), sizeof(addrStr));
+	fileHeader.lel_version = htolel(SCCP_CAPTURE_VERSION);
+	fileHeader.lel_protocolType = htolel(protocolType);
+	fileHeader.lel_startSec = htolel((uint32_t) now.tv_sec);
+	fileHeader.lel_startUsec = htolel((uint32_t) now.tv_usec);
+	if (sccp_netsock_is_IPv6(peer)) {
+		const struct sockaddr_in6 *in6 = (const struct sockaddr_in6 *) peer;
+		fileHeader.ipVersion = 6;
+		fileHeader.port = in6->sin6_port;
+		memcpy(fileHeader.addr, &in6->sin6_addr, sizeof(in6->sin6_addr));
+	} else {
+		const struct sockaddr_in *in = (const struct sockaddr_in *) peer;
+		fileHeader.ipVersion = 4;
+		fileHeader.port = in->sin_port;
+		memcpy(fileHeader.addr, &in->sin_addr, sizeof(in->sin_addr));
+	}
+
+	sccp_mutex_lock(&sccp_capture_lock);
+	if (sccp_capture_running) {
+		snprintf(filename, sizeof(filename), "%s/%s-%ld-%u.sccpcap", sccp_capture_directory, addrStr, (long) now.tv_sec, sccp_capture_files++);
+		epoch = sccp_capture_epoch;
+		if (!(file = fopen(filename, "w"))) {
+			pbx_log(LOG_WARNING, "SCCP: (sccp_capture_open) Could not open capture file '%s': %s\n", filename, strerror(errno));
+		}
+	}
+	sccp_mutex_unlock(&sccp_capture_lock);
+
+	if (file) {
+		if (fwrite(&fileHeader, sizeof(fileHeader), 1, file) != 1 || !(capture = sccp_capture_new(file, epoch))) {
+			fclose(file);
+			return NULL;
+		}
+		sccp_log(DEBUGCAT_SOCKET) (VERBOSE_PREFIX_3 "SCCP: Capturing session from %s to '%s'\n", addrStr, filename);
+	}
+	return capture;
+}
+
+/*!
+ * \brief Account for a frame and append it to the capture file
+ * \param capture Session Capture
+ * \param direction Direction of the frame
+ * \param frame Raw frame (sccp_header_t + payload)
+ * \param len Number of bytes in frame
+ */
+void sccp_capture_frame(sccp_capture_t *capture, sccp_capture_direction_t direction, const void *frame, size_t len)
+{
+	struct timeval now;
+	sccp_capture_record_header_t recordHeader = { 0 };
+
+	if (!capture || len < SCCP_PACKET_HEADER) {
+		return;
+	}
+
+	sccp_mutex_lock(&capture->lock);
+	capture->frames[direction]++;
+	capture->bytes[direction] += len;
+	if (direction == SCCP_CAPTURE_OUTBOUND) {
+		int slot = sccp_capture_messageSlot(letohl(((const sccp_header_t *) frame)->lel_messageId));
+		if (slot >= 0) {
+			capture->messages[slot]++;
+		}
+	}
+	if (capture->file && (!sccp_capture_running || capture->epoch != sccp_capture_epoch)) {
+		fclose(capture->file);
+		capture->file = NULL;
+	}
+	if (capture->file) {
+		now = pbx_tvnow();
+		recordHeader.lel_sec = htolel((uint32_t) now.tv_sec);
+		recordHeader.lel_usec = htolel((uint32_t) now.tv_usec);
+		recordHeader.direction = direction;
+		recordHeader.lel_length = htolel((uint32_t) len);
+		if (fwrite(&recordHeader, sizeof(recordHeader), 1, capture->file) != 1 || fwrite(frame, len, 1, capture->file) != 1) {
+			pbx_log(LOG_WARNING, "SCCP: (sccp_capture_frame) Write failed (%s), closing capture file\n", strerror(errno));
+			fclose(capture->file);
+			capture->file = NULL;
+		}
+	}
+	sccp_mutex_unlock(&capture->lock);
+}
+
+/*!
+ * \brief Close the capture file and free the capture
+ */
+void sccp_capture_close(sccp_capture_t **capture)
+{
+	sccp_capture_t *c = *capture;
+
+	if (!c) {
+		return;
+	}
+	*capture = NULL;
+	if (c->file) {
+		fclose(c->file);
+	}
+	sccp_mutex_destroy(&c->lock);
+	sccp_free(c);
+}
+
+/* ----------------------------------------------------------------------------------------------------------------- REPLAY - */
+/*!
+ * \brief Capture File being Replayed
+ */
+typedef struct sccp_capture_replay {
+	const char *filename;
+	FILE *file;
+	sccp_session_t *session;										/*!< Replay Session, owns counter */
+	sccp_capture_t *counter;										/*!< Counts the frames the replay session sends */
+	sccp_capture_record_header_t next;									/*!< Header of the next record */
+	boolean_t pending;											/*!< next contains a record */
+	uint64_t nextUs;
+} sccp_capture_replay_t;
+
+static uint64_t sccp_capture_clockNs(clockid_t clock)
+{
+	struct timespec ts;
+
+	clock_gettime(clock, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static void sccp_capture_replay_readNext(sccp_capture_replay_t *replay)
+{
+	replay->pending = (fread(&replay->next, sizeof(replay->next), 1, replay->file) == 1);
+	if (replay->pending) {
+		replay->nextUs = (uint64_t) letohl(replay->next.lel_sec) * 1000000ULL + letohl(replay->next.lel_usec);
+	}
+}
+
+static boolean_t sccp_capture_replay_open(sccp_capture_replay_t *replay, const char *filename)
+{
+	sccp_capture_file_header_t fileHeader;
+	struct sockaddr_storage peer = { 0 };
+
+	replay->filename = filename;
+	if (!(replay->file = fopen(filename, "r"))) {
+		pbx_log(LOG_ERROR, "SCCP: (sccp_capture_replay) Could not open '%s': %s\n", filename, strerror(errno));
+		return FALSE;
+	}
+	if (fread(&fileHeader, sizeof(fileHeader), 1, replay->file) != 1 || memcmp(fileHeader.magic, SCCP_CAPTURE_MAGIC, sizeof(SCCP_CAPTURE_MAGIC)) || letohl(fileHeader.lel_version) != SCCP_CAPTURE_VERSION) {
+		pbx_log(LOG_ERROR, "SCCP: (sccp_capture_replay) '%s' is not a version %d sccp capture file\n", filename, SCCP_CAPTURE_VERSION);
+		return FALSE;
+	}
+	if (fileHeader.ipVersion == 6) {
+		struct sockaddr_in6 *in6 = (struct sockaddr_in6 *) &peer;
+		in6->sin6_family = AF_INET6;
+		in6->sin6_port = fileHeader.port;
+		memcpy(&in6->sin6_addr, fileHeader.addr, sizeof(in6->sin6_addr));
+	} else {
+		struct sockaddr_in *in = (struct sockaddr_in *) &peer;
+		in->sin_family = AF_INET;
+		in->sin_port = fileHeader.port;
+		memcpy(&in->sin_addr, fileHeader.addr, sizeof(in->sin_addr));
+	}
+	if (!(replay->counter = sccp_capture_new(NULL, 0)) || !(replay->session = sccp_session_createReplay(&peer, letohl(fileHeader.lel_protocolType), replay->counter))) {
+		return FALSE;
+	}
+	sccp_capture_replay_readNext(replay);
+	return TRUE;
+}
+
+static void sccp_capture_replay_close(sccp_capture_replay_t *replay, sccp_capture_replay_stats_t *stats)
+{
+	int slot;
+
+	if (replay->session) {
+		sccp_session_destroyReplay(replay->session);
+		replay->session = NULL;
+	}
+	if (replay->counter) {
+		stats->outFrames += replay->counter->frames[SCCP_CAPTURE_OUTBOUND];
+		stats->outBytes += replay->counter->bytes[SCCP_CAPTURE_OUTBOUND];
+		for (slot = 0; slot < SCCP_CAPTURE_MESSAGE_SLOTS; slot++) {
+			stats->outMessages[slot] += replay->counter->messages[slot];
+		}
+		sccp_capture_close(&replay->counter);
+	}
+	if (replay->file) {
+		fclose(replay->file);
+		replay->file = NULL;
+	}
+}
+
+/*!
+ * \brief Replay the inbound frames of a set of capture files through the session layer
+ * \param files Capture Files, one replay session is created per file
+ * \param numFiles Number of files
+ * \param speed 0 replays as fast as possible, 1.0 reproduces the captured inter frame gaps, 2.0 twice as fast, etc
+ * \param stats Replay Statistics (zeroed by this function)
+ * \return 0 on success, -1 if a capture file could not be read
+ *
+ * \note Frames of all files are merged by their timestamp, so the interleaving of the sessions is the one that was captured.
+ *       The outbound frames are counted instead of being sent, the captured outbound frames are only used for comparison.
+ */
+int sccp_capture_replay(char *const files[], int numFiles, double speed, sccp_capture_replay_stats_t *stats)
+{
+	sccp_capture_replay_t *replays;
+	unsigned char *frame;
+	uint64_t firstUs = 0, lastUs = 0, startWallNs, startProcessNs, startNs, frameNs;
+	int i, res = 0;
+
+	memset(stats, 0, sizeof(*stats));
+	if (numFiles <= 0) {
+		return -1;
+	}
+	if (!(replays = sccp_calloc(sizeof *replays, numFiles)) || !(frame = sccp_malloc(SCCP_MAX_PACKET * 2))) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		sccp_free(replays);
+		return -1;
+	}
+	for (i = 0; i < numFiles; i++) {
+		if (!sccp_capture_replay_open(&replays[i], files[i])) {
+			res = -1;
+			goto EXIT;
+		}
+		stats->sessions++;
+	}
+
+	startWallNs = sccp_capture_clockNs(CLOCK_MONOTONIC);
+	startProcessNs = sccp_capture_clockNs(CLOCK_PROCESS_CPUTIME_ID);
+	for (;;) {
+		sccp_capture_replay_t *replay = NULL;
+		uint32_t len;
+
+		for (i = 0; i < numFiles; i++) {								/* earliest pending record of all files */
+			if (replays[i].pending && (!replay || replays[i].nextUs < replay->nextUs)) {
+				replay = &replays[i];
+			}
+		}
+		if (!replay) {
+			break;
+		}
+		if (!firstUs) {
+			firstUs = replay->nextUs;
+		}
+		lastUs = replay->nextUs;
+
+		len = letohl(replay->next.lel_length);
+		if (len < SCCP_PACKET_HEADER || len > SCCP_MAX_PACKET || fread(frame, len, 1, replay->file) != 1) {
+			pbx_log(LOG_ERROR, "SCCP: (sccp_capture_replay) '%s' is truncated or corrupt\n", replay->filename);
+			res = -1;
+			break;
+		}
+		if (replay->next.direction == SCCP_CAPTURE_INBOUND) {
+			if (speed > 0) {								/* reproduce the captured pacing */
+				int64_t dueNs = (int64_t) ((replay->nextUs - firstUs) * 1000 / speed) - (int64_t) (sccp_capture_clockNs(CLOCK_MONOTONIC) - startWallNs);
+				if (dueNs > 0) {
+					usleep(dueNs / 1000);
+				}
+			}
+			startNs = sccp_capture_clockNs(CLOCK_THREAD_CPUTIME_ID);
+			if (sccp_session_replayFrame(replay->session, frame, len) != 0) {
+				stats->failedFrames++;
+			}
+			frameNs = sccp_capture_clockNs(CLOCK_THREAD_CPUTIME_ID) - startNs;
+			stats->inFrames++;
+			stats->handlerCpuNs += frameNs;
+			if (frameNs > stats->handlerMaxNs) {
+				stats->handlerMaxNs = frameNs;
+			}
+		} else {
+			stats->capturedOutFrames++;
+		}
+		sccp_capture_replay_readNext(replay);
+	}
+	stats->wallNs = sccp_capture_clockNs(CLOCK_MONOTONIC) - startWallNs;
+	stats->processCpuNs = sccp_capture_clockNs(CLOCK_PROCESS_CPUTIME_ID) - startProcessNs;
+	stats->capturedUs = lastUs - firstUs;
+EXIT:
+	for (i = 0; i < numFiles; i++) {
+		sccp_capture_replay_close(&replays[i], stats);
+	}
+	sccp_free(frame);
+	sccp_free(replays);
+	return res;
+}
+
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,83 @@
+/*!
+ * \file        sccp_capture.h
+ * \brief       SCCP Session Capture and Replay Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * Capture File Layout (all integers little endian, like the skinny protocol itself):
+ *  - one sccp_capture_file_header_t per file (one file per session)
+ *  - followed by any number of records: sccp_capture_record_header_t + lel_length bytes of the raw frame as it was on the wire
+ *    (8 byte sccp_header_t + payload)
+ */
+#pragma once
+
+#define SCCP_CAPTURE_MAGIC "SCCPCAP"										/*!< Capture File Magic (including the terminating NULL) */
+#define SCCP_CAPTURE_VERSION 1
+#define SCCP_CAPTURE_MESSAGE_SLOTS (SCCP_MESSAGE_HIGH_BOUNDARY + 1 + SPCP_MESSAGE_HIGH_BOUNDARY - SPCP_MESSAGE_LOW_BOUNDARY + 1)
+
+typedef struct sccp_capture sccp_capture_t;									/*!< SCCP Session Capture */
+
+/*!
+ * \brief Capture Frame Direction
+ */
+typedef enum {
+	SCCP_CAPTURE_INBOUND,											/*!< Device -> chan-sccp */
+	SCCP_CAPTURE_OUTBOUND,											/*!< chan-sccp -> Device */
+	SCCP_CAPTURE_DIRECTION_SENTINEL,
+} sccp_capture_direction_t;
+
+/*!
+ * \brief Capture File Header
+ */
+typedef struct sccp_capture_file_header {
+	char magic[8];												/*!< SCCP_CAPTURE_MAGIC */
+	uint32_t lel_version;											/*!< SCCP_CAPTURE_VERSION */
+	uint32_t lel_protocolType;										/*!< Session Protocol Type (SCCP_PROTOCOL / SPCP_PROTOCOL) */
+	uint32_t lel_startSec;											/*!< Session Start (seconds) */
+	uint32_t lel_startUsec;											/*!< Session Start (microseconds) */
+	uint8_t ipVersion;											/*!< Peer IP Version (4 / 6) */
+	uint8_t reserved;
+	uint16_t port;												/*!< Peer Port (network byte order) */
+	uint8_t addr[16];											/*!< Peer Address (network byte order) */
+} sccp_capture_file_header_t;
+
+/*!
+ * \brief Capture Record Header
+ */
+typedef struct sccp_capture_record_header {
+	uint32_t lel_sec;											/*!< Timestamp (seconds) */
+	uint32_t lel_usec;											/*!< Timestamp (microseconds) */
+	uint8_t direction;											/*!< sccp_capture_direction_t */
+	uint8_t reserved[3];
+	uint32_t lel_length;											/*!< Number of frame bytes following this header */
+} sccp_capture_record_header_t;
+
+/*!
+ * \brief Capture Replay Statistics
+ */
+typedef struct sccp_capture_replay_stats {
+	uint32_t sessions;											/*!< Number of replayed capture files */
+	uint32_t inFrames;											/*!< Inbound frames fed to the session layer */
+	uint32_t failedFrames;											/*!< Inbound frames the session layer refused (session would have been closed) */
+	uint32_t capturedOutFrames;										/*!< Outbound frames present in the captures */
+	uint32_t outFrames;											/*!< Outbound frames produced during the replay */
+	uint64_t outBytes;											/*!< Outbound bytes produced during the replay */
+	uint64_t handlerCpuNs;											/*!< Thread cpu time spent handling the inbound frames */
+	uint64_t handlerMaxNs;											/*!< Worst thread cpu time for a single inbound frame */
+	uint64_t processCpuNs;											/*!< Process cpu time during the replay (includes threadpool / event workers) */
+	uint64_t wallNs;											/*!< Wall clock time of the replay */
+	uint64_t capturedUs;											/*!< Time span covered by the captures */
+	uint32_t outMessages[SCCP_CAPTURE_MESSAGE_SLOTS];							/*!< Outbound frames per message type (see sccp_capture_messageId) */
+} sccp_capture_replay_stats_t;
+
+__BEGIN_C_EXTERN__
+SCCP_API boolean_t SCCP_CALL sccp_capture_start(const char *directory);
+SCCP_API void SCCP_CALL sccp_capture_stop(void);
+SCCP_API boolean_t SCCP_CALL sccp_capture_isRunning(char *directory, size_t directoryLen, uint32_t *files);
+SCCP_API sccp_capture_t * SCCP_CALL sccp_capture_open(const struct sockaddr_storage *peer, uint32_t protocolType);
+SCCP_API void SCCP_CALL sccp_capture_frame(sccp_capture_t *capture, sccp_capture_direction_t direction, const void *frame, size_t len);
+SCCP_API void SCCP_CALL sccp_capture_close(sccp_capture_t **capture);
+SCCP_API sccp_mid_t SCCP_CALL sccp_capture_messageId(int slot);
+SCCP_API int SCCP_CALL sccp_capture_replay(char *const files[], int numFiles, double speed, sccp_capture_replay_stats_t *stats);
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -29,6 +29,7 @@ SCCP_FILE_VERSION(__FILE__, "");
 #include "sccp_features.h"
 #include "sccp_indicate.h"
 #include "sccp_line.h"
+#include "sccp_mwi.h"
 #include "sccp_netsock.h"
 #include "sccp_utils.h"
 #include "sccp_labels.h"
@@ -40,6 +41,58 @@ void __sccp_channel_destroy(sccp_channel_t * channel);
 
 AST_MUTEX_DEFINE_STATIC(callCountLock);
 
+/*!
+ * \brief Live Channel Index
+ * Hash index of all live channels, by callid and by passthrupartyid, so that a channel can be found without traversing
+ * GLOB(lines) and locking every line->channels list. The index holds a reference to every indexed channel, which is dropped
+ * when the channel is cleaned or removed from its line, lookups retain the channel while holding sccp_channel_indexLock.
+ */
+#define SCCP_CHANNEL_INDEX_SIZE SCCP_HASH_PRIME
+static sccp_channel_t *sccp_channel_callidIndex[SCCP_CHANNEL_INDEX_SIZE];
+static sccp_channel_t *sccp_channel_passthruIndex[SCCP_CHANNEL_INDEX_SIZE];
+AST_RWLOCK_DEFINE_STATIC(sccp_channel_indexLock);
+
+static void sccp_channel_addToIndex(sccp_channel_t * channel)
+{
+	unsigned int callidBucket = channel->callid % SCCP_CHANNEL_INDEX_SIZE;
+	unsigned int passthruBucket = channel->passthrupartyid % SCCP_CHANNEL_INDEX_SIZE;
+
+	if (!(channel = sccp_channel_retain(channel))) {							// Add into index retained
+		return;
+	}
+	pbx_rwlock_wrlock(&sccp_channel_indexLock);
+	channel->callidHashNext = sccp_channel_callidIndex[callidBucket];
+	sccp_channel_callidIndex[callidBucket] = channel;
+	channel->passthruHashNext = sccp_channel_passthruIndex[passthruBucket];
+	sccp_channel_passthruIndex[passthruBucket] = channel;
+	pbx_rwlock_unlock(&sccp_channel_indexLock);
+}
+
+void sccp_channel_removeFromIndex(const sccp_channel_t * channel)
+{
+	sccp_channel_t **entry = NULL;
+	sccp_channel_t *indexed = NULL;
+
+	pbx_rwlock_wrlock(&sccp_channel_indexLock);
+	for (entry = &sccp_channel_callidIndex[channel->callid % SCCP_CHANNEL_INDEX_SIZE]; *entry; entry = &(*entry)->callidHashNext) {
+		if (*entry == channel) {
+			indexed = *entry;
+			*entry = channel->callidHashNext;
+			break;
+		}
+	}
+	for (entry = &sccp_channel_passthruIndex[channel->passthrupartyid % SCCP_CHANNEL_INDEX_SIZE]; *entry; entry = &(*entry)->passthruHashNext) {
+		if (*entry == channel) {
+			*entry = channel->passthruHashNext;
+			break;
+		}
+	}
+	pbx_rwlock_unlock(&sccp_channel_indexLock);
+	if (indexed) {
+		sccp_channel_release(&indexed);								// Remove the index reference
+	}
+}
+
 /*!
  * \brief Private Channel Data Structure
  */
@@ -196,6 +249,7 @@ channelPtr sccp_channel_allocate(constLinePtr l, constDevicePtr device)
 
 		/* run setters */
 		sccp_line_addChannel(l, channel);
+		sccp_channel_addToIndex(channel);
 		channel->setDevice(channel, device);
 
 		/* return new channel */
@@ -259,6 +313,9 @@ void sccp_channel_setDevice(sccp_channel_t * const channel, const sccp_device_t
 	if (!channel || !channel->privateData) {
 		return;
 	}
+	if (channel->privateData->device != device) {
+		sccp_mwi_updateActiveCall(channel, TRUE);						/* no longer suppress the mwi lamp on the previous device */
+	}
 
 	/** for previous device,set active channel to null */
 	if (!device) {
@@ -292,6 +349,7 @@ void sccp_channel_setDevice(sccp_channel_t * const channel, const sccp_device_t
 		memcpy(&channel->capabilities.audio, &channel->privateData->device->capabilities.audio, sizeof(channel->capabilities.audio));
 		sccp_copy_string(channel->currentDeviceId, channel->privateData->device->id, sizeof(char[StationMaxDeviceNameSize]));
 		channel->dtmfmode = channel->privateData->device->getDtmfMode(channel->privateData->device);
+		sccp_mwi_updateActiveCall(channel, FALSE);
 		return;
 	}
 EXIT:
@@ -1935,6 +1993,7 @@ void sccp_channel_clean(sccp_channel_t * channel)
 
 	// l = channel->line;
 	sccp_log((DEBUGCAT_CHANNEL)) (VERBOSE_PREFIX_3 "SCCP: Cleaning channel %s\n", channel->designator);
+	sccp_channel_removeFromIndex(channel);
 
 	if (ATOMIC_FETCH(&channel->scheduler.deny, &channel->scheduler.lock) == 0) {
 		sccp_channel_stop_and_deny_scheduled_tasks(channel);
@@ -2022,6 +2081,7 @@ void __sccp_channel_destroy(sccp_channel_t * channel)
 	sccp_log((DEBUGCAT_CHANNEL)) (VERBOSE_PREFIX_3 "Destroying channel %s\n", channel->designator);
 	AUTO_RELEASE(sccp_device_t, d , sccp_channel_getDevice(channel));
 	if (d) {
+		sccp_mwi_updateActiveCall(channel, TRUE);
 		sccp_channel_closeAllMediaTransmitAndReceive(d, channel);
 	}
 
@@ -2806,18 +2866,17 @@ sccp_channel_t *sccp_find_channel_by_lineInstance_and_callid(const sccp_device_t
 sccp_channel_t *sccp_channel_find_byid(uint32_t callid)
 {
 	sccp_channel_t *channel = NULL;
-	sccp_line_t *l = NULL;
+	sccp_channel_t *tmpc = NULL;
 
 	sccp_log((DEBUGCAT_CHANNEL)) (VERBOSE_PREFIX_3 "SCCP: Looking for channel by id %u\n", callid);
 
-	SCCP_RWLIST_RDLOCK(&GLOB(lines));
-	SCCP_RWLIST_TRAVERSE(&GLOB(lines), l, list) {
-		channel = sccp_find_channel_on_line_byid(l, callid);
-		if (channel) {
+	pbx_rwlock_rdlock(&sccp_channel_indexLock);
+	for (tmpc = sccp_channel_callidIndex[callid % SCCP_CHANNEL_INDEX_SIZE]; tmpc; tmpc = tmpc->callidHashNext) {
+		if (tmpc->callid == callid && tmpc->state != SCCP_CHANNELSTATE_DOWN && (channel = sccp_channel_retain(tmpc))) {
 			break;
 		}
 	}
-	SCCP_RWLIST_UNLOCK(&GLOB(lines));
+	pbx_rwlock_unlock(&sccp_channel_indexLock);
 	if (!channel) {
 		sccp_log((DEBUGCAT_CHANNEL)) (VERBOSE_PREFIX_3 "SCCP: Could not find channel for callid:%d on device\n", callid);
 	}
@@ -2839,20 +2898,17 @@ sccp_channel_t *sccp_channel_find_byid(uint32_t callid)
 sccp_channel_t *sccp_channel_find_bypassthrupartyid(uint32_t passthrupartyid)
 {
 	sccp_channel_t *c = NULL;
-	sccp_line_t *l = NULL;
+	sccp_channel_t *tmpc = NULL;
 
 	sccp_log((DEBUGCAT_CHANNEL)) (VERBOSE_PREFIX_3 "SCCP: Looking for channel by PassThruId %u\n", passthrupartyid);
 
-	SCCP_RWLIST_RDLOCK(&GLOB(lines));
-	SCCP_RWLIST_TRAVERSE(&GLOB(lines), l, list) {
-		SCCP_LIST_LOCK(&l->channels);
-		c = SCCP_LIST_FIND(&l->channels, sccp_channel_t, tmpc, list, (tmpc->passthrupartyid == passthrupartyid && tmpc->state != SCCP_CHANNELSTATE_DOWN), TRUE, __FILE__, __LINE__, __PRETTY_FUNCTION__);
-		SCCP_LIST_UNLOCK(&l->channels);
-		if (c) {
+	pbx_rwlock_rdlock(&sccp_channel_indexLock);
+	for (tmpc = sccp_channel_passthruIndex[passthrupartyid % SCCP_CHANNEL_INDEX_SIZE]; tmpc; tmpc = tmpc->passthruHashNext) {
+		if (tmpc->passthrupartyid == passthrupartyid && tmpc->state != SCCP_CHANNELSTATE_DOWN && (c = sccp_channel_retain(tmpc))) {
 			break;
 		}
 	}
-	SCCP_RWLIST_UNLOCK(&GLOB(lines));
+	pbx_rwlock_unlock(&sccp_channel_indexLock);
 
 	if (!c) {
 		sccp_log((DEBUGCAT_CHANNEL)) (VERBOSE_PREFIX_3 "SCCP: Could not find active channel with Passthrupartyid %u\n", passthrupartyid);
@@ -24,31 +24,37 @@ __BEGIN_C_EXTERN__
  * \note This contains the current channel information
  */
 struct sccp_channel {
+	/* hot runtime state: kept together at the start of the structure (first two cache lines), state updates and channel
+	 * lookups do not need to touch the rest (checked by the channel_layout test) */
 	const uint32_t callid;											/*!< Call ID */
 	const uint32_t passthrupartyid;										/*!< Pass Through ID */
 	sccp_channelstate_t state;										/*!< Internal channel state SCCP_CHANNELSTATE_* */
 	sccp_channelstate_t previousChannelState;								/*!< Previous channel state SCCP_CHANNELSTATE_* */
+	volatile CAS32_TYPE lineStateCounter;									/*!< Bucket this channel is accounted in on line->stateCounter (sccp_line_statecounter_t) */
+	boolean_t mwiActiveCall;										/*!< this channel is accounted in device->mwiState.activeCalls */
 	sccp_channelstatereason_t channelStateReason;								/*!< Reason the new/current state was set (for example to handle HOLD differently for transfer then normal) */
 	skinny_calltype_t calltype;										/*!< Skinny Call Type as SKINNY_CALLTYPE_* */
 	
 	PBX_CHANNEL_TYPE *owner;										/*!< Asterisk Channel Owner */
 	sccp_line_t * const line;										/*!< SCCP Line */
 	SCCP_LIST_ENTRY (sccp_channel_t) list;									/*!< Channel Linked List */
-	char dialedNumber[SCCP_MAX_EXTENSION];									/*!< Last Dialed Number */
+	sccp_channel_t *callidHashNext;										/*!< Next Channel in the same CallId Index Bucket */
+	sccp_channel_t *passthruHashNext;									/*!< Next Channel in the same PassThruPartyId Index Bucket */
+	sccp_private_channel_data_t * const privateData;
+	sccp_device_t * const (*getDevice) (const sccp_channel_t * channel);					/*!< function to retrieve refcounted device */
+	sccp_linedevices_t * const (*getLineDevice) (const sccp_channel_t * channel);				/*!< function to retrieve refcounted linedevice */
+	void (*setDevice) (sccp_channel_t * const channel, const sccp_device_t * device);			/*!< set refcounted device connected to the channel */
 	const char * const designator;
+	/* end of hot runtime state */
+
+	char dialedNumber[SCCP_MAX_EXTENSION];									/*!< Last Dialed Number */
 	sccp_subscription_id_t subscriptionId;
 	boolean_t answered_elsewhere;										/*!< Answered Elsewhere */
 	boolean_t privacy;											/*!< Private */
 	boolean_t peerIsSCCP;											/*!< Indicates that channel-peer is also SCCP */
 	sccp_video_mode_t videomode;										/*!< Video Mode (0 off - 1 user - 2 auto) */
-
-	sccp_device_t * const (*getDevice) (const sccp_channel_t * channel);					/*!< function to retrieve refcounted device */
-	sccp_linedevices_t * const (*getLineDevice) (const sccp_channel_t * channel);				/*!< function to retrieve refcounted linedevice */
-	void (*setDevice) (sccp_channel_t * const channel, const sccp_device_t * device);			/*!< set refcounted device connected to the channel */
 	char currentDeviceId[StationMaxDeviceNameSize];								/*!< Returns a constant char of the Device Id if available */
 
-	sccp_private_channel_data_t * const privateData;
-
 	struct {
 		skinny_codec_t audio[SKINNY_MAX_CAPABILITIES];							/*!< our channel Capability in preference order */
 		skinny_codec_t video[SKINNY_MAX_CAPABILITIES];
@@ -180,6 +186,7 @@ SCCP_API void SCCP_CALL sccp_channel_StatisticsRequest(sccp_channel_t * channel)
 SCCP_API void SCCP_CALL sccp_channel_answer(const sccp_device_t * device, sccp_channel_t * channel);
 SCCP_API void SCCP_CALL sccp_channel_stop_and_deny_scheduled_tasks(sccp_channel_t * channel);
 SCCP_API void SCCP_CALL sccp_channel_clean(sccp_channel_t * channel);
+SCCP_API void SCCP_CALL sccp_channel_removeFromIndex(const sccp_channel_t * channel);
 SCCP_API void SCCP_CALL sccp_channel_transfer(channelPtr channel, constDevicePtr device);
 SCCP_API void SCCP_CALL sccp_channel_transfer_release(devicePtr d, channelPtr c);
 SCCP_API void SCCP_CALL sccp_channel_transfer_cancel(devicePtr d, channelPtr c);
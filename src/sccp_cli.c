@@ -60,7 +60,11 @@ SCCP_FILE_VERSION(__FILE__, "");
 #include "sccp_features.h"
 #include "sccp_mwi.h"
 #include "sccp_hint.h"
+#include "sccp_devstate.h"
 #include "sccp_labels.h"
+#include "sccp_realtime.h"
+#include "sccp_actions.h"
+#include "sccp_capture.h"
 #include "sys/stat.h"
 #include <asterisk/cli.h>
 #include <asterisk/paths.h>
@@ -790,6 +794,10 @@ static int sccp_show_device(int fd, sccp_cli_totals_t *totals, struct mansession
 	CLI_AMI_OUTPUT_PARAM("Protocol Version",	CLI_AMI_LIST_WIDTH, "Supported '%d', In Use '%d'", d->protocolversion, d->inuseprotocolversion);
 	CLI_AMI_OUTPUT_PARAM("Protocol In Use",		CLI_AMI_LIST_WIDTH, "%s Version %d", d->protocol ? (d->protocol->type == SCCP_PROTOCOL ? "SCCP" : "SPCP" ) : "NONE", d->protocol ? d->protocol->version : 0);
 	char binstr[41] = "";
+	uint32_t regcacheHits = 0, regcacheMisses = 0;
+	char shadowbuf[256] = "";
+	size_t shadowlen = 0;
+	sccp_shadow_msgtype_t shadowtype;
 	CLI_AMI_OUTPUT_PARAM("Device Features",		CLI_AMI_LIST_WIDTH, "%#1x,%s", d->device_features, sccp_dec2binstr(binstr, 40, d->device_features));
 	CLI_AMI_OUTPUT_PARAM("Tokenstate",		CLI_AMI_LIST_WIDTH, "%s", sccp_tokenstate2str(d->status.token));
 	CLI_AMI_OUTPUT_PARAM("Keepalive",		CLI_AMI_LIST_WIDTH, "%d", d->keepalive);
@@ -799,12 +807,21 @@ static int sccp_show_device(int fd, sccp_cli_totals_t *totals, struct mansession
 	CLI_AMI_OUTPUT_PARAM("MWI light",		CLI_AMI_LIST_WIDTH, "%s(%d)", skinny_lampmode2str(d->mwilamp), d->mwilamp);
 	CLI_AMI_OUTPUT_PARAM("MWI handset light", 	CLI_AMI_LIST_WIDTH, "%s", sccp_dec2binstr(binstr, 40, d->mwilight));
 	CLI_AMI_OUTPUT_PARAM("MWI During call",		CLI_AMI_LIST_WIDTH, "%s", d->mwioncall ? "keep on" : "turn off");
+	CLI_AMI_OUTPUT_PARAM("MWI New/Old Messages",	CLI_AMI_LIST_WIDTH, "%d/%d", d->mwiState.newmsgs, d->mwiState.oldmsgs);
+	CLI_AMI_OUTPUT_PARAM("MWI Active Calls",	CLI_AMI_LIST_WIDTH, "%d", d->mwiState.activeCalls);
+	CLI_AMI_OUTPUT_PARAM("MWI Lamp Updates",	CLI_AMI_LIST_WIDTH, "%u sent, %u suppressed", d->mwiState.lampUpdates, d->mwiState.lampUpdatesSuppressed);
 	CLI_AMI_OUTPUT_PARAM("Description",		CLI_AMI_LIST_WIDTH, "%s", d->description ? d->description : "<not set>");
 	CLI_AMI_OUTPUT_PARAM("Config Phone Type",	CLI_AMI_LIST_WIDTH, "%s", d->config_type);
 	CLI_AMI_OUTPUT_PARAM("Skinny Phone Type",	CLI_AMI_LIST_WIDTH, "%s(%d)", skinny_devicetype2str(d->skinny_type), d->skinny_type);
 	CLI_AMI_OUTPUT_YES_NO("Softkey support",	CLI_AMI_LIST_WIDTH, d->softkeysupport);
 	CLI_AMI_OUTPUT_PARAM("Softkeyset",		CLI_AMI_LIST_WIDTH, "%s => %s (%p)", d->softkeyDefinition, d->softkeyset ? d->softkeyset->name : "NULL !", d->softkeyset);
 	CLI_AMI_OUTPUT_YES_NO("BTemplate support",	CLI_AMI_LIST_WIDTH, d->buttonTemplate);
+	sccp_dev_regcache_getStats(d, &regcacheHits, &regcacheMisses);
+	CLI_AMI_OUTPUT_PARAM("Reg. Response Cache",	CLI_AMI_LIST_WIDTH, "%u hits, %u misses", regcacheHits, regcacheMisses);
+	for (shadowtype = 0; shadowtype < SCCP_SHADOW_SENTINEL && shadowlen < sizeof(shadowbuf); shadowtype++) {
+		shadowlen += snprintf(shadowbuf + shadowlen, sizeof(shadowbuf) - shadowlen, "%s%s:%u", shadowtype ? ", " : "", sccp_shadow_msgtype2str(shadowtype), d->shadow.suppressed[shadowtype]);
+	}
+	CLI_AMI_OUTPUT_PARAM("Suppressed Messages",	CLI_AMI_LIST_WIDTH, "%s", shadowbuf);
 	CLI_AMI_OUTPUT_YES_NO("linesRegistered",	CLI_AMI_LIST_WIDTH, d->linesRegistered);
 	CLI_AMI_OUTPUT_PARAM("Image Version",		CLI_AMI_LIST_WIDTH, "%s", d->loadedimageversion);
 	CLI_AMI_OUTPUT_PARAM("Timezone Offset",		CLI_AMI_LIST_WIDTH, "%d", d->tz_offset);
@@ -1427,6 +1444,7 @@ static int sccp_show_channels(int fd, sccp_cli_totals_t *totals, struct mansessi
 	int local_line_total = 0;
 	char tmpname[25];
 	char addrStr[INET6_ADDRSTRLEN] = "";
+	uint32_t ciSent = 0, ciSuppressed = 0, ciReused = 0;
 
 #define CLI_AMI_TABLE_NAME Channels
 #define CLI_AMI_TABLE_PER_ENTRY_NAME Channel
@@ -1446,7 +1464,8 @@ static int sccp_show_channels(int fd, sccp_cli_totals_t *totals, struct mansessi
 			}													\
 			if (&channel->rtp) {											\
 				sccp_copy_string(addrStr,sccp_netsock_stringify(&channel->rtp.audio.phone), sizeof(addrStr));	\
-			}
+			}													\
+			iCallInfo.GetStats(sccp_channel_getCallInfo(channel), &ciSent, &ciSuppressed, &ciReused);
 
 #define CLI_AMI_TABLE_AFTER_ITERATION 												\
 		}														\
@@ -1464,7 +1483,10 @@ static int sccp_show_channels(int fd, sccp_cli_totals_t *totals, struct mansessi
 		CLI_AMI_TABLE_FIELD(WriteCodec,		"-10.10",	s,	10,	codec2name(channel->rtp.audio.writeFormat))		\
 		CLI_AMI_TABLE_FIELD(RTPPeer,		"22.22",	s,	22,	addrStr)						\
 		CLI_AMI_TABLE_FIELD(Direct,		"-6.6",		s,	6,	channel->rtp.audio.directMedia ? "yes" : "no")		\
-		CLI_AMI_TABLE_FIELD(DTMFmode,		"-8.8",		s,	8,	sccp_dtmfmode2str(channel->dtmfmode))
+		CLI_AMI_TABLE_FIELD(DTMFmode,		"-8.8",		s,	8,	sccp_dtmfmode2str(channel->dtmfmode))			\
+		CLI_AMI_TABLE_FIELD(CISent,		"-6",		d,	6,	ciSent)							\
+		CLI_AMI_TABLE_FIELD(CISkip,		"-6",		d,	6,	ciSuppressed)						\
+		CLI_AMI_TABLE_FIELD(CIReuse,		"-7",		d,	7,	ciReused)
 #include "sccp_cli_table.h"
 
 	if (s) {
@@ -1582,6 +1604,21 @@ CLI_AMI_ENTRY(show_hint_lineStates, sccp_show_hint_lineStates, "Show all SCCP Hi
 #undef CLI_COMPLETE
 #undef AMI_COMMAND
 #undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+    /* --------------------------------------------------------------------------------------------CHECK_HINT LINESTATES - */
+static char cli_check_hint_lineStates_usage[] = "Usage: sccp check hint linestates\n" "	Check the incremental SCCP Line State Counters against a full rescan of the lines.\n";
+static char ami_check_hint_lineStates_usage[] = "Usage: SCCPCheckHintLineStates\n" "Check the incremental SCCP Line State Counters against a full rescan of the lines.\n\n" "PARAMS: None\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "check", "hint", "lineStates"
+#define AMI_COMMAND "SCCPCheckHintLineStates"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS ""
+CLI_AMI_ENTRY(check_hint_lineStates, sccp_check_hint_lineStates, "Check all SCCP Hint Line State Counters", cli_check_hint_lineStates_usage, FALSE, TRUE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
 #endif														/* DOXYGEN_SHOULD_SKIP_THIS */
     /* ---------------------------------------------------------------------------------------------SHOW_HINT LINESTATES - */
 static char cli_show_hint_subscriptions_usage[] = "Usage: sccp show hint linestates\n" "	Show All SCCP HINT LineStates.\n";
@@ -1598,6 +1635,157 @@ CLI_AMI_ENTRY(show_hint_subscriptions, sccp_show_hint_subscriptions, "Show all S
 #undef AMI_COMMAND
 #undef CLI_COMMAND
 #endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+    /* ---------------------------------------------------------------------------------------------SHOW_HINT STATISTICS - */
+static char cli_show_hint_statistics_usage[] = "Usage: sccp show hint statistics\n" "	Show SCCP Hint Subscription Statistics, including the time-to-BLF-ready after device registration.\n";
+static char ami_show_hint_statistics_usage[] = "Usage: SCCPShowHintStatistics\n" "Show SCCP Hint Subscription Statistics, including the time-to-BLF-ready after device registration.\n\n" "PARAMS: None\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "hint", "statistics"
+#define AMI_COMMAND "SCCPShowHintStatistics"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS ""
+CLI_AMI_ENTRY(show_hint_statistics, sccp_show_hint_statistics, "Show SCCP Hint Subscription Statistics", cli_show_hint_statistics_usage, FALSE, TRUE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+    /* -----------------------------------------------------------------------------------------------SHOW_MESSAGE_STATS - */
+static char cli_show_message_stats_usage[] = "Usage: sccp show message stats\n" "	Show the number of received messages per Skinny message type and their dispatch latency (avg, p50, p90, p99, max in microseconds).\n";
+static char ami_show_message_stats_usage[] = "Usage: SCCPShowMessageStats\n" "Show the number of received messages per Skinny message type and their dispatch latency.\n\n" "PARAMS: None\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "message", "stats"
+#define AMI_COMMAND "SCCPShowMessageStats"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS ""
+CLI_AMI_ENTRY(show_message_stats, sccp_show_message_stats, "Show SCCP Message Dispatch Statistics", cli_show_message_stats_usage, FALSE, TRUE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+    /* ----------------------------------------------------------------------------------------------RESET_MESSAGE_STATS - */
+    /*!
+     * \brief Reset the Message Dispatch Statistics
+     * \param fd Fd as int
+     * \param totals Total number of lines as int
+     * \param s AMI Session
+     * \param m Message
+     * \param argc Argc as int
+     * \param argv[] Argv[] as char
+     * \return Result as int
+     * 
+     * \called_from_asterisk
+     */
+static int sccp_reset_message_stats(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+
+	sccp_message_stats_reset();
+	if (s) {
+		astman_append(s, "Response: Success\r\n");
+		astman_append(s, "Message: Message statistics reset\r\n");
+		local_line_total += 2;
+		totals->lines = local_line_total;
+	} else {
+		pbx_cli(fd, "SCCP: Message statistics reset\n");
+	}
+	return RESULT_SUCCESS;
+}
+
+static char cli_reset_message_stats_usage[] = "Usage: sccp reset message stats\n" "	Clear the per message type dispatch counters and latency histograms.\n";
+static char ami_reset_message_stats_usage[] = "Usage: SCCPResetMessageStats\n" "Clear the per message type dispatch counters and latency histograms.\n\n" "PARAMS: None\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "reset", "message", "stats"
+#define AMI_COMMAND "SCCPResetMessageStats"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS ""
+CLI_AMI_ENTRY(reset_message_stats, sccp_reset_message_stats, "Reset SCCP Message Dispatch Statistics", cli_reset_message_stats_usage, FALSE, FALSE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+#ifdef CS_DEVSTATE_FEATURE
+    /* ---------------------------------------------------------------------------------------------------SHOW_DEVSTATES - */
+static char cli_show_devstates_usage[] = "Usage: sccp show devstates\n" "	Show SCCP Custom Device States, their subscribers and the notification latency.\n";
+static char ami_show_devstates_usage[] = "Usage: SCCPShowDevstates\n" "Show SCCP Custom Device States, their subscribers and the notification latency.\n\n" "PARAMS: None\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "devstates"
+#define AMI_COMMAND "SCCPShowDevstates"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS ""
+CLI_AMI_ENTRY(show_devstates, sccp_show_devstates, "Show SCCP Custom Device States", cli_show_devstates_usage, FALSE, TRUE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+#endif														/* CS_DEVSTATE_FEATURE */
+#ifdef CS_SCCP_REALTIME
+    /* ----------------------------------------------------------------------------------------------SHOW_REALTIME_CACHE - */
+static char cli_show_realtime_cache_usage[] = "Usage: sccp show realtime cache\n" "	Show the SCCP realtime lookup cache and its hit/miss counters.\n";
+static char ami_show_realtime_cache_usage[] = "Usage: SCCPShowRealtimeCache\n" "Show the SCCP realtime lookup cache and its hit/miss counters.\n\n" "PARAMS: None\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "realtime", "cache"
+#define AMI_COMMAND "SCCPShowRealtimeCache"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS ""
+CLI_AMI_ENTRY(show_realtime_cache, sccp_show_realtime_cache, "Show SCCP Realtime Lookup Cache", cli_show_realtime_cache_usage, FALSE, TRUE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+    /* ---------------------------------------------------------------------------------------------FLUSH_REALTIME_CACHE - */
+    /*!
+     * \brief Flush the Realtime Lookup Cache
+     * \param fd Fd as int
+     * \param totals Total number of lines as int
+     * \param s AMI Session
+     * \param m Message
+     * \param argc Argc as int
+     * \param argv[] Argv[] as char
+     * \return Result as int
+     * 
+     * \called_from_asterisk
+     */
+static int sccp_flush_realtime_cache(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	int removed = sccp_realtime_cache_flush();
+
+	if (s) {
+		astman_append(s, "Response: Success\r\n");
+		astman_append(s, "Message: Realtime cache flushed\r\n");
+		astman_append(s, "RemovedEntries: %d\r\n", removed);
+		local_line_total += 3;
+		totals->lines = local_line_total;
+	} else {
+		pbx_cli(fd, "SCCP: Realtime cache flushed, %d entries removed\n", removed);
+	}
+	return RESULT_SUCCESS;
+}
+
+static char cli_flush_realtime_cache_usage[] = "Usage: sccp realtime cache flush\n" "	Remove all cached realtime device and line lookups (including the negative ones) and reset the counters.\n";
+static char ami_flush_realtime_cache_usage[] = "Usage: SCCPFlushRealtimeCache\n" "Remove all cached realtime device and line lookups and reset the counters.\n\n" "PARAMS: None\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "realtime", "cache", "flush"
+#define AMI_COMMAND "SCCPFlushRealtimeCache"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS ""
+CLI_AMI_ENTRY(flush_realtime_cache, sccp_flush_realtime_cache, "Flush SCCP Realtime Lookup Cache", cli_flush_realtime_cache_usage, FALSE, FALSE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+#endif														/* CS_SCCP_REALTIME */
     /* -------------------------------------------------------------------------------------------------------TEST- */
 #ifdef CS_EXPERIMENTAL
 /*!
@@ -2497,6 +2685,7 @@ static int sccp_cli_reload(int fd, int argc, char *argv[])
 				}
 #ifdef CS_SCCP_REALTIME
 				if (device->realtime) {
+					sccp_realtime_cache_invalidate(SCCP_REALTIME_CACHE_DEVICE, argv[3]);		/* reread row, drop the cached one */
 					v = pbx_load_realtime(GLOB(realtimedevicetable), "name", argv[3], NULL);
 				} else
 #endif
@@ -2561,6 +2750,7 @@ static int sccp_cli_reload(int fd, int argc, char *argv[])
 				}
 #ifdef CS_SCCP_REALTIME
 				if (line->realtime) {
+					sccp_realtime_cache_invalidate(SCCP_REALTIME_CACHE_LINE, argv[3]);		/* reread row, drop the cached one */
 					v = pbx_load_realtime(GLOB(realtimelinetable), "name", argv[3], NULL);
 				} else
 #endif
@@ -2627,6 +2817,7 @@ static int sccp_cli_reload(int fd, int argc, char *argv[])
 		} else if (sccp_strequals("force", argv[2]) && argc == 3) {
 			pbx_cli(fd, "Force Reading Config file '%s'\n", GLOB(config_file_name));
 			force_reload = TRUE;
+			sccp_config_requestFullReload();							/* also reapply unchanged sections when incrementalreload is enabled */
 		} else if (sccp_strequals("file", argv[2])) {
 			if (argc == 4) {
 				// build config file path
@@ -2774,6 +2965,56 @@ static char config_generate_usage[] = "Usage: SCCP config generate [filename]\n"
 CLI_ENTRY(cli_config_generate, sccp_cli_config_generate, "Generate a SCCP configuration file", config_generate_usage, FALSE)
 #undef CLI_COMMAND
 #undef CLI_COMPLETE
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+    /* ------------------------------------------------------------------------------------------------------------CAPTURE- */
+    /*!
+     * \brief Start / Stop capturing the sessions to disk
+     * \param fd Fd as int
+     * \param argc Argc as int
+     * \param argv[] Argv[] as char
+     * \return Result as int
+     * 
+     * \called_from_asterisk
+     */
+static int sccp_cli_capture(int fd, int argc, char *argv[])
+{
+	char directory[SCCP_PATH_MAX];
+	uint32_t files = 0;
+
+	if (argc < 2 || argc > 4) {
+		return RESULT_SHOWUSAGE;
+	}
+	if (argc >= 3 && sccp_strcaseequals(argv[2], "on")) {
+		if (argc == 4) {
+			sccp_copy_string(directory, argv[3], sizeof(directory));
+		} else {
+			snprintf(directory, sizeof(directory), "%s/sccp-capture", ast_config_AST_LOG_DIR);
+		}
+		if (!sccp_capture_start(directory)) {
+			pbx_cli(fd, "SCCP: Could not start capturing to '%s'\n", directory);
+			return RESULT_FAILURE;
+		}
+	} else if (argc == 3 && sccp_strcaseequals(argv[2], "off")) {
+		sccp_capture_stop();
+	} else if (argc != 2) {
+		return RESULT_SHOWUSAGE;
+	}
+	if (sccp_capture_isRunning(directory, sizeof(directory), &files)) {
+		pbx_cli(fd, "SCCP: Capturing sessions accepted since the start to '%s' (%u files)\n", directory, files);
+	} else {
+		pbx_cli(fd, "SCCP: Session capture is off\n");
+	}
+	return RESULT_SUCCESS;
+}
+
+static char capture_usage[] = "Usage: sccp capture [on [directory]|off]\n" "       Write the raw frames of newly accepted sessions to a capture file per session (default directory: <astlogdir>/sccp-capture).\n" "       The capture files can be replayed offline using sccp_replay.\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "capture"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+CLI_ENTRY(cli_capture, sccp_cli_capture, "Capture SCCP sessions to disk", capture_usage, FALSE)
+#undef CLI_COMMAND
+#undef CLI_COMPLETE
 #endif														/* DOXYGEN_SHOULD_SKIP_THIS */
     /* -------------------------------------------------------------------------------------------------------SHOW VERSION- */
     /*!
@@ -3409,6 +3650,7 @@ static struct pbx_cli_entry cli_entries[] = {
 	AST_CLI_DEFINE(cli_do_debug, "Enable SCCP debugging."),
 	AST_CLI_DEFINE(cli_no_debug, "Disable SCCP debugging."),
 	AST_CLI_DEFINE(cli_config_generate, "SCCP generate config file."),
+	AST_CLI_DEFINE(cli_capture, "Capture SCCP sessions to disk."),
 	AST_CLI_DEFINE(cli_reload, "SCCP module reload."),
 	AST_CLI_DEFINE(cli_reload_file, "SCCP module reload file."),
 	AST_CLI_DEFINE(cli_reload_force, "SCCP module reload force."),
@@ -3431,7 +3673,18 @@ static struct pbx_cli_entry cli_entries[] = {
 	AST_CLI_DEFINE(cli_conference_command, "SCCP Conference Commands."),
 #endif
 	AST_CLI_DEFINE(cli_show_hint_lineStates, "Show all hint lineStates"),
-	AST_CLI_DEFINE(cli_show_hint_subscriptions, "Show all hint subscriptions")
+	AST_CLI_DEFINE(cli_check_hint_lineStates, "Check all hint lineState counters"),
+	AST_CLI_DEFINE(cli_show_hint_subscriptions, "Show all hint subscriptions"),
+	AST_CLI_DEFINE(cli_show_hint_statistics, "Show hint subscription statistics"),
+	AST_CLI_DEFINE(cli_show_message_stats, "Show message dispatch statistics"),
+	AST_CLI_DEFINE(cli_reset_message_stats, "Reset message dispatch statistics"),
+#ifdef CS_DEVSTATE_FEATURE
+	AST_CLI_DEFINE(cli_show_devstates, "Show custom device states"),
+#endif
+#ifdef CS_SCCP_REALTIME
+	AST_CLI_DEFINE(cli_show_realtime_cache, "Show realtime lookup cache"),
+	AST_CLI_DEFINE(cli_flush_realtime_cache, "Flush realtime lookup cache"),
+#endif
 };
 
 /*!
@@ -3474,7 +3727,18 @@ int sccp_register_cli(void)
 	res |= pbx_manager_register("SCCPConference", _MAN_REP_FLAGS, manager_conference_command, "conference commands", ami_conference_command_usage);
 #endif
 	res |= pbx_manager_register("SCCPShowHintLineStates", _MAN_REP_FLAGS, manager_show_hint_lineStates, "show hint lineStates", ami_show_hint_lineStates_usage);
+	res |= pbx_manager_register("SCCPCheckHintLineStates", _MAN_REP_FLAGS, manager_check_hint_lineStates, "check hint lineState counters", ami_check_hint_lineStates_usage);
 	res |= pbx_manager_register("SCCPShowHintSubscriptions", _MAN_REP_FLAGS, manager_show_hint_subscriptions, "show hint subscriptions", ami_show_hint_subscriptions_usage);
+	res |= pbx_manager_register("SCCPShowHintStatistics", _MAN_REP_FLAGS, manager_show_hint_statistics, "show hint subscription statistics", ami_show_hint_statistics_usage);
+	res |= pbx_manager_register("SCCPShowMessageStats", _MAN_REP_FLAGS, manager_show_message_stats, "show message dispatch statistics", ami_show_message_stats_usage);
+	res |= pbx_manager_register("SCCPResetMessageStats", _MAN_REP_FLAGS, manager_reset_message_stats, "reset message dispatch statistics", ami_reset_message_stats_usage);
+#ifdef CS_DEVSTATE_FEATURE
+	res |= pbx_manager_register("SCCPShowDevstates", _MAN_REP_FLAGS, manager_show_devstates, "show custom device states", ami_show_devstates_usage);
+#endif
+#ifdef CS_SCCP_REALTIME
+	res |= pbx_manager_register("SCCPShowRealtimeCache", _MAN_REP_FLAGS, manager_show_realtime_cache, "show realtime lookup cache", ami_show_realtime_cache_usage);
+	res |= pbx_manager_register("SCCPFlushRealtimeCache", _MAN_REP_FLAGS, manager_flush_realtime_cache, "flush realtime lookup cache", ami_flush_realtime_cache_usage);
+#endif
 	res |= pbx_manager_register("SCCPShowRefcount", _MAN_REP_FLAGS, manager_show_refcount, "show refcount", ami_show_refcount_usage);
 
 	return res;
@@ -3513,7 +3777,18 @@ int sccp_unregister_cli(void)
 	res |= pbx_manager_unregister("SCCPConference");
 #endif
 	res |= pbx_manager_unregister("SCCPShowHintLineStates");
+	res |= pbx_manager_unregister("SCCPCheckHintLineStates");
 	res |= pbx_manager_unregister("SCCPShowHintSubscriptions");
+	res |= pbx_manager_unregister("SCCPShowHintStatistics");
+	res |= pbx_manager_unregister("SCCPShowMessageStats");
+	res |= pbx_manager_unregister("SCCPResetMessageStats");
+#ifdef CS_DEVSTATE_FEATURE
+	res |= pbx_manager_unregister("SCCPShowDevstates");
+#endif
+#ifdef CS_SCCP_REALTIME
+	res |= pbx_manager_unregister("SCCPShowRealtimeCache");
+	res |= pbx_manager_unregister("SCCPFlushRealtimeCache");
+#endif
 	res |= pbx_manager_unregister("SCCPShowRefcount");
 
 	return res;
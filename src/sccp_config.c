@@ -85,6 +85,7 @@
 #include "config.h"
 #include "common.h"
 #include "sccp_config.h"
+#include "sccp_config_snapshot.h"
 #include "sccp_device.h"
 #include "sccp_featureButton.h"
 #include "sccp_line.h"
@@ -244,34 +245,144 @@ static const SCCPConfigSegment *sccp_find_segment(const sccp_config_segment_t se
 }
 
 /*!
- * \brief Find of SCCP Config Options
+ * \brief SCCP Config Alias Index Entry
+ *
+ * Every name of an option ("disallow|allow" has two) gets its own entry, pointing into the option name itself, so
+ * that a lookup does not need to copy or tokenize the option names.
  */
-static const SCCPConfigOption *sccp_find_config(const sccp_config_segment_t segment, const char *name)
+typedef struct SCCPConfigAlias {
+	const char *name;											/*!< Start of the alias within SCCPConfigOption->name */
+	size_t len;												/*!< Length of the alias */
+	const SCCPConfigOption *option;										/*!< Option this alias resolves to */
+} SCCPConfigAlias;
+
+/*!
+ * \brief Per Segment Alias Index, sorted case insensitive by alias and then by option order
+ */
+static struct {
+	SCCPConfigAlias *aliases;
+	size_t size;
+} sccpConfigAliasIndex[ARRAY_LEN(sccpConfigSegments)];
+static pthread_once_t sccpConfigAliasIndexOnce = PTHREAD_ONCE_INIT;					/*!< Alias Index is built once, on first use */
+
+/*!
+ * \brief Compare two aliases, shorter aliases sort before longer aliases sharing the same prefix
+ */
+static int sccp_config_alias_cmp(const void *ptr_a, const void *ptr_b)
 {
-	long unsigned int i = 0;
-	const SCCPConfigSegment *sccpConfigSegment = sccp_find_segment(segment);
-	const SCCPConfigOption *config = sccpConfigSegment->config;
+	const SCCPConfigAlias *a = (const SCCPConfigAlias *) ptr_a;
+	const SCCPConfigAlias *b = (const SCCPConfigAlias *) ptr_b;
+	int res = strncasecmp(a->name, b->name, a->len < b->len ? a->len : b->len);
 
-	char delims[] = "|";
-	char *token = NULL;
-	char *config_name = NULL;
+	if (!res) {
+		res = (a->len > b->len) - (a->len < b->len);
+	}
+	if (!res) {
+		res = (a->option > b->option) - (a->option < b->option);					/* keep table order for duplicates */
+	}
+	return res;
+}
 
-	for (i = 0; i < sccpConfigSegment->config_size; i++) {
-		if (strstr(config[i].name, delims) != NULL) {
-			config_name = pbx_strdupa(config[i].name);
-			token = strtok(config_name, delims);
-			while (token != NULL) {
-				if (!strcasecmp(token, name)) {
-					return &config[i];
+/*!
+ * \brief Compare a nul terminated name against an alias, using the same ordering as sccp_config_alias_cmp
+ */
+static inline int sccp_config_alias_name_cmp(const char *name, const SCCPConfigAlias *alias)
+{
+	int res = strncasecmp(name, alias->name, alias->len);
+
+	if (!res && name[alias->len] != '\0') {
+		res = 1;
+	}
+	return res;
+}
+
+/*!
+ * \brief Build the alias index of all segments, done once on first use
+ * \note only called through pthread_once(&sccpConfigAliasIndexOnce), which also publishes the index to the other threads
+ */
+static void sccp_config_buildAliasIndex(void)
+{
+	long unsigned int segment_idx = 0, i = 0;
+	const SCCPConfigSegment *sccpConfigSegment = NULL;
+	const char *start = NULL, *end = NULL;
+	size_t size = 0;
+
+	for (segment_idx = 0; segment_idx < ARRAY_LEN(sccpConfigSegments); segment_idx++) {
+		sccpConfigSegment = &sccpConfigSegments[segment_idx];
+		size = 0;
+		for (i = 0; i < sccpConfigSegment->config_size; i++) {
+			size++;
+			for (start = sccpConfigSegment->config[i].name; (start = strchr(start, '|')); start++) {
+				size++;
+			}
+		}
+		if (!(sccpConfigAliasIndex[segment_idx].aliases = sccp_calloc(size, sizeof(SCCPConfigAlias)))) {
+			pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+			continue;
+		}
+		size = 0;
+		for (i = 0; i < sccpConfigSegment->config_size; i++) {
+			for (start = sccpConfigSegment->config[i].name; *start; start = *end ? end + 1 : end) {
+				if (!(end = strchr(start, '|'))) {
+					end = start + strlen(start);
+				}
+				if (end > start) {								/* skip empty aliases, like strtok does */
+					sccpConfigAliasIndex[segment_idx].aliases[size].name = start;
+					sccpConfigAliasIndex[segment_idx].aliases[size].len = end - start;
+					sccpConfigAliasIndex[segment_idx].aliases[size].option = &sccpConfigSegment->config[i];
+					size++;
 				}
-				token = strtok(NULL, delims);
 			}
 		}
-		if (!strcasecmp(config[i].name, name)) {
-			return &config[i];
+		qsort(sccpConfigAliasIndex[segment_idx].aliases, size, sizeof(SCCPConfigAlias), sccp_config_alias_cmp);
+		sccpConfigAliasIndex[segment_idx].size = size;
+	}
+}
+
+static void __attribute__((destructor)) sccp_config_destroyAliasIndex(void)
+{
+	long unsigned int segment_idx = 0;
+
+	for (segment_idx = 0; segment_idx < ARRAY_LEN(sccpConfigSegments); segment_idx++) {
+		if (sccpConfigAliasIndex[segment_idx].aliases) {
+			sccp_free(sccpConfigAliasIndex[segment_idx].aliases);
 		}
+		sccpConfigAliasIndex[segment_idx].size = 0;
 	}
+}
+
+/*!
+ * \brief Find of SCCP Config Options
+ *
+ * Binary search in the alias index of the segment, no allocation and no tokenizing of option names. When an alias is
+ * used by more than one option, the first one in the option table is returned.
+ */
+static const SCCPConfigOption *sccp_find_config(const sccp_config_segment_t segment, const char *name)
+{
+	const SCCPConfigSegment *sccpConfigSegment = sccp_find_segment(segment);
+	const SCCPConfigAlias *aliases = NULL;
+	size_t low = 0, high = 0, mid = 0;
+	int res = 0;
 
+	if (!sccpConfigSegment || sccp_strlen_zero(name)) {
+		return NULL;
+	}
+	pthread_once(&sccpConfigAliasIndexOnce, sccp_config_buildAliasIndex);
+	aliases = sccpConfigAliasIndex[sccpConfigSegment - sccpConfigSegments].aliases;
+	high = sccpConfigAliasIndex[sccpConfigSegment - sccpConfigSegments].size;
+
+	while (low < high) {										/* lower bound: first alias >= name */
+		mid = low + (high - low) / 2;
+		res = sccp_config_alias_name_cmp(name, &aliases[mid]);
+		if (res > 0) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	if (aliases && low < sccpConfigAliasIndex[sccpConfigSegment - sccpConfigSegments].size && sccp_config_alias_name_cmp(name, &aliases[low]) == 0) {
+		return aliases[low].option;
+	}
 	return NULL;
 }
 
@@ -283,9 +394,10 @@ static PBX_VARIABLE_TYPE *createVariableSetForMultiEntryParameters(PBX_VARIABLE_
 	char delims[] = "|";
 	char option_name[strlen(configOptionName) + 2];
 	char *token = NULL;
+	char *tokenstate = NULL;
 	
 	snprintf(option_name, sizeof(option_name), "%s%s", configOptionName, delims);
-	token = strtok(option_name, delims);
+	token = strtok_r(option_name, delims, &tokenstate);
 	while (token != NULL) {
 		sccp_log_and((DEBUGCAT_CONFIG + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_4 "Token %s/%s\n", option_name, token);
 		for (v = cat_root; v; v = v->next) {
@@ -308,7 +420,7 @@ static PBX_VARIABLE_TYPE *createVariableSetForMultiEntryParameters(PBX_VARIABLE_
 				}
 			}
 		}
-		token = strtok(NULL, delims);
+		token = strtok_r(NULL, delims, &tokenstate);
 	}
 EXIT:
 	return out;
@@ -2234,6 +2346,7 @@ static void sccp_config_buildDevice(sccp_device_t * d, PBX_VARIABLE_TYPE * varia
 		d->pendingUpdate = 0;
 	}
 	d->pendingDelete = 0;
+	sccp_dev_regcache_invalidate(d);
 }
 
 /*!
@@ -2398,6 +2511,336 @@ void cleanup_stale_contexts(char *new, char *old)
 	}
 }
 
+#define SCCP_CONFIG_BUILD_CHUNK 64										/*!< Number of sections built by a single build job */
+
+/*!
+ * \brief Staged Device or Line Section, built during the parallel phase of sccp_config_readDevicesLines
+ */
+typedef struct sccp_config_stagedSection {
+	const char *name;											/*!< Section Name (owned by GLOB(cfg)) */
+	PBX_VARIABLE_TYPE *v;											/*!< Section Variables (owned by GLOB(cfg)) */
+	sccp_device_t *device;											/*!< Retained Device, or NULL */
+	sccp_line_t *line;											/*!< Retained Line, or NULL */
+	boolean_t isNew;											/*!< Object still has to be added to the globals */
+	sccp_nat_t nat;												/*!< Nat state to restore on an existing device */
+	uint64_t hash;												/*!< Section Hash, see sccp_config_hashSection */
+	boolean_t unchanged;											/*!< Incremental Reload: section did not change, nothing to build */
+	int hashNext;												/*!< Index + 1 of the next Section in the same Bucket */
+} sccp_config_stagedSection_t;
+
+typedef struct sccp_config_buildState {
+	sccp_mutex_t lock;
+	pbx_cond_t done;
+	int pending;												/*!< Build jobs not finished yet */
+} sccp_config_buildState_t;
+
+typedef struct sccp_config_buildJob {
+	sccp_config_buildState_t *state;
+	sccp_config_stagedSection_t *sections;
+	int numsections;
+} sccp_config_buildJob_t;
+
+#define SCCP_CONFIG_HASH_SEED 14695981039346656037ULL								/*!< FNV-1a 64bit offset basis */
+#define SCCP_CONFIG_HASH_PRIME 1099511628211ULL									/*!< FNV-1a 64bit prime */
+
+static uint64_t sccp_config_sharedSectionsHash = 0;							/*!< Hash of the general/softkeyset sections of the previous (re)load, 0 = unknown */
+static boolean_t sccp_config_fullReloadRequested = FALSE;
+
+static uint64_t sccp_config_hashString(uint64_t hash, const char *str)
+{
+	do {													/* including the terminating '\0' as separator */
+		hash = (hash ^ (unsigned char) *str) * SCCP_CONFIG_HASH_PRIME;
+	} while (*str++);
+	return hash;
+}
+
+/*!
+ * \brief Hash a config section: its name and all its variables in order (including the ones inherited from a template)
+ * \note used by the incremental reload to find the sections which changed since the previous (re)load
+ */
+static uint64_t sccp_config_hashSection(uint64_t hash, const char *cat, PBX_VARIABLE_TYPE *v)
+{
+	hash = sccp_config_hashString(hash, cat);
+	for (; v; v = v->next) {
+		hash = sccp_config_hashString(hash, v->name);
+		hash = sccp_config_hashString(hash, v->value);
+	}
+	return hash;
+}
+
+/*!
+ * \brief Hash all sections which are not device or line sections (general, softkeysets)
+ * \note a change in any of them falls back to a full reload, devices and lines inherit from / refer to them
+ */
+static uint64_t sccp_config_hashSharedSections(void)
+{
+	uint64_t hash = SCCP_CONFIG_HASH_SEED;
+	const char *utype = NULL;
+	char *cat = NULL;
+
+	while ((cat = pbx_category_browse(GLOB(cfg), cat))) {
+		utype = pbx_variable_retrieve(GLOB(cfg), cat, "type");
+		if (utype && (!strcasecmp(utype, "device") || !strcasecmp(utype, "line"))) {
+			continue;
+		}
+		hash = sccp_config_hashSection(hash, cat, ast_variable_browse(GLOB(cfg), cat));
+	}
+	return hash;
+}
+
+/*!
+ * \brief Make the next reload a full reload, even if incrementalreload is enabled
+ */
+void sccp_config_requestFullReload(void)
+{
+	sccp_config_fullReloadRequested = TRUE;
+}
+
+/*!
+ * \brief Find an already staged device or line section with the same name
+ * \note sections are built in parallel, so a section defined twice may only be staged once
+ */
+static sccp_config_stagedSection_t *sccp_config_findStagedSection(sccp_config_stagedSection_t *sections, const int *stagedIndex, const char *name, boolean_t isDevice)
+{
+	int idx = stagedIndex[sccp_strcasehash(name, SCCP_HASH_PRIME)];
+
+	for (; idx; idx = sections[idx - 1].hashNext) {
+		if ((isDevice ? sections[idx - 1].device != NULL : sections[idx - 1].line != NULL) && sccp_strcaseequals(sections[idx - 1].name, name)) {
+			return &sections[idx - 1];
+		}
+	}
+	return NULL;
+}
+
+/*!
+ * \brief Incremental Reload: mark configured devices and lines whose section has been removed from sccp.conf
+ * \note realtime objects and the hotline line are not configured through a section
+ */
+static int sccp_config_markRemovedSections(sccp_config_stagedSection_t *sections, const int *stagedIndex)
+{
+	sccp_device_t *d = NULL;
+	sccp_line_t *l = NULL;
+	int removed = 0;
+
+	SCCP_RWLIST_WRLOCK(&GLOB(devices));
+	SCCP_RWLIST_TRAVERSE(&GLOB(devices), d, list) {
+#ifdef CS_SCCP_REALTIME
+		if (d->realtime) {
+			continue;
+		}
+#endif
+		if (!sccp_config_findStagedSection(sections, stagedIndex, d->id, TRUE)) {
+			sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "%s: device section removed\n", d->id);
+			sccp_device_prepareReload(d);
+			d->configHash = 0;
+			removed++;
+		}
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(devices));
+
+	SCCP_RWLIST_WRLOCK(&GLOB(lines));
+	SCCP_RWLIST_TRAVERSE(&GLOB(lines), l, list) {
+#ifdef CS_SCCP_REALTIME
+		if (l->realtime) {
+			continue;
+		}
+#endif
+		if (GLOB(hotline)->line != l && !sccp_config_findStagedSection(sections, stagedIndex, l->name, FALSE)) {
+			sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "%s: line section removed\n", l->name);
+			sccp_line_prepareReload(l);
+			l->configHash = 0;
+			removed++;
+		}
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(lines));
+	return removed;
+}
+
+/*!
+ * \brief Incremental Reload: invalidate the cached registration responses of the devices which were not rebuilt, but refer to a line
+ * which was rebuilt or removed
+ */
+static void sccp_config_invalidateUnchangedDevices(sccp_config_stagedSection_t *sections, const int *stagedIndex)
+{
+	sccp_device_t *d = NULL;
+	sccp_buttonconfig_t *config = NULL;
+	const sccp_config_stagedSection_t *section = NULL;
+	boolean_t invalidate = FALSE;
+
+	SCCP_RWLIST_RDLOCK(&GLOB(devices));
+	SCCP_RWLIST_TRAVERSE(&GLOB(devices), d, list) {
+		if ((section = sccp_config_findStagedSection(sections, stagedIndex, d->id, TRUE)) && !section->unchanged) {
+			continue;								/* rebuilt, already invalidated by sccp_config_buildDevice */
+		}
+		invalidate = FALSE;
+		SCCP_LIST_LOCK(&d->buttonconfig);
+		SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+			if (config->type != LINE || sccp_strlen_zero(config->button.line.name)) {
+				continue;
+			}
+			if ((section = sccp_config_findStagedSection(sections, stagedIndex, config->button.line.name, FALSE))) {
+				invalidate = !section->unchanged;
+			} else {
+				AUTO_RELEASE(sccp_line_t, line , sccp_line_find_byname(config->button.line.name, FALSE));
+				invalidate = (line && line->pendingDelete) ? TRUE : FALSE;
+			}
+			if (invalidate) {
+				break;
+			}
+		}
+		SCCP_LIST_UNLOCK(&d->buttonconfig);
+		if (invalidate) {
+			sccp_log((DEBUGCAT_CONFIG + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "%s: line reconfigured, invalidating cached registration responses\n", d->id);
+			sccp_dev_regcache_invalidate(d);
+		}
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(devices));
+}
+
+#ifdef CS_SCCP_REALTIME
+/*!
+ * \brief Invalidate the cached registration responses of the devices attached to a reconfigured realtime line
+ */
+static void sccp_config_invalidateLineDevices(sccp_line_t * l)
+{
+	sccp_linedevices_t *linedevice = NULL;
+
+	SCCP_LIST_LOCK(&l->devices);
+	SCCP_LIST_TRAVERSE(&l->devices, linedevice, list) {
+		sccp_dev_regcache_invalidate(linedevice->device);
+	}
+	SCCP_LIST_UNLOCK(&l->devices);
+}
+#endif
+
+/*!
+ * \brief Add the section at position numsections to the staging area
+ */
+static void sccp_config_commitStagedSection(sccp_config_stagedSection_t *sections, int *stagedIndex, int *numsections)
+{
+	unsigned int hash = sccp_strcasehash(sections[*numsections].name, SCCP_HASH_PRIME);
+
+	sections[*numsections].hashNext = stagedIndex[hash];
+	stagedIndex[hash] = ++(*numsections);
+}
+
+/*!
+ * \brief Return a cleared staging slot for section 'name', growing the staging area when needed
+ * \note the slot only becomes part of the staging area through sccp_config_commitStagedSection
+ */
+static sccp_config_stagedSection_t *sccp_config_stageSection(sccp_config_stagedSection_t **sections, int *numsections, int *maxsections, const char *name)
+{
+	sccp_config_stagedSection_t *section = NULL;
+
+	if (*numsections == *maxsections) {
+		sccp_config_stagedSection_t *grown = NULL;
+
+		if (!(grown = sccp_realloc(*sections, sizeof(sccp_config_stagedSection_t) * (*maxsections + 256)))) {
+			pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+			return NULL;
+		}
+		*sections = grown;
+		*maxsections += 256;
+	}
+	section = &(*sections)[*numsections];
+	memset(section, 0, sizeof(sccp_config_stagedSection_t));
+	section->name = name;
+	section->nat = SCCP_NAT_AUTO;
+	return section;
+}
+
+/*!
+ * \brief Build a range of staged sections
+ * \note runs on the build threadpool, every section refers to a different object
+ */
+static void *sccp_config_buildJob_run(void *ptr)
+{
+	sccp_config_buildJob_t *job = (sccp_config_buildJob_t *) ptr;
+	sccp_config_buildState_t *state = job->state;
+	sccp_config_stagedSection_t *section = NULL;
+	int idx;
+
+	for (idx = 0; idx < job->numsections; idx++) {
+		section = &job->sections[idx];
+		if (section->unchanged) {
+			continue;
+		}
+		if (section->line) {
+			sccp_config_buildLine(section->line, section->v, section->name, FALSE);
+			section->line->configHash = section->hash;
+		} else if (section->device) {
+			sccp_config_buildDevice(section->device, section->v, section->name, FALSE);
+			section->device->configHash = section->hash;
+			/* load saved settings from ast db */
+			sccp_config_restoreDeviceFeatureStatus(section->device);
+
+			/* restore current nat status, if device does not get restarted */
+			if (!section->isNew && 0 == section->device->pendingDelete && sccp_device_getRegistrationState(section->device) != SKINNY_DEVICE_RS_NONE) {
+				if (SCCP_NAT_AUTO == section->device->nat && (SCCP_NAT_AUTO == section->nat || SCCP_NAT_AUTO_OFF == section->nat || SCCP_NAT_AUTO_ON == section->nat)) {
+					section->device->nat = section->nat;
+				}
+			}
+		}
+	}
+	sccp_free(job);
+
+	sccp_mutex_lock(&state->lock);
+	state->pending--;
+	pbx_cond_signal(&state->done);
+	sccp_mutex_unlock(&state->lock);
+	return NULL;
+}
+
+/*!
+ * \brief Build all staged sections on a dedicated threadpool and wait for them to finish
+ *
+ * sccp_reload calls this while holding the GLOB(lock) write lock. Jobs on the general threadpool (like the hint linestatus
+ * listener) can be blocked on that lock, so waiting for build jobs queued behind them would never return. The build threadpool
+ * only lives for the duration of this call and only runs build jobs. When it cannot be started, everything is built inline.
+ */
+static void sccp_config_buildStagedSections(sccp_config_stagedSection_t *sections, int numsections)
+{
+	sccp_config_buildState_t state = {.pending = 0};
+	sccp_config_buildJob_t *job = NULL;
+	sccp_threadpool_t *buildPool = NULL;
+	int idx;
+
+	pbx_mutex_init(&state.lock);
+	pbx_cond_init(&state.done, NULL);
+	if (numsections > SCCP_CONFIG_BUILD_CHUNK) {
+		buildPool = sccp_threadpool_init(THREADPOOL_MIN_SIZE);
+	}
+
+	for (idx = 0; idx < numsections; idx += SCCP_CONFIG_BUILD_CHUNK) {
+		if (!(job = sccp_calloc(1, sizeof(sccp_config_buildJob_t)))) {
+			pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+			break;
+		}
+		job->state = &state;
+		job->sections = &sections[idx];
+		job->numsections = (numsections - idx < SCCP_CONFIG_BUILD_CHUNK) ? numsections - idx : SCCP_CONFIG_BUILD_CHUNK;
+
+		sccp_mutex_lock(&state.lock);
+		state.pending++;
+		sccp_mutex_unlock(&state.lock);
+		if (!(buildPool && sccp_threadpool_add_work(buildPool, (void *) sccp_config_buildJob_run, (void *) job))) {
+			sccp_config_buildJob_run(job);
+		}
+	}
+
+	sccp_mutex_lock(&state.lock);
+	while (state.pending > 0) {
+		pbx_cond_wait(&state.done, &state.lock);
+	}
+	sccp_mutex_unlock(&state.lock);
+	if (buildPool) {
+		sccp_threadpool_destroy(buildPool);
+	}
+
+	pbx_cond_destroy(&state.done);
+	pbx_mutex_destroy(&state.lock);
+}
+
 /*!
  * \brief Read Lines from the Config File
  *
@@ -2415,14 +2858,27 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 
 	char *cat = NULL;
 	PBX_VARIABLE_TYPE *v = NULL;
-	uint8_t device_count = 0;
-	uint8_t line_count = 0;
+	int device_count = 0;
+	int line_count = 0;
 	sccp_device_t *d = NULL;
+	sccp_config_stagedSection_t *sections = NULL, *section = NULL;
+	int numsections = 0, maxsections = 0, idx = 0;
+	int stagedIndex[SCCP_HASH_PRIME] = { 0 };
+	struct timeval phase_start = pbx_tvnow();
+	struct timeval reload_start = phase_start;
+	long scanMs = 0, buildMs = 0, commitMs = 0;
+	uint64_t sharedHash = GLOB(cfg) ? sccp_config_hashSharedSections() : 0;
+	boolean_t incremental = FALSE;
+	int unchanged_count = 0, removed_count = 0;
 
 	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "Loading Devices and Lines from config\n");
 
 	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "Checking Reading Type:%s (%d)\n", readingtype == 0 ? "Module load" : "Reload", readingtype);
-	if (readingtype == SCCP_CONFIG_READRELOAD) {
+	if (readingtype == SCCP_CONFIG_READRELOAD && GLOB(incrementalreload) && !sccp_config_fullReloadRequested && sccp_config_sharedSectionsHash && sharedHash == sccp_config_sharedSectionsHash) {
+		/* general and softkeyset sections did not change: only changed/removed devices and lines are marked, while scanning */
+		sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "Incremental Reload\n");
+		incremental = TRUE;
+	} else if (readingtype == SCCP_CONFIG_READRELOAD) {
 		sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "Device Pre Reload\n");
 		sccp_device_pre_reload();
 		sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "Line Pre Reload\n");
@@ -2435,7 +2891,9 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 		pbx_log(LOG_NOTICE, "SCCP: (sccp_config_readDevicesLines) Unable to load config file sccp.conf, SCCP disabled\n");
 		return FALSE;
 	}
+	sccp_config_fullReloadRequested = FALSE;
 
+	/* phase 1: scan the sections and stage the objects to be built */
 	while ((cat = pbx_category_browse(GLOB(cfg), cat))) {
 
 		const char *utype;
@@ -2455,39 +2913,40 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 			if (sccp_strlen_zero(pbx_variable_retrieve(GLOB(cfg), cat, "devicetype"))) {
 				pbx_log(LOG_WARNING, "Unknown type '%s' for '%s' in %s\n", utype, cat, "sccp.conf");
 				continue;
-			} else {
-				v = ast_variable_browse(GLOB(cfg), cat);
+			} else if (sccp_config_findStagedSection(sections, stagedIndex, cat, TRUE)) {
+				pbx_log(LOG_WARNING, "SCCP: (sccp_config_readDevicesLines) Device [%s] is defined more than once, skipping\n", cat);
+				continue;
+			} else if ((section = sccp_config_stageSection(&sections, &numsections, &maxsections, cat))) {
+				section->v = ast_variable_browse(GLOB(cfg), cat);
+				section->hash = sccp_config_hashSection(SCCP_CONFIG_HASH_SEED, cat, section->v);
 
 				// Try to find out if we have the device already on file.
 				// However, do not look into realtime, since
 				// we might have been asked to create a device for realtime addition,
 				// thus causing an infinite loop / recursion.
-				AUTO_RELEASE(sccp_device_t, device, sccp_device_find_byid(cat, FALSE));
-				sccp_nat_t nat = SCCP_NAT_AUTO;
-
-				/* create new device with default values */
-				if (!device) {
-					device = sccp_device_create(cat);
-					// sccp_copy_string(d->id, cat, sizeof(d->id));         /* set device name */
-					sccp_device_addToGlobals(device);
+				section->device = sccp_device_find_byid(cat, FALSE);
+
+				/* create new device with default values, added to the globals after it has been built */
+				if (!section->device) {
+					if (!(section->device = sccp_device_create(cat))) {
+						continue;
+					}
+					section->isNew = TRUE;
 					device_count++;
+				} else if (incremental && !section->device->pendingDelete && section->device->configHash == section->hash) {
+					section->unchanged = TRUE;
+					unchanged_count++;
 				} else {
-					if (device->pendingDelete) {
-						nat = device->nat;
-						device->pendingDelete = 0;
+					if (incremental) {
+						sccp_device_prepareReload(section->device);
 					}
-				}
-				sccp_config_buildDevice(device, v, cat, FALSE);
-				sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "found device %d: %s\n", device_count, cat);
-				/* load saved settings from ast db */
-				sccp_config_restoreDeviceFeatureStatus(device);
-				
-				/* restore current nat status, if device does not get restarted */
-				if (0 == device->pendingDelete && sccp_device_getRegistrationState(device) != SKINNY_DEVICE_RS_NONE) {
-					if (SCCP_NAT_AUTO == device->nat && (SCCP_NAT_AUTO == nat || SCCP_NAT_AUTO_OFF == nat || SCCP_NAT_AUTO_ON == nat)) {
-						device->nat = nat;
+					if (section->device->pendingDelete) {
+						section->nat = section->device->nat;
+						section->device->pendingDelete = 0;
 					}
 				}
+				sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "found device %d: %s\n", device_count, cat);
+				sccp_config_commitStagedSection(sections, stagedIndex, &numsections);
 			}
 		} else if (!strcasecmp(utype, "line")) {
 			/* check minimum requirements for a line */
@@ -2497,24 +2956,41 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 				pbx_log(LOG_WARNING, "Unknown type '%s' for '%s' in %s\n", utype, cat, "sccp.conf");
 				continue;
 			}
+			if (sccp_config_findStagedSection(sections, stagedIndex, cat, FALSE)) {
+				pbx_log(LOG_WARNING, "SCCP: (sccp_config_readDevicesLines) Line [%s] is defined more than once, skipping\n", cat);
+				continue;
+			}
+			if (!(section = sccp_config_stageSection(&sections, &numsections, &maxsections, cat))) {
+				continue;
+			}
 			line_count++;
 
-			v = ast_variable_browse(GLOB(cfg), cat);
-			AUTO_RELEASE(sccp_line_t, l , sccp_line_find_byname(cat, FALSE));
+			section->v = ast_variable_browse(GLOB(cfg), cat);
+			section->hash = sccp_config_hashSection(SCCP_CONFIG_HASH_SEED, cat, section->v);
 
 			/* check if we have this line already */
-			//    SCCP_RWLIST_WRLOCK(&GLOB(lines));
-			if (l) {
-				sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "found line %d: %s, do update\n", line_count, cat);
-				sccp_config_buildLine(l, v, cat, FALSE);
-			} else if ((l = sccp_line_create(cat))) {
-				sccp_config_buildLine(l, v, cat, FALSE);
-				sccp_line_addToGlobals(l);						/* may find another line instance create by another thread, in that case the newly created line is going to be dropped when l is released */
+			if ((section->line = sccp_line_find_byname(cat, FALSE))) {
+				if (incremental && !section->line->pendingDelete && section->line->configHash == section->hash) {
+					section->unchanged = TRUE;
+					unchanged_count++;
+				} else {
+					sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "found line %d: %s, do update\n", line_count, cat);
+					if (incremental) {
+						sccp_line_prepareReload(section->line);
+					}
+				}
+			} else if ((section->line = sccp_line_create(cat))) {
+				section->isNew = TRUE;
+			} else {
+				continue;
 			}
-			//    SCCP_RWLIST_UNLOCK(&GLOB(lines));
+			sccp_config_commitStagedSection(sections, stagedIndex, &numsections);
 
 		} else if (!strcasecmp(utype, "softkeyset")) {
 			sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "parsing softkey [%s]\n", cat);
+			if (incremental) {
+				continue;								/* unchanged and not cleared by an incremental reload */
+			}
 			if (sccp_strcaseequals(cat, "default")) {
 				pbx_log(LOG_WARNING, "SCCP: (sccp_config_readDevicesLines) The 'default' softkeyset cannot be overriden, please use another name\n");
 			} else {
@@ -2525,7 +3001,46 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 			pbx_log(LOG_WARNING, "SCCP: (sccp_config_readDevicesLines) UNKNOWN SECTION / UTYPE, type: %s\n", utype);
 		}
 	}
-	sccp_config_add_default_softkeyset();
+	if (incremental) {
+		removed_count = sccp_config_markRemovedSections(sections, stagedIndex);
+	}
+	scanMs = ast_tvdiff_ms(pbx_tvnow(), phase_start);
+
+	/* phase 2: build the staged devices and lines in parallel, every section refers to its own object */
+	phase_start = pbx_tvnow();
+	sccp_config_buildStagedSections(sections, numsections);
+	if (incremental) {
+		sccp_config_invalidateUnchangedDevices(sections, stagedIndex);
+	}
+	buildMs = ast_tvdiff_ms(pbx_tvnow(), phase_start);
+
+	/* phase 3: publish the newly built objects */
+	phase_start = pbx_tvnow();
+	for (idx = 0; idx < numsections; idx++) {
+		section = &sections[idx];
+		if (section->line) {
+			if (section->isNew) {
+				sccp_line_addToGlobals(section->line);					/* may find another line instance create by another thread, in that case the newly created line is going to be dropped when it is released */
+			}
+			sccp_line_release(&section->line);
+		} else if (section->device) {
+			if (section->isNew) {
+				sccp_device_addToGlobals(section->device);
+			}
+			sccp_device_release(&section->device);
+		}
+	}
+	commitMs = ast_tvdiff_ms(pbx_tvnow(), phase_start);
+	if (sections) {
+		sccp_free(sections);
+	}
+	if (incremental) {
+		pbx_log(LOG_NOTICE, "SCCP: Incrementally reloaded %d sections (%d unchanged, %d removed, %d new devices, %d lines): scan %ld ms, build %ld ms, publish %ld ms\n", numsections, unchanged_count, removed_count, device_count, line_count, scanMs, buildMs, commitMs);
+	} else {
+		pbx_log(LOG_NOTICE, "SCCP: %s %d sections (%d new devices, %d lines): scan %ld ms, build %ld ms, publish %ld ms\n", readingtype == SCCP_CONFIG_READRELOAD ? "Reloaded" : "Loaded", numsections, device_count, line_count, scanMs, buildMs, commitMs);
+		sccp_config_add_default_softkeyset();
+	}
+	sccp_config_sharedSectionsHash = sharedHash;
 
 #ifdef CS_SCCP_REALTIME
 	/* reload realtime lines */
@@ -2556,6 +3071,7 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 					} else {
 						line->pendingUpdate = 0;
 					}
+					sccp_config_invalidateLineDevices(line);
 					pbx_variables_destroy(rv);
 				}
 			} while (0);
@@ -2587,6 +3103,7 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 					} else {
 						device->pendingUpdate = 0;
 					}
+					sccp_dev_regcache_invalidate(device);
 					pbx_variables_destroy(rv);
 				}
 			} while (0);
@@ -2614,6 +3131,7 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 
 	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "Checking Reading Type\n");
 	if (readingtype == SCCP_CONFIG_READRELOAD) {
+		phase_start = pbx_tvnow();
 		/* IMPORTANT: The line_post_reload function may change the pendingUpdate field of
 		 * devices, so it's really important to call it *before* calling device_post_real().
 		 */
@@ -2623,6 +3141,7 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 		sccp_device_post_reload();
 		sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "Softkey Post Reload\n");
 		sccp_softkey_post_reload();
+		pbx_log(LOG_NOTICE, "SCCP: Post reload (device resets) %ld ms, whole device/line reload %ld ms\n", (long) ast_tvdiff_ms(pbx_tvnow(), phase_start), (long) ast_tvdiff_ms(pbx_tvnow(), reload_start));
 	}
 	return TRUE;
 }
@@ -2699,6 +3218,18 @@ sccp_config_file_status_t sccp_config_getConfig(boolean_t force)
 	// struct ast_flags config_flags = { CONFIG_FLAG_WITHCOMMENTS & CONFIG_FLAG_FILEUNCHANGED };
 	int res = 0;
 	struct ast_flags config_flags = { CONFIG_FLAG_FILEUNCHANGED };
+	sccp_config_snapshot_source_t source = { 0 };
+	boolean_t haveSource = FALSE;
+	boolean_t fromSnapshot = FALSE;
+	struct timeval start = pbx_tvnow();
+
+	if (sccp_strlen_zero(GLOB(config_file_name))) {
+		GLOB(config_file_name) = pbx_strdup("sccp.conf");
+	}
+	if (force && !GLOB(cfg) && (GLOB(cfg) = sccp_config_snapshot_load(GLOB(config_file_name)))) {		/* module load: use the snapshot of an unchanged config file */
+		fromSnapshot = TRUE;
+		goto VALIDATE;
+	}
 	if (force) {
 		if (GLOB(cfg)) {
 			pbx_config_destroy(GLOB(cfg));
@@ -2707,9 +3238,7 @@ sccp_config_file_status_t sccp_config_getConfig(boolean_t force)
 		pbx_clear_flag(&config_flags, CONFIG_FLAG_FILEUNCHANGED);
 	}
 
-	if (sccp_strlen_zero(GLOB(config_file_name))) {
-		GLOB(config_file_name) = pbx_strdup("sccp.conf");
-	}
+	haveSource = sccp_config_snapshot_statSource(GLOB(config_file_name), &source);
 	GLOB(cfg) = pbx_config_load(GLOB(config_file_name), "chan_sccp", config_flags);
 	if (GLOB(cfg) == CONFIG_STATUS_FILEMISSING) {
 		pbx_log(LOG_ERROR, "Config file '%s' not found, aborting (re)load.\n", GLOB(config_file_name));
@@ -2741,6 +3270,7 @@ sccp_config_file_status_t sccp_config_getConfig(boolean_t force)
 			pbx_log(LOG_NOTICE, "Config file '%s' has not changed, forcing reload.\n", GLOB(config_file_name));
 		}
 	}
+VALIDATE:
 	if (GLOB(cfg)) {
 		if (ast_variable_browse(GLOB(cfg), "devices")) {						/* Warn user when old entries exist in sccp.conf */
 			pbx_log(LOG_ERROR, "\n\n --> You are using an old configuration format, please update '%s'!!\n --> Loading of module chan_sccp with current sccp.conf has terminated\n --> Check http://chan-sccp-b.sourceforge.net/doc_setup.shtml for more information.\n\n", GLOB(config_file_name));
@@ -2761,7 +3291,12 @@ sccp_config_file_status_t sccp_config_getConfig(boolean_t force)
 		res = CONFIG_STATUS_FILE_NOT_FOUND;
 		goto FUNC_EXIT;
 	}
-	pbx_log(LOG_NOTICE, "Config file '%s' loaded.\n", GLOB(config_file_name));
+	if (fromSnapshot) {
+		pbx_log(LOG_NOTICE, "Config file '%s' loaded from snapshot in %ld ms.\n", GLOB(config_file_name), (long) ast_tvdiff_ms(pbx_tvnow(), start));
+	} else {
+		pbx_log(LOG_NOTICE, "Config file '%s' loaded in %ld ms.\n", GLOB(config_file_name), (long) ast_tvdiff_ms(pbx_tvnow(), start));
+		sccp_config_snapshot_save(GLOB(cfg), GLOB(config_file_name), haveSource ? &source : NULL, ast_tvdiff_ms(pbx_tvnow(), start));
+	}
 	res = CONFIG_STATUS_FILE_OK;
 FUNC_EXIT:
 	return res;
@@ -3001,6 +3536,17 @@ void sccp_config_softKeySet(PBX_VARIABLE_TYPE * variable, const char *name)
 		variable = variable->next;
 	}
 
+	/* devices using this softkeyset (every device may fall back to 'default') have to rebuild their softkey responses */
+	sccp_device_t *d = NULL;
+	boolean_t isDefault = sccp_strcaseequals(name, "default");
+
+	SCCP_RWLIST_RDLOCK(&GLOB(devices));
+	SCCP_RWLIST_TRAVERSE(&GLOB(devices), d, list) {
+		if (isDefault || d->softkeyset == softKeySetConfiguration || (d->softkeyDefinition && sccp_strcaseequals(d->softkeyDefinition, name))) {
+			sccp_dev_regcache_invalidate(d);
+		}
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(devices));
 }
 
 
@@ -3565,6 +4111,158 @@ AST_TEST_DEFINE(sccp_config_tokenized_default)
 	return AST_TEST_PASS;
 }
 
+/* previous implementation of sccp_find_config, used as reference */
+static const SCCPConfigOption *sccp_find_config_scan(const sccp_config_segment_t segment, const char *name)
+{
+	long unsigned int i = 0;
+	const SCCPConfigSegment *sccpConfigSegment = sccp_find_segment(segment);
+	const SCCPConfigOption *config = sccpConfigSegment->config;
+	char *config_name = NULL, *token = NULL, *tokenstate = NULL;
+
+	for (i = 0; i < sccpConfigSegment->config_size; i++) {
+		if (strchr(config[i].name, '|') != NULL) {
+			config_name = pbx_strdupa(config[i].name);
+			for (token = strtok_r(config_name, "|", &tokenstate); token; token = strtok_r(NULL, "|", &tokenstate)) {
+				if (!strcasecmp(token, name)) {
+					return &config[i];
+				}
+			}
+		}
+		if (!strcasecmp(config[i].name, name)) {
+			return &config[i];
+		}
+	}
+	return NULL;
+}
+
+#define NUM_TEST_DEVICES 8000
+AST_TEST_DEFINE(sccp_config_find_config)
+{
+	long unsigned int segment_idx = 0, i = 0;
+	int device = 0, numaliases = 0;
+	char *config_name = NULL, *token = NULL, *tokenstate = NULL;
+	char upper[80];
+	size_t i_upper = 0;
+	const SCCPConfigSegment *sccpConfigSegment = NULL;
+	const char **aliases = NULL;
+	struct timeval start;
+	long indexMs = 0, scanMs = 0;
+
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "find_config";
+			info->category = "/channels/chan_sccp/config/";
+			info->summary = "chan-sccp-b config option lookup test";
+			info->description = "resolves every option name and alias through the alias index and compares the result and the time needed for the keys of 8000 device sections against a scan of the option table";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	pbx_test_status_update(test, "Resolve every option and alias of every segment...\n");
+	for (segment_idx = 0; segment_idx < ARRAY_LEN(sccpConfigSegments); segment_idx++) {
+		sccpConfigSegment = &sccpConfigSegments[segment_idx];
+		for (i = 0; i < sccpConfigSegment->config_size; i++) {
+			config_name = pbx_strdupa(sccpConfigSegment->config[i].name);
+			for (token = strtok_r(config_name, "|", &tokenstate); token; token = strtok_r(NULL, "|", &tokenstate)) {
+				pbx_test_validate(test, sccp_find_config(sccpConfigSegment->segment, token) == sccp_find_config_scan(sccpConfigSegment->segment, token));
+				for (i_upper = 0; token[i_upper] && i_upper < sizeof(upper) - 1; i_upper++) {
+					upper[i_upper] = toupper(token[i_upper]);
+				}
+				upper[i_upper] = '\0';
+				pbx_test_validate(test, sccp_find_config(sccpConfigSegment->segment, upper) == sccp_find_config_scan(sccpConfigSegment->segment, token));
+			}
+		}
+	}
+	pbx_test_validate(test, sccp_find_config(SCCP_CONFIG_GLOBAL_SEGMENT, "allow") == sccp_find_config(SCCP_CONFIG_GLOBAL_SEGMENT, "disallow"));
+	pbx_test_validate(test, sccp_find_config(SCCP_CONFIG_DEVICE_SEGMENT, "unknown_option") == NULL);
+	pbx_test_validate(test, sccp_find_config(SCCP_CONFIG_DEVICE_SEGMENT, "") == NULL);
+
+	sccpConfigSegment = sccp_find_segment(SCCP_CONFIG_DEVICE_SEGMENT);
+	aliases = pbx_malloc(sizeof(char *) * sccpConfigSegment->config_size * 2);
+	pbx_test_validate(test, aliases != NULL);
+	for (i = 0; i < sccpConfigSegment->config_size && numaliases < (int) sccpConfigSegment->config_size * 2; i++) {
+		config_name = pbx_strdupa(sccpConfigSegment->config[i].name);
+		for (token = strtok_r(config_name, "|", &tokenstate); token && numaliases < (int) sccpConfigSegment->config_size * 2; token = strtok_r(NULL, "|", &tokenstate)) {
+			aliases[numaliases++] = token;
+		}
+	}
+
+	pbx_test_status_update(test, "Resolve %d device keys for %d devices using the alias index...\n", numaliases, NUM_TEST_DEVICES);
+	start = pbx_tvnow();
+	for (device = 0; device < NUM_TEST_DEVICES; device++) {
+		for (i = 0; i < (long unsigned int) numaliases; i++) {
+			if (!sccp_find_config(SCCP_CONFIG_DEVICE_SEGMENT, aliases[i])) {
+				break;
+			}
+		}
+	}
+	indexMs = ast_tvdiff_ms(pbx_tvnow(), start);
+
+	pbx_test_status_update(test, "Resolve %d device keys for %d devices using a table scan...\n", numaliases, NUM_TEST_DEVICES / 10);
+	start = pbx_tvnow();
+	for (device = 0; device < NUM_TEST_DEVICES / 10; device++) {					/* keep the test short, extrapolate from a tenth */
+		for (i = 0; i < (long unsigned int) numaliases; i++) {
+			if (!sccp_find_config_scan(SCCP_CONFIG_DEVICE_SEGMENT, aliases[i])) {
+				break;
+			}
+		}
+	}
+	scanMs = ast_tvdiff_ms(pbx_tvnow(), start) * 10;
+	pbx_test_status_update(test, "%d device sections: alias index %ld ms, table scan (extrapolated) %ld ms\n", NUM_TEST_DEVICES, indexMs, scanMs);
+	sccp_free(aliases);
+
+	return AST_TEST_PASS;
+}
+
+AST_TEST_DEFINE(sccp_config_section_hash)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "section_hash";
+			info->category = "/channels/chan_sccp/config/";
+			info->summary = "chan-sccp-b config section hash test";
+			info->description = "chan-sccp-b incremental reload only rebuilds sections with a different hash";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	PBX_VARIABLE_TYPE *root = NULL, *other = NULL;
+	uint64_t hash = 0;
+	enum ast_test_result_state res = AST_TEST_PASS;
+
+	root = ast_variable_new("devicetype", "7960", "");
+	root->next = ast_variable_new("button", "line, 1000", "");
+	root->next->next = ast_variable_new("button", "line, 1001", "");
+	hash = sccp_config_hashSection(SCCP_CONFIG_HASH_SEED, "SEP001122334455", root);
+
+	pbx_test_status_update(test, "Same section, same hash...\n");
+	pbx_test_validate_cleanup(test, hash == sccp_config_hashSection(SCCP_CONFIG_HASH_SEED, "SEP001122334455", root), res, cleanup);
+
+	pbx_test_status_update(test, "Other section name, other hash...\n");
+	pbx_test_validate_cleanup(test, hash != sccp_config_hashSection(SCCP_CONFIG_HASH_SEED, "SEP001122334456", root), res, cleanup);
+
+	pbx_test_status_update(test, "Swapped buttons, other hash...\n");
+	other = ast_variable_new("devicetype", "7960", "");
+	other->next = ast_variable_new("button", "line, 1001", "");
+	other->next->next = ast_variable_new("button", "line, 1000", "");
+	pbx_test_validate_cleanup(test, hash != sccp_config_hashSection(SCCP_CONFIG_HASH_SEED, "SEP001122334455", other), res, cleanup);
+	pbx_variables_destroy(other);
+
+	pbx_test_status_update(test, "Name/Value boundary moved, other hash...\n");
+	other = ast_variable_new("devicetyp", "e7960", "");
+	other->next = ast_variable_new("button", "line, 1000", "");
+	other->next->next = ast_variable_new("button", "line, 1001", "");
+	pbx_test_validate_cleanup(test, hash != sccp_config_hashSection(SCCP_CONFIG_HASH_SEED, "SEP001122334455", other), res, cleanup);
+
+cleanup:
+	pbx_variables_destroy(other);
+	pbx_variables_destroy(root);
+
+	return res;
+}
+
 /*
 AST_TEST_DEFINE(sccp_config_setValue)
 {
@@ -3610,6 +4308,8 @@ static void __attribute__((constructor)) sccp_register_tests(void)
 	AST_TEST_REGISTER(sccp_config_base_functions);
 	AST_TEST_REGISTER(sccp_config_multientry);
 	AST_TEST_REGISTER(sccp_config_tokenized_default);
+	AST_TEST_REGISTER(sccp_config_find_config);
+	AST_TEST_REGISTER(sccp_config_section_hash);
 	//AST_TEST_REGISTER(sccp_config_setValue);
 	//AST_TEST_REGISTER(sccp_config_setDefault);
 }
@@ -3619,6 +4319,8 @@ static void __attribute__((destructor)) sccp_unregister_tests(void)
 	AST_TEST_UNREGISTER(sccp_config_base_functions);
 	AST_TEST_UNREGISTER(sccp_config_multientry);
 	AST_TEST_UNREGISTER(sccp_config_tokenized_default);
+	AST_TEST_UNREGISTER(sccp_config_find_config);
+	AST_TEST_UNREGISTER(sccp_config_section_hash);
 	//AST_TEST_UNREGISTER(sccp_config_setValue);
 	//AST_TEST_UNREGISTER(sccp_config_setDefault);
 }
@@ -116,7 +116,13 @@ static const SCCPConfigOption sccpGlobalConfigOptions[]={
 #ifdef CS_SCCP_REALTIME
 	{"devicetable", 		G_OBJ_REF(realtimedevicetable), 	TYPE_STRINGPTR,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"sccpdevice",			"datebasetable for devices\n"},
 	{"linetable", 			G_OBJ_REF(realtimelinetable), 		TYPE_STRINGPTR,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"sccpline",			"datebasetable for lines\n"},
+	{"realtimecachettl", 		G_OBJ_REF(realtimecachettl), 		TYPE_UINT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"60",				"Number of seconds realtime device and line lookups (including lookups which did not find a row) are cached. 0 disables the cache\n"},
+	{"realtimepreload", 		G_OBJ_REF(realtimepreload), 		TYPE_BOOLEAN,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"no",				"Build all realtime lines and devices at startup, before the listener is opened, instead of on first registration\n"},
 #endif
+	{"incrementalreload", 		G_OBJ_REF(incrementalreload), 		TYPE_BOOLEAN,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"no",				"During reload only reapply device and line sections which have changed since the previous (re)load. Unchanged devices are not touched at all.\n"
+																																					"Changes to the general section or to a softkeyset always cause a full reload, 'sccp reload force' also forces one.\n"},
+	{"configsnapshot", 		G_OBJ_REF(configsnapshot), 		TYPE_BOOLEAN,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"no",				"Write a binary snapshot of the parsed configuration (to the asterisk var directory), which is loaded instead of parsing this file on the next module load, as long as this file has not changed.\n"
+																																					"Not used when this file uses #include or #exec.\n"},
 	{"meetme", 			G_OBJ_REF(meetme), 			TYPE_BOOLEAN,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"yes",				"enable/disable conferencing via meetme (on/off), make sure you have one of the meetme apps mentioned below activated in module.conf\n"
 																																	"when switching meetme=on it will search for the first of these three possible meetme applications and set these defaults\n"
 																																					" - {'MeetMe', 'qd'},\n"
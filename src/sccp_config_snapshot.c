@@ -0,0 +1,459 @@
+/*!
+ * \file        sccp_config_snapshot.c
+ * \brief       SCCP Compiled Configuration Snapshot
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * When 'configsnapshot' is enabled, every successfully parsed sccp.conf is written to a versioned and checksummed binary
+ * snapshot, holding the fully resolved sections (templates already applied) in config order. On the next module load the
+ * snapshot is mmap'ed and turned back into an ast_config without parsing the config file again, as long as the content of
+ * the source file still hashes to the value recorded in the snapshot. Timestamps are not used: on most filesystems they
+ * have a one second resolution and would miss an edit made within the same second. A config file using \#include / \#exec
+ * never gets a snapshot, as the included files can not be checked.
+ *
+ * Snapshot Layout: sccp_config_snapshot_header_t followed by the payload, a sequence of records:
+ *  - 'C' name '\\0'              starts a new section
+ *  - 'V' name '\\0' value '\\0'   adds a variable to the current section
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_config_snapshot.h"
+#include "sccp_utils.h"
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#include <asterisk/paths.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#define SCCP_CONFIG_SNAPSHOT_MAGIC "SCCPSNAP"
+#define SCCP_CONFIG_SNAPSHOT_VERSION 2
+#define SCCP_CONFIG_SNAPSHOT_HASH_SEED 14695981039346656037ULL							/*!< FNV-1a 64bit offset basis */
+#define SCCP_CONFIG_SNAPSHOT_HASH_PRIME 1099511628211ULL							/*!< FNV-1a 64bit prime */
+
+typedef struct sccp_config_snapshot_header {
+	char magic[8];												/*!< SCCP_CONFIG_SNAPSHOT_MAGIC */
+	uint32_t version;											/*!< SCCP_CONFIG_SNAPSHOT_VERSION */
+	uint32_t headerSize;											/*!< sizeof(sccp_config_snapshot_header_t) of the writer */
+	int64_t sourceSize;											/*!< Size of the Config File */
+	uint64_t sourceHash;											/*!< FNV-1a 64bit over the Config File content */
+	uint64_t payloadSize;											/*!< Number of bytes following the header */
+	uint64_t checksum;											/*!< FNV-1a 64bit over the payload */
+	uint32_t numCategories;											/*!< Number of Sections */
+	uint32_t parseMs;											/*!< Time it took to parse the Config File */
+} sccp_config_snapshot_header_t;
+
+typedef struct sccp_config_snapshot_buffer {
+	char *data;
+	size_t len;
+	size_t size;
+} sccp_config_snapshot_buffer_t;
+
+static uint64_t sccp_config_snapshot_checksum(const char *data, size_t len)
+{
+	uint64_t hash = SCCP_CONFIG_SNAPSHOT_HASH_SEED;
+	size_t pos;
+
+	for (pos = 0; pos < len; pos++) {
+		hash = (hash ^ (unsigned char) data[pos]) * SCCP_CONFIG_SNAPSHOT_HASH_PRIME;
+	}
+	return hash;
+}
+
+/*!
+ * \brief Hash the content of a file
+ * \return TRUE on success, FALSE if the file could not be read
+ */
+static boolean_t sccp_config_snapshot_hashFile(const char *path, struct stat *sb, uint64_t *hash)
+{
+	void *map = MAP_FAILED;
+	boolean_t res = FALSE;
+	int fd = -1;
+
+	if ((fd = open(path, O_RDONLY)) < 0) {
+		return FALSE;
+	}
+	if (fstat(fd, sb) != 0) {
+		res = FALSE;
+	} else if (sb->st_size == 0) {
+		*hash = sccp_config_snapshot_checksum(NULL, 0);
+		res = TRUE;
+	} else if ((map = mmap(NULL, sb->st_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED) {
+		*hash = sccp_config_snapshot_checksum((const char *) map, sb->st_size);
+		munmap(map, sb->st_size);
+		res = TRUE;
+	}
+	close(fd);
+	return res;
+}
+
+/*!
+ * \brief Resolve the config file and snapshot file names
+ */
+static void sccp_config_snapshot_paths(const char *config_file_name, char *source, size_t sourcelen, char *snapshot, size_t snapshotlen)
+{
+	const char *basename = NULL;
+
+	if (sccp_strlen_zero(config_file_name)) {
+		config_file_name = "sccp.conf";
+	}
+	if (config_file_name[0] == '/') {
+		snprintf(source, sourcelen, "%s", config_file_name);
+	} else {
+		snprintf(source, sourcelen, "%s/%s", ast_config_AST_CONFIG_DIR, config_file_name);
+	}
+	basename = strrchr(source, '/');
+	snprintf(snapshot, snapshotlen, "%s/chan_sccp-%s.snapshot", ast_config_AST_VAR_DIR, basename ? basename + 1 : source);
+}
+
+/*!
+ * \brief Append a record to the snapshot buffer
+ */
+static boolean_t sccp_config_snapshot_append(sccp_config_snapshot_buffer_t *buffer, char type, const char *name, const char *value)
+{
+	size_t namelen = strlen(name) + 1;
+	size_t valuelen = value ? strlen(value) + 1 : 0;
+	size_t needed = buffer->len + 1 + namelen + valuelen;
+
+	if (needed > buffer->size) {
+		size_t size = buffer->size ? buffer->size : 65536;
+		char *data = NULL;
+
+		while (size < needed) {
+			size *= 2;
+		}
+		if (!(data = sccp_realloc(buffer->data, size))) {
+			pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+			return FALSE;
+		}
+		buffer->data = data;
+		buffer->size = size;
+	}
+	buffer->data[buffer->len++] = type;
+	memcpy(buffer->data + buffer->len, name, namelen);
+	buffer->len += namelen;
+	if (value) {
+		memcpy(buffer->data + buffer->len, value, valuelen);
+		buffer->len += valuelen;
+	}
+	return TRUE;
+}
+
+/*!
+ * \brief Serialize all (non template) sections of cfg into buffer
+ * \return number of sections, -1 on failure
+ */
+static int sccp_config_snapshot_serialize(struct ast_config *cfg, sccp_config_snapshot_buffer_t *buffer)
+{
+	char *cat = NULL;
+	PBX_VARIABLE_TYPE *v = NULL;
+	int numCategories = 0;
+
+	while ((cat = pbx_category_browse(cfg, cat))) {
+		if (!sccp_config_snapshot_append(buffer, 'C', cat, NULL)) {
+			return -1;
+		}
+		for (v = ast_variable_browse(cfg, cat); v; v = v->next) {
+			if (!sccp_config_snapshot_append(buffer, 'V', v->name, v->value)) {
+				return -1;
+			}
+		}
+		numCategories++;
+	}
+	return numCategories;
+}
+
+/*!
+ * \brief Rebuild an ast_config from a (validated) snapshot payload
+ * \return new config, NULL if the payload is malformed
+ */
+static struct ast_config *sccp_config_snapshot_deserialize(const char *payload, size_t len, const char *filename)
+{
+	struct ast_config *cfg = NULL;
+	struct ast_category *category = NULL;
+	PBX_VARIABLE_TYPE *v = NULL;
+	const char *ptr = payload;
+	const char *end = payload + len;
+	const char *name = NULL;
+	boolean_t valid = TRUE;
+
+	if (len && end[-1] != '\0') {										/* every string is terminated inside the payload */
+		return NULL;
+	}
+	if (!(cfg = ast_config_new())) {
+		return NULL;
+	}
+	while (valid && ptr < end) {
+		switch (*ptr++) {
+			case 'C':
+				if (!(category = ast_category_new(ptr, filename, 0))) {
+					valid = FALSE;
+					break;
+				}
+				ast_category_append(cfg, category);
+				ptr += strlen(ptr) + 1;
+				break;
+			case 'V':
+				name = ptr;
+				ptr += strlen(ptr) + 1;
+				if (!category || ptr >= end || !(v = pbx_variable_new(name, ptr, filename))) {
+					valid = FALSE;
+					break;
+				}
+				ast_variable_append(category, v);
+				ptr += strlen(ptr) + 1;
+				break;
+			default:
+				valid = FALSE;
+				break;
+		}
+	}
+	if (!valid) {
+		pbx_config_destroy(cfg);
+		cfg = NULL;
+	}
+	return cfg;
+}
+
+/*!
+ * \brief Check if the config file pulls in other files, which can not be covered by the snapshot
+ */
+static boolean_t sccp_config_snapshot_hasIncludes(const char *source)
+{
+	char line[256];
+	char *ptr = NULL;
+	boolean_t res = FALSE;
+	FILE *f = fopen(source, "r");
+
+	if (!f) {
+		return TRUE;
+	}
+	while (!res && fgets(line, sizeof(line), f)) {
+		ptr = ast_skip_blanks(line);
+		if (!strncasecmp(ptr, "#include", 8) || !strncasecmp(ptr, "#tryinclude", 11) || !strncasecmp(ptr, "#exec", 5)) {
+			res = TRUE;
+		}
+	}
+	fclose(f);
+	return res;
+}
+
+/*!
+ * \brief Hash the config file, before it is parsed, so that a snapshot never claims a newer version of the file than it was made from
+ */
+boolean_t sccp_config_snapshot_statSource(const char *config_file_name, sccp_config_snapshot_source_t *source)
+{
+	char sourcepath[PATH_MAX];
+	char snapshotpath[PATH_MAX];
+	struct stat sb = { 0 };
+
+	sccp_config_snapshot_paths(config_file_name, sourcepath, sizeof(sourcepath), snapshotpath, sizeof(snapshotpath));
+	if (!sccp_config_snapshot_hashFile(sourcepath, &sb, &source->hash)) {
+		return FALSE;
+	}
+	source->size = (int64_t) sb.st_size;
+	return TRUE;
+}
+
+/*!
+ * \brief Load the config from its snapshot
+ * \return config, or NULL if there is no usable snapshot (missing, outdated, corrupt), in which case the config file has to be parsed
+ */
+struct ast_config *sccp_config_snapshot_load(const char *config_file_name)
+{
+	char sourcepath[PATH_MAX];
+	char snapshotpath[PATH_MAX];
+	struct stat source = { 0 };
+	struct stat sb = { 0 };
+	uint64_t sourceHash = 0;
+	const sccp_config_snapshot_header_t *header = NULL;
+	struct ast_config *cfg = NULL;
+	struct timeval start = pbx_tvnow();
+	void *map = MAP_FAILED;
+	int fd = -1;
+
+	sccp_config_snapshot_paths(config_file_name, sourcepath, sizeof(sourcepath), snapshotpath, sizeof(snapshotpath));
+	if (!sccp_config_snapshot_hashFile(sourcepath, &source, &sourceHash) || (fd = open(snapshotpath, O_RDONLY)) < 0) {
+		return NULL;
+	}
+	do {
+		if (fstat(fd, &sb) != 0 || (size_t) sb.st_size < sizeof(sccp_config_snapshot_header_t)) {
+			break;
+		}
+		if ((map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+			pbx_log(LOG_WARNING, "SCCP: Could not map config snapshot '%s': %s\n", snapshotpath, strerror(errno));
+			break;
+		}
+		header = (const sccp_config_snapshot_header_t *) map;
+		if (memcmp(header->magic, SCCP_CONFIG_SNAPSHOT_MAGIC, sizeof(header->magic)) || header->version != SCCP_CONFIG_SNAPSHOT_VERSION || header->headerSize != sizeof(sccp_config_snapshot_header_t)
+		    || header->payloadSize != (uint64_t) sb.st_size - sizeof(sccp_config_snapshot_header_t)) {
+			sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "SCCP: Config snapshot '%s' has an unknown format, ignoring it\n", snapshotpath);
+			break;
+		}
+		if (header->sourceSize != (int64_t) source.st_size || header->sourceHash != sourceHash) {
+			sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "SCCP: Config file '%s' changed since snapshot was written, parsing it\n", sourcepath);
+			break;
+		}
+		if (sccp_config_snapshot_checksum((const char *) map + sizeof(sccp_config_snapshot_header_t), header->payloadSize) != header->checksum) {
+			pbx_log(LOG_WARNING, "SCCP: Config snapshot '%s' is corrupt (checksum mismatch), parsing '%s'\n", snapshotpath, sourcepath);
+			break;
+		}
+		if (!(cfg = sccp_config_snapshot_deserialize((const char *) map + sizeof(sccp_config_snapshot_header_t), header->payloadSize, sourcepath))) {
+			pbx_log(LOG_WARNING, "SCCP: Config snapshot '%s' is malformed, parsing '%s'\n", snapshotpath, sourcepath);
+			break;
+		}
+		pbx_log(LOG_NOTICE, "SCCP: Config file '%s' loaded from snapshot in %ld ms (%u sections, parsing took %u ms)\n", sourcepath, (long) ast_tvdiff_ms(pbx_tvnow(), start), header->numCategories, header->parseMs);
+	} while (0);
+
+	if (map != MAP_FAILED) {
+		munmap(map, sb.st_size);
+	}
+	close(fd);
+	return cfg;
+}
+
+/*!
+ * \brief Write the snapshot for a freshly parsed config, or remove a stale one when configsnapshot is disabled
+ * \param cfg parsed config
+ * \param config_file_name config file name (relative to the asterisk config directory or absolute)
+ * \param source size and content hash of the config file taken before it was parsed
+ * \param parseMs time it took to parse the config file
+ */
+void sccp_config_snapshot_save(struct ast_config *cfg, const char *config_file_name, const sccp_config_snapshot_source_t *source, long parseMs)
+{
+	char sourcepath[PATH_MAX];
+	char snapshotpath[PATH_MAX];
+	char tmppath[PATH_MAX + 4];
+	sccp_config_snapshot_header_t header;
+	sccp_config_snapshot_buffer_t buffer = { NULL, 0, 0 };
+	int numCategories = 0;
+	FILE *f = NULL;
+
+	sccp_config_snapshot_paths(config_file_name, sourcepath, sizeof(sourcepath), snapshotpath, sizeof(snapshotpath));
+	if (!cfg || !source || !ast_true(pbx_variable_retrieve(cfg, "general", "configsnapshot"))) {
+		unlink(snapshotpath);
+		return;
+	}
+	if (sccp_config_snapshot_hasIncludes(sourcepath)) {
+		sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "SCCP: Config file '%s' uses #include/#exec, not writing a snapshot\n", sourcepath);
+		unlink(snapshotpath);
+		return;
+	}
+	if ((numCategories = sccp_config_snapshot_serialize(cfg, &buffer)) < 0) {
+		sccp_free(buffer.data);
+		return;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SCCP_CONFIG_SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.version = SCCP_CONFIG_SNAPSHOT_VERSION;
+	header.headerSize = sizeof(sccp_config_snapshot_header_t);
+	header.sourceSize = source->size;
+	header.sourceHash = source->hash;
+	header.payloadSize = buffer.len;
+	header.checksum = sccp_config_snapshot_checksum(buffer.data, buffer.len);
+	header.numCategories = numCategories;
+	header.parseMs = parseMs > 0 ? (uint32_t) parseMs : 0;
+
+	snprintf(tmppath, sizeof(tmppath), "%s.tmp", snapshotpath);						/* write aside and rename, a reader never sees a partial snapshot */
+	if (!(f = fopen(tmppath, "w"))) {
+		pbx_log(LOG_WARNING, "SCCP: Could not write config snapshot '%s': %s\n", tmppath, strerror(errno));
+	} else if (fwrite(&header, sizeof(header), 1, f) != 1 || (buffer.len && fwrite(buffer.data, buffer.len, 1, f) != 1) || fclose(f) != 0) {
+		pbx_log(LOG_WARNING, "SCCP: Could not write config snapshot '%s': %s\n", tmppath, strerror(errno));
+		unlink(tmppath);
+	} else if (rename(tmppath, snapshotpath) != 0) {
+		pbx_log(LOG_WARNING, "SCCP: Could not rename config snapshot '%s': %s\n", tmppath, strerror(errno));
+		unlink(tmppath);
+	} else {
+		sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "SCCP: Config snapshot '%s' written (%d sections, %zu bytes)\n", snapshotpath, numCategories, buffer.len);
+	}
+	sccp_free(buffer.data);
+}
+
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+AST_TEST_DEFINE(sccp_config_snapshot_roundtrip)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "snapshot";
+			info->category = "/channels/chan_sccp/config/";
+			info->summary = "chan-sccp-b config snapshot test";
+			info->description = "chan-sccp-b config snapshot serialize / deserialize round trip";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	enum ast_test_result_state res = AST_TEST_PASS;
+	sccp_config_snapshot_buffer_t buffer = { NULL, 0, 0 };
+	struct ast_config *cfg = ast_config_new();
+	struct ast_config *loaded = NULL;
+	struct ast_category *category = NULL;
+	PBX_VARIABLE_TYPE *v = NULL, *lv = NULL;
+	char name[20], value[40];
+	char *cat = NULL, *lcat = NULL;
+	int idx, button;
+
+	pbx_test_validate(test, cfg != NULL);
+	category = ast_category_new("general", "", 0);
+	ast_category_append(cfg, category);
+	ast_variable_append(category, pbx_variable_new("bindaddr", "0.0.0.0", ""));
+	ast_variable_append(category, pbx_variable_new("disallow", "all", ""));
+	ast_variable_append(category, pbx_variable_new("allow", "alaw", ""));
+	ast_variable_append(category, pbx_variable_new("empty", "", ""));
+	for (idx = 0; idx < 1000; idx++) {
+		snprintf(name, sizeof(name), "SEP%012d", idx);
+		category = ast_category_new(name, "", 0);
+		ast_category_append(cfg, category);
+		ast_variable_append(category, pbx_variable_new("type", "device", ""));
+		ast_variable_append(category, pbx_variable_new("devicetype", "7960", ""));
+		for (button = 0; button < 6; button++) {
+			snprintf(value, sizeof(value), "line, %d", idx * 6 + button);
+			ast_variable_append(category, pbx_variable_new("button", value, ""));
+		}
+	}
+
+	pbx_test_status_update(test, "Serialize...\n");
+	pbx_test_validate_cleanup(test, sccp_config_snapshot_serialize(cfg, &buffer) == 1001, res, cleanup);
+
+	pbx_test_status_update(test, "Deserialize...\n");
+	pbx_test_validate_cleanup(test, (loaded = sccp_config_snapshot_deserialize(buffer.data, buffer.len, "")) != NULL, res, cleanup);
+
+	pbx_test_status_update(test, "Compare sections and variables, in order...\n");
+	while ((cat = pbx_category_browse(cfg, cat))) {
+		lcat = pbx_category_browse(loaded, lcat);
+		pbx_test_validate_cleanup(test, lcat && sccp_strequals(cat, lcat), res, cleanup);
+		for (v = ast_variable_browse(cfg, cat), lv = ast_variable_browse(loaded, lcat); v; v = v->next, lv = lv->next) {
+			pbx_test_validate_cleanup(test, lv && sccp_strequals(v->name, lv->name) && sccp_strequals(v->value, lv->value), res, cleanup);
+		}
+		pbx_test_validate_cleanup(test, lv == NULL, res, cleanup);
+	}
+	pbx_test_validate_cleanup(test, pbx_category_browse(loaded, lcat) == NULL, res, cleanup);
+
+	pbx_test_status_update(test, "Truncated payload is rejected...\n");
+	pbx_test_validate_cleanup(test, sccp_config_snapshot_deserialize(buffer.data, buffer.len - 1, "") == NULL, res, cleanup);
+
+cleanup:
+	if (loaded) {
+		pbx_config_destroy(loaded);
+	}
+	pbx_config_destroy(cfg);
+	sccp_free(buffer.data);
+	return res;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_config_snapshot_roundtrip);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_config_snapshot_roundtrip);
+}
+#endif
+
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,19 @@
+/*!
+ * \file        sccp_config_snapshot.h
+ * \brief       SCCP Compiled Configuration Snapshot Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ */
+#pragma once
+
+__BEGIN_C_EXTERN__
+typedef struct sccp_config_snapshot_source {
+	int64_t size;												/*!< Size of the Config File */
+	uint64_t hash;												/*!< FNV-1a 64bit over the Config File content */
+} sccp_config_snapshot_source_t;
+
+SCCP_API boolean_t SCCP_CALL sccp_config_snapshot_statSource(const char *config_file_name, sccp_config_snapshot_source_t *source);
+SCCP_API struct ast_config * SCCP_CALL sccp_config_snapshot_load(const char *config_file_name);
+SCCP_API void SCCP_CALL sccp_config_snapshot_save(struct ast_config *cfg, const char *config_file_name, const sccp_config_snapshot_source_t *source, long parseMs);
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
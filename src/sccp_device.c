@@ -31,6 +31,7 @@
 #include "sccp_devstate.h"
 #include "sccp_featureParkingLot.h"
 #include "sccp_labels.h"
+#include "sccp_realtime.h"
 
 SCCP_FILE_VERSION(__FILE__, "");
 
@@ -55,6 +56,7 @@ struct sccp_private_device_data {
 	sccp_devicestate_t deviceState;											/*!< Device State */
 
 	skinny_registrationstate_t registrationState;
+	uint32_t registrationGeneration;									/*!< Incremented each time the device reaches SKINNY_DEVICE_RS_OK */
 };
 
 #define sccp_private_lock(x) sccp_mutex_lock(&((struct sccp_private_device_data * const)(x))->lock)			/* discard const */
@@ -326,36 +328,43 @@ static boolean_t sccp_device_checkACL(constDevicePtr device)
 void sccp_device_pre_reload(void)
 {
 	sccp_device_t *d = NULL;
-	sccp_buttonconfig_t *config = NULL;
 
 	SCCP_RWLIST_WRLOCK(&GLOB(devices));
 	SCCP_RWLIST_TRAVERSE(&GLOB(devices), d, list) {
-		sccp_log((DEBUGCAT_CONFIG + DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_3 "%s: Setting Device to Pending Delete=1\n", d->id);
+		sccp_device_prepareReload(d);
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(devices));
+}
+
+/*!
+ * \brief Mark a single device (and its buttons) as pending delete before its section is reapplied
+ * \note used for all devices by sccp_device_pre_reload, and only for changed/removed devices by an incremental reload
+ */
+void sccp_device_prepareReload(devicePtr d)
+{
+	sccp_buttonconfig_t *config = NULL;
+
+	sccp_log((DEBUGCAT_CONFIG + DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_3 "%s: Setting Device to Pending Delete=1\n", d->id);
 #ifdef CS_SCCP_REALTIME
-		if (!d->realtime) {										/* don't want to reset realtime devices, if they have not changed */
-			d->pendingDelete = 1;
-		}
+	if (!d->realtime) {											/* don't want to reset realtime devices, if they have not changed */
+		d->pendingDelete = 1;
+	}
 #endif
-		d->pendingUpdate = 0;
-		
-		/* clear softkeyset */
-		d->softkeyset = NULL;
-		d->softKeyConfiguration.modes = NULL;
-		d->softKeyConfiguration.size = 0;
-		d->isAnonymous=FALSE;
+	d->pendingUpdate = 0;
 
-		SCCP_LIST_LOCK(&d->buttonconfig);
-		SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
-			sccp_log((DEBUGCAT_CONFIG + DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_4 "%s: Setting Button at Index:%d to pendingDelete\n", d->id, config->index);
-			config->pendingDelete = 1;
-			config->pendingUpdate = 0;
-		}
-		SCCP_LIST_UNLOCK(&d->buttonconfig);
-		d->softkeyset = NULL;
-		d->softKeyConfiguration.modes = 0;
-		d->softKeyConfiguration.size = 0;
+	/* clear softkeyset */
+	d->softkeyset = NULL;
+	d->softKeyConfiguration.modes = NULL;
+	d->softKeyConfiguration.size = 0;
+	d->isAnonymous=FALSE;
+
+	SCCP_LIST_LOCK(&d->buttonconfig);
+	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+		sccp_log((DEBUGCAT_CONFIG + DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_4 "%s: Setting Button at Index:%d to pendingDelete\n", d->id, config->index);
+		config->pendingDelete = 1;
+		config->pendingUpdate = 0;
 	}
-	SCCP_RWLIST_UNLOCK(&GLOB(devices));
+	SCCP_LIST_UNLOCK(&d->buttonconfig);
 }
 
 /*!
@@ -392,6 +401,55 @@ boolean_t sccp_device_check_update(devicePtr device)
 	return res;
 }
 
+/*!
+ * \brief Threadpool job: reset a device whose reload reset was postponed by a call
+ * \param data Retained SCCP Device as void pointer (released here)
+ */
+static void *sccp_device_checkUpdateJob(void *data)
+{
+	sccp_device_t *d = (sccp_device_t *) data;
+
+	pbx_rwlock_rdlock(&GLOB(lock));
+	boolean_t reload_in_progress = GLOB(reload_in_progress);
+	pbx_rwlock_unlock(&GLOB(lock));
+	if (reload_in_progress == FALSE) {								/* otherwise sccp_device_post_reload will check it */
+		sccp_device_check_update(d);
+	}
+	sccp_device_release(&d);									/* explicit release */
+	return NULL;
+}
+
+/*!
+ * \brief Reset the devices of a line, whose reload reset was postponed because of a call
+ * \param l SCCP Line on which a call has ended
+ *
+ * \note The devices are checked on the general threadpool, sccp_device_check_update resets the device once it has no
+ * channels left. This replaces the session threads polling pendingUpdate / pendingDelete.
+ */
+void sccp_device_checkPendingUpdates(constLinePtr l)
+{
+	sccp_linedevices_t *linedevice = NULL;
+	sccp_device_t *d = NULL;
+
+	if (!l) {
+		return;
+	}
+	SCCP_LIST_LOCK(&((sccp_line_t *const)l)->devices);
+	SCCP_LIST_TRAVERSE(&l->devices, linedevice, list) {
+		if (!linedevice->device || (!linedevice->device->pendingUpdate && !linedevice->device->pendingDelete)) {
+			continue;
+		}
+		if (!(d = sccp_device_retain(linedevice->device))) {
+			continue;
+		}
+		if (!(GLOB(general_threadpool) && sccp_threadpool_add_work(GLOB(general_threadpool), (void *) sccp_device_checkUpdateJob, (void *) d))) {
+			pbx_log(LOG_WARNING, "%s: Could not queue the postponed reload reset\n", d->id);
+			sccp_device_release(&d);							/* explicit release */
+		}
+	}
+	SCCP_LIST_UNLOCK(&((sccp_line_t *const)l)->devices);
+}
+
 /*!
  * \brief run after the new device config is loaded during the reload process
  * \note See \ref sccp_config_reload
@@ -403,6 +461,7 @@ boolean_t sccp_device_check_update(devicePtr device)
 void sccp_device_post_reload(void)
 {
 	sccp_device_t *d = NULL;
+	int reset = 0, postponed = 0;
 	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "SCCP: (post_reload)\n");
 
 	SCCP_RWLIST_TRAVERSE_SAFE_BEGIN(&GLOB(devices), d, list) {
@@ -414,13 +473,20 @@ void sccp_device_post_reload(void)
 		 */
 		if (!sccp_device_check_update(d)) {
 			sccp_log((DEBUGCAT_CONFIG + DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_3 "Device %s will receive reset after current call is completed\n", d->id);
+			if (d->buttonIndex.table) {
+				sccp_dev_buildButtonIndex(d);							/* pick up the reloaded button configuration until the reset */
+			}
+			postponed++;
+		} else {
+			reset++;
 		}
 		// make sure preferences only contains the codecs that this device is capable of
 		sccp_codec_reduceSet(d->preferences.audio , d->capabilities.audio);
 		sccp_codec_reduceSet(d->preferences.video , d->capabilities.video);
-		/* should we re-check the device after hangup ? */
+		/* re-checked after hangup, see sccp_device_checkPendingUpdates */
 	}
 	SCCP_LIST_TRAVERSE_SAFE_END;
+	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "SCCP: (post_reload) %d device(s) reset, %d postponed until their calls have ended\n", reset, postponed);
 }
 
 /* ====================================================================================================== start getters / setters for privateData */
@@ -511,6 +577,19 @@ const skinny_registrationstate_t sccp_device_getRegistrationState(constDevicePtr
 	return state;
 }
 
+const uint32_t sccp_device_getRegistrationGeneration(constDevicePtr d)
+{
+	pbx_assert(d != NULL && d->privateData != NULL);
+
+	uint32_t generation = 0;
+
+	sccp_private_lock(d->privateData);
+	generation = d->privateData->registrationGeneration;
+	sccp_private_unlock(d->privateData);
+
+	return generation;
+}
+
 int sccp_device_setRegistrationState(constDevicePtr d, const skinny_registrationstate_t state)
 {
 	pbx_assert(d != NULL);
@@ -523,6 +602,9 @@ int sccp_device_setRegistrationState(constDevicePtr d, const skinny_registration
 	sccp_private_lock(d->privateData);
 	if (state != d->privateData->registrationState) {
 		d->privateData->registrationState = state;
+		if (SKINNY_DEVICE_RS_OK == state) {
+			d->privateData->registrationGeneration++;
+		}
 		changed=1;
 	}
 	sccp_private_unlock(d->privateData);
@@ -608,6 +690,9 @@ sccp_device_t *sccp_device_create(const char *id)
 	pbx_mutex_init(&d->messageStack.lock);
 	sccp_mutex_lock(&d->messageStack.lock);
 #endif
+	pbx_mutex_init(&d->mwiState.lock);
+	pbx_mutex_init(&d->shadow.lock);
+	pbx_mutex_init(&d->buttonIndex.lock);
 	uint8_t i;
 
 	for (i = 0; i < ARRAY_LEN(d->messageStack.messages); i++) {
@@ -777,6 +862,49 @@ void sccp_device_preregistration(devicePtr device)
 #endif
 }
 
+/*!
+ * \brief GLOB(devices) ID Index
+ * Case insensitive hash index on device->id, protected by the GLOB(devices) lock
+ * The helpers take the table, so the test framework can exercise a private index
+ */
+static sccp_device_t *sccp_device_idIndex[SCCP_HASH_PRIME];
+
+static void sccp_device_idIndexInsert(sccp_device_t **index, sccp_device_t * d)
+{
+	unsigned int bucket = sccp_strcasehash(d->id, SCCP_HASH_PRIME);
+
+	d->hashNext = index[bucket];
+	index[bucket] = d;
+}
+
+static void sccp_device_idIndexRemove(sccp_device_t **index, const sccp_device_t * d)
+{
+	sccp_device_t **entry = &index[sccp_strcasehash(d->id, SCCP_HASH_PRIME)];
+
+	for (; *entry; entry = &(*entry)->hashNext) {
+		if (*entry == d) {
+			*entry = d->hashNext;
+			break;
+		}
+	}
+}
+
+/*!
+ * \brief Find a device in the GLOB(devices) ID Index
+ * \note needs to be called with GLOB(devices) locked
+ */
+static sccp_device_t * __PURE__ sccp_device_idIndexFind(sccp_device_t * const *index, const char *id)
+{
+	sccp_device_t *d = NULL;
+
+	for (d = index[sccp_strcasehash(id, SCCP_HASH_PRIME)]; d; d = d->hashNext) {
+		if (sccp_strcaseequals(d->id, id)) {
+			break;
+		}
+	}
+	return d;
+}
+
 /*!
  * \brief Add a device to the global sccp_device list
  * \param device SCCP Device
@@ -795,6 +923,7 @@ void sccp_device_addToGlobals(constDevicePtr device)
 	if (d) {
 		SCCP_RWLIST_WRLOCK(&GLOB(devices));
 		SCCP_RWLIST_INSERT_SORTALPHA(&GLOB(devices), d, list, id);
+		sccp_device_idIndexInsert(sccp_device_idIndex, d);
 		SCCP_RWLIST_UNLOCK(&GLOB(devices));
 		sccp_log((DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_3 "Added device '%s' to Glob(devices)\n", d->id);
 	}
@@ -818,10 +947,16 @@ void sccp_device_removeFromGlobals(devicePtr device)
 
 	SCCP_RWLIST_WRLOCK(&GLOB(devices));
 	if ((d = SCCP_RWLIST_REMOVE(&GLOB(devices), device, list))) {
+		sccp_device_idIndexRemove(sccp_device_idIndex, d);
 		sccp_log((DEBUGCAT_CORE + DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_3 "Removed device '%s' from Glob(devices)\n", DEV_ID_LOG(device));
 		sccp_device_release(&d);					/* explicit release of device after removing from list */
 	}
 	SCCP_RWLIST_UNLOCK(&GLOB(devices));
+#ifdef CS_SCCP_REALTIME
+	if (device->realtime) {
+		sccp_realtime_cache_invalidate(SCCP_REALTIME_CACHE_DEVICE, device->id);			/* reread the row when the device comes back */
+	}
+#endif
 }
 
 /*!
@@ -1293,6 +1428,7 @@ void sccp_dev_set_registered(devicePtr d, skinny_registrationstate_t state)
 
 		sccp_dev_postregistration(d);
 	} else if (state == SKINNY_DEVICE_RS_PROGRESS) {
+		sccp_dev_shadow_reset(d, FALSE);								/* the phone starts out blank */
 		memset(&event, 0, sizeof(sccp_event_t));
 		event.type = SCCP_EVENT_DEVICE_PREREGISTERED;
 		event.event.deviceRegistered.device = sccp_device_retain(d);
@@ -1345,14 +1481,6 @@ void sccp_dev_set_keyset(constDevicePtr d, uint8_t lineInstance, uint32_t callid
 						  (d->transfer) ? KEYMODE_CONNTRANS : KEYMODE_CONNECTED);
 		}
 	}
-	REQ(msg, SelectSoftKeysMessage);
-	if (!msg) {
-		return;
-	}
-	msg->data.SelectSoftKeysMessage.lel_lineInstance = htolel(lineInstance);
-	msg->data.SelectSoftKeysMessage.lel_callReference = htolel(callid);
-	msg->data.SelectSoftKeysMessage.lel_softKeySetIndex = htolel(softKeySetIndex);
-
 	if (softKeySetIndex == KEYMODE_ONHOOK || softKeySetIndex == KEYMODE_OFFHOOK || softKeySetIndex == KEYMODE_OFFHOOKFEAT) {
 		sccp_softkey_setSoftkeyState((sccp_device_t *) d, softKeySetIndex, SKINNY_LBL_REDIAL, (sccp_strlen_zero(d->redialInformation.number) && !d->useRedialMenu) ? FALSE : TRUE);
 	}
@@ -1384,8 +1512,38 @@ void sccp_dev_set_keyset(constDevicePtr d, uint8_t lineInstance, uint32_t callid
 			sccp_softkey_setSoftkeyState((sccp_device_t *) d, softKeySetIndex, SKINNY_LBL_TRANSFER, FALSE);
 		}
 	}
+	uint32_t validKeyMask = d->softKeyConfiguration.activeMask[softKeySetIndex];
+
+	if (lineInstance <= SCCP_SHADOW_MAX_INSTANCE) {
+		sccp_device_t *device = (sccp_device_t *) d;
+		boolean_t unchanged = FALSE;
+
+		sccp_mutex_lock(&device->shadow.lock);
+		if (device->shadow.keyset[lineInstance].valid && device->shadow.keyset[lineInstance].softKeySetIndex == softKeySetIndex && device->shadow.keyset[lineInstance].callid == callid && device->shadow.keyset[lineInstance].validKeyMask == validKeyMask) {
+			device->shadow.suppressed[SCCP_SHADOW_SELECTSOFTKEYS]++;
+			unchanged = TRUE;
+		} else {
+			device->shadow.keyset[lineInstance].valid = TRUE;
+			device->shadow.keyset[lineInstance].softKeySetIndex = softKeySetIndex;
+			device->shadow.keyset[lineInstance].callid = callid;
+			device->shadow.keyset[lineInstance].validKeyMask = validKeyMask;
+		}
+		sccp_mutex_unlock(&device->shadow.lock);
+		if (unchanged) {
+			sccp_log((DEBUGCAT_SOFTKEY + DEBUGCAT_DEVICE + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "%s: Softkeyset %s(%d) already set on line %d and call %d, skipping\n", d->id, skinny_keymode2str(softKeySetIndex), softKeySetIndex, lineInstance, callid);
+			return;
+		}
+	}
+
+	REQ(msg, SelectSoftKeysMessage);
+	if (!msg) {
+		return;
+	}
+	msg->data.SelectSoftKeysMessage.lel_lineInstance = htolel(lineInstance);
+	msg->data.SelectSoftKeysMessage.lel_callReference = htolel(callid);
+	msg->data.SelectSoftKeysMessage.lel_softKeySetIndex = htolel(softKeySetIndex);
 	//msg->data.SelectSoftKeysMessage.les_validKeyMask = 0xFFFFFFFF;           /* htolel(65535); */
-	msg->data.SelectSoftKeysMessage.les_validKeyMask = htolel(d->softKeyConfiguration.activeMask[softKeySetIndex]);
+	msg->data.SelectSoftKeysMessage.les_validKeyMask = htolel(validKeyMask);
 
 	sccp_log((DEBUGCAT_SOFTKEY + DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_3 "%s: Set softkeyset to %s(%d) on line %d  and call %d\n", d->id, skinny_keymode2str(softKeySetIndex), softKeySetIndex, lineInstance, callid);
 	sccp_log((DEBUGCAT_SOFTKEY + DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_3 "%s: validKeyMask %u\n", d->id, msg->data.SelectSoftKeysMessage.les_validKeyMask);
@@ -1402,6 +1560,26 @@ void sccp_dev_set_keyset(constDevicePtr d, uint8_t lineInstance, uint32_t callid
 void sccp_dev_set_ringer(constDevicePtr d, uint8_t opt, uint8_t lineInstance, uint32_t callid)
 {
 	sccp_msg_t *msg = NULL;
+	sccp_device_t *device = (sccp_device_t *) d;
+	boolean_t unchanged = FALSE;
+
+	if (!d) {
+		return;
+	}
+	sccp_mutex_lock(&device->shadow.lock);
+	if (device->shadow.ringMode == opt && device->shadow.ringLineInstance == lineInstance && device->shadow.ringCallid == callid) {
+		device->shadow.suppressed[SCCP_SHADOW_SETRINGER]++;
+		unchanged = TRUE;
+	} else {
+		device->shadow.ringMode = opt;
+		device->shadow.ringLineInstance = lineInstance;
+		device->shadow.ringCallid = callid;
+	}
+	sccp_mutex_unlock(&device->shadow.lock);
+	if (unchanged) {
+		sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "%s: Ringer already in mode %s(%d), skipping\n", DEV_ID_LOG(d), skinny_ringtype2str(opt), opt);
+		return;
+	}
 
 	REQ(msg, SetRingerMessage);
 	if (!msg) {
@@ -1430,6 +1608,21 @@ void sccp_dev_set_speaker(constDevicePtr d, uint8_t mode)
 	if (!d || !d->session) {
 		return;
 	}
+	sccp_device_t *device = (sccp_device_t *) d;
+	boolean_t unchanged = FALSE;
+
+	sccp_mutex_lock(&device->shadow.lock);
+	if (device->shadow.speakerMode == mode) {
+		device->shadow.suppressed[SCCP_SHADOW_SETSPEAKERMODE]++;
+		unchanged = TRUE;
+	} else {
+		device->shadow.speakerMode = mode;
+	}
+	sccp_mutex_unlock(&device->shadow.lock);
+	if (unchanged) {
+		sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "%s: Speaker already '%s', skipping\n", d->id, (mode == SKINNY_STATIONSPEAKER_ON ? "on" : (mode == SKINNY_STATIONSPEAKER_OFF ? "off" : "unknown")));
+		return;
+	}
 	REQ(msg, SetSpeakerModeMessage);
 	if (!msg) {
 		return;
@@ -1646,6 +1839,26 @@ void sccp_dev_clearprompt(constDevicePtr d, const uint8_t lineInstance, const ui
 	if (!d || !d->session || !d->protocol || !d->hasDisplayPrompt()) {
 		return;												/* only for telecaster and new phones */
 	}
+	if (lineInstance <= SCCP_SHADOW_MAX_INSTANCE) {
+		sccp_device_t *device = (sccp_device_t *) d;
+		boolean_t unchanged = FALSE;
+
+		sccp_mutex_lock(&device->shadow.lock);
+		if (device->shadow.prompt[lineInstance].valid && device->shadow.prompt[lineInstance].cleared && device->shadow.prompt[lineInstance].callid == callid) {
+			device->shadow.suppressed[SCCP_SHADOW_CLEARPROMPT]++;
+			unchanged = TRUE;
+		} else {
+			device->shadow.prompt[lineInstance].valid = TRUE;
+			device->shadow.prompt[lineInstance].cleared = TRUE;
+			device->shadow.prompt[lineInstance].callid = callid;
+			device->shadow.prompt[lineInstance].hash = 0;
+		}
+		sccp_mutex_unlock(&device->shadow.lock);
+		if (unchanged) {
+			sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "%s: Status prompt on line %d and callid %d already cleared, skipping\n", d->id, lineInstance, callid);
+			return;
+		}
+	}
 	REQ(msg, ClearPromptStatusMessage);
 	if (!msg) {
 		return;
@@ -1656,6 +1869,17 @@ void sccp_dev_clearprompt(constDevicePtr d, const uint8_t lineInstance, const ui
 	sccp_log((DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_3 "%s: Clear the status prompt on line %d and callid %d\n", d->id, lineInstance, callid);
 }
 
+static uint32_t sccp_dev_shadow_hashPrompt(const char *text)
+{
+	uint32_t hash = 2166136261U;										/* FNV-1a */
+
+	while (text && *text) {
+		hash ^= (uint8_t) *text++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
 /*!
  * \brief Send Display Prompt to Device
  * \param d SCCP Device
@@ -1679,6 +1903,27 @@ void sccp_dev_displayprompt_debug(constDevicePtr d, const uint8_t lineInstance,
 	if (!d || !d->session || !d->protocol || !d->hasDisplayPrompt()) {
 		return;
 	}
+	if (lineInstance <= SCCP_SHADOW_MAX_INSTANCE) {
+		sccp_device_t *device = (sccp_device_t *) d;
+		boolean_t unchanged = FALSE;
+		uint32_t hash = sccp_dev_shadow_hashPrompt(msg);
+
+		sccp_mutex_lock(&device->shadow.lock);
+		if (timeout == 0 && device->shadow.prompt[lineInstance].valid && !device->shadow.prompt[lineInstance].cleared && device->shadow.prompt[lineInstance].callid == callid && device->shadow.prompt[lineInstance].hash == hash) {
+			device->shadow.suppressed[SCCP_SHADOW_DISPLAYPROMPT]++;
+			unchanged = TRUE;
+		} else {
+			device->shadow.prompt[lineInstance].valid = (timeout == 0);				/* a prompt with a timeout will be replaced by the phone */
+			device->shadow.prompt[lineInstance].cleared = FALSE;
+			device->shadow.prompt[lineInstance].callid = callid;
+			device->shadow.prompt[lineInstance].hash = hash;
+		}
+		sccp_mutex_unlock(&device->shadow.lock);
+		if (unchanged) {
+			sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "%s: Prompt '%s' already shown on line %d, skipping\n", d->id, msg, lineInstance);
+			return;
+		}
+	}
 	d->protocol->displayPrompt(d, lineInstance, callid, timeout, msg);
 }
 
@@ -1831,6 +2076,322 @@ void sccp_dev_displayprinotify_debug(constDevicePtr d, const char *msg, const sc
 	sccp_log((DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_3 "%s: Display notify with timeout %d and priority %d\n", d->id, timeout, priority);
 }
 
+/*!
+ * \brief Button Index Destructor, called when the last reference is released
+ */
+static int __sccp_buttonindex_destroy(const void *ptr)
+{
+	sccp_buttonindex_t *table = (sccp_buttonindex_t *) ptr;
+	uint16_t instance = 0;
+
+	if (table->service) {
+		for (instance = 0; instance < table->serviceSize; instance++) {
+			if (table->service[instance].label) {
+				sccp_free(table->service[instance].label);
+			}
+			if (table->service[instance].url) {
+				sccp_free(table->service[instance].url);
+			}
+		}
+		sccp_free(table->service);
+	}
+	if (table->speeddial) {
+		sccp_free(table->speeddial);
+	}
+	if (table->feature) {
+		sccp_free(table->feature);
+	}
+	return 0;
+}
+
+/*!
+ * \brief Replace the Button Index of a device
+ *
+ * The device holds one reference to its current table. Readers retain the table (sccp_dev_getButtonIndex) under
+ * d->buttonIndex.lock, so dropping the device reference after the swap frees the old table once the last reader is done.
+ */
+static void sccp_dev_replaceButtonIndex(devicePtr d, sccp_buttonindex_t * newTable)
+{
+	sccp_buttonindex_t *oldTable = NULL;
+
+	sccp_mutex_lock(&d->buttonIndex.lock);
+	oldTable = d->buttonIndex.table;
+	d->buttonIndex.table = newTable;
+	sccp_mutex_unlock(&d->buttonIndex.lock);
+
+	if (oldTable) {
+		sccp_buttonindex_release(&oldTable);							/* explicit release of the device reference */
+	}
+}
+
+/*!
+ * \brief Get the Button Index of a device
+ * \param d SCCP Device
+ * \return Retained Button Index or NULL (not built yet / device cleaned)
+ *
+ * \note the caller has to release the returned index
+ */
+sccp_buttonindex_t *sccp_dev_getButtonIndex(constDevicePtr d)
+{
+	sccp_buttonindex_t *table = NULL;
+
+	if (!d) {
+		return NULL;
+	}
+	sccp_mutex_lock((sccp_mutex_t *) &d->buttonIndex.lock);					/* discard const */
+	if (d->buttonIndex.table) {
+		table = sccp_buttonindex_retain(d->buttonIndex.table);
+	}
+	sccp_mutex_unlock((sccp_mutex_t *) &d->buttonIndex.lock);
+	return table;
+}
+
+/*!
+ * \brief (Re)Build the Button Index of a device from its buttonconfig
+ * \param d SCCP Device
+ *
+ * \note needs to be called after the button instances have been assigned (button template)
+ */
+void sccp_dev_buildButtonIndex(devicePtr d)
+{
+	sccp_buttonconfig_t *config = NULL;
+	sccp_buttonindex_t *table = NULL;
+	uint16_t speeddialSize = 1;
+	uint16_t serviceSize = 1;
+
+	if (!d) {
+		return;
+	}
+
+	SCCP_LIST_LOCK(&d->buttonconfig);
+	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+		if ((config->type == SPEEDDIAL || config->type == FEATURE) && config->instance >= speeddialSize) {
+			speeddialSize = config->instance + 1;
+		} else if (config->type == SERVICE && config->instance >= serviceSize) {
+			serviceSize = config->instance + 1;
+		}
+	}
+
+	if (!(table = (sccp_buttonindex_t *) sccp_refcount_object_alloc(sizeof(sccp_buttonindex_t), SCCP_REF_BUTTONINDEX, d->id, __sccp_buttonindex_destroy))) {
+		SCCP_LIST_UNLOCK(&d->buttonconfig);
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, d->id);
+		return;
+	}
+	if (!(table->speeddial = sccp_calloc(speeddialSize, sizeof(sccp_speed_t))) ||
+	    !(table->feature = sccp_calloc(speeddialSize, sizeof(sccp_feature_type_t))) ||
+	    !(table->service = sccp_calloc(serviceSize, sizeof(sccp_buttonindex_service_t)))) {
+		SCCP_LIST_UNLOCK(&d->buttonconfig);
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, d->id);
+		sccp_buttonindex_release(&table);							/* explicit release, destructor frees the partial table */
+		return;
+	}
+	table->speeddialSize = speeddialSize;
+	table->serviceSize = serviceSize;
+
+	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+		if (config->instance == 0) {
+			continue;
+		}
+		switch (config->type) {
+			case SPEEDDIAL:
+				{
+					sccp_speed_t *k = &table->speeddial[config->instance];
+
+					k->valid = TRUE;
+					k->instance = config->instance;
+					k->type = SCCP_BUTTONTYPE_SPEEDDIAL;
+					sccp_copy_string(k->name, config->label, sizeof(k->name));
+					sccp_copy_string(k->ext, config->button.speeddial.ext, sizeof(k->ext));
+					if (!sccp_strlen_zero(config->button.speeddial.hint)) {
+						sccp_copy_string(k->hint, config->button.speeddial.hint, sizeof(k->hint));
+					}
+				}
+				break;
+			case FEATURE:
+				table->feature[config->instance] = config->button.feature.id;
+				break;
+			case SERVICE:
+				{
+					sccp_buttonindex_service_t *service = &table->service[config->instance];
+
+					service->label = pbx_strdup(config->label ? config->label : "");
+					service->url = pbx_strdup(config->button.service.url ? config->button.service.url : "");
+				}
+				break;
+			default:
+				break;
+		}
+	}
+	SCCP_LIST_UNLOCK(&d->buttonconfig);
+
+	sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_BUTTONTEMPLATE)) (VERBOSE_PREFIX_3 "%s: Built button index (speeddial/feature instances:%d, service instances:%d)\n", d->id, speeddialSize - 1, serviceSize - 1);
+	sccp_dev_replaceButtonIndex(d, table);
+}
+
+/*!
+ * \brief Delete the Button Index of a device
+ * \param d SCCP Device
+ *
+ * \note readers which still hold a reference keep their copy until they release it
+ */
+void sccp_dev_deleteButtonIndex(devicePtr d)
+{
+	if (d) {
+		sccp_dev_replaceButtonIndex(d, NULL);
+	}
+}
+
+#define SCCP_REGCACHE_MAX_INDEX StationMaxButtonTemplateSize							/*!< Highest cached speeddial / feature index */
+
+/*!
+ * \brief SCCP Registration Response Cache Structure
+ * \note Only valid for the configGeneration of the device and the protocol version it was filled for, reconfiguring the device, its
+ * lines or its softkeyset, or a phone registering with another protocol version empties it.
+ */
+struct sccp_regcache {
+	int generation;												/*!< configGeneration of the device for the cached messages */
+	uint8_t protocolVersion;										/*!< inuseprotocolversion of the cached messages */
+	sccp_msg_t *msg[SCCP_REGCACHE_SENTINEL][SCCP_REGCACHE_MAX_INDEX + 1];					/*!< Encoded messages, index 0 for the not indexed entries */
+	uint32_t hits;												/*!< Responses served from the cache */
+	uint32_t misses;											/*!< Responses which had to be built */
+};
+
+static void sccp_dev_regcache_clear(sccp_regcache_t * cache)
+{
+	int entry, index;
+
+	for (entry = 0; entry < SCCP_REGCACHE_SENTINEL; entry++) {
+		for (index = 0; index <= SCCP_REGCACHE_MAX_INDEX; index++) {
+			if (cache->msg[entry][index]) {
+				sccp_free(cache->msg[entry][index]);
+			}
+		}
+	}
+}
+
+/*!
+ * \brief Get a copy of a cached registration response, ready to be sent
+ * \param d SCCP Device
+ * \param entry Registration Cache Entry
+ * \param index Speeddial / Feature index for the indexed entries, 0 otherwise
+ * \return Copy of the cached message (freed by sccp_dev_send), or NULL when it has to be built (and stored)
+ */
+sccp_msg_t *sccp_dev_regcache_get(devicePtr d, sccp_regcache_entry_t entry, uint16_t index)
+{
+	sccp_regcache_t *cache = d->registrationCache;
+	const sccp_msg_t *cached = NULL;
+	sccp_msg_t *msg = NULL;
+	size_t len = 0;
+
+	if (!cache || entry >= SCCP_REGCACHE_SENTINEL || index > SCCP_REGCACHE_MAX_INDEX) {
+		return NULL;
+	}
+	if (cache->generation != ATOMIC_FETCH(&d->configGeneration, &GLOB(usecnt_lock)) || cache->protocolVersion != d->inuseprotocolversion) {
+		sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "%s: Configuration or protocol changed, dropping cached registration responses\n", d->id);
+		sccp_dev_regcache_clear(cache);
+		cache->generation = ATOMIC_FETCH(&d->configGeneration, &GLOB(usecnt_lock));
+		cache->protocolVersion = d->inuseprotocolversion;
+		cache->misses++;
+		return NULL;
+	}
+	if (!(cached = cache->msg[entry][index])) {
+		cache->misses++;
+		return NULL;
+	}
+	len = letohl(cached->header.length) + 8;								/* see sccp_build_packet */
+	if ((msg = sccp_malloc(len))) {
+		memcpy(msg, cached, len);
+		cache->hits++;
+	}
+	return msg;
+}
+
+/*!
+ * \brief Store a copy of a freshly built registration response, before it is sent
+ * \param d SCCP Device
+ * \param entry Registration Cache Entry
+ * \param index Speeddial / Feature index for the indexed entries, 0 otherwise
+ * \param msg message to be sent
+ */
+void sccp_dev_regcache_store(devicePtr d, sccp_regcache_entry_t entry, uint16_t index, const sccp_msg_t * msg)
+{
+	sccp_regcache_t *cache = d->registrationCache;
+	int generation = ATOMIC_FETCH(&d->configGeneration, &GLOB(usecnt_lock));
+	size_t len = 0;
+
+	if (!msg || entry >= SCCP_REGCACHE_SENTINEL || index > SCCP_REGCACHE_MAX_INDEX) {
+		return;
+	}
+	if (!cache) {
+		if (!(cache = d->registrationCache = sccp_calloc(1, sizeof(sccp_regcache_t)))) {
+			pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, d->id);
+			return;
+		}
+		cache->generation = generation;
+		cache->protocolVersion = d->inuseprotocolversion;
+	} else if (cache->generation != generation || cache->protocolVersion != d->inuseprotocolversion) {
+		sccp_dev_regcache_clear(cache);
+		cache->generation = generation;
+		cache->protocolVersion = d->inuseprotocolversion;
+	}
+	if (cache->msg[entry][index]) {
+		sccp_free(cache->msg[entry][index]);
+	}
+	len = letohl(msg->header.length) + 8;
+	if ((cache->msg[entry][index] = sccp_malloc(len))) {
+		memcpy(cache->msg[entry][index], msg, len);
+	}
+}
+
+/*!
+ * \brief Delete the Registration Response Cache of a device
+ */
+void sccp_dev_regcache_delete(devicePtr d)
+{
+	if (d->registrationCache) {
+		sccp_dev_regcache_clear(d->registrationCache);
+		sccp_free(d->registrationCache);
+	}
+}
+
+/*!
+ * \brief Invalidate the Registration Response Cache of a device, after the device, one of its lines or its softkeyset has been (re)configured
+ */
+void sccp_dev_regcache_invalidate(devicePtr d)
+{
+	(void) ATOMIC_INCR(&d->configGeneration, 1, &GLOB(usecnt_lock));
+}
+
+void sccp_dev_regcache_getStats(constDevicePtr d, uint32_t *hits, uint32_t *misses)
+{
+	*hits = d->registrationCache ? d->registrationCache->hits : 0;
+	*misses = d->registrationCache ? d->registrationCache->misses : 0;
+}
+
+/*!
+ * \brief Find SpeedDial by Index, without copying
+ * \param buttonIndex Button Index retained by the caller (sccp_dev_getButtonIndex)
+ * \param instance Instance as uint16_t
+ * \param withHint With Hint as boolean_t
+ * \return Speeddial inside the button index (do not modify, only valid while the index is retained), or NULL
+ */
+const sccp_speed_t *sccp_dev_speedButton_find_byindex(const sccp_buttonindex_t * buttonIndex, const uint16_t instance, boolean_t withHint)
+{
+	const sccp_speed_t *k = NULL;
+
+	if (!buttonIndex || instance == 0) {
+		return NULL;
+	}
+	if (instance < buttonIndex->speeddialSize && buttonIndex->speeddial[instance].valid) {
+		k = &buttonIndex->speeddial[instance];
+		/* we are searching for hinted speeddials, or for non hinted ones */
+		if (withHint == sccp_strlen_zero(k->hint)) {
+			k = NULL;
+		}
+	}
+	return k;
+}
+
 /*!
  * \brief Find SpeedDial by Index
  * \param d SCCP Device
@@ -1839,39 +2400,44 @@ void sccp_dev_displayprinotify_debug(constDevicePtr d, const char *msg, const sc
  * \param k SCCP Speeddial (Returned by Ref)
  * \return Void
  *
+ * \note copies the entry from the device button index, use sccp_dev_speedButton_find_byindex on hot paths
  */
 void sccp_dev_speed_find_byindex(constDevicePtr d, const uint16_t instance, boolean_t withHint, sccp_speed_t * const k)
 {
-	sccp_buttonconfig_t *config  = NULL;
+	const sccp_speed_t *speeddial = NULL;
 
 	if (!d || !d->session || instance == 0) {
 		return;
 	}
-	memset(k, 0, sizeof(sccp_speed_t));
-	sccp_copy_string(k->name, "unknown speeddial", sizeof(k->name));
+	AUTO_RELEASE(sccp_buttonindex_t, buttonIndex , sccp_dev_getButtonIndex(d));
+	if ((speeddial = sccp_dev_speedButton_find_byindex(buttonIndex, instance, withHint))) {
+		memcpy(k, speeddial, sizeof(sccp_speed_t));
+	} else {
+		memset(k, 0, sizeof(sccp_speed_t));
+		sccp_copy_string(k->name, "unknown speeddial", sizeof(k->name));
+	}
+}
 
-	SCCP_LIST_LOCK(&((devicePtr)d)->buttonconfig);
-	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
-		if (config->type == SPEEDDIAL && config->instance == instance) {
-			/* we are searching for hinted speeddials */
-			if (TRUE == withHint && !sccp_strlen_zero(config->button.speeddial.hint)) {
-				k->valid = TRUE;
-				k->instance = instance;
-				k->type = SCCP_BUTTONTYPE_SPEEDDIAL;
-				sccp_copy_string(k->name, config->label, sizeof(k->name));
-				sccp_copy_string(k->ext, config->button.speeddial.ext, sizeof(k->ext));
-				sccp_copy_string(k->hint, config->button.speeddial.hint, sizeof(k->hint));
-				
-			} else if(FALSE == withHint && sccp_strlen_zero(config->button.speeddial.hint)) {
-				k->valid = TRUE;
-				k->instance = instance;
-				k->type = SCCP_BUTTONTYPE_SPEEDDIAL;
-				sccp_copy_string(k->name, config->label, sizeof(k->name));
-				sccp_copy_string(k->ext, config->button.speeddial.ext, sizeof(k->ext));
-			}
-		}
+/*!
+ * \brief Find Feature ID by Index
+ * \param d SCCP Device
+ * \param instance Instance as uint16_t
+ * \return Feature ID of the feature button, or SCCP_FEATURE_UNKNOWN
+ *
+ * \note the button status lives in the buttonconfig, handlers which change it have to look the button up there
+ */
+sccp_feature_type_t sccp_dev_featureID_find_byindex(constDevicePtr d, const uint16_t instance)
+{
+	sccp_feature_type_t featureID = SCCP_FEATURE_UNKNOWN;
+
+	if (!d || instance == 0) {
+		return SCCP_FEATURE_UNKNOWN;
+	}
+	AUTO_RELEASE(sccp_buttonindex_t, buttonIndex , sccp_dev_getButtonIndex(d));
+	if (buttonIndex && instance < buttonIndex->speeddialSize) {
+		featureID = buttonIndex->feature[instance];
 	}
-	SCCP_LIST_UNLOCK(&((devicePtr)d)->buttonconfig);
+	return featureID;
 }
 
 /*!
@@ -2372,6 +2938,7 @@ void _sccp_dev_clean(devicePtr device, boolean_t remove_from_global, boolean_t r
 #endif
 			}
 		}
+		sccp_dev_deleteButtonIndex(d);								/* button instances are reset below */
 		SCCP_LIST_TRAVERSE_SAFE_BEGIN(&d->buttonconfig, config, list) {
 			sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_2 "%s: checking buttonconfig for pendingDelete (index:%d, type:%s (%d), pendingDelete:%s, pendingUpdate:%s)\n",
 				d->id, config->index, sccp_config_buttontype2str(config->type), config->type, config->pendingDelete ? "True" : "False", config->pendingUpdate ? "True" : "False");
@@ -2578,6 +3145,15 @@ int __sccp_device_destroy(const void *ptr)
 		pbx_mutex_destroy(&d->messageStack.lock);
 #endif
 	}
+	pbx_mutex_destroy(&d->mwiState.lock);
+	pbx_mutex_destroy(&d->shadow.lock);
+
+	// cleanup button index
+	sccp_dev_deleteButtonIndex(d);
+	pbx_mutex_destroy(&d->buttonIndex.lock);
+
+	// cleanup registration response cache
+	sccp_dev_regcache_delete(d);
 
 	// cleanup variables
 	if (d->variables) {
@@ -2642,30 +3218,25 @@ boolean_t sccp_device_isVideoSupported(constDevicePtr device)
 /*!
  * \brief Find ServiceURL by index
  * \param device SCCP Device
+ * \param buttonIndex Button Index retained by the caller (sccp_dev_getButtonIndex)
  * \param instance Instance as uint8_t
- * \return SCCP Service
+ * \return SCCP Service inside the button index (only valid while the index is retained), or NULL
  *
  */
-sccp_buttonconfig_t *sccp_dev_serviceURL_find_byindex(devicePtr device, uint16_t instance)
+const sccp_buttonindex_service_t *sccp_dev_serviceURL_find_byindex(constDevicePtr device, const sccp_buttonindex_t * buttonIndex, uint16_t instance)
 {
-	sccp_buttonconfig_t *config = NULL;
+	const sccp_buttonindex_service_t *service = NULL;
 
-	if (!device || !device->session) {
+	if (!device || !device->session || !buttonIndex) {
 		return NULL;
 	}
 	sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_BUTTONTEMPLATE)) (VERBOSE_PREFIX_3 "%s: searching for service with instance %d\n", device->id, instance);
-	SCCP_LIST_LOCK(&device->buttonconfig);
-	SCCP_LIST_TRAVERSE(&device->buttonconfig, config, list) {
-		sccp_log_and((DEBUGCAT_DEVICE + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "%s: instance: %d buttontype: %d\n", device->id, config->instance, config->type);
-
-		if (config->type == SERVICE && config->instance == instance) {
-			sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_BUTTONTEMPLATE)) (VERBOSE_PREFIX_3 "%s: found service: %s\n", device->id, config->label);
-			break;
-		}
+	if (instance > 0 && instance < buttonIndex->serviceSize && buttonIndex->service[instance].url) {
+		service = &buttonIndex->service[instance];
+		sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_BUTTONTEMPLATE)) (VERBOSE_PREFIX_3 "%s: found service: %s\n", device->id, service->label);
 	}
-	SCCP_LIST_UNLOCK(&device->buttonconfig);
 
-	return config;
+	return service;
 }
 
 /*!
@@ -2717,6 +3288,7 @@ void sccp_device_sendcallstate(constDevicePtr d, uint8_t instance, uint32_t call
 	if (!msg) {
 		return;
 	}
+	sccp_dev_shadow_forgetLine(d, instance);								/* the phone applies its own keyset/prompt on a callstate change */
 	msg->data.CallStateMessage.lel_callState = htolel(state);
 	msg->data.CallStateMessage.lel_lineInstance = htolel(instance);
 	msg->data.CallStateMessage.lel_callReference = htolel(callid);
@@ -3244,7 +3816,9 @@ sccp_device_t *sccp_device_find_byid(const char *id, boolean_t useRealtime)
 	}
 
 	SCCP_RWLIST_RDLOCK(&GLOB(devices));
-	d = SCCP_RWLIST_FIND(&GLOB(devices), sccp_device_t, tmpd, list, (sccp_strcaseequals(tmpd->id, id)), TRUE, __FILE__, __LINE__, __PRETTY_FUNCTION__);
+	if ((d = sccp_device_idIndexFind(sccp_device_idIndex, id))) {
+		d = sccp_device_retain(d);
+	}
 	SCCP_RWLIST_UNLOCK(&GLOB(devices));
 
 #ifdef CS_SCCP_REALTIME
@@ -3286,13 +3860,14 @@ sccp_device_t *sccp_device_find_realtime(const char *name)
 	if (sccp_strlen_zero(GLOB(realtimedevicetable)) || sccp_strlen_zero(name)) {
 		return NULL;
 	}
-	if ((variable = pbx_load_realtime(GLOB(realtimedevicetable), "name", name, NULL))) {
+	if ((variable = sccp_realtime_load(SCCP_REALTIME_CACHE_DEVICE, name))) {
 		v = variable;
 		sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: Device '%s' found in realtime table '%s'\n", name, GLOB(realtimedevicetable));
 
 		d = sccp_device_create(name);		/** create new device */
 		if (!d) {
 			pbx_log(LOG_ERROR, "SCCP: Unable to build realtime device '%s'\n", name);
+			pbx_variables_destroy(v);
 			return NULL;
 		}
 		// sccp_copy_string(d->id, name, sizeof(d->id));
@@ -3317,6 +3892,36 @@ sccp_device_t *sccp_device_find_realtime(const char *name)
 void sccp_device_setLamp(constDevicePtr device, skinny_stimulus_t stimulus, uint8_t instance, skinny_lampmode_t mode)
 {
 	sccp_msg_t *msg = NULL;
+	sccp_device_t *d = (sccp_device_t *) device;
+	boolean_t unchanged = FALSE;
+	uint8_t i;
+
+	if (!d) {
+		return;
+	}
+	sccp_mutex_lock(&d->shadow.lock);
+	for (i = 0; i < d->shadow.lampCount; i++) {
+		if (d->shadow.lamp[i].stimulus == stimulus && d->shadow.lamp[i].instance == instance) {
+			break;
+		}
+	}
+	if (i < d->shadow.lampCount) {
+		if (d->shadow.lamp[i].mode == mode) {
+			d->shadow.suppressed[SCCP_SHADOW_SETLAMP]++;
+			unchanged = TRUE;
+		}
+		d->shadow.lamp[i].mode = mode;
+	} else if (i < SCCP_SHADOW_MAX_LAMPS) {
+		d->shadow.lamp[i].stimulus = stimulus;
+		d->shadow.lamp[i].instance = instance;
+		d->shadow.lamp[i].mode = mode;
+		d->shadow.lampCount++;
+	}
+	sccp_mutex_unlock(&d->shadow.lock);
+	if (unchanged) {
+		sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "%s: Lamp %s(%d) already %s, skipping\n", d->id, skinny_stimulus2str(stimulus), instance, skinny_lampmode2str(mode));
+		return;
+	}
 
 	REQ(msg, SetLampMessage);
 
@@ -3328,4 +3933,371 @@ void sccp_device_setLamp(constDevicePtr device, skinny_stimulus_t stimulus, uint
 	}
 }
 
+/*!
+ * \brief Forget what the device shadow knows about the phone
+ * \param d SCCP Device
+ * \param keepLamps keep the lamp states (the phone does not change those on its own)
+ *
+ * \note used on registration and on hook/stimulus events originated by the phone, after which it may show something we did not send
+ */
+void sccp_dev_shadow_reset(constDevicePtr d, boolean_t keepLamps)
+{
+	sccp_device_t *device = (sccp_device_t *) d;
+
+	if (!d) {
+		return;
+	}
+	sccp_mutex_lock(&device->shadow.lock);
+	if (!keepLamps) {
+		device->shadow.lampCount = 0;
+	}
+	device->shadow.speakerMode = 0;
+	device->shadow.ringMode = 0;
+	memset(device->shadow.keyset, 0, sizeof(device->shadow.keyset));
+	memset(device->shadow.prompt, 0, sizeof(device->shadow.prompt));
+	sccp_mutex_unlock(&device->shadow.lock);
+}
+
+/*!
+ * \brief Forget the keyset and prompt of a lineInstance in the device shadow
+ * \param d SCCP Device
+ * \param lineInstance LineInstance as uint8_t
+ */
+void sccp_dev_shadow_forgetLine(constDevicePtr d, uint8_t lineInstance)
+{
+	sccp_device_t *device = (sccp_device_t *) d;
+
+	if (!d || lineInstance > SCCP_SHADOW_MAX_INSTANCE) {
+		return;
+	}
+	sccp_mutex_lock(&device->shadow.lock);
+	device->shadow.keyset[lineInstance].valid = FALSE;
+	device->shadow.keyset[0].valid = FALSE;									/* the base keyset follows the active line */
+	device->shadow.prompt[lineInstance].valid = FALSE;
+	sccp_mutex_unlock(&device->shadow.lock);
+}
+
+const char *sccp_shadow_msgtype2str(sccp_shadow_msgtype_t type)
+{
+	static const char *const names[SCCP_SHADOW_SENTINEL] = {
+		[SCCP_SHADOW_SETLAMP] = "SetLamp",
+		[SCCP_SHADOW_SELECTSOFTKEYS] = "SelectSoftKeys",
+		[SCCP_SHADOW_SETSPEAKERMODE] = "SetSpeakerMode",
+		[SCCP_SHADOW_SETRINGER] = "SetRinger",
+		[SCCP_SHADOW_DISPLAYPROMPT] = "DisplayPrompt",
+		[SCCP_SHADOW_CLEARPROMPT] = "ClearPrompt",
+	};
+	return (type < SCCP_SHADOW_SENTINEL) ? names[type] : "Unknown";
+}
+
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+#define TEST_CACHELINE_SIZE 64
+#define TEST_HOT_CACHELINES 2
+#define NUM_TEST_OBJECTS 8000
+#define NUM_TEST_LOOPS 20
+#define NUM_TEST_DEVICES 2000
+#define NUM_TEST_LOOKUP_LOOPS 10
+
+#define TEST_REPORT_FIELD(_type, _field) pbx_test_status_update(test, "  %-24s offset:%5d size:%5d cacheline:%d\n", #_field, (int) offsetof(_type, _field), (int) sizeof(((_type *)0)->_field), (int) (offsetof(_type, _field) / TEST_CACHELINE_SIZE));
+
+AST_TEST_DEFINE(sccp_device_layout)
+{
+	int rc = AST_TEST_PASS;
+	int loop, idx;
+	sccp_device_t *devices = NULL;
+	sccp_device_t *d = NULL;
+	struct timeval start;
+	long hotMs = 0, coldMs = 0;
+	volatile unsigned long sum = 0;
+
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "device_layout";
+			info->category = "/channels/chan_sccp/device/";
+			info->summary = "chan-sccp-b device structure layout test";
+			info->description = "reports the sccp_device_t layout and times a traversal of the hot part against the cold part";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	pbx_test_status_update(test, "sccp_device_t size:%d, hot part:%d bytes\n", (int) sizeof(sccp_device_t), (int) offsetof(sccp_device_t, buttonconfig));
+	TEST_REPORT_FIELD(sccp_device_t, list);
+	TEST_REPORT_FIELD(sccp_device_t, session);
+	TEST_REPORT_FIELD(sccp_device_t, protocol);
+	TEST_REPORT_FIELD(sccp_device_t, privateData);
+	TEST_REPORT_FIELD(sccp_device_t, active_channel);
+	TEST_REPORT_FIELD(sccp_device_t, id);
+	TEST_REPORT_FIELD(sccp_device_t, lineButtons);
+	TEST_REPORT_FIELD(sccp_device_t, inuseprotocolversion);
+	TEST_REPORT_FIELD(sccp_device_t, nat);
+	TEST_REPORT_FIELD(sccp_device_t, buttonconfig);
+	TEST_REPORT_FIELD(sccp_device_t, buttonIndex);
+	TEST_REPORT_FIELD(sccp_device_t, capabilities);
+	TEST_REPORT_FIELD(sccp_device_t, softKeyConfiguration);
+	TEST_REPORT_FIELD(sccp_device_t, messageStack);
+	TEST_REPORT_FIELD(sccp_device_t, pendingDelete);
+#ifdef SCCP_ATOMIC
+	pbx_test_validate(test, offsetof(sccp_device_t, buttonconfig) <= TEST_CACHELINE_SIZE * TEST_HOT_CACHELINES);
+#endif
+
+	devices = sccp_calloc(NUM_TEST_OBJECTS, sizeof(sccp_device_t));
+	pbx_test_validate(test, devices != NULL);
+	for (idx = 0; idx < NUM_TEST_OBJECTS - 1; idx++) {
+		devices[idx].list.next = &devices[idx + 1];
+		devices[idx].inuseprotocolversion = idx % 23;
+	}
+
+	pbx_test_status_update(test, "Traverse %d devices %d times, reading hot fields...\n", NUM_TEST_OBJECTS, NUM_TEST_LOOPS);
+	start = pbx_tvnow();
+	for (loop = 0; loop < NUM_TEST_LOOPS; loop++) {
+		for (d = devices; d; d = d->list.next) {
+			sum += d->inuseprotocolversion + (d->session ? 1 : 0) + (d->active_channel ? 1 : 0) + d->id[0];
+		}
+	}
+	hotMs = ast_tvdiff_ms(pbx_tvnow(), start);
+
+	pbx_test_status_update(test, "Traverse %d devices %d times, reading hot and cold fields...\n", NUM_TEST_OBJECTS, NUM_TEST_LOOPS);
+	start = pbx_tvnow();
+	for (loop = 0; loop < NUM_TEST_LOOPS; loop++) {
+		for (d = devices; d; d = d->list.next) {
+			sum += d->inuseprotocolversion + (d->session ? 1 : 0) + d->mwilight + d->pendingDelete;
+		}
+	}
+	coldMs = ast_tvdiff_ms(pbx_tvnow(), start);
+	pbx_test_status_update(test, "device traversal: hot fields %ld ms, hot and cold fields %ld ms (checksum:%lu)\n", hotMs, coldMs, sum);
+
+	sccp_free(devices);
+	return rc;
+}
+
+AST_TEST_DEFINE(sccp_channel_layout)
+{
+	int rc = AST_TEST_PASS;
+	int loop, idx;
+	sccp_channel_t *channels = NULL;
+	sccp_channel_t *c = NULL;
+	struct timeval start;
+	long hotMs = 0, coldMs = 0;
+	volatile unsigned long sum = 0;
+
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "channel_layout";
+			info->category = "/channels/chan_sccp/device/";
+			info->summary = "chan-sccp-b channel structure layout test";
+			info->description = "reports the sccp_channel_t layout and times channel state updates";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	pbx_test_status_update(test, "sccp_channel_t size:%d, hot part:%d bytes\n", (int) sizeof(sccp_channel_t), (int) offsetof(sccp_channel_t, dialedNumber));
+	TEST_REPORT_FIELD(sccp_channel_t, callid);
+	TEST_REPORT_FIELD(sccp_channel_t, state);
+	TEST_REPORT_FIELD(sccp_channel_t, owner);
+	TEST_REPORT_FIELD(sccp_channel_t, line);
+	TEST_REPORT_FIELD(sccp_channel_t, list);
+	TEST_REPORT_FIELD(sccp_channel_t, privateData);
+	TEST_REPORT_FIELD(sccp_channel_t, getDevice);
+	TEST_REPORT_FIELD(sccp_channel_t, designator);
+	TEST_REPORT_FIELD(sccp_channel_t, dialedNumber);
+	TEST_REPORT_FIELD(sccp_channel_t, subscriptionId);
+	TEST_REPORT_FIELD(sccp_channel_t, rtp);
+	pbx_test_validate(test, offsetof(sccp_channel_t, dialedNumber) <= TEST_CACHELINE_SIZE * TEST_HOT_CACHELINES);
+
+	channels = sccp_calloc(NUM_TEST_OBJECTS, sizeof(sccp_channel_t));
+	pbx_test_validate(test, channels != NULL);
+	for (idx = 0; idx < NUM_TEST_OBJECTS - 1; idx++) {
+		channels[idx].list.next = &channels[idx + 1];
+	}
+
+	pbx_test_status_update(test, "Update the state of %d channels %d times...\n", NUM_TEST_OBJECTS, NUM_TEST_LOOPS);
+	start = pbx_tvnow();
+	for (loop = 0; loop < NUM_TEST_LOOPS; loop++) {
+		for (c = channels; c; c = c->list.next) {
+			c->previousChannelState = c->state;
+			c->state = (sccp_channelstate_t) (loop % 2 ? SCCP_CHANNELSTATE_RINGING : SCCP_CHANNELSTATE_CONNECTED);
+			c->lineStateCounter = loop % 4;
+			sum += c->callid + (c->owner ? 1 : 0) + (c->line ? 1 : 0);
+		}
+	}
+	hotMs = ast_tvdiff_ms(pbx_tvnow(), start);
+
+	pbx_test_status_update(test, "Update the state of %d channels %d times, reading a cold field...\n", NUM_TEST_OBJECTS, NUM_TEST_LOOPS);
+	start = pbx_tvnow();
+	for (loop = 0; loop < NUM_TEST_LOOPS; loop++) {
+		for (c = channels; c; c = c->list.next) {
+			c->previousChannelState = c->state;
+			c->state = (sccp_channelstate_t) (loop % 2 ? SCCP_CHANNELSTATE_RINGING : SCCP_CHANNELSTATE_CONNECTED);
+			sum += c->callid + c->dialedNumber[0] + c->ringermode;
+		}
+	}
+	coldMs = ast_tvdiff_ms(pbx_tvnow(), start);
+	pbx_test_status_update(test, "channel state update: hot fields %ld ms, hot and cold fields %ld ms (checksum:%lu)\n", hotMs, coldMs, sum);
+
+	sccp_free(channels);
+	return rc;
+}
+
+AST_TEST_DEFINE(sccp_device_shadow)
+{
+	sccp_device_t *d = NULL;
+	int i;
+	enum ast_test_result_state res = AST_TEST_PASS;
+
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "device_shadow";
+			info->category = "/channels/chan_sccp/device/";
+			info->summary = "chan-sccp-b device shadow state test";
+			info->description = "redundant lamp and ringer messages are suppressed until the shadow state is reset";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	if (!(d = sccp_calloc(1, sizeof(sccp_device_t)))) {
+		return AST_TEST_FAIL;
+	}
+	pbx_mutex_init(&d->shadow.lock);
+	sccp_copy_string(d->id, "SEPTESTSHADOW", sizeof(d->id));
+
+	pbx_test_status_update(test, "Same lamp state twice, second one suppressed...\n");
+	sccp_device_setLamp(d, SKINNY_STIMULUS_LINE, 1, SKINNY_LAMP_ON);
+	sccp_device_setLamp(d, SKINNY_STIMULUS_LINE, 1, SKINNY_LAMP_ON);
+	pbx_test_validate_cleanup(test, d->shadow.suppressed[SCCP_SHADOW_SETLAMP] == 1, res, cleanup);
+
+	pbx_test_status_update(test, "Other lamp mode or instance, not suppressed...\n");
+	sccp_device_setLamp(d, SKINNY_STIMULUS_LINE, 1, SKINNY_LAMP_BLINK);
+	sccp_device_setLamp(d, SKINNY_STIMULUS_LINE, 2, SKINNY_LAMP_BLINK);
+	pbx_test_validate_cleanup(test, d->shadow.suppressed[SCCP_SHADOW_SETLAMP] == 1, res, cleanup);
+
+	pbx_test_status_update(test, "Lamps beyond the shadow table are always sent...\n");
+	for (i = 0; i < SCCP_SHADOW_MAX_LAMPS + 8; i++) {
+		sccp_device_setLamp(d, SKINNY_STIMULUS_SPEEDDIAL, i, SKINNY_LAMP_ON);
+	}
+	for (i = 0; i < SCCP_SHADOW_MAX_LAMPS + 8; i++) {
+		sccp_device_setLamp(d, SKINNY_STIMULUS_SPEEDDIAL, i, SKINNY_LAMP_ON);
+	}
+	pbx_test_validate_cleanup(test, d->shadow.suppressed[SCCP_SHADOW_SETLAMP] == 1 + SCCP_SHADOW_MAX_LAMPS - 2, res, cleanup);
+
+	pbx_test_status_update(test, "Ringer only suppressed for the same mode, line and call...\n");
+	sccp_dev_set_ringer(d, SKINNY_RINGTYPE_INSIDE, 1, 100);
+	sccp_dev_set_ringer(d, SKINNY_RINGTYPE_INSIDE, 1, 100);
+	sccp_dev_set_ringer(d, SKINNY_RINGTYPE_INSIDE, 1, 101);
+	pbx_test_validate_cleanup(test, d->shadow.suppressed[SCCP_SHADOW_SETRINGER] == 1, res, cleanup);
+
+	pbx_test_status_update(test, "Reset keeping lamps forgets the ringer only...\n");
+	sccp_dev_shadow_reset(d, TRUE);
+	sccp_dev_set_ringer(d, SKINNY_RINGTYPE_INSIDE, 1, 101);
+	sccp_device_setLamp(d, SKINNY_STIMULUS_LINE, 2, SKINNY_LAMP_BLINK);
+	pbx_test_validate_cleanup(test, d->shadow.suppressed[SCCP_SHADOW_SETRINGER] == 1, res, cleanup);
+	pbx_test_validate_cleanup(test, d->shadow.suppressed[SCCP_SHADOW_SETLAMP] == SCCP_SHADOW_MAX_LAMPS, res, cleanup);
+
+	pbx_test_status_update(test, "Full reset forgets the lamps...\n");
+	sccp_dev_shadow_reset(d, FALSE);
+	sccp_device_setLamp(d, SKINNY_STIMULUS_LINE, 2, SKINNY_LAMP_BLINK);
+	pbx_test_validate_cleanup(test, d->shadow.suppressed[SCCP_SHADOW_SETLAMP] == SCCP_SHADOW_MAX_LAMPS, res, cleanup);
+
+cleanup:
+	pbx_mutex_destroy(&d->shadow.lock);
+	sccp_free(d);
+	return res;
+}
+
+AST_TEST_DEFINE(sccp_device_find_byid_benchmark)
+{
+	int rc = AST_TEST_PASS;
+	int loop, idx;
+	char id[StationMaxDeviceNameSize];
+	struct timeval start;
+	long indexMs = 0, scanMs = 0;
+	sccp_device_t **index = NULL;
+	sccp_device_t *devices = NULL;
+	sccp_device_t *d = NULL;
+
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "find_byid";
+			info->category = "/channels/chan_sccp/device/";
+			info->summary = "chan-sccp-b device lookup test";
+			info->description = "compares a private device id index against a full list scan, leaving GLOB(devices) untouched";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	index = sccp_calloc(SCCP_HASH_PRIME, sizeof(sccp_device_t *));
+	devices = sccp_calloc(NUM_TEST_DEVICES, sizeof(sccp_device_t));
+	pbx_test_validate_cleanup(test, index != NULL && devices != NULL, rc, cleanup);
+
+	pbx_test_status_update(test, "Index %d devices...\n", NUM_TEST_DEVICES);
+	for (idx = 0; idx < NUM_TEST_DEVICES; idx++) {
+		snprintf(devices[idx].id, sizeof(devices[idx].id), "SEP0000000%05d", idx);
+		if (idx < NUM_TEST_DEVICES - 1) {
+			devices[idx].list.next = &devices[idx + 1];
+		}
+		sccp_device_idIndexInsert(index, &devices[idx]);
+	}
+
+	pbx_test_status_update(test, "Lookup %d devices %d times using the id index...\n", NUM_TEST_DEVICES, NUM_TEST_LOOKUP_LOOPS);
+	start = pbx_tvnow();
+	for (loop = 0; loop < NUM_TEST_LOOKUP_LOOPS; loop++) {
+		for (idx = 0; idx < NUM_TEST_DEVICES; idx++) {
+			snprintf(id, sizeof(id), "sep0000000%05d", idx);				/* lookup is case insensitive */
+			d = sccp_device_idIndexFind(index, id);
+			pbx_test_validate_cleanup(test, d == &devices[idx], rc, cleanup);
+		}
+	}
+	indexMs = ast_tvdiff_ms(pbx_tvnow(), start);
+
+	pbx_test_status_update(test, "Lookup %d devices %d times using a list scan...\n", NUM_TEST_DEVICES, NUM_TEST_LOOKUP_LOOPS);
+	start = pbx_tvnow();
+	for (loop = 0; loop < NUM_TEST_LOOKUP_LOOPS; loop++) {
+		for (idx = 0; idx < NUM_TEST_DEVICES; idx++) {
+			snprintf(id, sizeof(id), "sep0000000%05d", idx);
+			for (d = devices; d; d = d->list.next) {
+				if (sccp_strcaseequals(d->id, id)) {
+					break;
+				}
+			}
+			pbx_test_validate_cleanup(test, d == &devices[idx], rc, cleanup);
+		}
+	}
+	scanMs = ast_tvdiff_ms(pbx_tvnow(), start);
+	pbx_test_status_update(test, "%d lookups: id index %ld ms, list scan %ld ms\n", NUM_TEST_DEVICES * NUM_TEST_LOOKUP_LOOPS, indexMs, scanMs);
+
+	pbx_test_status_update(test, "Lookup of an unknown device...\n");
+	pbx_test_validate_cleanup(test, sccp_device_idIndexFind(index, "SEPFFFFFFFFFFFF") == NULL, rc, cleanup);
+
+	pbx_test_status_update(test, "Lookup after removal...\n");
+	sccp_device_idIndexRemove(index, &devices[NUM_TEST_DEVICES / 2]);
+	pbx_test_validate_cleanup(test, sccp_device_idIndexFind(index, devices[NUM_TEST_DEVICES / 2].id) == NULL, rc, cleanup);
+	pbx_test_validate_cleanup(test, sccp_device_idIndexFind(index, devices[0].id) == &devices[0], rc, cleanup);
+
+cleanup:
+	sccp_free(devices);
+	sccp_free(index);
+	return rc;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_device_layout);
+	AST_TEST_REGISTER(sccp_channel_layout);
+	AST_TEST_REGISTER(sccp_device_shadow);
+	AST_TEST_REGISTER(sccp_device_find_byid_benchmark);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_device_layout);
+	AST_TEST_UNREGISTER(sccp_channel_layout);
+	AST_TEST_UNREGISTER(sccp_device_shadow);
+	AST_TEST_UNREGISTER(sccp_device_find_byid_benchmark);
+}
+#endif
+
 // kate: indent-width 4; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets on;
@@ -14,6 +14,8 @@
 #define sccp_device_retain(_x)		sccp_refcount_retain_type(sccp_device_t, _x)
 #define sccp_device_release(_x)		sccp_refcount_release_type(sccp_device_t, _x)
 #define sccp_device_refreplace(_x, _y)	sccp_refcount_refreplace_type(sccp_device_t, _x, _y)
+#define sccp_buttonindex_retain(_x)	sccp_refcount_retain_type(sccp_buttonindex_t, _x)
+#define sccp_buttonindex_release(_x)	sccp_refcount_release_type(sccp_buttonindex_t, _x)
 
 __BEGIN_C_EXTERN__
 
@@ -88,6 +90,59 @@ struct sccp_speed {
 	SCCP_LIST_ENTRY (sccp_speed_t) list;									/*!< SpeedDial Linked List Entry */
 };
 
+/*!
+ * \brief SCCP Button Index Service Entry
+ */
+struct sccp_buttonindex_service {
+	char *label;												/*!< Copy of the Service Button Label */
+	char *url;												/*!< Copy of the Service Button URL */
+};
+
+/*!
+ * \brief SCCP Button Index Structure
+ * \note Refcounted per device snapshot of the speeddial, feature and service buttons, indexed by instance. Built when the button
+ * template has been sent and on reload, and replaced as a whole (never changed in place). It only holds copies, never
+ * pointers into the buttonconfig, so a reader that retained it (sccp_dev_getButtonIndex) can keep using its entries after the
+ * buttonconfig has been reloaded or freed.
+ */
+struct sccp_buttonindex {
+	uint16_t speeddialSize;											/*!< Number of speeddial / feature entries (highest instance + 1) */
+	uint16_t serviceSize;											/*!< Number of service entries (highest instance + 1) */
+	sccp_speed_t *speeddial;										/*!< Speeddial snapshot by instance (valid == FALSE for unused instances) */
+	sccp_feature_type_t *feature;										/*!< Feature ID by instance, SCCP_FEATURE_UNKNOWN for unused instances (features share the speeddial instances) */
+	sccp_buttonindex_service_t *service;									/*!< Service snapshot by instance (url == NULL for unused instances) */
+};
+
+/*!
+ * \brief Registration Response Cache Entries
+ * \note Responses to the requests a phone sends while (re)registering, which only depend on the configuration
+ */
+typedef enum {
+	SCCP_REGCACHE_BUTTONTEMPLATE,
+	SCCP_REGCACHE_SOFTKEYTEMPLATE,
+	SCCP_REGCACHE_SOFTKEYSET,
+	SCCP_REGCACHE_SPEEDDIALSTAT,										/* by speeddial instance */
+	SCCP_REGCACHE_FEATURESTATDYNAMIC,									/* by feature index */
+	SCCP_REGCACHE_SENTINEL,
+} sccp_regcache_entry_t;
+
+/*!
+ * \brief Device Shadow State Message Types
+ * \note Messages which are dropped when they would not change what the phone currently shows
+ */
+typedef enum {
+	SCCP_SHADOW_SETLAMP,
+	SCCP_SHADOW_SELECTSOFTKEYS,
+	SCCP_SHADOW_SETSPEAKERMODE,
+	SCCP_SHADOW_SETRINGER,
+	SCCP_SHADOW_DISPLAYPROMPT,
+	SCCP_SHADOW_CLEARPROMPT,
+	SCCP_SHADOW_SENTINEL,
+} sccp_shadow_msgtype_t;
+
+#define SCCP_SHADOW_MAX_LAMPS 64										/*!< Lamps tracked per device, further lamps are always sent */
+#define SCCP_SHADOW_MAX_INSTANCE StationMaxButtonTemplateSize							/*!< Highest lineInstance tracked, higher instances are always sent */
+
 /*!
  * \brief Privacy Feature Enum
  */
@@ -155,33 +210,39 @@ struct softKeySetConfiguration {
  * \brief SCCP Device Structure
  */
 struct sccp_device {
-	char id[StationMaxDeviceNameSize];									/*!< SEP<macAddress> of the device. */
-	const sccp_deviceProtocol_t *protocol;									/*!< protocol the devices uses */
-	skinny_devicetype_t skinny_type;									/*!< Model of this Phone sent by the station, devicetype */
-	uint32_t device_features;										/*!< device features (contains protocolversion in 8bit first segement */
-	sccp_earlyrtp_t earlyrtp;										/*!< RTP Channel State where to open the RTP Media Stream */
-	uint16_t keepalive;											/*!< Station Specific Keepalive Timeout */
-	uint16_t keepaliveinterval;										/*!< Currently set Keepalive Timeout */
-	uint8_t protocolversion;										/*!< Skinny Supported Protocol Version */
-	uint8_t inuseprotocolversion;										/*!< Skinny Used Protocol Version */
-	uint16_t directrtp;											/*!< Direct RTP Support (Boolean, default=on) */
-
-	sccp_nat_t nat;												/*!< Network Address Translation Support (Boolean, default=on) */
-	sccp_session_t *session;										/*!< Current Session */
+	/* hot runtime state: kept together at the start of the structure, so that walking GLOB(devices) and handling messages
+	 * touches the first two cache lines only (checked by the device_layout test). Configuration goes below. */
 	SCCP_RWLIST_ENTRY (sccp_device_t) list;									/*!< Global Device Linked List */
-
+	sccp_device_t *hashNext;										/*!< Next Device in the same GLOB(devices) ID Index Bucket */
+	sccp_session_t *session;										/*!< Current Session */
+	const sccp_deviceProtocol_t *protocol;									/*!< protocol the devices uses */
 	sccp_private_device_data_t *privateData;
-	
 	sccp_channel_t *active_channel;										/*!< Active SCCP Channel */
 	sccp_line_t *currentLine;										/*!< Current Line */
+	char id[StationMaxDeviceNameSize];									/*!< SEP<macAddress> of the device. */
 
 	struct {
 		sccp_linedevices_t **instance;
 		uint8_t size;
 	} lineButtons;
 
+	skinny_devicetype_t skinny_type;									/*!< Model of this Phone sent by the station, devicetype */
+	uint32_t device_features;										/*!< device features (contains protocolversion in 8bit first segement */
+	uint8_t protocolversion;										/*!< Skinny Supported Protocol Version */
+	uint8_t inuseprotocolversion;										/*!< Skinny Used Protocol Version */
+	uint16_t keepalive;											/*!< Station Specific Keepalive Timeout */
+	uint16_t keepaliveinterval;										/*!< Currently set Keepalive Timeout */
+	uint16_t directrtp;											/*!< Direct RTP Support (Boolean, default=on) */
+	sccp_earlyrtp_t earlyrtp;										/*!< RTP Channel State where to open the RTP Media Stream */
+	sccp_nat_t nat;												/*!< Network Address Translation Support (Boolean, default=on) */
+	/* end of hot runtime state */
+
 	//SCCP_LIST_HEAD (, sccp_buttonconfig_t) buttonconfig;							/*!< SCCP Button Config Attached to this Device */
 	sccp_buttonconfig_list_t buttonconfig;									/*!< SCCP Button Config Attached to this Device */
+	struct {
+		sccp_mutex_t lock;										/*!< Button Index Lock, protects the table pointer while it is retained or replaced */
+		sccp_buttonindex_t *table;									/*!< Current Button Index (one reference held by the device) */
+	} buttonIndex;												/*!< Speeddial / Feature / Service Button Index */
 	SCCP_LIST_HEAD (, sccp_selectedchannel_t) selectedChannels;						/*!< Selected Channel List */
 	SCCP_LIST_HEAD (, sccp_addon_t) addons;									/*!< Add-Ons connect to this Device */
 	SCCP_LIST_HEAD (, sccp_hostname_t) permithosts;								/*!< Permit Registration to the Hostname/IP Address */
@@ -253,6 +314,49 @@ struct sccp_device {
 		uint16_t oldmsgs;										/*!< Old Messages */
 	} voicemailStatistic;											/*!< VoiceMail Statistics */
 
+	/*!
+	 * \brief Aggregated MWI State, maintained incrementally from mailbox events and channel state transitions
+	 */
+	struct {
+		sccp_mutex_t lock;										/*!< MWI State Lock */
+		int newmsgs;											/*!< New Messages summed over all attached lines */
+		int oldmsgs;											/*!< Old Messages summed over all attached lines */
+		int activeCalls;										/*!< Own channels in an active state (suppress the lamp when mwioncall=off) */
+		uint32_t lampUpdates;										/*!< Number of MWI Lamp Messages sent */
+		uint32_t lampUpdatesSuppressed;									/*!< Number of redundant MWI Lamp Messages not sent */
+	} mwiState;												/*!< Aggregated MWI State Structure */
+
+	/*!
+	 * \brief Shadow of what the phone currently shows, used to drop messages which would not change anything
+	 * \note Reset on registration, keyset/prompt of a line are forgotten on a CallState change, speaker/ringer/keysets on phone originated hook events
+	 */
+	struct {
+		sccp_mutex_t lock;										/*!< Shadow State Lock */
+		struct {
+			uint8_t stimulus;									/*!< Lamp Stimulus */
+			uint8_t instance;									/*!< Lamp Instance */
+			uint8_t mode;										/*!< Current Lamp Mode */
+		} lamp[SCCP_SHADOW_MAX_LAMPS];									/*!< Lamp mode per stimulus/instance */
+		uint8_t lampCount;										/*!< Number of lamps tracked */
+		uint8_t speakerMode;										/*!< Current Speaker Mode (0 = unknown) */
+		uint8_t ringMode;										/*!< Current Ring Mode (0 = unknown) */
+		uint8_t ringLineInstance;									/*!< LineInstance of the current Ring Mode */
+		uint32_t ringCallid;										/*!< Callid of the current Ring Mode */
+		struct {
+			boolean_t valid;									/*!< Keyset is known */
+			uint8_t softKeySetIndex;								/*!< Current Keyset */
+			uint32_t callid;									/*!< Callid of the current Keyset */
+			uint32_t validKeyMask;									/*!< Enabled softkeys of the current Keyset */
+		} keyset[SCCP_SHADOW_MAX_INSTANCE + 1];								/*!< Current keyset per lineInstance (0 = base) */
+		struct {
+			boolean_t valid;									/*!< Prompt is known */
+			boolean_t cleared;									/*!< Prompt has been cleared */
+			uint32_t callid;									/*!< Callid of the current Prompt */
+			uint32_t hash;										/*!< Hash of the current Prompt Text */
+		} prompt[SCCP_SHADOW_MAX_INSTANCE + 1];								/*!< Last permanent prompt per lineInstance */
+		uint32_t suppressed[SCCP_SHADOW_SENTINEL];							/*!< Redundant messages not sent, per message type */
+	} shadow;												/*!< Device Shadow State Structure */
+
 	/* feature configurations */
 	sccp_featureConfiguration_t privacyFeature;								/*!< Device Privacy Feature. \see SCCP_PRIVACYFEATURE_* */
 	sccp_featureConfiguration_t overlapFeature;								/*!< Overlap Dial Feature */
@@ -288,6 +392,8 @@ struct sccp_device {
 	boolean_t isAnonymous;											/*!< Device is connected Anonymously (Guest) */
 
 	btnlist *buttonTemplate;
+	sccp_regcache_t *registrationCache;									/*!< Encoded Registration Responses (only used by the session thread) */
+	int configGeneration;											/*!< Incremented whenever this device, one of its lines or its softkeyset is (re)configured */
 
 	struct {
 		char *action;
@@ -347,6 +453,7 @@ struct sccp_device {
 #endif
 	boolean_t pendingDelete;										/*!< this bit will tell the scheduler to delete this line when unused */
 	boolean_t pendingUpdate;										/*!< this will contain the updated line struct once reloaded from config to update the line when unused */
+	uint64_t configHash;											/*!< Hash of the sccp.conf section this device was last built from (incremental reload) */
 };
 
 // Number of additional keys per addon -FS
@@ -387,7 +494,9 @@ struct sccp_device_indication_cb {
 #define sccp_dev_displayprinotify(p,q,r,s) sccp_dev_displayprinotify_debug(p,q,r,s,__FILE__, __LINE__, __PRETTY_FUNCTION__)
 
 SCCP_API void SCCP_CALL sccp_device_pre_reload(void);
+SCCP_API void SCCP_CALL sccp_device_prepareReload(devicePtr d);
 SCCP_API void SCCP_CALL sccp_device_post_reload(void);
+SCCP_API void SCCP_CALL sccp_device_checkPendingUpdates(constLinePtr l);
 
 /* ====================================================================================================== start getters / setters for privateData */
 SCCP_API const SCCP_CALL sccp_accessorystate_t sccp_device_getAccessoryStatus(constDevicePtr d, const sccp_accessory_t accessory);
@@ -396,6 +505,7 @@ SCCP_API int SCCP_CALL sccp_device_setAccessoryStatus(constDevicePtr d, const sc
 SCCP_API const SCCP_CALL sccp_devicestate_t sccp_device_getDeviceState(constDevicePtr d);
 SCCP_API int SCCP_CALL sccp_device_setDeviceState(constDevicePtr d, const sccp_devicestate_t state);
 SCCP_API const SCCP_CALL skinny_registrationstate_t sccp_device_getRegistrationState(constDevicePtr d);
+SCCP_API const SCCP_CALL uint32_t sccp_device_getRegistrationGeneration(constDevicePtr d);
 SCCP_API int SCCP_CALL sccp_device_setRegistrationState(constDevicePtr d, const skinny_registrationstate_t state);
 /* ======================================================================================================== end getters / setters for privateData */
 
@@ -409,7 +519,7 @@ SCCP_API void SCCP_CALL sccp_dev_setActiveLine(devicePtr device, constLinePtr l)
 SCCP_API sccp_channel_t * SCCP_CALL sccp_device_getActiveChannel(constDevicePtr device);
 SCCP_API void SCCP_CALL sccp_device_setActiveChannel(devicePtr d, sccp_channel_t * channel);
 
-SCCP_API sccp_buttonconfig_t * SCCP_CALL sccp_dev_serviceURL_find_byindex(devicePtr device, uint16_t instance);
+SCCP_API const sccp_buttonindex_service_t * SCCP_CALL sccp_dev_serviceURL_find_byindex(constDevicePtr device, const sccp_buttonindex_t * buttonIndex, uint16_t instance);
 
 #define REQ(x,y) x = sccp_build_packet(y, sizeof(x->data.y))
 #define REQCMD(x,y) x = sccp_build_packet(y, 0)
@@ -438,6 +548,16 @@ SCCP_API void SCCP_CALL sccp_dev_displayprinotify_debug(constDevicePtr d, const
 SCCP_API void SCCP_CALL sccp_dev_cleardisplaynotify(constDevicePtr d);
 SCCP_API void SCCP_CALL sccp_dev_cleardisplayprinotify(constDevicePtr d, const uint8_t priority);
 SCCP_API void SCCP_CALL sccp_dev_speed_find_byindex(constDevicePtr d, const uint16_t instance, boolean_t withHint, sccp_speed_t * const k);
+SCCP_API const sccp_speed_t * SCCP_CALL sccp_dev_speedButton_find_byindex(const sccp_buttonindex_t * buttonIndex, const uint16_t instance, boolean_t withHint);
+SCCP_API sccp_feature_type_t SCCP_CALL sccp_dev_featureID_find_byindex(constDevicePtr d, const uint16_t instance);
+SCCP_API sccp_buttonindex_t * SCCP_CALL sccp_dev_getButtonIndex(constDevicePtr d);
+SCCP_API void SCCP_CALL sccp_dev_buildButtonIndex(devicePtr d);
+SCCP_API void SCCP_CALL sccp_dev_deleteButtonIndex(devicePtr d);
+SCCP_API sccp_msg_t * SCCP_CALL sccp_dev_regcache_get(devicePtr d, sccp_regcache_entry_t entry, uint16_t index);
+SCCP_API void SCCP_CALL sccp_dev_regcache_store(devicePtr d, sccp_regcache_entry_t entry, uint16_t index, const sccp_msg_t * msg);
+SCCP_API void SCCP_CALL sccp_dev_regcache_delete(devicePtr d);
+SCCP_API void SCCP_CALL sccp_dev_regcache_invalidate(devicePtr d);
+SCCP_API void SCCP_CALL sccp_dev_regcache_getStats(constDevicePtr d, uint32_t *hits, uint32_t *misses);
 SCCP_API void SCCP_CALL sccp_dev_forward_status(constLinePtr l, uint8_t lineInstance, constDevicePtr device);
 SCCP_API void SCCP_CALL sccp_dev_postregistration(void *data);
 SCCP_API void SCCP_CALL _sccp_dev_clean(devicePtr device, boolean_t remove_from_global, boolean_t restart_device);
@@ -489,5 +609,8 @@ SCCP_API sccp_device_t * SCCP_CALL sccp_device_find_realtime(const char *name);
 #endif
 
 SCCP_API void SCCP_CALL sccp_device_setLamp(constDevicePtr device, skinny_stimulus_t stimulus, uint8_t instance, skinny_lampmode_t mode);
+SCCP_API void SCCP_CALL sccp_dev_shadow_reset(constDevicePtr d, boolean_t keepLamps);
+SCCP_API void SCCP_CALL sccp_dev_shadow_forgetLine(constDevicePtr d, uint8_t lineInstance);
+SCCP_API const char * SCCP_CALL sccp_shadow_msgtype2str(sccp_shadow_msgtype_t type);
 __END_C_EXTERN__
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -18,30 +18,82 @@ SCCP_FILE_VERSION(__FILE__, "");
 #if defined(CS_AST_HAS_EVENT) && defined(HAVE_PBX_EVENT_H)							// ast_event_subscribe
 #  include <asterisk/event.h>
 #endif
+#include <asterisk/cli.h>
 
 #if CS_DEVSTATE_FEATURE
+#define SCCP_DEVSTATE_HASH_SIZE SCCP_HASH_PRIME									/*!< Number of buckets in the deviceState hash table */
+#define sccp_devstate_deviceState_retain(_x)	sccp_refcount_retain_type(sccp_devstate_deviceState_t, _x)
+#define sccp_devstate_deviceState_release(_x)	sccp_refcount_release_type(sccp_devstate_deviceState_t, _x)
+#define sccp_devstate_executor_retain(_x)	sccp_refcount_retain_type(sccp_devstate_executor_t, _x)
+#define sccp_devstate_executor_release(_x)	sccp_refcount_release_type(sccp_devstate_executor_t, _x)
+
 typedef struct sccp_devstate_SubscribingDevice sccp_devstate_SubscribingDevice_t;
+typedef struct sccp_devstate_deviceState sccp_devstate_deviceState_t;
+typedef struct sccp_devstate_executor sccp_devstate_executor_t;
+typedef struct sccp_devstate_pendingUpdate sccp_devstate_pendingUpdate_t;
 
 struct sccp_devstate_SubscribingDevice 
 {
 	SCCP_LIST_ENTRY (sccp_devstate_SubscribingDevice_t) list;
 	sccp_device_t *device;											/*!< SCCP Device */
+	sccp_devstate_executor_t *executor;									/*!< Per Device Executor delivering the notifications */
 	sccp_buttonconfig_t *buttonConfig;
 	char label[StationMaxNameSize];
 	uint8_t instance;											/*!< Instance */
 };
 
-typedef struct sccp_devstate_deviceState sccp_devstate_deviceState_t;
 struct sccp_devstate_deviceState 
 {
 	SCCP_LIST_HEAD (, sccp_devstate_SubscribingDevice_t) subscribers;
 	SCCP_LIST_ENTRY (struct sccp_devstate_deviceState) list;
+	sccp_devstate_deviceState_t *hashNext;									/*!< Next deviceState in the same Hash Bucket */
 	char devicestate[StationMaxNameSize];
 	PBX_EVENT_SUBSCRIPTION *sub;
 	uint32_t featureState;
+
+	/*!
+	 * \brief Notification Statistics
+	 */
+	struct {
+		sccp_mutex_t lock;										/*!< Statistics Lock */
+		uint32_t changes;										/*!< Number of State Changes received */
+		uint32_t notifications;										/*!< Number of Subscriber Notifications sent */
+		long lastLatencyMs;										/*!< Last State Change to Notification Latency */
+		long maxLatencyMs;										/*!< Max State Change to Notification Latency */
+		uint64_t totalLatencyMs;									/*!< Summed State Change to Notification Latency */
+	} statistic;												/*!< Notification Statistics Structure */
+};
+
+/*!
+ * \brief Pending Notification for a Subscribing Device
+ */
+struct sccp_devstate_pendingUpdate 
+{
+	SCCP_LIST_ENTRY (sccp_devstate_pendingUpdate_t) list;
+	sccp_devstate_deviceState_t *deviceState;								/*!< deviceState (retained, current featureState is sent) */
+	char label[StationMaxNameSize];
+	uint8_t instance;											/*!< Instance */
+	struct timeval queued;											/*!< Time the state change was received */
+};
+
+/*!
+ * \brief Per Device Executor
+ *
+ * Collects the pending notifications for one device and delivers them from the general threadpool, with at most one job per
+ * device in flight, so the updates for a device stay ordered and the PBX callback thread never sends to the device itself.
+ * Refcounted: retained by every subscriber of the device and by the queued job.
+ */
+struct sccp_devstate_executor 
+{
+	sccp_mutex_t lock;											/*!< Executor Lock */
+	sccp_device_t *device;											/*!< SCCP Device (retained) */
+	SCCP_LIST_HEAD (, sccp_devstate_pendingUpdate_t) pending;						/*!< Pending Notifications */
+	boolean_t scheduled;											/*!< A job for this executor is queued / running */
+	boolean_t removed;											/*!< Device unregistered, free after the running job */
 };
 
 static SCCP_LIST_HEAD (, struct sccp_devstate_deviceState) deviceStates;
+static sccp_devstate_deviceState_t *deviceStateHash[SCCP_DEVSTATE_HASH_SIZE];				/*!< deviceState hash table, protected by the deviceStates lock */
 
 void sccp_devstate_deviceRegisterListener(const sccp_event_t * event);
 sccp_devstate_deviceState_t *sccp_devstate_createDeviceStateHandler(const char *devstate);
@@ -53,14 +105,19 @@ void sccp_devstate_changed_cb(void *data, struct stasis_subscription *sub, struc
 #else
 void sccp_devstate_changed_cb(const struct ast_event *ast_event, void *data);
 #endif
-void sccp_devstate_removeSubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_device_t * device);
+sccp_devstate_executor_t *sccp_devstate_removeSubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_device_t * device);
 void sccp_devstate_notifySubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_devstate_SubscribingDevice_t * subscriber);
-void sccp_devstate_addSubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_device_t * device, sccp_buttonconfig_t * buttonConfig);
+void sccp_devstate_addSubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_device_t * device, sccp_buttonconfig_t * buttonConfig, sccp_devstate_executor_t * executor);
+static void sccp_devstate_sendFeatureState(const sccp_device_t * device, uint8_t instance, const char *label, uint32_t featureState);
+static int __sccp_devstate_deviceState_destroy(const void *ptr);
+static sccp_devstate_executor_t *sccp_devstate_executor_create(const sccp_device_t * device);
+static void sccp_devstate_executor_queue(sccp_devstate_executor_t * executor, sccp_devstate_deviceState_t * deviceState, const sccp_devstate_SubscribingDevice_t * subscriber, struct timeval queued);
 
 void sccp_devstate_module_start(void)
 {
 	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "SCCP: Starting devstate system\n");
 	SCCP_LIST_HEAD_INIT(&deviceStates);
+	memset(deviceStateHash, 0, sizeof(deviceStateHash));
 	sccp_event_subscribe(SCCP_EVENT_DEVICE_REGISTERED | SCCP_EVENT_DEVICE_UNREGISTERED, sccp_devstate_deviceRegisterListener, TRUE);
 }
 
@@ -77,12 +134,14 @@ void sccp_devstate_module_stop(void)
 
 			SCCP_LIST_LOCK(&deviceState->subscribers);
 			while ((subscriber = SCCP_LIST_REMOVE_HEAD(&deviceState->subscribers, list))) {
+				sccp_devstate_executor_release(&subscriber->executor);		/* explicit release */
 				sccp_device_release(&subscriber->device);		/* explicit release */
+				sccp_free(subscriber);
 			}
 			SCCP_LIST_UNLOCK(&deviceState->subscribers);
-			SCCP_LIST_HEAD_DESTROY(&deviceState->subscribers);
-			sccp_free(deviceState);
+			sccp_devstate_deviceState_release(&deviceState);			/* explicit release, freed after the last queued notification */
 		}
+		memset(deviceStateHash, 0, sizeof(deviceStateHash));
 		SCCP_LIST_UNLOCK(&deviceStates);
 	}
 
@@ -94,6 +153,7 @@ static void sccp_devstate_deviceRegistered(const sccp_device_t * device)
 {
 	sccp_buttonconfig_t *config;
 	sccp_devstate_deviceState_t *deviceState;
+	sccp_devstate_executor_t *executor = NULL;
 
 	AUTO_RELEASE(sccp_device_t, d , sccp_device_retain((sccp_device_t *) device));
 
@@ -108,10 +168,16 @@ static void sccp_devstate_deviceRegistered(const sccp_device_t * device)
 				SCCP_LIST_UNLOCK(&deviceStates);
 
 				if (deviceState) {
-					sccp_devstate_addSubscriber(deviceState, device, config);
+					if (!executor && !(executor = sccp_devstate_executor_create(d))) {
+						return;
+					}
+					sccp_devstate_addSubscriber(deviceState, device, config, executor);
 				}
 			}
 		}
+		if (executor) {
+			sccp_devstate_executor_release(&executor);					/* explicit release of the creation reference, subscribers hold their own */
+		}
 	}
 }
 
@@ -119,6 +185,7 @@ static void sccp_devstate_deviceUnRegistered(const sccp_device_t * device)
 {
 	sccp_buttonconfig_t *config;
 	sccp_devstate_deviceState_t *deviceState;
+	sccp_devstate_executor_t *executor = NULL;
 
 	AUTO_RELEASE(sccp_device_t, d , sccp_device_retain((sccp_device_t *) device));
 
@@ -128,7 +195,12 @@ static void sccp_devstate_deviceUnRegistered(const sccp_device_t * device)
 				SCCP_LIST_LOCK(&deviceStates);
 				deviceState = sccp_devstate_getDeviceStateHandler(config->button.feature.options);
 				if (deviceState) {
-					sccp_devstate_removeSubscriber(deviceState, device);
+					if ((executor = sccp_devstate_removeSubscriber(deviceState, device))) {
+						sccp_mutex_lock(&executor->lock);
+						executor->removed = TRUE;				/* drop pending notifications for this device */
+						sccp_mutex_unlock(&executor->lock);
+						sccp_devstate_executor_release(&executor);		/* explicit release */
+					}
 				}
 				SCCP_LIST_UNLOCK(&deviceStates);
 			}
@@ -159,6 +231,10 @@ void sccp_devstate_deviceRegisterListener(const sccp_event_t * event)
 	}
 }
 
+/*!
+ * \brief Find the deviceState Handler
+ * \note called with deviceStates locked, case insensitive lookup through the deviceState hash table
+ */
 sccp_devstate_deviceState_t * __PURE__ sccp_devstate_getDeviceStateHandler(const char *devstate)
 {
 	if (!devstate) {
@@ -167,7 +243,7 @@ sccp_devstate_deviceState_t * __PURE__ sccp_devstate_getDeviceStateHandler(const
 
 	sccp_devstate_deviceState_t *deviceState = NULL;
 
-	SCCP_LIST_TRAVERSE(&deviceStates, deviceState, list) {
+	for (deviceState = deviceStateHash[sccp_strcasehash(devstate, SCCP_DEVSTATE_HASH_SIZE)]; deviceState; deviceState = deviceState->hashNext) {
 		if (!strncasecmp(devstate, deviceState->devicestate, sizeof(deviceState->devicestate))) {
 			break;
 		}
@@ -176,6 +252,10 @@ sccp_devstate_deviceState_t * __PURE__ sccp_devstate_getDeviceStateHandler(const
 	return deviceState;
 }
 
+/*!
+ * \brief Create a deviceState Handler
+ * \note called with deviceStates locked
+ */
 sccp_devstate_deviceState_t *sccp_devstate_createDeviceStateHandler(const char *devstate)
 {
 	if (!devstate) {
@@ -184,16 +264,18 @@ sccp_devstate_deviceState_t *sccp_devstate_createDeviceStateHandler(const char *
 
 	sccp_devstate_deviceState_t *deviceState = NULL;
 	char buf[256] = "";
+	unsigned int bucket;
 
 	snprintf(buf, 254, "Custom:%s", devstate);
 	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_4 "%s: (sccp_devstate_createDeviceStateHandler) create handler for %s/%s\n", "SCCP", devstate, buf);
 
-	deviceState = sccp_calloc(sizeof *deviceState, 1);
+	deviceState = (sccp_devstate_deviceState_t *) sccp_refcount_object_alloc(sizeof *deviceState, SCCP_REF_DEVSTATE, devstate, __sccp_devstate_deviceState_destroy);
 	if (!deviceState) {
 		pbx_log(LOG_ERROR, "Memory Allocation for deviceState failed!\n");
 		return NULL;
 	}
 	SCCP_LIST_HEAD_INIT(&deviceState->subscribers);
+	pbx_mutex_init(&deviceState->statistic.lock);								/* initial reference is held by the deviceStates list */
 	sccp_copy_string(deviceState->devicestate, devstate, sizeof(deviceState->devicestate));
 #if ASTERISK_VERSION_GROUP >= 112
 	struct stasis_topic *devstate_specific_topic = ast_device_state_topic((const char *)buf);
@@ -204,58 +286,229 @@ sccp_devstate_deviceState_t *sccp_devstate_createDeviceStateHandler(const char *
 	deviceState->featureState = (ast_device_state(buf) == AST_DEVICE_NOT_INUSE) ? 0 : 1;
 
 	SCCP_LIST_INSERT_HEAD(&deviceStates, deviceState, list);
+	bucket = sccp_strcasehash(deviceState->devicestate, SCCP_DEVSTATE_HASH_SIZE);
+	deviceState->hashNext = deviceStateHash[bucket];
+	deviceStateHash[bucket] = deviceState;
 	return deviceState;
 }
 
-void sccp_devstate_addSubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_device_t * device, sccp_buttonconfig_t * buttonConfig)
+void sccp_devstate_addSubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_device_t * device, sccp_buttonconfig_t * buttonConfig, sccp_devstate_executor_t * executor)
 {
 	sccp_devstate_SubscribingDevice_t *subscriber;
 
 	subscriber = sccp_calloc(sizeof *subscriber, 1);
+	if (!subscriber) {
+		pbx_log(LOG_ERROR, "Memory Allocation for devstate subscriber failed!\n");
+		return;
+	}
 	subscriber->device = sccp_device_retain((sccp_device_t *) device);
 	subscriber->instance = buttonConfig->instance;
 	subscriber->buttonConfig = buttonConfig;
 	subscriber->buttonConfig->button.feature.status = deviceState->featureState;
 	sccp_copy_string(subscriber->label, buttonConfig->label, sizeof(subscriber->label));
+	subscriber->executor = sccp_devstate_executor_retain(executor);
 
+	SCCP_LIST_LOCK(&deviceState->subscribers);
 	SCCP_LIST_INSERT_HEAD(&deviceState->subscribers, subscriber, list);
+	SCCP_LIST_UNLOCK(&deviceState->subscribers);
 	sccp_devstate_notifySubscriber(deviceState, subscriber);						/* set initial state */
 }
 
-void sccp_devstate_removeSubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_device_t * device)
+/*!
+ * \brief Remove the subscriptions of a device from a deviceState
+ * \return executor of the removed subscriber(s), with one reference held for the caller (or NULL)
+ */
+sccp_devstate_executor_t *sccp_devstate_removeSubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_device_t * device)
 {
 	sccp_devstate_SubscribingDevice_t *subscriber = NULL;
+	sccp_devstate_executor_t *executor = NULL;
 
+	SCCP_LIST_LOCK(&deviceState->subscribers);
 	SCCP_LIST_TRAVERSE_SAFE_BEGIN(&deviceState->subscribers, subscriber, list) {
 		if (subscriber->device == device) {
 			SCCP_LIST_REMOVE_CURRENT(list);
+			if (executor) {
+				sccp_devstate_executor_release(&subscriber->executor);		/* explicit release */
+			} else {
+				executor = subscriber->executor;					/* hand over the subscriber reference */
+			}
 			sccp_device_release(&subscriber->device);				/* explicit release */
+			sccp_free(subscriber);
 		}
 
 	}
 	SCCP_LIST_TRAVERSE_SAFE_END;
+	SCCP_LIST_UNLOCK(&deviceState->subscribers);
+	return executor;
 }
 
-void sccp_devstate_notifySubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_devstate_SubscribingDevice_t * subscriber)
+static void sccp_devstate_sendFeatureState(const sccp_device_t * device, uint8_t instance, const char *label, uint32_t featureState)
 {
-	pbx_assert(subscriber->device != NULL);
+	pbx_assert(device != NULL);
 	sccp_msg_t *msg = NULL;
 
-	if (subscriber->device->inuseprotocolversion >= 15) {
+	if (device->inuseprotocolversion >= 15) {
 		REQ(msg, FeatureStatDynamicMessage);
-		msg->data.FeatureStatDynamicMessage.lel_featureIndex = htolel(subscriber->instance);
+		msg->data.FeatureStatDynamicMessage.lel_featureIndex = htolel(instance);
 		msg->data.FeatureStatDynamicMessage.lel_featureID = htolel(SKINNY_BUTTONTYPE_FEATURE);
-		msg->data.FeatureStatDynamicMessage.lel_featureStatus = htolel(deviceState->featureState);
-		sccp_copy_string(msg->data.FeatureStatDynamicMessage.featureTextLabel, subscriber->label, sizeof(msg->data.FeatureStatDynamicMessage.featureTextLabel));
+		msg->data.FeatureStatDynamicMessage.lel_featureStatus = htolel(featureState);
+		sccp_copy_string(msg->data.FeatureStatDynamicMessage.featureTextLabel, label, sizeof(msg->data.FeatureStatDynamicMessage.featureTextLabel));
 	} else {
 		REQ(msg, FeatureStatMessage);
-		msg->data.FeatureStatMessage.lel_featureIndex = htolel(subscriber->instance);
+		msg->data.FeatureStatMessage.lel_featureIndex = htolel(instance);
 		msg->data.FeatureStatMessage.lel_featureID = htolel(SKINNY_BUTTONTYPE_FEATURE);
-		msg->data.FeatureStatMessage.lel_featureStatus = htolel(deviceState->featureState);
-		sccp_copy_string(msg->data.FeatureStatMessage.featureTextLabel, subscriber->label, sizeof(msg->data.FeatureStatMessage.featureTextLabel));
+		msg->data.FeatureStatMessage.lel_featureStatus = htolel(featureState);
+		sccp_copy_string(msg->data.FeatureStatMessage.featureTextLabel, label, sizeof(msg->data.FeatureStatMessage.featureTextLabel));
 	}
 
-	sccp_dev_send(subscriber->device, msg);
+	sccp_dev_send(device, msg);
+}
+
+void sccp_devstate_notifySubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_devstate_SubscribingDevice_t * subscriber)
+{
+	pbx_assert(subscriber->device != NULL);
+	sccp_devstate_sendFeatureState(subscriber->device, subscriber->instance, subscriber->label, deviceState->featureState);
+}
+
+/*!
+ * \brief deviceState Destructor, called when it has been removed from deviceStates and no notification is queued anymore
+ */
+static int __sccp_devstate_deviceState_destroy(const void *ptr)
+{
+	sccp_devstate_deviceState_t *deviceState = (sccp_devstate_deviceState_t *) ptr;
+
+	SCCP_LIST_HEAD_DESTROY(&deviceState->subscribers);
+	pbx_mutex_destroy(&deviceState->statistic.lock);
+	return 0;
+}
+
+/* ========================================================================================================================= Per Device Executor */
+/*!
+ * \brief Executor Destructor, called when the last reference (subscriber or queued job) is gone
+ */
+static int __sccp_devstate_executor_destroy(const void *ptr)
+{
+	sccp_devstate_executor_t *executor = (sccp_devstate_executor_t *) ptr;
+	sccp_devstate_pendingUpdate_t *update = NULL;
+
+	SCCP_LIST_LOCK(&executor->pending);
+	while ((update = SCCP_LIST_REMOVE_HEAD(&executor->pending, list))) {
+		sccp_devstate_deviceState_release(&update->deviceState);					/* explicit release */
+		sccp_free(update);
+	}
+	SCCP_LIST_UNLOCK(&executor->pending);
+	SCCP_LIST_HEAD_DESTROY(&executor->pending);
+	sccp_device_release(&executor->device);								/* explicit release */
+	pbx_mutex_destroy(&executor->lock);
+	return 0;
+}
+
+static sccp_devstate_executor_t *sccp_devstate_executor_create(const sccp_device_t * device)
+{
+	sccp_devstate_executor_t *executor = (sccp_devstate_executor_t *) sccp_refcount_object_alloc(sizeof *executor, SCCP_REF_DEVSTATEEXECUTOR, device->id, __sccp_devstate_executor_destroy);
+
+	if (!executor) {
+		pbx_log(LOG_ERROR, "Memory Allocation for devstate executor failed!\n");
+		return NULL;
+	}
+	pbx_mutex_init(&executor->lock);
+	SCCP_LIST_HEAD_INIT(&executor->pending);
+	executor->device = sccp_device_retain((sccp_device_t *) device);
+	return executor;
+}
+
+/*!
+ * \brief Executor Job: deliver all pending notifications of one device (threadpool worker)
+ */
+static void *sccp_devstate_executor_run(void *data)
+{
+	sccp_devstate_executor_t *executor = (sccp_devstate_executor_t *) data;
+	sccp_devstate_pendingUpdate_t *update = NULL;
+	boolean_t removed = FALSE;
+	long latencyMs = 0;
+
+	while (TRUE) {
+		SCCP_LIST_LOCK(&executor->pending);
+		update = SCCP_LIST_REMOVE_HEAD(&executor->pending, list);
+		SCCP_LIST_UNLOCK(&executor->pending);
+
+		sccp_mutex_lock(&executor->lock);
+		removed = executor->removed;
+		if (!update) {
+			executor->scheduled = FALSE;
+			sccp_mutex_unlock(&executor->lock);
+			break;
+		}
+		sccp_mutex_unlock(&executor->lock);
+
+		if (!removed && GLOB(module_running)) {
+			sccp_devstate_sendFeatureState(executor->device, update->instance, update->label, update->deviceState->featureState);
+
+			latencyMs = ast_tvdiff_ms(pbx_tvnow(), update->queued);
+			sccp_mutex_lock(&update->deviceState->statistic.lock);
+			update->deviceState->statistic.notifications++;
+			update->deviceState->statistic.lastLatencyMs = latencyMs;
+			update->deviceState->statistic.totalLatencyMs += latencyMs;
+			if (latencyMs > update->deviceState->statistic.maxLatencyMs) {
+				update->deviceState->statistic.maxLatencyMs = latencyMs;
+			}
+			sccp_mutex_unlock(&update->deviceState->statistic.lock);
+		}
+		sccp_devstate_deviceState_release(&update->deviceState);					/* explicit release */
+		sccp_free(update);
+	}
+
+	/* take the job's reference away, frees the executor if the device unregistered in the mean time */
+	sccp_devstate_executor_release(&executor);							/* explicit release */
+	return NULL;
+}
+
+/*!
+ * \brief Queue a notification for a subscriber on its device executor
+ * \note called from the PBX callback thread, only one job per device is queued on the threadpool at any time
+ * \note a notification already pending for the same button is not queued twice, the job always sends the current featureState
+ */
+static void sccp_devstate_executor_queue(sccp_devstate_executor_t * executor, sccp_devstate_deviceState_t * deviceState, const sccp_devstate_SubscribingDevice_t * subscriber, struct timeval queued)
+{
+	sccp_devstate_pendingUpdate_t *update = NULL;
+	boolean_t schedule = FALSE;
+
+	SCCP_LIST_LOCK(&executor->pending);
+	SCCP_LIST_TRAVERSE(&executor->pending, update, list) {
+		if (update->deviceState == deviceState && update->instance == subscriber->instance) {
+			break;
+		}
+	}
+	if (!update && (update = sccp_calloc(sizeof *update, 1))) {
+		if (!(update->deviceState = sccp_devstate_deviceState_retain(deviceState))) {
+			SCCP_LIST_UNLOCK(&executor->pending);
+			sccp_free(update);
+			return;
+		}
+		update->instance = subscriber->instance;
+		update->queued = queued;
+		sccp_copy_string(update->label, subscriber->label, sizeof(update->label));
+		SCCP_LIST_INSERT_TAIL(&executor->pending, update, list);
+	}
+	SCCP_LIST_UNLOCK(&executor->pending);
+
+	sccp_mutex_lock(&executor->lock);
+	if (!executor->scheduled && !executor->removed) {
+		executor->scheduled = TRUE;
+		schedule = TRUE;
+	}
+	sccp_mutex_unlock(&executor->lock);
+	if (schedule && !sccp_devstate_executor_retain(executor)) {						/* reference held by the job */
+		sccp_mutex_lock(&executor->lock);
+		executor->scheduled = FALSE;
+		sccp_mutex_unlock(&executor->lock);
+		return;
+	}
+
+	if (schedule && !(GLOB(general_threadpool) && sccp_threadpool_add_work(GLOB(general_threadpool), (void *) sccp_devstate_executor_run, (void *) executor))) {
+		pbx_log(LOG_WARNING, "%s: (sccp_devstate_executor_queue) Could not add work to threadpool, notifying directly\n", DEV_ID_LOG(executor->device));
+		sccp_devstate_executor_run(executor);
+	}
 }
 
 //void sccp_devstate_changed_cb(const struct ast_event *ast_event, void *data)
@@ -268,6 +521,7 @@ void sccp_devstate_changed_cb(const struct ast_event *ast_event, void *data)
 	sccp_devstate_deviceState_t *deviceState = NULL;
 	sccp_devstate_SubscribingDevice_t *subscriber = NULL;
 	enum ast_device_state state;
+	struct timeval now = pbx_tvnow();
 
 #if ASTERISK_VERSION_GROUP >= 112
 	struct ast_device_state_message *dev_state = stasis_message_data(msg);
@@ -285,12 +539,70 @@ void sccp_devstate_changed_cb(const struct ast_event *ast_event, void *data)
 	deviceState = (sccp_devstate_deviceState_t *) data;
 	deviceState->featureState = (state == AST_DEVICE_NOT_INUSE) ? 0 : 1;
 
+	sccp_mutex_lock(&deviceState->statistic.lock);
+	deviceState->statistic.changes++;
+	sccp_mutex_unlock(&deviceState->statistic.lock);
+
 	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "%s: (sccp_devstate_changed_cb) got new device state for %s, state: %d, deviceState->subscribers.count %d\n", "SCCP", deviceState->devicestate, state, deviceState->subscribers.size);
+	SCCP_LIST_LOCK(&deviceState->subscribers);
 	SCCP_LIST_TRAVERSE(&deviceState->subscribers, subscriber, list) {
-		sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "%s: (sccp_devstate_changed_cb) notify subscriber for state %d\n", DEV_ID_LOG(subscriber->device), deviceState->featureState);
+		sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "%s: (sccp_devstate_changed_cb) queue notification for state %d\n", DEV_ID_LOG(subscriber->device), deviceState->featureState);
 		subscriber->buttonConfig->button.feature.status = deviceState->featureState;
-		sccp_devstate_notifySubscriber(deviceState, subscriber);
+		sccp_devstate_executor_queue(subscriber->executor, deviceState, subscriber, now);
+	}
+	SCCP_LIST_UNLOCK(&deviceState->subscribers);
+}
+
+/*!
+ * \brief Show Device States
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_show_devstates(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	uint32_t changes = 0, notifications = 0;
+	long lastLatencyMs = 0, maxLatencyMs = 0, avgLatencyMs = 0;
+
+#define CLI_AMI_TABLE_NAME DeviceStates
+#define CLI_AMI_TABLE_PER_ENTRY_NAME DeviceState
+#define CLI_AMI_TABLE_LIST_ITER_HEAD &deviceStates
+#define CLI_AMI_TABLE_LIST_ITER_TYPE sccp_devstate_deviceState_t
+#define CLI_AMI_TABLE_LIST_ITER_VAR deviceState
+#define CLI_AMI_TABLE_LIST_LOCK SCCP_LIST_LOCK
+#define CLI_AMI_TABLE_LIST_ITERATOR SCCP_LIST_TRAVERSE
+#define CLI_AMI_TABLE_LIST_UNLOCK SCCP_LIST_UNLOCK
+#define CLI_AMI_TABLE_BEFORE_ITERATION 														\
+		sccp_mutex_lock(&deviceState->statistic.lock);										\
+		changes = deviceState->statistic.changes;										\
+		notifications = deviceState->statistic.notifications;									\
+		lastLatencyMs = deviceState->statistic.lastLatencyMs;									\
+		maxLatencyMs = deviceState->statistic.maxLatencyMs;									\
+		avgLatencyMs = notifications ? (long) (deviceState->statistic.totalLatencyMs / notifications) : 0;			\
+		sccp_mutex_unlock(&deviceState->statistic.lock);
+#define CLI_AMI_TABLE_FIELDS 															\
+ 		CLI_AMI_TABLE_FIELD(DeviceState,	"-30.30",	s,	30,	deviceState->devicestate)				\
+ 		CLI_AMI_TABLE_FIELD(State,		"-5.5",		s,	5,	deviceState->featureState ? "On" : "Off")		\
+ 		CLI_AMI_TABLE_FIELD(Subscribers,	"11",		d,	11,	SCCP_LIST_GETSIZE(&deviceState->subscribers))		\
+ 		CLI_AMI_TABLE_FIELD(Changes,		"8",		u,	8,	changes)						\
+ 		CLI_AMI_TABLE_FIELD(Notifications,	"13",		u,	13,	notifications)						\
+ 		CLI_AMI_TABLE_FIELD(LastMs,		"6",		ld,	6,	lastLatencyMs)						\
+ 		CLI_AMI_TABLE_FIELD(AvgMs,		"6",		ld,	6,	avgLatencyMs)						\
+ 		CLI_AMI_TABLE_FIELD(MaxMs,		"6",		ld,	6,	maxLatencyMs)
+#include "sccp_cli_table.h"
+
+	if (s) {
+		totals->lines = local_line_total;
+		totals->tables = 1;
 	}
+	return RESULT_SUCCESS;
 }
 #endif
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
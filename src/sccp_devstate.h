@@ -7,6 +7,7 @@
  * \since       2013-08-15
  */
 #pragma once
+#include "sccp_cli.h"
 
 __BEGIN_C_EXTERN__
 /*!
@@ -24,6 +25,7 @@ struct sccp_devstate_specifier {
 
 SCCP_API void SCCP_CALL sccp_devstate_module_start(void);
 SCCP_API void SCCP_CALL sccp_devstate_module_stop(void);
+SCCP_API int SCCP_CALL sccp_show_devstates(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
 #endif
 __END_C_EXTERN__
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -1317,6 +1317,14 @@ void sccp_feat_adhocDial(constDevicePtr d, constLinePtr line)
 void sccp_feat_changed(constDevicePtr device, const sccp_linedevices_t * const linedevice, sccp_feature_type_t featureType)
 {
 	if (device) {
+		if (SCCP_FEATURE_DND == featureType) {
+			uint8_t instance;
+			for (instance = SCCP_FIRST_LINEINSTANCE; instance < device->lineButtons.size; instance++) {
+				if (device->lineButtons.instance[instance]) {
+					sccp_linedevice_updateDNDCounter(device->lineButtons.instance[instance]);
+				}
+			}
+		}
 		sccp_featButton_changed(device, featureType);
 
 		sccp_event_t event = {{{0}}};
@@ -137,7 +137,11 @@ struct sccp_global_vars {
 #ifdef CS_SCCP_REALTIME
 	char *realtimedevicetable;										/*!< Database Table Name for SCCP Devices */
 	char *realtimelinetable;											/*!< Database Table Name for SCCP Lines */
+	uint16_t realtimecachettl;										/*!< Seconds Realtime Lookups are Cached */
+	boolean_t realtimepreload;										/*!< Build all Realtime Lines and Devices at Startup */
 #endif
+	boolean_t incrementalreload;										/*!< Only reapply Device and Line Sections which changed during Reload */
+	boolean_t configsnapshot;										/*!< Write a Snapshot of the parsed Config, used on the next Module Load */
 	char used_context[SCCP_MAX_EXTENSION];									/*!< placeholder to check if context are already used in regcontext (DUNDI) */
 
 	char *config_file_name;											/*!< SCCP Config File Name in Use */
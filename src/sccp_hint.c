@@ -110,17 +110,55 @@ struct sccp_hint_list {
 	SCCP_LIST_ENTRY (sccp_hint_list_t) list;								/*!< Hint Type Linked List Entry */
 };														/*!< SCCP Hint List Structure */
 
+/*!
+ * \brief SCCP Hint Subscription Batch Structure
+ * \note one batch per registering device, processed by the general threadpool
+ */
+typedef struct sccp_hint_subscriptionBatch {
+	sccp_device_t *device;											/*!< SCCP Device (retained) */
+	uint32_t registrationGeneration;									/*!< Device Registration this batch was queued for */
+	struct timeval queued;											/*!< Time the batch was queued (registration) */
+	uint16_t size;												/*!< Number of Entries */
+	struct {
+		char hintStr[SCCP_MAX_EXTENSION + SCCP_MAX_CONTEXT + 2];					/*!< Hint as exten[@context] */
+		uint8_t instance;										/*!< Instance */
+		uint8_t positionOnDevice;									/*!< Button Position on Device */
+		sccp_hint_list_t *hint;										/*!< Resolved Hint */
+		sccp_hint_list_t *discard;									/*!< Hint created by this batch, but created by another thread first */
+		boolean_t created;										/*!< Hint was created by this batch (owned by this entry) */
+		sccp_hint_SubscribingDevice_t *subscriber;							/*!< Created Subscriber */
+	} entries[];												/*!< Batch Entries */
+} sccp_hint_subscriptionBatch_t;										/*!< SCCP Hint Subscription Batch Structure */
+
+/*!
+ * \brief SCCP Hint Subscription Batch Statistics
+ * \note protected by the sccp_hint_subscriptions lock
+ */
+static struct {
+	uint32_t batches;											/*!< Number of Processed Batches (Registrations) */
+	uint32_t subscriptions;											/*!< Number of Subscriptions Added */
+	uint32_t hintsCreated;											/*!< Number of Hints Created */
+	long lastReadyMs;											/*!< Last time-to-BLF-ready in ms */
+	long maxReadyMs;											/*!< Max time-to-BLF-ready in ms */
+	uint64_t totalReadyMs;											/*!< Summed time-to-BLF-ready in ms */
+} sccp_hint_batchStatistics;
+
 /* ========================================================================================================================= Declarations */
 static void sccp_hint_updateLineState(struct sccp_hint_lineState *lineState);
 static void sccp_hint_updateLineStateForMultipleChannels(struct sccp_hint_lineState *lineState);
 static void sccp_hint_updateLineStateForSingleChannel(struct sccp_hint_lineState *lineState);
 static void sccp_hint_checkForDND(struct sccp_hint_lineState *lineState);
 static sccp_hint_list_t *sccp_hint_create(char *hint_exten, char *hint_context);
+static void sccp_hint_notifySubscriber(sccp_hint_list_t * hint, sccp_hint_SubscribingDevice_t * subscriber);
 static void sccp_hint_notifySubscribers(sccp_hint_list_t * hint);			/* old */
 static void sccp_hint_notifyLineStateUpdate(struct sccp_hint_lineState *linestate); 	/* new */
 static void sccp_hint_deviceRegistered(const sccp_device_t * device);
 static void sccp_hint_deviceUnRegistered(const char *deviceName);
-static void sccp_hint_addSubscription4Device(const sccp_device_t * device, const char *hintStr, const uint8_t instance, const uint8_t positionOnDevice);
+static void *sccp_hint_processSubscriptionBatch(void *data);
+static sccp_hint_list_t *sccp_hint_find(const sccp_device_t * device, const char *hintStr);
+static sccp_hint_list_t *sccp_hint_createFromHintStr(const sccp_device_t * device, const char *hintStr);
+static void sccp_hint_destroy(sccp_hint_list_t * hint);
+static sccp_hint_SubscribingDevice_t *sccp_hint_addSubscription4Device(const sccp_device_t * device, sccp_hint_list_t * hint, const uint8_t instance, const uint8_t positionOnDevice);
 static void sccp_hint_attachLine(sccp_line_t * line, sccp_device_t * device);
 static void sccp_hint_detachLine(sccp_line_t * line, sccp_device_t * device);
 static void sccp_hint_lineStatusChanged(sccp_line_t * line, sccp_device_t * device);
@@ -202,6 +240,7 @@ void sccp_hint_module_start(void)
 	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "SCCP: Starting hint system\n");
 	SCCP_LIST_HEAD_INIT(&lineStates);
 	SCCP_LIST_HEAD_INIT(&sccp_hint_subscriptions);
+	memset(&sccp_hint_batchStatistics, 0, sizeof(sccp_hint_batchStatistics));
 	sccp_event_subscribe(SCCP_EVENT_DEVICE_REGISTERED | SCCP_EVENT_DEVICE_UNREGISTERED | SCCP_EVENT_DEVICE_DETACHED | SCCP_EVENT_DEVICE_ATTACHED | SCCP_EVENT_LINESTATUS_CHANGED, sccp_hint_eventListener, TRUE);
 	sccp_event_subscribe(SCCP_EVENT_FEATURE_CHANGED, sccp_hint_handleFeatureChangeEvent, TRUE);
 #ifdef CS_USE_ASTERISK_DISTRIBUTED_DEVSTATE
@@ -235,11 +274,6 @@ void sccp_hint_module_stop(void)
 
 		SCCP_LIST_LOCK(&sccp_hint_subscriptions);
 		while ((hint = SCCP_LIST_REMOVE_HEAD(&sccp_hint_subscriptions, list))) {
-#ifdef CS_USE_ASTERISK_DISTRIBUTED_DEVSTATE
-			pbx_event_unsubscribe(hint->device_state_sub);
-#endif
-			ast_extension_state_del(hint->stateid, NULL);
-
 			// All subscriptions that have this device should be removed, force cleanup 
 			SCCP_LIST_LOCK(&hint->subscribers);
 			while ((subscriber = SCCP_LIST_REMOVE_HEAD(&hint->subscribers, list))) {
@@ -251,9 +285,7 @@ void sccp_hint_module_stop(void)
 				}
 			}
 			SCCP_LIST_UNLOCK(&hint->subscribers);
-			SCCP_LIST_HEAD_DESTROY(&hint->subscribers);
-			iCallInfo.Destructor(&hint->callInfo);
-			sccp_free(hint);
+			sccp_hint_destroy(hint);
 		}
 		SCCP_LIST_UNLOCK(&sccp_hint_subscriptions);
 	}
@@ -316,17 +348,7 @@ static int sccp_hint_devstate_cb(char *context, char *id, enum ast_extension_sta
 #endif
 
 	if (hint->callInfo) {
-		if (hint->calltype == SKINNY_CALLTYPE_INBOUND) {
-			iCallInfo.Getter(hint->callInfo, 
-				SCCP_CALLINFO_CALLINGPARTY_NAME, &cidName, 
-				SCCP_CALLINFO_CALLINGPARTY_NUMBER, &cidNumber, 
-				SCCP_CALLINFO_KEY_SENTINEL);
-		} else {
-			iCallInfo.Getter(hint->callInfo, 
-				SCCP_CALLINFO_CALLEDPARTY_NAME, &cidName, 
-				SCCP_CALLINFO_CALLEDPARTY_NUMBER, &cidNumber, 
-				SCCP_CALLINFO_KEY_SENTINEL);
-		}
+		iCallInfo.GetParty(hint->callInfo, (hint->calltype == SKINNY_CALLTYPE_INBOUND) ? SCCP_CALLINFO_PARTY_CALLING : SCCP_CALLINFO_PARTY_CALLED, cidName, cidNumber, NULL);
 	}
 
 	/* save previousState */
@@ -430,6 +452,9 @@ static void sccp_hint_eventListener(const sccp_event_t * event)
  * \brief Handle Hints for Device Register
  * \param device SCCP Device
  * 
+ * Collects all hinted speeddials of the device into a single subscription batch and hands it to the general threadpool,
+ * so that creating hints / extension state watchers does not happen on the registration path, one speeddial at a time.
+ *
  * \note device locked by parent
  * 
  * \warning
@@ -438,19 +463,198 @@ static void sccp_hint_eventListener(const sccp_event_t * event)
 static void sccp_hint_deviceRegistered(const sccp_device_t * device)
 {
 	sccp_buttonconfig_t *config;
+	sccp_hint_subscriptionBatch_t *batch = NULL;
 	uint8_t positionOnDevice = 0;
+	uint16_t size = 0;
 
 	AUTO_RELEASE(sccp_device_t, d , sccp_device_retain((sccp_device_t *) device));
 
-	if (d) {
-		SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
-			positionOnDevice++;
+	if (!d) {
+		return;
+	}
+	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+		if (config->type == SPEEDDIAL && !sccp_strlen_zero(config->button.speeddial.hint)) {
+			size++;
+		}
+	}
+	if (!size) {
+		return;
+	}
 
-			if (config->type == SPEEDDIAL && !sccp_strlen_zero(config->button.speeddial.hint)) {
-				sccp_hint_addSubscription4Device(device, config->button.speeddial.hint, config->instance, positionOnDevice);
+	batch = sccp_calloc(sizeof *batch + size * sizeof(batch->entries[0]), 1);
+	if (!batch) {
+		pbx_log(LOG_ERROR, "%s (hint_deviceRegistered) Memory Allocation Error while creating subscription batch\n", DEV_ID_LOG(d));
+		return;
+	}
+	batch->queued = pbx_tvnow();
+	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+		positionOnDevice++;
+
+		if (config->type == SPEEDDIAL && !sccp_strlen_zero(config->button.speeddial.hint) && batch->size < size) {
+			sccp_copy_string(batch->entries[batch->size].hintStr, config->button.speeddial.hint, sizeof(batch->entries[batch->size].hintStr));
+			batch->entries[batch->size].instance = config->instance;
+			batch->entries[batch->size].positionOnDevice = positionOnDevice;
+			batch->size++;
+		}
+	}
+	batch->device = sccp_device_retain(d);
+	batch->registrationGeneration = sccp_device_getRegistrationGeneration(d);
+
+	sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_3 "%s (hint_deviceRegistered) Queueing %d hint subscription(s)\n", DEV_ID_LOG(d), batch->size);
+	if (GLOB(general_threadpool) && sccp_threadpool_add_work(GLOB(general_threadpool), (void *) sccp_hint_processSubscriptionBatch, (void *) batch)) {
+		return;
+	}
+	pbx_log(LOG_WARNING, "%s (hint_deviceRegistered) Could not add subscription batch to threadpool, processing it directly\n", DEV_ID_LOG(d));
+	sccp_hint_processSubscriptionBatch(batch);
+}
+
+/*!
+ * \brief Check that a Subscription Batch still belongs to the current registration of its device
+ * \param batch Subscription Batch
+ * \return TRUE when the device is registered and has not re-registered since the batch was queued
+ */
+static boolean_t sccp_hint_isSubscriptionBatchCurrent(const sccp_hint_subscriptionBatch_t * batch)
+{
+	return GLOB(module_running) && batch->device && sccp_device_getRegistrationState(batch->device) == SKINNY_DEVICE_RS_OK && sccp_device_getRegistrationGeneration(batch->device) == batch->registrationGeneration;
+}
+
+/*!
+ * \brief Process a Hint Subscription Batch (threadpool worker)
+ * \param data Subscription Batch (sccp_hint_subscriptionBatch_t *) as void pointer
+ *
+ * The entries are resolved in three steps:
+ *  - the existing hints are looked up under the sccp_hint_subscriptions lock;
+ *  - the missing hints are created without holding it, because sccp_hint_create registers the extension state / devstate
+ *    callbacks with the pbx and runs the devstate callback. A hint shared by multiple speeddials of the batch is created once;
+ *  - the lock is taken again to link the new hints and the subscribers. A hint that another thread created in the meantime
+ *    wins, and the copy created by this batch is destroyed after the lock has been released.
+ *
+ * The completion step then sends the current state of every subscribed hint to this device only, instead of notifying all
+ * subscribers of each hint again, and records the time-to-BLF-ready.
+ *
+ * A batch queued for an earlier registration of the device (the device re-registered before the batch got processed) is
+ * dropped, the batch of the new registration will add the subscribers instead.
+ *
+ * \note releases the batch and the device it retains
+ */
+static void *sccp_hint_processSubscriptionBatch(void *data)
+{
+	sccp_hint_subscriptionBatch_t *batch = (sccp_hint_subscriptionBatch_t *) data;
+	sccp_hint_SubscribingDevice_t *subscriber = NULL;
+	sccp_hint_SubscribingDevice_t *current = NULL;
+	uint16_t idx;
+	uint16_t prev;
+	uint16_t subscribed = 0;
+	uint16_t created = 0;
+	long readyMs = 0;
+
+	if (!batch) {
+		return NULL;
+	}
+
+	if (!sccp_hint_isSubscriptionBatchCurrent(batch)) {
+		sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_3 "%s (hint_processSubscriptionBatch) Device no longer registered (or re-registered), skipping %d hint subscription(s)\n", DEV_ID_LOG(batch->device), batch->size);
+		batch->size = 0;
+	}
+
+	/* look up the existing hints */
+	SCCP_LIST_LOCK(&sccp_hint_subscriptions);
+	for (idx = 0; idx < batch->size; idx++) {
+		batch->entries[idx].hint = sccp_hint_find(batch->device, batch->entries[idx].hintStr);
+	}
+	SCCP_LIST_UNLOCK(&sccp_hint_subscriptions);
+
+	/* create the missing ones, without holding the sccp_hint_subscriptions lock */
+	for (idx = 0; idx < batch->size; idx++) {
+		if (batch->entries[idx].hint) {
+			continue;
+		}
+		for (prev = 0; prev < idx; prev++) {
+			if (batch->entries[prev].created && sccp_strequals(batch->entries[prev].hintStr, batch->entries[idx].hintStr)) {
+				batch->entries[idx].hint = batch->entries[prev].hint;
+				break;
+			}
+		}
+		if (!batch->entries[idx].hint && (batch->entries[idx].hint = sccp_hint_createFromHintStr(batch->device, batch->entries[idx].hintStr))) {
+			batch->entries[idx].created = TRUE;
+		}
+	}
+
+	/* link the new hints and the subscribers */
+	SCCP_LIST_LOCK(&sccp_hint_subscriptions);
+	for (idx = 0; idx < batch->size; idx++) {
+		if (batch->entries[idx].created) {
+			sccp_hint_list_t *existing = sccp_hint_find(batch->device, batch->entries[idx].hintStr);
+
+			if (existing) {									/* created by another thread (or another entry) in the meantime */
+				batch->entries[idx].discard = batch->entries[idx].hint;
+				for (prev = idx; prev < batch->size; prev++) {
+					if (batch->entries[prev].hint == batch->entries[idx].discard) {
+						batch->entries[prev].hint = existing;
+					}
+				}
+			} else {
+				SCCP_LIST_INSERT_HEAD(&sccp_hint_subscriptions, batch->entries[idx].hint, list);
+				created++;
 			}
 		}
 	}
+	if (sccp_hint_isSubscriptionBatchCurrent(batch)) {
+		for (idx = 0; idx < batch->size; idx++) {
+			if (!batch->entries[idx].hint) {
+				continue;
+			}
+			if ((batch->entries[idx].subscriber = sccp_hint_addSubscription4Device(batch->device, batch->entries[idx].hint, batch->entries[idx].instance, batch->entries[idx].positionOnDevice))) {
+				subscribed++;
+			}
+		}
+	}
+	SCCP_LIST_UNLOCK(&sccp_hint_subscriptions);
+
+	for (idx = 0; idx < batch->size; idx++) {
+		if (batch->entries[idx].discard) {
+			sccp_hint_destroy(batch->entries[idx].discard);
+		}
+	}
+
+	/* completion: bulk update of all keysets and lamps on this device, outside of the sccp_hint_subscriptions lock */
+	if (subscribed && sccp_hint_isSubscriptionBatchCurrent(batch)) {
+		for (idx = 0; idx < batch->size; idx++) {
+			if (!(subscriber = batch->entries[idx].subscriber)) {
+				continue;
+			}
+			SCCP_LIST_LOCK(&batch->entries[idx].hint->subscribers);
+			SCCP_LIST_TRAVERSE(&batch->entries[idx].hint->subscribers, current, list) {
+				if (current == subscriber) {						/* not removed by a concurrent unregister */
+					break;
+				}
+			}
+			if (current) {
+				sccp_dev_set_keyset(batch->device, subscriber->instance, 0, KEYMODE_ONHOOK);
+				sccp_hint_notifySubscriber(batch->entries[idx].hint, subscriber);
+			}
+			SCCP_LIST_UNLOCK(&batch->entries[idx].hint->subscribers);
+		}
+
+		readyMs = ast_tvdiff_ms(pbx_tvnow(), batch->queued);
+		SCCP_LIST_LOCK(&sccp_hint_subscriptions);
+		sccp_hint_batchStatistics.batches++;
+		sccp_hint_batchStatistics.subscriptions += subscribed;
+		sccp_hint_batchStatistics.hintsCreated += created;
+		sccp_hint_batchStatistics.lastReadyMs = readyMs;
+		sccp_hint_batchStatistics.totalReadyMs += readyMs;
+		if (readyMs > sccp_hint_batchStatistics.maxReadyMs) {
+			sccp_hint_batchStatistics.maxReadyMs = readyMs;
+		}
+		SCCP_LIST_UNLOCK(&sccp_hint_subscriptions);
+		sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_3 "%s (hint_processSubscriptionBatch) %d/%d hint subscription(s) ready (%d new hint(s)), time-to-BLF-ready: %ld ms\n", DEV_ID_LOG(batch->device), subscribed, batch->size, created, readyMs);
+	}
+
+	if (batch->device) {
+		sccp_device_release(&batch->device);						/* explicit release */
+	}
+	sccp_free(batch);
+	return NULL;
 }
 
 /*!
@@ -484,80 +688,110 @@ static void sccp_hint_deviceUnRegistered(const char *deviceName)
 }
 
 /*!
- * \brief Subscribe to a Hint
- * \param device SCCP Device
- * \param hintStr Asterisk Hint Name as char
- * \param instance Instance as int
- * \param positionOnDevice button index on device (used to detect devicetype)
- * 
- * \warning
- *  - sccp_hint_subscriptions is not always locked
- * 
- * \note called with retained device
+ * \brief Split a Hint String into exten and context
+ * \param hintStr Asterisk Hint Name as char (exten[@context])
+ * \param buffer Buffer to split the hint string in
+ * \param size Size of buffer
+ * \param hint_exten Hint Extension (Returned by Ref, points into buffer)
+ * \param hint_context Hint Context (Returned by Ref, points into buffer or GLOB(context))
  */
-static void sccp_hint_addSubscription4Device(const sccp_device_t * device, const char *hintStr, const uint8_t instance, const uint8_t positionOnDevice)
+static void sccp_hint_splitHintStr(const char *hintStr, char *buffer, size_t size, char **hint_exten, char **hint_context)
 {
-	sccp_hint_list_t *hint = NULL;
+	char *splitter;
 
-	char buffer[256] = "";
-	char *splitter, *hint_exten, *hint_context;
-
-	sccp_copy_string(buffer, hintStr, sizeof(buffer));
+	sccp_copy_string(buffer, hintStr, size);
 
 	/* get exten and context */
 	splitter = buffer;
-	hint_exten = strsep(&splitter, "@");
-	if (hint_exten) {
-		pbx_strip(hint_exten);
+	*hint_exten = strsep(&splitter, "@");
+	if (*hint_exten) {
+		pbx_strip(*hint_exten);
 	}
-	hint_context = splitter;
-	if (hint_context) {
-		pbx_strip(hint_context);
+	*hint_context = splitter;
+	if (*hint_context) {
+		pbx_strip(*hint_context);
 	} else {
-		hint_context = GLOB(context);
+		*hint_context = GLOB(context);
 	}
+}
+
+/*!
+ * \brief Find the Hint for a Hint String
+ * \param device SCCP Device (only used for logging)
+ * \param hintStr Asterisk Hint Name as char (exten[@context])
+ * \return SCCP Hint Linked List Pointer or NULL
+ *
+ * \note called with sccp_hint_subscriptions locked
+ */
+static sccp_hint_list_t *sccp_hint_find(const sccp_device_t * device, const char *hintStr)
+{
+	sccp_hint_list_t *hint = NULL;
 
-	/* skip subscribtions to already owned line */
-	/*      sccp_buttonconfig_t *config;
-	   SCCP_LIST_TRAVERSE(&device->buttonconfig, config, list) {
-	   if (config->type == LINE && sccp_strcaseequals(config->button.line.name, hint_exten)) {
-	   sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_3 "%s (hint_addSubscription4Device) Skipping Hint Registration for Line we already have this connected (%s, %s).\n", DEV_ID_LOG(device), config->button.line.name, hint_exten);
-	   return;
-	   }
-	   } */
-	sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_3 "%s (hint_addSubscription4Device) Dialplan %s for exten: %s and context: %s\n", DEV_ID_LOG(device), hintStr, hint_exten, hint_context);
+	char buffer[256] = "";
+	char *hint_exten, *hint_context;
+
+	sccp_hint_splitHintStr(hintStr, buffer, sizeof(buffer), &hint_exten, &hint_context);
+	sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_3 "%s (hint_find) Dialplan %s for exten: %s and context: %s\n", DEV_ID_LOG(device), hintStr, hint_exten, hint_context);
 
 	SCCP_LIST_TRAVERSE(&sccp_hint_subscriptions, hint, list) {
 		if (sccp_strlen(hint_exten) == sccp_strlen(hint->exten)
 		    && sccp_strlen(hint_context) == sccp_strlen(hint->context)
 		    && sccp_strequals(hint_exten, hint->exten)
 		    && sccp_strequals(hint_context, hint->context)) {
-			sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s (hint_addSubscription4Device) Hint found for exten '%s@%s'\n", DEV_ID_LOG(device), hint_exten, hint_context);
-			break;
+			sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s (hint_find) Hint found for exten '%s@%s'\n", DEV_ID_LOG(device), hint_exten, hint_context);
+			return hint;
 		}
 	}
+	return NULL;
+}
+
+/*!
+ * \brief Create the Hint for a Hint String
+ * \param device SCCP Device (only used for logging)
+ * \param hintStr Asterisk Hint Name as char (exten[@context])
+ * \return SCCP Hint Linked List Pointer (not linked into sccp_hint_subscriptions yet) or NULL
+ *
+ * \note must be called without sccp_hint_subscriptions locked, sccp_hint_create registers the extension state / devstate
+ * callbacks with the pbx and runs the devstate callback
+ */
+static sccp_hint_list_t *sccp_hint_createFromHintStr(const sccp_device_t * device, const char *hintStr)
+{
+	sccp_hint_list_t *hint = NULL;
+
+	char buffer[256] = "";
+	char *hint_exten, *hint_context;
+
+	sccp_hint_splitHintStr(hintStr, buffer, sizeof(buffer), &hint_exten, &hint_context);
 
 	/* we have no hint */
-	if (!hint) {
-		sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s (hint_addSubscription4Device) create new hint for %s@%s\n", DEV_ID_LOG(device), hint_exten, hint_context);
-		hint = sccp_hint_create(hint_exten, hint_context);
-		if (!hint) {
-			pbx_log(LOG_NOTICE, "%s (hint_addSubscription4Device) hint create failed for %s@%s\n", DEV_ID_LOG(device), hint_exten, hint_context);
-			return;
-		}
-		SCCP_LIST_LOCK(&sccp_hint_subscriptions);
-		SCCP_LIST_INSERT_HEAD(&sccp_hint_subscriptions, hint, list);
-		SCCP_LIST_UNLOCK(&sccp_hint_subscriptions);
+	sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s (hint_createFromHintStr) create new hint for %s@%s\n", DEV_ID_LOG(device), hint_exten, hint_context);
+	if (!(hint = sccp_hint_create(hint_exten, hint_context))) {
+		pbx_log(LOG_NOTICE, "%s (hint_createFromHintStr) hint create failed for %s@%s\n", DEV_ID_LOG(device), hint_exten, hint_context);
 	}
+	return hint;
+}
 
-	/* add subscribing device */
-	sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s (hint_addSubscription4Device) create subscriber or hint: %s in %s\n", DEV_ID_LOG(device), hint->exten, hint->context);
+/*!
+ * \brief Subscribe to a Hint
+ * \param device SCCP Device
+ * \param hint SCCP Hint Linked List Pointer
+ * \param instance Instance as int
+ * \param positionOnDevice button index on device (used to detect devicetype)
+ * \return SCCP Hint Subscribing Device or NULL
+ * 
+ * \note called with retained device and sccp_hint_subscriptions locked
+ * \note does not notify the new subscriber, this is done by the completion step of the subscription batch
+ */
+static sccp_hint_SubscribingDevice_t *sccp_hint_addSubscription4Device(const sccp_device_t * device, sccp_hint_list_t * hint, const uint8_t instance, const uint8_t positionOnDevice)
+{
 	sccp_hint_SubscribingDevice_t *subscriber;
 
+	/* add subscribing device */
+	sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s (hint_addSubscription4Device) create subscriber or hint: %s in %s\n", DEV_ID_LOG(device), hint->exten, hint->context);
 	subscriber = sccp_calloc(sizeof *subscriber, 1);
 	if (!subscriber) {
 		pbx_log(LOG_ERROR, "%s (hint_addSubscription4Device) Memory Allocation Error while creating subscriber object\n", DEV_ID_LOG(device));
-		return;
+		return NULL;
 	}
 
 	subscriber->device = sccp_device_retain((sccp_device_t *) device);
@@ -565,11 +799,11 @@ static void sccp_hint_addSubscription4Device(const sccp_device_t * device, const
 	subscriber->positionOnDevice = positionOnDevice;
 
 	sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s (hint_addSubscription4Device) Adding subscription for hint %s@%s\n", DEV_ID_LOG(device), hint->exten, hint->context);
+	SCCP_LIST_LOCK(&hint->subscribers);
 	SCCP_LIST_INSERT_HEAD(&hint->subscribers, subscriber, list);
+	SCCP_LIST_UNLOCK(&hint->subscribers);
 
-	sccp_dev_set_keyset(device, subscriber->instance, 0, KEYMODE_ONHOOK);
-
-	sccp_hint_notifySubscribers(hint);
+	return subscriber;
 }
 
 /*!
@@ -653,6 +887,21 @@ static sccp_hint_list_t *sccp_hint_create(char *hint_exten, char *hint_context)
 	return hint;
 }
 
+/*!
+ * \brief destroy a hint structure
+ * \param hint SCCP Hint Linked List Pointer (already removed from sccp_hint_subscriptions, without subscribers)
+ */
+static void sccp_hint_destroy(sccp_hint_list_t * hint)
+{
+#ifdef CS_USE_ASTERISK_DISTRIBUTED_DEVSTATE
+	pbx_event_unsubscribe(hint->device_state_sub);
+#endif
+	ast_extension_state_del(hint->stateid, NULL);
+	SCCP_LIST_HEAD_DESTROY(&hint->subscribers);
+	iCallInfo.Destructor(&hint->callInfo);
+	sccp_free(hint);
+}
+
 /* ========================================================================================================================= Event Handlers : LineState */
 static void sccp_hint_attachLine(sccp_line_t * line, sccp_device_t * device) 
 {
@@ -801,19 +1050,7 @@ static void sccp_hint_updateLineStateForMultipleChannels(struct sccp_hint_lineSt
 					sccp_callerid_presentation_t presentation = CALLERID_PRESENTATION_ALLOWED;
 
 					/* set cid name/numbe information according to the call direction */
-					if (SKINNY_CALLTYPE_INBOUND == channel->calltype) {
-						iCallInfo.Getter(ci, 
-							SCCP_CALLINFO_CALLINGPARTY_NAME, &cid_name, 
-							SCCP_CALLINFO_CALLINGPARTY_NUMBER, &cid_num, 
-							SCCP_CALLINFO_PRESENTATION, &presentation, 
-							SCCP_CALLINFO_KEY_SENTINEL);
-					} else {
-						iCallInfo.Getter(ci, 
-							SCCP_CALLINFO_CALLEDPARTY_NAME, &cid_name, 
-							SCCP_CALLINFO_CALLEDPARTY_NUMBER, &cid_num, 
-							SCCP_CALLINFO_PRESENTATION, &presentation, 
-							SCCP_CALLINFO_KEY_SENTINEL);
-					}
+					iCallInfo.GetParty(ci, (SKINNY_CALLTYPE_INBOUND == channel->calltype) ? SCCP_CALLINFO_PARTY_CALLING : SCCP_CALLINFO_PARTY_CALLED, cid_name, cid_num, &presentation);
 					if (presentation == CALLERID_PRESENTATION_FORBIDDEN) {
 						sccp_copy_string(lineState->callInfo.partyName, SKINNY_DISP_PRIVATE, sizeof(lineState->callInfo.partyName));
 						sccp_copy_string(lineState->callInfo.partyNumber, SKINNY_DISP_PRIVATE, sizeof(lineState->callInfo.partyNumber));
@@ -931,19 +1168,11 @@ static void sccp_hint_updateLineStateForSingleChannel(struct sccp_hint_lineState
 				/** set cid name/number information according to the call direction */
 				switch (channel->calltype) {
 					case SKINNY_CALLTYPE_INBOUND:
-						iCallInfo.Getter(ci, 
-							SCCP_CALLINFO_CALLINGPARTY_NAME, &cid_name, 
-							SCCP_CALLINFO_CALLINGPARTY_NUMBER, &cid_num, 
-							SCCP_CALLINFO_PRESENTATION, &presentation, 
-							SCCP_CALLINFO_KEY_SENTINEL);
+						iCallInfo.GetParty(ci, SCCP_CALLINFO_PARTY_CALLING, cid_name, cid_num, &presentation);
 						sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s: get speeddial party: '%s <%s>' (callingParty)\n", line->name, cid_name, cid_num);
 						break;
 					case SKINNY_CALLTYPE_OUTBOUND:
-						iCallInfo.Getter(ci, 
-							SCCP_CALLINFO_CALLEDPARTY_NAME, &cid_name, 
-							SCCP_CALLINFO_CALLEDPARTY_NUMBER, &cid_num, 
-							SCCP_CALLINFO_PRESENTATION, &presentation, 
-							SCCP_CALLINFO_KEY_SENTINEL);
+						iCallInfo.GetParty(ci, SCCP_CALLINFO_PARTY_CALLED, cid_name, cid_num, &presentation);
 						sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s: get speeddial party: '%s <%s>' (calledParty)\n", line->name, cid_name, cid_num);
 						break;
 					case SKINNY_CALLTYPE_FORWARD:
@@ -1101,213 +1330,219 @@ static enum ast_device_state sccp_hint_hint2DeviceState(sccp_channelstate_t stat
 
 /* ========================================================================================================================= Subscriber Notify : Updates Speeddial */
 /*!
- * \brief send hint status to subscriber
+ * \brief send hint status to a single subscriber
  * \param hint SCCP Hint Linked List Pointer
+ * \param subscriber SCCP Hint Subscribing Device
  *
- * \todo Check if the actual device still exists while going throughthe hint->subscribers and not pointing at rubish
+ * \note called with hint->subscribers locked
  */
-static void sccp_hint_notifySubscribers(sccp_hint_list_t * hint)
+static void sccp_hint_notifySubscriber(sccp_hint_list_t * hint, sccp_hint_SubscribingDevice_t * subscriber)
 {
-	sccp_hint_SubscribingDevice_t *subscriber = NULL;
+	AUTO_RELEASE(sccp_device_t, d , sccp_device_retain((sccp_device_t *) subscriber->device));
 
-	if (!hint) {
-		pbx_log(LOG_ERROR, "SCCP: (sccp_hint_notifySubscribers) no hint provided to notifySubscribers about\n");
-		return;
-	}
+	if (d) {
+		//sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s (hint_notifySubscribers) notify subscriber %s of %s's state %s (%d)\n", DEV_ID_LOG(d), d->id, hint->hint_dialplan, sccp_channelstate2str(hint->currentState), hint->currentState);
+#ifdef CS_DYNAMIC_SPEEDDIAL
+		sccp_msg_t *msg = NULL;
+		const sccp_speed_t *k = NULL;
+		const char *speeddialName = "unknown speeddial";
+		char displayMessage[80] = "";
+		skinny_busylampfield_state_t status = SKINNY_BLF_STATUS_UNKNOWN;
+		if (d->inuseprotocolversion >= 15) {
+			AUTO_RELEASE(sccp_buttonindex_t, buttonIndex , sccp_dev_getButtonIndex(d));
+			if ((k = sccp_dev_speedButton_find_byindex(buttonIndex, subscriber->instance, TRUE))) {
+				speeddialName = k->name;
+			}
 
-	if (!GLOB(module_running) || SCCP_REF_RUNNING != sccp_refcount_isRunning()) {
-		sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_3 "%s (hint_notifySubscribers) Skip processing hint while we are shutting down.\n", hint->exten);
-		return;
-	}
+			char cidName[StationMaxNameSize] = "";
+			char cidNumber[StationMaxDirnumSize] = "";
 
-	sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_3 "%s (hint_notifySubscribers) notify %u subscriber(s) of %s's state %s\n", hint->exten, SCCP_LIST_GETSIZE(&hint->subscribers), hint->hint_dialplan, sccp_channelstate2str(hint->currentState));
+			switch (hint->currentState) {
+			case SCCP_CHANNELSTATE_DOWN:
+				snprintf(displayMessage, sizeof(displayMessage), "%s", speeddialName);
+				status = SKINNY_BLF_STATUS_UNKNOWN;	/* default state */
+				break;
 
-	SCCP_LIST_LOCK(&hint->subscribers);
-	SCCP_LIST_TRAVERSE(&hint->subscribers, subscriber, list) {
-		AUTO_RELEASE(sccp_device_t, d , sccp_device_retain((sccp_device_t *) subscriber->device));
+			case SCCP_CHANNELSTATE_ONHOOK:
+				snprintf(displayMessage, sizeof(displayMessage), "%s", speeddialName);
+				status = SKINNY_BLF_STATUS_IDLE;
+				break;
 
-		if (d) {
-			//sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s (hint_notifySubscribers) notify subscriber %s of %s's state %s (%d)\n", DEV_ID_LOG(d), d->id, hint->hint_dialplan, sccp_channelstate2str(hint->currentState), hint->currentState);
-#ifdef CS_DYNAMIC_SPEEDDIAL
-			sccp_msg_t *msg = NULL;
-			sccp_speed_t k;
-			char displayMessage[80] = "";
-			skinny_busylampfield_state_t status = SKINNY_BLF_STATUS_UNKNOWN;
-			if (d->inuseprotocolversion >= 15) {
-				sccp_dev_speed_find_byindex( d, subscriber->instance, TRUE, &k);
+			case SCCP_CHANNELSTATE_DND:
+				//snprintf(displayMessage, sizeof(displayMessage), k.name, sizeof(displayMessage));
+				snprintf(displayMessage, sizeof(displayMessage), "(DND) %s", speeddialName);
+				status = SKINNY_BLF_STATUS_DND;	/* dnd */
+				break;
 
-				char cidName[StationMaxNameSize] = "";
-				char cidNumber[StationMaxDirnumSize] = "";
+			case SCCP_CHANNELSTATE_CONGESTION:
+				snprintf(displayMessage, sizeof(displayMessage), "%s", speeddialName);
+				status = SKINNY_BLF_STATUS_UNKNOWN;	/* device/line not found */
+				break;
 
-				switch (hint->currentState) {
-				case SCCP_CHANNELSTATE_DOWN:
+			case SCCP_CHANNELSTATE_RINGING:
+				status = SKINNY_BLF_STATUS_ALERTING;	/* ringin */
+				/* fall through */
+
+			default:
+#ifdef CS_DYNAMIC_SPEEDDIAL
+				if (sccp_hint_isCIDavailabe(d, subscriber->positionOnDevice) == TRUE) {
+					iCallInfo.GetParty(hint->callInfo, (hint->calltype == SKINNY_CALLTYPE_INBOUND) ? SCCP_CALLINFO_PARTY_CALLING : SCCP_CALLINFO_PARTY_CALLED, cidName, cidNumber, NULL);
+					if (strlen(cidName) > 0) {
+						snprintf(displayMessage, sizeof(displayMessage), "%s %s %s", cidName, (SCCP_CHANNELSTATE_CONNECTED == hint->currentState) ? "<=>" : ((hint->calltype == SKINNY_CALLTYPE_OUTBOUND) ? "<-" : "->"), speeddialName);
+					} else if (strlen(cidNumber) > 0) {
+						snprintf(displayMessage, sizeof(displayMessage), "%s %s %s", cidNumber, (SCCP_CHANNELSTATE_CONNECTED == hint->currentState) ? "<=>" : ((hint->calltype == SKINNY_CALLTYPE_OUTBOUND) ? "<-" : "->"), speeddialName);
+					} else {
+						snprintf(displayMessage, sizeof(displayMessage), "%s", speeddialName);
+					}
+				} else 
+#endif
+				{
 					snprintf(displayMessage, sizeof(displayMessage), "%s", k.name);
-					status = SKINNY_BLF_STATUS_UNKNOWN;	/* default state */
-					break;
+				}
+				if (status == SKINNY_BLF_STATUS_UNKNOWN) {	/* still default value --> set */
+					status = SKINNY_BLF_STATUS_INUSE;
+				}
+				break;
+			}
 
+			sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s (hint_notifySubscribers) notify device: %s@%d, displayMessage:%s, state: %s ->  %s\n", hint->exten, DEV_ID_LOG(d), subscriber->instance, displayMessage, sccp_channelstate2str(hint->currentState), skinny_busylampfield_state2str(status)); 
+			/*!
+			* hack to fix the white text without shadow issue -MC
+			*
+			* first send a label which is 1-character shorter than the correct one. 
+			* then send another message with a longer label (correct/final label) will force an update (in white over the back drop in black)
+			*/
+			REQ(msg, FeatureStatDynamicMessage);
+			if (msg) {
+				sccp_copy_string(msg->data.FeatureStatDynamicMessage.featureTextLabel, displayMessage, sizeof(msg->data.FeatureStatDynamicMessage.featureTextLabel));
+				msg->data.FeatureStatDynamicMessage.lel_featureIndex = htolel(subscriber->instance);
+				msg->data.FeatureStatDynamicMessage.lel_featureID = htolel(SKINNY_BUTTONTYPE_BLFSPEEDDIAL);
+				msg->data.FeatureStatDynamicMessage.lel_featureStatus = htolel(status);
+				msg->data.FeatureStatDynamicMessage.featureTextLabel[strlen(displayMessage)-1] = '\0';
+				sccp_dev_send(d, msg);
+			} else {
+				sccp_free(msg);
+			}
+
+			/*!
+			 * Send the actual message we wanted to send */
+			REQ(msg, FeatureStatDynamicMessage);
+			if (msg) {
+				sccp_copy_string(msg->data.FeatureStatDynamicMessage.featureTextLabel, displayMessage, sizeof(msg->data.FeatureStatDynamicMessage.featureTextLabel));
+				msg->data.FeatureStatDynamicMessage.lel_featureIndex = htolel(subscriber->instance);
+				msg->data.FeatureStatDynamicMessage.lel_featureID = htolel(SKINNY_BUTTONTYPE_BLFSPEEDDIAL);
+				msg->data.FeatureStatDynamicMessage.lel_featureStatus = htolel(status);
+				sccp_dev_send(d, msg);
+			} else {
+				sccp_free(msg);
+			}
+		} else
+#endif
+		{
+			/*
+			   we have dynamic speeddial enabled, but subscriber can not handle this.
+			   We have to switch back to old hint style and send old state.
+			 */
+			sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s (hint_notifySubscribers) can not handle dynamic speeddial, fall back to old behavior using state %s (%d)\n", DEV_ID_LOG(d), sccp_channelstate2str(hint->currentState), hint->currentState);
+
+			/*
+			   With the old hint style we should only use SCCP_CHANNELSTATE_ONHOOK and SCCP_CHANNELSTATE_CALLREMOTEMULTILINE as callstate,
+			   otherwise we get a callplane on device -> set all states except onhook to SCCP_CHANNELSTATE_CALLREMOTEMULTILINE -MC
+			 */
+			skinny_callstate_t iconstate = SKINNY_CALLSTATE_CALLREMOTEMULTILINE;
+
+			switch (hint->currentState) {
+				case SCCP_CHANNELSTATE_DOWN:
 				case SCCP_CHANNELSTATE_ONHOOK:
-					snprintf(displayMessage, sizeof(displayMessage), "%s", k.name);
-					status = SKINNY_BLF_STATUS_IDLE;
+					iconstate = SKINNY_CALLSTATE_ONHOOK;
 					break;
-
-				case SCCP_CHANNELSTATE_DND:
-					//snprintf(displayMessage, sizeof(displayMessage), k.name, sizeof(displayMessage));
-					snprintf(displayMessage, sizeof(displayMessage), "(DND) %s", k.name);
-					status = SKINNY_BLF_STATUS_DND;	/* dnd */
+				case SCCP_CHANNELSTATE_RINGING:
+					if (d->allowRinginNotification) {
+						iconstate = SKINNY_CALLSTATE_RINGIN;
+					}
 					break;
-
+				case SCCP_CHANNELSTATE_ZOMBIE:
 				case SCCP_CHANNELSTATE_CONGESTION:
-					snprintf(displayMessage, sizeof(displayMessage), "%s", k.name);
-					status = SKINNY_BLF_STATUS_UNKNOWN;	/* device/line not found */
+				case SCCP_CHANNELSTATE_CONNECTED:
+				case SCCP_CHANNELSTATE_OFFHOOK:
+				case SCCP_CHANNELSTATE_RINGOUT:
+				case SCCP_CHANNELSTATE_RINGOUT_ALERTING:
+				case SCCP_CHANNELSTATE_BUSY:
+				case SCCP_CHANNELSTATE_HOLD:
+				case SCCP_CHANNELSTATE_CALLWAITING:
+				case SCCP_CHANNELSTATE_CALLPARK:
+				case SCCP_CHANNELSTATE_PROCEED:
+				case SCCP_CHANNELSTATE_CALLREMOTEMULTILINE:
+				case SCCP_CHANNELSTATE_INVALIDNUMBER:
+				case SCCP_CHANNELSTATE_DIALING:
+				case SCCP_CHANNELSTATE_PROGRESS:
+				case SCCP_CHANNELSTATE_GETDIGITS:
+				case SCCP_CHANNELSTATE_SPEEDDIAL:
+				case SCCP_CHANNELSTATE_DIGITSFOLL:
+				case SCCP_CHANNELSTATE_INVALIDCONFERENCE:
+				case SCCP_CHANNELSTATE_CONNECTEDCONFERENCE:
+				case SCCP_CHANNELSTATE_BLINDTRANSFER:
+				case SCCP_CHANNELSTATE_DND:
+				case SCCP_CHANNELSTATE_CALLTRANSFER:
+				case SCCP_CHANNELSTATE_CALLCONFERENCE:
+					iconstate = SKINNY_CALLSTATE_CALLREMOTEMULTILINE;
 					break;
+				case SCCP_CHANNELSTATE_SENTINEL:
+					break;
+			}
+			sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s (hint_notifySubscribers) setting icon to state %s (%d)\n", DEV_ID_LOG(d), skinny_callstate2str(iconstate), iconstate);
 
-				case SCCP_CHANNELSTATE_RINGING:
-					status = SKINNY_BLF_STATUS_ALERTING;	/* ringin */
-					/* fall through */
+			if (SCCP_CHANNELSTATE_RINGING == hint->previousState) {
+				/* we send a congestion to the phone, so call will not be marked as missed call */
+				sccp_device_sendcallstate(d, subscriber->instance, 0, SKINNY_CALLSTATE_CONGESTION, SKINNY_CALLPRIORITY_NORMAL, SKINNY_CALLINFO_VISIBILITY_HIDDEN);
+			}
 
-				default:
-#ifdef CS_DYNAMIC_SPEEDDIAL
-					if (sccp_hint_isCIDavailabe(d, subscriber->positionOnDevice) == TRUE) {
-						if (hint->calltype == SKINNY_CALLTYPE_INBOUND) {
-							iCallInfo.Getter(hint->callInfo, 
-								SCCP_CALLINFO_CALLINGPARTY_NAME, &cidName, 
-								SCCP_CALLINFO_CALLINGPARTY_NUMBER, &cidNumber, 
-								SCCP_CALLINFO_KEY_SENTINEL);
-						} else {
-							iCallInfo.Getter(hint->callInfo, 
-								SCCP_CALLINFO_CALLEDPARTY_NAME, &cidName, 
-								SCCP_CALLINFO_CALLEDPARTY_NUMBER, &cidNumber, 
-								SCCP_CALLINFO_KEY_SENTINEL);
-						}
-						if (strlen(cidName) > 0) {
-							snprintf(displayMessage, sizeof(displayMessage), "%s %s %s", cidName, (SCCP_CHANNELSTATE_CONNECTED == hint->currentState) ? "<=>" : ((hint->calltype == SKINNY_CALLTYPE_OUTBOUND) ? "<-" : "->"), k.name);
-						} else if (strlen(cidNumber) > 0) {
-							snprintf(displayMessage, sizeof(displayMessage), "%s %s %s", cidNumber, (SCCP_CHANNELSTATE_CONNECTED == hint->currentState) ? "<=>" : ((hint->calltype == SKINNY_CALLTYPE_OUTBOUND) ? "<-" : "->"), k.name);
-						} else {
-							snprintf(displayMessage, sizeof(displayMessage), "%s", k.name);
-						}
-					} else 
-#endif
-					{
-						snprintf(displayMessage, sizeof(displayMessage), "%s", k.name);
-					}
-					if (status == SKINNY_BLF_STATUS_UNKNOWN) {	/* still default value --> set */
-						status = SKINNY_BLF_STATUS_INUSE;
-					}
-					break;
-				}
+			sccp_device_sendcallstate(d, subscriber->instance, 0, iconstate, SKINNY_CALLPRIORITY_NORMAL, SKINNY_CALLINFO_VISIBILITY_DEFAULT); /** do not set visibility to COLLAPSED, this will hidde callInfo in state CALLREMOTEMULTILINE */
 
-				sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s (hint_notifySubscribers) notify device: %s@%d, displayMessage:%s, state: %s ->  %s\n", hint->exten, DEV_ID_LOG(d), subscriber->instance, displayMessage, sccp_channelstate2str(hint->currentState), skinny_busylampfield_state2str(status)); 
-				/*!
-				* hack to fix the white text without shadow issue -MC
-				*
-				* first send a label which is 1-character shorter than the correct one. 
-				* then send another message with a longer label (correct/final label) will force an update (in white over the back drop in black)
-				*/
-				REQ(msg, FeatureStatDynamicMessage);
-				if (msg) {
-					sccp_copy_string(msg->data.FeatureStatDynamicMessage.featureTextLabel, displayMessage, sizeof(msg->data.FeatureStatDynamicMessage.featureTextLabel));
-					msg->data.FeatureStatDynamicMessage.lel_featureIndex = htolel(subscriber->instance);
-					msg->data.FeatureStatDynamicMessage.lel_featureID = htolel(SKINNY_BUTTONTYPE_BLFSPEEDDIAL);
-					msg->data.FeatureStatDynamicMessage.lel_featureStatus = htolel(status);
-					msg->data.FeatureStatDynamicMessage.featureTextLabel[strlen(displayMessage)-1] = '\0';
-					sccp_dev_send(d, msg);
-				} else {
-					sccp_free(msg);
-				}
+			if (hint->currentState == SCCP_CHANNELSTATE_ONHOOK || hint->currentState == SCCP_CHANNELSTATE_CONGESTION) {
+				sccp_device_setLamp(d, SKINNY_STIMULUS_LINE, subscriber->instance, SKINNY_LAMP_OFF);
+				sccp_dev_set_keyset(d, subscriber->instance, 0, KEYMODE_ONHOOK);
 
-				/*!
-				 * Send the actual message we wanted to send */
-				REQ(msg, FeatureStatDynamicMessage);
-				if (msg) {
-					sccp_copy_string(msg->data.FeatureStatDynamicMessage.featureTextLabel, displayMessage, sizeof(msg->data.FeatureStatDynamicMessage.featureTextLabel));
-					msg->data.FeatureStatDynamicMessage.lel_featureIndex = htolel(subscriber->instance);
-					msg->data.FeatureStatDynamicMessage.lel_featureID = htolel(SKINNY_BUTTONTYPE_BLFSPEEDDIAL);
-					msg->data.FeatureStatDynamicMessage.lel_featureStatus = htolel(status);
-					sccp_dev_send(d, msg);
-				} else {
-					sccp_free(msg);
-				}
-			} else
-#endif
-			{
-				/*
-				   we have dynamic speeddial enabled, but subscriber can not handle this.
-				   We have to switch back to old hint style and send old state.
-				 */
-				sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s (hint_notifySubscribers) can not handle dynamic speeddial, fall back to old behavior using state %s (%d)\n", DEV_ID_LOG(d), sccp_channelstate2str(hint->currentState), hint->currentState);
-
-				/*
-				   With the old hint style we should only use SCCP_CHANNELSTATE_ONHOOK and SCCP_CHANNELSTATE_CALLREMOTEMULTILINE as callstate,
-				   otherwise we get a callplane on device -> set all states except onhook to SCCP_CHANNELSTATE_CALLREMOTEMULTILINE -MC
-				 */
-				skinny_callstate_t iconstate = SKINNY_CALLSTATE_CALLREMOTEMULTILINE;
-
-				switch (hint->currentState) {
-					case SCCP_CHANNELSTATE_DOWN:
-					case SCCP_CHANNELSTATE_ONHOOK:
-						iconstate = SKINNY_CALLSTATE_ONHOOK;
-						break;
-					case SCCP_CHANNELSTATE_RINGING:
-						if (d->allowRinginNotification) {
-							iconstate = SKINNY_CALLSTATE_RINGIN;
-						}
-						break;
-					case SCCP_CHANNELSTATE_ZOMBIE:
-					case SCCP_CHANNELSTATE_CONGESTION:
-					case SCCP_CHANNELSTATE_CONNECTED:
-					case SCCP_CHANNELSTATE_OFFHOOK:
-					case SCCP_CHANNELSTATE_RINGOUT:
-					case SCCP_CHANNELSTATE_RINGOUT_ALERTING:
-					case SCCP_CHANNELSTATE_BUSY:
-					case SCCP_CHANNELSTATE_HOLD:
-					case SCCP_CHANNELSTATE_CALLWAITING:
-					case SCCP_CHANNELSTATE_CALLPARK:
-					case SCCP_CHANNELSTATE_PROCEED:
-					case SCCP_CHANNELSTATE_CALLREMOTEMULTILINE:
-					case SCCP_CHANNELSTATE_INVALIDNUMBER:
-					case SCCP_CHANNELSTATE_DIALING:
-					case SCCP_CHANNELSTATE_PROGRESS:
-					case SCCP_CHANNELSTATE_GETDIGITS:
-					case SCCP_CHANNELSTATE_SPEEDDIAL:
-					case SCCP_CHANNELSTATE_DIGITSFOLL:
-					case SCCP_CHANNELSTATE_INVALIDCONFERENCE:
-					case SCCP_CHANNELSTATE_CONNECTEDCONFERENCE:
-					case SCCP_CHANNELSTATE_BLINDTRANSFER:
-					case SCCP_CHANNELSTATE_DND:
-					case SCCP_CHANNELSTATE_CALLTRANSFER:
-					case SCCP_CHANNELSTATE_CALLCONFERENCE:
-						iconstate = SKINNY_CALLSTATE_CALLREMOTEMULTILINE;
-						break;
-					case SCCP_CHANNELSTATE_SENTINEL:
-						break;
-				}
-				sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "%s (hint_notifySubscribers) setting icon to state %s (%d)\n", DEV_ID_LOG(d), skinny_callstate2str(iconstate), iconstate);
+			} else if (hint->currentState == SCCP_CHANNELSTATE_RINGING && d->allowRinginNotification) {
+				sccp_device_setLamp(d, SKINNY_STIMULUS_LINE, subscriber->instance, SKINNY_LAMP_BLINK);
+				sccp_dev_set_keyset(d, subscriber->instance, 0, KEYMODE_INUSEHINT);
 
-				if (SCCP_CHANNELSTATE_RINGING == hint->previousState) {
-					/* we send a congestion to the phone, so call will not be marked as missed call */
-					sccp_device_sendcallstate(d, subscriber->instance, 0, SKINNY_CALLSTATE_CONGESTION, SKINNY_CALLPRIORITY_NORMAL, SKINNY_CALLINFO_VISIBILITY_HIDDEN);
-				}
+			} else {
+				iCallInfo.Send(hint->callInfo, 0 /*callid*/, (hint->calltype == SKINNY_CALLTYPE_OUTBOUND) ? SKINNY_CALLTYPE_OUTBOUND : SKINNY_CALLTYPE_INBOUND, subscriber->instance, d, TRUE);
+				sccp_device_setLamp(d, SKINNY_STIMULUS_LINE, subscriber->instance, SKINNY_LAMP_ON);
+				sccp_dev_set_keyset(d, subscriber->instance, 0 /*callid*/, KEYMODE_INUSEHINT);
+			}
+		}
+	} else {
+		sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "SCCP: (sccp_hint_notifySubscribers) device not found/retained\n");
+	}
+}
 
-				sccp_device_sendcallstate(d, subscriber->instance, 0, iconstate, SKINNY_CALLPRIORITY_NORMAL, SKINNY_CALLINFO_VISIBILITY_DEFAULT); /** do not set visibility to COLLAPSED, this will hidde callInfo in state CALLREMOTEMULTILINE */
+/*!
+ * \brief send hint status to subscriber
+ * \param hint SCCP Hint Linked List Pointer
+ *
+ * \todo Check if the actual device still exists while going throughthe hint->subscribers and not pointing at rubish
+ */
+static void sccp_hint_notifySubscribers(sccp_hint_list_t * hint)
+{
+	sccp_hint_SubscribingDevice_t *subscriber = NULL;
 
-				if (hint->currentState == SCCP_CHANNELSTATE_ONHOOK || hint->currentState == SCCP_CHANNELSTATE_CONGESTION) {
-					sccp_device_setLamp(d, SKINNY_STIMULUS_LINE, subscriber->instance, SKINNY_LAMP_OFF);
-					sccp_dev_set_keyset(d, subscriber->instance, 0, KEYMODE_ONHOOK);
+	if (!hint) {
+		pbx_log(LOG_ERROR, "SCCP: (sccp_hint_notifySubscribers) no hint provided to notifySubscribers about\n");
+		return;
+	}
 
-				} else if (hint->currentState == SCCP_CHANNELSTATE_RINGING && d->allowRinginNotification) {
-					sccp_device_setLamp(d, SKINNY_STIMULUS_LINE, subscriber->instance, SKINNY_LAMP_BLINK);
-					sccp_dev_set_keyset(d, subscriber->instance, 0, KEYMODE_INUSEHINT);
+	if (!GLOB(module_running) || SCCP_REF_RUNNING != sccp_refcount_isRunning()) {
+		sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_3 "%s (hint_notifySubscribers) Skip processing hint while we are shutting down.\n", hint->exten);
+		return;
+	}
 
-				} else {
-					iCallInfo.Send(hint->callInfo, 0 /*callid*/, (hint->calltype == SKINNY_CALLTYPE_OUTBOUND) ? SKINNY_CALLTYPE_OUTBOUND : SKINNY_CALLTYPE_INBOUND, subscriber->instance, d, TRUE);
-					sccp_device_setLamp(d, SKINNY_STIMULUS_LINE, subscriber->instance, SKINNY_LAMP_ON);
-					sccp_dev_set_keyset(d, subscriber->instance, 0 /*callid*/, KEYMODE_INUSEHINT);
-				}
-			}
-		} else {
-			sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "SCCP: (sccp_hint_notifySubscribers) device not found/retained\n");
-		}
+	sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_3 "%s (hint_notifySubscribers) notify %u subscriber(s) of %s's state %s\n", hint->exten, SCCP_LIST_GETSIZE(&hint->subscribers), hint->hint_dialplan, sccp_channelstate2str(hint->currentState));
+
+	SCCP_LIST_LOCK(&hint->subscribers);
+	SCCP_LIST_TRAVERSE(&hint->subscribers, subscriber, list) {
+		sccp_hint_notifySubscriber(hint, subscriber);
 	}
 	SCCP_LIST_UNLOCK(&hint->subscribers);
 }
@@ -1456,23 +1691,14 @@ static gcc_inline boolean_t sccp_hint_isCIDavailabe(const sccp_device_t * device
 
 static void sccp_hint_checkForDND(struct sccp_hint_lineState *lineState)
 {
-	sccp_linedevices_t *lineDevice = NULL;
 	sccp_line_t *line = lineState->line;
 
 	do {
 		/* we have to check if all devices on this line are dnd=SCCP_DNDMODE_REJECT, otherwise do not propagate DND status */
-		boolean_t allDevicesInDND = TRUE;
-
-		SCCP_LIST_LOCK(&line->devices);
-		SCCP_LIST_TRAVERSE(&line->devices, lineDevice, list) {
-			if (lineDevice->device && lineDevice->device->dndFeature.status != SCCP_DNDMODE_REJECT) {
-				allDevicesInDND = FALSE;
-				break;
-			}
-		}
-		SCCP_LIST_UNLOCK(&line->devices);
+		sccp_line_stateCounters_t counters;
+		sccp_line_getStateCounters(line, &counters);
 
-		if (allDevicesInDND) {
+		if (counters.dnd >= line->statistic.numberOfActiveDevices) {
 			lineState->callInfo.calltype = SKINNY_CALLTYPE_INBOUND;
 			lineState->state = SCCP_CHANNELSTATE_DND;
 		}
@@ -1544,6 +1770,69 @@ int sccp_show_hint_lineStates(int fd, sccp_cli_totals_t *totals, struct mansessi
 	return RESULT_SUCCESS;
 }
 
+/*!
+ * \brief Check Hint LineState Counters
+ * \param fd Fd as int   
+ * \param total Total number of lines as int
+ * \param s AMI Session 
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \note Compares the incrementally maintained line state counters against a full rescan of line->channels / line->devices. Channels
+ * whose state was set outside sccp_indicate are not accounted for yet, they are skipped and shown in the Skipped column.
+ * 
+ * \called_from_asterisk
+ */
+int sccp_check_hint_lineStates(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	int mismatches = 0;
+
+#define CLI_AMI_TABLE_NAME HintLineStateCounters
+#define CLI_AMI_TABLE_PER_ENTRY_NAME HintLineStateCounter
+#define CLI_AMI_TABLE_LIST_ITER_HEAD &lineStates
+#define CLI_AMI_TABLE_LIST_ITER_TYPE struct sccp_hint_lineState
+#define CLI_AMI_TABLE_LIST_ITER_VAR lineState
+#define CLI_AMI_TABLE_LIST_LOCK SCCP_LIST_LOCK
+#define CLI_AMI_TABLE_LIST_ITERATOR SCCP_LIST_TRAVERSE
+#define CLI_AMI_TABLE_LIST_UNLOCK SCCP_LIST_UNLOCK
+#define CLI_AMI_TABLE_BEFORE_ITERATION														\
+	if (lineState->line) {															\
+		sccp_line_stateCounters_t counters;												\
+		sccp_line_stateCounters_t recount;												\
+		int skipped = 0;														\
+		sccp_line_getStateCounters(lineState->line, &counters);										\
+		sccp_line_recountStateCounters(lineState->line, &recount, &skipped);								\
+		boolean_t consistent = (0 == memcmp(&counters, &recount, sizeof(sccp_line_stateCounters_t))) ? TRUE : FALSE;			\
+		if (!consistent) {														\
+			mismatches++;														\
+		}
+#define CLI_AMI_TABLE_AFTER_ITERATION 														\
+	}
+#define CLI_AMI_TABLE_FIELDS 															\
+ 		CLI_AMI_TABLE_FIELD(LineName,		"-10.10",	s,	10,	lineState->line->name)					\
+ 		CLI_AMI_TABLE_FIELD(Ringing,		"-7",		d,	7,	counters.ringing)					\
+ 		CLI_AMI_TABLE_FIELD(Connected,		"-9",		d,	9,	counters.connected)					\
+ 		CLI_AMI_TABLE_FIELD(Held,		"-4",		d,	4,	counters.held)						\
+ 		CLI_AMI_TABLE_FIELD(InUse,		"-5",		d,	5,	counters.inuse)						\
+ 		CLI_AMI_TABLE_FIELD(DND,		"-3",		d,	3,	counters.dnd)						\
+ 		CLI_AMI_TABLE_FIELD(Skipped,		"-7",		d,	7,	skipped)						\
+ 		CLI_AMI_TABLE_FIELD(Consistent,		"-10.10",	s,	10,	consistent ? "Yes" : "MISMATCH")
+
+#include "sccp_cli_table.h"
+
+	if (mismatches) {
+		pbx_log(LOG_WARNING, "SCCP: (check_hint_lineStates) %d line(s) with inconsistent line state counters\n", mismatches);
+	}
+	if (s) {
+		totals->lines = local_line_total;
+		totals->tables = 1;
+	}
+	return RESULT_SUCCESS;
+}
+
 /*!
  * \brief Show Hint Subscriptions
  * \param fd Fd as int   
@@ -1605,4 +1894,48 @@ int sccp_show_hint_subscriptions(int fd, sccp_cli_totals_t *totals, struct manse
 	return RESULT_SUCCESS;
 }
 
+/*!
+ * \brief Show Hint Subscription Batch Statistics (time-to-BLF-ready)
+ * \param fd Fd as int   
+ * \param totals Total number of lines as int
+ * \param s AMI Session 
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ * 
+ * \called_from_asterisk
+ */
+int sccp_show_hint_statistics(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	const char *actionid = "";
+
+	if (!s) {
+		CLI_AMI_OUTPUT(fd, s, "\n--- SCCP hint subscription statistics ------------------------------------------------------------------------------------\n");
+	} else {
+		astman_append(s, "Response: Success\r\n");
+		astman_append(s, "Message: SCCPHintStatistics\r\n");
+		actionid = astman_get_header(m, "ActionID");
+		if (!pbx_strlen_zero(actionid)) {
+			astman_append(s, "ActionID: %s\r\n", actionid);
+		}
+		local_line_total++;
+	}
+	SCCP_LIST_LOCK(&sccp_hint_subscriptions);
+	CLI_AMI_OUTPUT_PARAM("Hints", CLI_AMI_LIST_WIDTH, "%d", SCCP_LIST_GETSIZE(&sccp_hint_subscriptions));
+	CLI_AMI_OUTPUT_PARAM("Registrations Processed", CLI_AMI_LIST_WIDTH, "%u", sccp_hint_batchStatistics.batches);
+	CLI_AMI_OUTPUT_PARAM("Subscriptions Added", CLI_AMI_LIST_WIDTH, "%u", sccp_hint_batchStatistics.subscriptions);
+	CLI_AMI_OUTPUT_PARAM("Hints Created", CLI_AMI_LIST_WIDTH, "%u", sccp_hint_batchStatistics.hintsCreated);
+	CLI_AMI_OUTPUT_PARAM("Last Time-to-BLF-Ready (ms)", CLI_AMI_LIST_WIDTH, "%ld", sccp_hint_batchStatistics.lastReadyMs);
+	CLI_AMI_OUTPUT_PARAM("Max Time-to-BLF-Ready (ms)", CLI_AMI_LIST_WIDTH, "%ld", sccp_hint_batchStatistics.maxReadyMs);
+	CLI_AMI_OUTPUT_PARAM("Avg Time-to-BLF-Ready (ms)", CLI_AMI_LIST_WIDTH, "%ld", sccp_hint_batchStatistics.batches ? (long) (sccp_hint_batchStatistics.totalReadyMs / sccp_hint_batchStatistics.batches) : 0L);
+	SCCP_LIST_UNLOCK(&sccp_hint_subscriptions);
+
+	if (s) {
+		totals->lines = local_line_total;
+	}
+	return RESULT_SUCCESS;
+}
+
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
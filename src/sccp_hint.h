@@ -15,6 +15,8 @@ SCCP_API void SCCP_CALL sccp_hint_module_start(void);
 SCCP_API void SCCP_CALL sccp_hint_module_stop(void);
 
 SCCP_API int SCCP_CALL sccp_show_hint_lineStates(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+SCCP_API int SCCP_CALL sccp_check_hint_lineStates(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+SCCP_API int SCCP_CALL sccp_show_hint_statistics(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
 SCCP_API int SCCP_CALL sccp_show_hint_subscriptions(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
 __END_C_EXTERN__
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -17,6 +17,7 @@
 #include "sccp_device.h"
 #include "sccp_indicate.h"
 #include "sccp_line.h"
+#include "sccp_mwi.h"
 #include "sccp_utils.h"
 #include "sccp_labels.h"
 
@@ -217,19 +218,11 @@ void __sccp_indicate(const sccp_device_t * const maybe_device, sccp_channel_t *
 				sccp_dev_set_keyset(d, lineInstance, c->callid, KEYMODE_RINGIN);
 				char prompt[100];
 
-				char orig_called_name[StationMaxNameSize] = {0};
-				char orig_called_num[StationMaxDirnumSize] = {0};
-				char calling_name[StationMaxNameSize] = {0};
-				char calling_num[StationMaxDirnumSize] = {0};
-				iCallInfo.Getter(sccp_channel_getCallInfo(c), 
-					SCCP_CALLINFO_ORIG_CALLEDPARTY_NAME, &orig_called_name,
-					SCCP_CALLINFO_ORIG_CALLEDPARTY_NUMBER, &orig_called_num,
-					SCCP_CALLINFO_CALLINGPARTY_NAME, &calling_name, 
-					SCCP_CALLINFO_CALLINGPARTY_NUMBER, &calling_num,
-					SCCP_CALLINFO_KEY_SENTINEL);
-
 				/* GPL - Modify below to expand possible data shown on phone */
 				char caller[100];
+				iCallInfo.RdLock(ci);
+				const char *calling_name = iCallInfo.PeekString(ci, SCCP_CALLINFO_CALLINGPARTY_NAME);
+				const char *calling_num = iCallInfo.PeekString(ci, SCCP_CALLINFO_CALLINGPARTY_NUMBER);
 				if (!sccp_strlen_zero(calling_name)) {
 					if (!sccp_strlen_zero(calling_num)) {
 						snprintf(caller,sizeof(caller), "%s (%s)", calling_name, calling_num);
@@ -243,6 +236,7 @@ void __sccp_indicate(const sccp_device_t * const maybe_device, sccp_channel_t *
 						snprintf(caller,sizeof(caller), "%s", SKINNY_DISP_UNKNOWN_NUMBER);
 					}
 				}
+				iCallInfo.Unlock(ci);
 				snprintf(prompt, sizeof(prompt), "%s%s", (c->ringermode == SKINNY_RINGTYPE_URGENT) ? SKINNY_DISP_FLASH : SKINNY_DISP_FROM, caller);
 				sccp_dev_displayprompt(d, lineInstance, c->callid, prompt, GLOB(digittimeout));
 			}
@@ -433,6 +427,10 @@ void __sccp_indicate(const sccp_device_t * const maybe_device, sccp_channel_t *
 			break;
 	}
 
+	/* account the final channel state in the line state counters (used by the hint DND check) */
+	sccp_line_updateChannelStateCounters(c);
+	sccp_mwi_updateActiveCall(c, FALSE);
+
 	/* if channel state has changed, notify the others */
 	if (d && c->state != c->previousChannelState) {
 		/* if it is a shared line and a state of interest */
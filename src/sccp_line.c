@@ -12,6 +12,7 @@
 
 #include "config.h"
 #include "common.h"
+#include "sccp_atomic.h"
 #include "sccp_channel.h"
 #include "sccp_device.h"
 #include "sccp_line.h"
@@ -19,6 +20,7 @@
 #include "sccp_features.h"
 #include "sccp_mwi.h"
 #include "sccp_utils.h"
+#include "sccp_realtime.h"
 
 SCCP_FILE_VERSION(__FILE__, "");
 
@@ -42,20 +44,30 @@ void sccp_line_pre_reload(void)
 		if (GLOB(hotline)->line == l) {									/* always remove hotline from linedevice */
 			sccp_log((DEBUGCAT_CONFIG + DEBUGCAT_LINE)) (VERBOSE_PREFIX_3 "%s: Removing Hotline from Device\n", l->name);
 			sccp_line_removeDevice(l, NULL);
+			l->pendingUpdate = 0;
 		} else {											/* Don't want to include the hotline line */
-#ifdef CS_SCCP_REALTIME
-			if (l->realtime == FALSE)
-#endif
-			{
-				sccp_log((DEBUGCAT_CONFIG + DEBUGCAT_LINE)) (VERBOSE_PREFIX_3 "%s: Setting Line to Pending Delete=1\n", l->name);
-				l->pendingDelete = 1;
-			}
+			sccp_line_prepareReload(l);
 		}
-		l->pendingUpdate = 0;
 	}
 	SCCP_LIST_TRAVERSE_SAFE_END;
 }
 
+/*!
+ * \brief Mark a single (non hotline) line as pending delete before its section is reapplied
+ * \note used for all lines by sccp_line_pre_reload, and only for changed/removed lines by an incremental reload
+ */
+void sccp_line_prepareReload(linePtr l)
+{
+#ifdef CS_SCCP_REALTIME
+	if (l->realtime == FALSE)
+#endif
+	{
+		sccp_log((DEBUGCAT_CONFIG + DEBUGCAT_LINE)) (VERBOSE_PREFIX_3 "%s: Setting Line to Pending Delete=1\n", l->name);
+		l->pendingDelete = 1;
+	}
+	l->pendingUpdate = 0;
+}
+
 /*!
  * \brief run after the new line config is loaded during the reload process
  * \note See \ref sccp_config_reload
@@ -129,6 +141,52 @@ sccp_line_t *sccp_line_create(const char *name)
 	SCCP_LIST_HEAD_INIT(&l->channels);
 	SCCP_LIST_HEAD_INIT(&l->devices);
 	SCCP_LIST_HEAD_INIT(&l->mailboxes);
+#ifndef SCCP_ATOMIC
+	pbx_mutex_init(&l->stateCounter.lock);
+#endif
+	return l;
+}
+
+/*!
+ * \brief GLOB(lines) Name Index
+ * Case insensitive hash index on line->name, protected by the GLOB(lines) lock
+ * The helpers take the table, so the test framework can exercise a private index
+ */
+static sccp_line_t *sccp_line_nameIndex[SCCP_HASH_PRIME];
+
+static void sccp_line_nameIndexInsert(sccp_line_t **index, sccp_line_t * l)
+{
+	unsigned int bucket = sccp_strcasehash(l->name, SCCP_HASH_PRIME);
+
+	l->hashNext = index[bucket];
+	index[bucket] = l;
+}
+
+static void sccp_line_nameIndexRemove(sccp_line_t **index, const sccp_line_t * l)
+{
+	sccp_line_t **entry = &index[sccp_strcasehash(l->name, SCCP_HASH_PRIME)];
+
+	for (; *entry; entry = &(*entry)->hashNext) {
+		if (*entry == l) {
+			*entry = l->hashNext;
+			break;
+		}
+	}
+}
+
+/*!
+ * \brief Find a line in the GLOB(lines) Name Index
+ * \note needs to be called with GLOB(lines) locked
+ */
+static sccp_line_t * __PURE__ sccp_line_nameIndexFind(sccp_line_t * const *index, const char *name)
+{
+	sccp_line_t *l = NULL;
+
+	for (l = index[sccp_strcasehash(name, SCCP_HASH_PRIME)]; l; l = l->hashNext) {
+		if (sccp_strcaseequals(l->name, name)) {
+			break;
+		}
+	}
 	return l;
 }
 
@@ -149,6 +207,7 @@ void sccp_line_addToGlobals(sccp_line_t * line)
 		/* add to list */
 		sccp_line_retain(l);										/* add retained line to the list */
 		SCCP_RWLIST_INSERT_SORTALPHA(&GLOB(lines), l, list, cid_num);
+		sccp_line_nameIndexInsert(sccp_line_nameIndex, l);
 		sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "Added line '%s' to Glob(lines)\n", l->name);
 
 		/* emit event */
@@ -175,8 +234,15 @@ void sccp_line_removeFromGlobals(sccp_line_t * line)
 	if (line) {
 		SCCP_RWLIST_WRLOCK(&GLOB(lines));
 		removed_line = SCCP_RWLIST_REMOVE(&GLOB(lines), line, list);
+		if (removed_line) {
+			sccp_line_nameIndexRemove(sccp_line_nameIndex, removed_line);
+		}
 		SCCP_RWLIST_UNLOCK(&GLOB(lines));
 
+		if (!removed_line) {
+			return;
+		}
+
 		sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "Removed line '%s' from Glob(lines)\n", removed_line->name);
 
 		//sccp_event_t event = {{{0}}};
@@ -337,6 +403,9 @@ int __sccp_line_destroy(const void *ptr)
 		pbx_log(LOG_WARNING, "%s: (line_destroy) there are connected device left during line destroy\n", l->name);
 	}
 	SCCP_LIST_HEAD_DESTROY(&l->devices);
+#ifndef SCCP_ATOMIC
+	pbx_mutex_destroy(&l->stateCounter.lock);
+#endif
 
 	return 0;
 }
@@ -551,6 +620,8 @@ void sccp_line_addDevice(sccp_line_t * line, sccp_device_t * d, uint8_t lineInst
 
 	linedevice->line->statistic.numberOfActiveDevices++;
 	linedevice->device->configurationStatistic.numberOfLines++;
+	sccp_linedevice_updateDNDCounter(linedevice);
+	sccp_mwi_updateLineDeviceCounts(linedevice, FALSE);
 
 	// fire event for new device
 	sccp_event_t event = {{{0}}};
@@ -591,6 +662,11 @@ void sccp_line_removeDevice(sccp_line_t * l, sccp_device_t * device)
 			regcontext_exten(l, &(linedevice->subscriptionId), 0);
 			SCCP_LIST_REMOVE_CURRENT(list);
 			l->statistic.numberOfActiveDevices--;
+			if (linedevice->countedAsDND) {
+				(void) ATOMIC_DECR(&l->stateCounter.dnd, 1, &l->stateCounter.lock);
+				linedevice->countedAsDND = FALSE;
+			}
+			sccp_mwi_updateLineDeviceCounts(linedevice, TRUE);
 
 			sccp_event_t event = {{{0}}};
 			event.type = SCCP_EVENT_DEVICE_DETACHED;
@@ -600,6 +676,7 @@ void sccp_line_removeDevice(sccp_line_t * l, sccp_device_t * device)
 			sccp_linedevice_release(&linedevice);						/* explicit release of list retained linedevice */
 #ifdef CS_SCCP_REALTIME
 			if (l->realtime && SCCP_LIST_GETSIZE(&l->devices) == 0 && SCCP_LIST_GETSIZE(&l->channels) == 0 ) {
+				sccp_realtime_cache_invalidate(SCCP_REALTIME_CACHE_LINE, l->name);		/* reread the row when the line comes back */
 				sccp_line_removeFromGlobals(l);
 			}
 #endif
@@ -609,6 +686,180 @@ void sccp_line_removeDevice(sccp_line_t * l, sccp_device_t * device)
 	SCCP_LIST_UNLOCK(&l->devices);
 }
 
+/*=================================================================================== STATE COUNTERS ==============*/
+/*!
+ * \brief Map a channel state onto the line state counter it is accounted in
+ */
+static sccp_line_statecounter_t __sccp_line_channelstate2counter(const sccp_channelstate_t state)
+{
+	switch (state) {
+		case SCCP_CHANNELSTATE_DOWN:
+		case SCCP_CHANNELSTATE_ONHOOK:
+		case SCCP_CHANNELSTATE_ZOMBIE:
+		case SCCP_CHANNELSTATE_SENTINEL:
+			return SCCP_LINE_STATECOUNTER_NONE;
+		case SCCP_CHANNELSTATE_RINGING:
+		case SCCP_CHANNELSTATE_CALLWAITING:
+			return SCCP_LINE_STATECOUNTER_RINGING;
+		case SCCP_CHANNELSTATE_CONNECTED:
+		case SCCP_CHANNELSTATE_CONNECTEDCONFERENCE:
+			return SCCP_LINE_STATECOUNTER_CONNECTED;
+		case SCCP_CHANNELSTATE_HOLD:
+			return SCCP_LINE_STATECOUNTER_HELD;
+		default:
+			return SCCP_LINE_STATECOUNTER_INUSE;
+	}
+}
+
+static volatile CAS32_TYPE *__sccp_line_stateCounterPtr(sccp_line_t * l, const sccp_line_statecounter_t counter)
+{
+	switch (counter) {
+		case SCCP_LINE_STATECOUNTER_INUSE:
+			return &l->stateCounter.inuse;
+		case SCCP_LINE_STATECOUNTER_RINGING:
+			return &l->stateCounter.ringing;
+		case SCCP_LINE_STATECOUNTER_CONNECTED:
+			return &l->stateCounter.connected;
+		case SCCP_LINE_STATECOUNTER_HELD:
+			return &l->stateCounter.held;
+		case SCCP_LINE_STATECOUNTER_NONE:
+			break;
+	}
+	return NULL;
+}
+
+/*!
+ * \brief Move a channel from the counter it is currently accounted in, to a new one
+ * \note O(1), does not lock line->channels. The bucket is claimed with a compare and swap, so that concurrent transitions of the
+ * same channel only move it once.
+ */
+static void __sccp_line_moveStateCounter(sccp_line_t * l, sccp_channel_t * c, const sccp_line_statecounter_t newCounter)
+{
+	volatile CAS32_TYPE *counterPtr = NULL;
+	sccp_line_statecounter_t oldCounter = SCCP_LINE_STATECOUNTER_NONE;
+
+	do {
+		oldCounter = (sccp_line_statecounter_t) ATOMIC_FETCH(&c->lineStateCounter, &l->stateCounter.lock);
+		if (oldCounter == newCounter) {
+			return;
+		}
+	} while (CAS32(&c->lineStateCounter, (CAS32_TYPE) oldCounter, (CAS32_TYPE) newCounter, &l->stateCounter.lock) != (CAS32_TYPE) oldCounter);
+
+	if ((counterPtr = __sccp_line_stateCounterPtr(l, oldCounter))) {
+		(void) ATOMIC_DECR(counterPtr, 1, &l->stateCounter.lock);
+	}
+	if ((counterPtr = __sccp_line_stateCounterPtr(l, newCounter))) {
+		(void) ATOMIC_INCR(counterPtr, 1, &l->stateCounter.lock);
+	}
+}
+
+/*!
+ * \brief Update the line state counters after a channel state transition
+ * \param channel SCCP Channel (after sccp_channel_setChannelstate / indicate)
+ *
+ * \note called from sccp_indicate, once the final channel state is known
+ */
+void sccp_line_updateChannelStateCounters(channelPtr channel)
+{
+	if (!channel || !channel->line) {
+		return;
+	}
+	__sccp_line_moveStateCounter(channel->line, channel, __sccp_line_channelstate2counter(channel->state));
+}
+
+/*!
+ * \brief Update the DND appearance counter of the line connected to this linedevice
+ * \param ld SCCP LineDevice
+ *
+ * \note called when the linedevice is attached and when the DND feature of the device changes
+ */
+void sccp_linedevice_updateDNDCounter(sccp_linedevices_t * ld)
+{
+	if (!ld || !ld->line || !ld->device) {
+		return;
+	}
+	sccp_line_t *l = ld->line;
+	boolean_t inDND = (ld->device->dndFeature.status == SCCP_DNDMODE_REJECT) ? TRUE : FALSE;
+
+	if (inDND != ld->countedAsDND) {
+		if (inDND) {
+			(void) ATOMIC_INCR(&l->stateCounter.dnd, 1, &l->stateCounter.lock);
+		} else {
+			(void) ATOMIC_DECR(&l->stateCounter.dnd, 1, &l->stateCounter.lock);
+		}
+		ld->countedAsDND = inDND;
+	}
+}
+
+/*!
+ * \brief Get a snapshot of the incrementally maintained line state counters
+ * \note O(1), does not lock line->channels or line->devices
+ */
+void sccp_line_getStateCounters(constLinePtr line, sccp_line_stateCounters_t * counters)
+{
+	sccp_line_t *l = (sccp_line_t *) line;									/* discard const */
+
+	counters->inuse = ATOMIC_FETCH(&l->stateCounter.inuse, &l->stateCounter.lock);
+	counters->ringing = ATOMIC_FETCH(&l->stateCounter.ringing, &l->stateCounter.lock);
+	counters->connected = ATOMIC_FETCH(&l->stateCounter.connected, &l->stateCounter.lock);
+	counters->held = ATOMIC_FETCH(&l->stateCounter.held, &l->stateCounter.lock);
+	counters->dnd = ATOMIC_FETCH(&l->stateCounter.dnd, &l->stateCounter.lock);
+}
+
+/*!
+ * \brief Recount the line state by scanning line->channels and line->devices
+ * \param line SCCP Line
+ * \param counters recounted state counters
+ * \param skipped number of channels whose state was set outside sccp_indicate, which are not accounted for yet. They are counted in
+ * the bucket they are accounted in, so they do not show up as a mismatch.
+ * \note Only used to self-check the incremental counters (sccp check hint lineStates)
+ */
+void sccp_line_recountStateCounters(constLinePtr line, sccp_line_stateCounters_t * counters, int *skipped)
+{
+	sccp_line_t *l = (sccp_line_t *) line;									/* discard const */
+	sccp_channel_t *c = NULL;
+	sccp_linedevices_t *ld = NULL;
+	sccp_line_statecounter_t counter = SCCP_LINE_STATECOUNTER_NONE;
+	sccp_line_statecounter_t accounted = SCCP_LINE_STATECOUNTER_NONE;
+
+	memset(counters, 0, sizeof(sccp_line_stateCounters_t));
+	*skipped = 0;
+	SCCP_LIST_LOCK(&l->channels);
+	SCCP_LIST_TRAVERSE(&l->channels, c, list) {
+		counter = __sccp_line_channelstate2counter(c->state);
+		accounted = (sccp_line_statecounter_t) ATOMIC_FETCH(&c->lineStateCounter, &l->stateCounter.lock);
+		if (counter != accounted) {								/* state set outside sccp_indicate, not accounted yet */
+			counter = accounted;
+			(*skipped)++;
+		}
+		switch (counter) {
+			case SCCP_LINE_STATECOUNTER_INUSE:
+				counters->inuse++;
+				break;
+			case SCCP_LINE_STATECOUNTER_RINGING:
+				counters->ringing++;
+				break;
+			case SCCP_LINE_STATECOUNTER_CONNECTED:
+				counters->connected++;
+				break;
+			case SCCP_LINE_STATECOUNTER_HELD:
+				counters->held++;
+				break;
+			case SCCP_LINE_STATECOUNTER_NONE:
+				break;
+		}
+	}
+	SCCP_LIST_UNLOCK(&l->channels);
+
+	SCCP_LIST_LOCK(&l->devices);
+	SCCP_LIST_TRAVERSE(&l->devices, ld, list) {
+		if (ld->device && ld->device->dndFeature.status == SCCP_DNDMODE_REJECT) {
+			counters->dnd++;
+		}
+	}
+	SCCP_LIST_UNLOCK(&l->devices);
+}
+
 /*!
  * \brief Add a Channel to a Line
  *
@@ -673,6 +924,7 @@ void sccp_line_removeChannel(sccp_line_t * line, sccp_channel_t * channel)
 			if (c->state == SCCP_CHANNELSTATE_HOLD) {
 				c->line->statistic.numberOfHeldChannels--;
 			}
+			__sccp_line_moveStateCounter(l, c, SCCP_LINE_STATECOUNTER_NONE);
 			sccp_log((DEBUGCAT_LINE)) (VERBOSE_PREFIX_1 "SCCP: Removing channel %d from line %s\n", c->callid, l->name);
 			sccp_channel_release(&c);					/* explicit release of channel from list */
 		}
@@ -818,8 +1070,14 @@ sccp_line_t *sccp_line_find_byname(const char *name, uint8_t useRealtime)
 {
 	sccp_line_t *l = NULL;
 
+	if (sccp_strlen_zero(name)) {
+		return NULL;
+	}
+
 	SCCP_RWLIST_RDLOCK(&GLOB(lines));
-	l = SCCP_RWLIST_FIND(&GLOB(lines), sccp_line_t, tmpl, list, (sccp_strcaseequals(tmpl->name, name)), TRUE, __FILE__, __LINE__, __PRETTY_FUNCTION__);
+	if ((l = sccp_line_nameIndexFind(sccp_line_nameIndex, name))) {
+		l = sccp_line_retain(l);
+	}
 	SCCP_RWLIST_UNLOCK(&GLOB(lines));
 #ifdef CS_SCCP_REALTIME
 	if (!l && useRealtime) {
@@ -871,7 +1129,7 @@ sccp_line_t *sccp_line_find_realtime_byname(const char *name)
 		return NULL;
 	}
 
-	if ((variable = pbx_load_realtime(GLOB(realtimelinetable), "name", name, NULL))) {
+	if ((variable = sccp_realtime_load(SCCP_REALTIME_CACHE_LINE, name))) {
 		v = variable;
 		sccp_log((DEBUGCAT_LINE + DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: Line '%s' found in realtime table '%s'\n", name, GLOB(realtimelinetable));
 
@@ -885,6 +1143,7 @@ sccp_line_t *sccp_line_find_realtime_byname(const char *name)
 			pbx_variables_destroy(v);
 		} else {
 			pbx_log(LOG_ERROR, "SCCP: Unable to build realtime line '%s'\n", name);
+			pbx_variables_destroy(v);
 		}
 		// SCCP_RWLIST_UNLOCK(&GLOB(lines));
 		return l;
@@ -1119,4 +1378,95 @@ void sccp_line_deleteLineButtonsArray(sccp_device_t * device)
 		sccp_free(device->lineButtons.instance);
 	}
 }
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+#define NUM_TEST_LINES 2000
+#define NUM_TEST_LOOPS 10
+AST_TEST_DEFINE(sccp_line_find_byname_benchmark)
+{
+	int rc = AST_TEST_PASS;
+	int loop, idx;
+	char name[StationMaxNameSize];
+	struct timeval start;
+	long indexMs = 0, scanMs = 0;
+	sccp_line_t **index = NULL;
+	sccp_line_t *lines = NULL;
+	sccp_line_t *l = NULL;
+
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "find_byname";
+			info->category = "/channels/chan_sccp/line/";
+			info->summary = "chan-sccp-b line lookup test";
+			info->description = "compares a private line name index against a full list scan, leaving GLOB(lines) untouched";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	index = sccp_calloc(SCCP_HASH_PRIME, sizeof(sccp_line_t *));
+	lines = sccp_calloc(NUM_TEST_LINES, sizeof(sccp_line_t));
+	pbx_test_validate_cleanup(test, index != NULL && lines != NULL, rc, cleanup);
+
+	pbx_test_status_update(test, "Index %d lines...\n", NUM_TEST_LINES);
+	for (idx = 0; idx < NUM_TEST_LINES; idx++) {
+		snprintf(lines[idx].name, sizeof(lines[idx].name), "sccptestline%05d", idx);
+		if (idx < NUM_TEST_LINES - 1) {
+			lines[idx].list.next = &lines[idx + 1];
+		}
+		sccp_line_nameIndexInsert(index, &lines[idx]);
+	}
+
+	pbx_test_status_update(test, "Lookup %d lines %d times using the name index...\n", NUM_TEST_LINES, NUM_TEST_LOOPS);
+	start = pbx_tvnow();
+	for (loop = 0; loop < NUM_TEST_LOOPS; loop++) {
+		for (idx = 0; idx < NUM_TEST_LINES; idx++) {
+			snprintf(name, sizeof(name), "SCCPTestLine%05d", idx);				/* lookup is case insensitive */
+			l = sccp_line_nameIndexFind(index, name);
+			pbx_test_validate_cleanup(test, l == &lines[idx], rc, cleanup);
+		}
+	}
+	indexMs = ast_tvdiff_ms(pbx_tvnow(), start);
+
+	pbx_test_status_update(test, "Lookup %d lines %d times using a list scan...\n", NUM_TEST_LINES, NUM_TEST_LOOPS);
+	start = pbx_tvnow();
+	for (loop = 0; loop < NUM_TEST_LOOPS; loop++) {
+		for (idx = 0; idx < NUM_TEST_LINES; idx++) {
+			snprintf(name, sizeof(name), "SCCPTestLine%05d", idx);
+			for (l = lines; l; l = l->list.next) {
+				if (sccp_strcaseequals(l->name, name)) {
+					break;
+				}
+			}
+			pbx_test_validate_cleanup(test, l == &lines[idx], rc, cleanup);
+		}
+	}
+	scanMs = ast_tvdiff_ms(pbx_tvnow(), start);
+	pbx_test_status_update(test, "%d lookups: name index %ld ms, list scan %ld ms\n", NUM_TEST_LINES * NUM_TEST_LOOPS, indexMs, scanMs);
+
+	pbx_test_status_update(test, "Lookup of an unknown line...\n");
+	pbx_test_validate_cleanup(test, sccp_line_nameIndexFind(index, "sccptestline_unknown") == NULL, rc, cleanup);
+
+	pbx_test_status_update(test, "Lookup after removal...\n");
+	sccp_line_nameIndexRemove(index, &lines[NUM_TEST_LINES / 2]);
+	pbx_test_validate_cleanup(test, sccp_line_nameIndexFind(index, lines[NUM_TEST_LINES / 2].name) == NULL, rc, cleanup);
+	pbx_test_validate_cleanup(test, sccp_line_nameIndexFind(index, lines[0].name) == &lines[0], rc, cleanup);
+
+cleanup:
+	sccp_free(lines);
+	sccp_free(index);
+	return rc;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_line_find_byname_benchmark);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_line_find_byname_benchmark);
+}
+#endif
+
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -19,6 +19,29 @@
 #define sccp_line_refreplace(_x, _y)		sccp_refcount_refreplace_type(sccp_line_t, _x, _y)
 
 __BEGIN_C_EXTERN__
+/*!
+ * \brief SCCP Line Channel State Counter Buckets
+ * \note Every channel on a line is accounted in exactly one of these buckets (see sccp_line_updateChannelStateCounters)
+ */
+typedef enum {
+	SCCP_LINE_STATECOUNTER_NONE = 0,									/*!< Idle / Not Accounted */
+	SCCP_LINE_STATECOUNTER_INUSE,										/*!< Offhook, Dialing, Ringout, Proceed, ... */
+	SCCP_LINE_STATECOUNTER_RINGING,										/*!< Ringing / Callwaiting */
+	SCCP_LINE_STATECOUNTER_CONNECTED,									/*!< Connected / Connected Conference */
+	SCCP_LINE_STATECOUNTER_HELD,										/*!< Hold */
+} sccp_line_statecounter_t;
+
+/*!
+ * \brief SCCP Line State Counters Snapshot
+ */
+typedef struct sccp_line_stateCounters {
+	int inuse;												/*!< Number of other non-idle Channels */
+	int ringing;												/*!< Number of Ringing Channels */
+	int connected;												/*!< Number of Connected Channels */
+	int held;												/*!< Number of Held Channels */
+	int dnd;												/*!< Number of Appearances in DND (Reject) */
+} sccp_line_stateCounters_t;											/*!< SCCP Line State Counters Snapshot */
+
 /*!
  * \brief SCCP Line Structure
  * \note A line is the equivalent of a 'phone line' going to the phone.
@@ -33,12 +56,23 @@ struct sccp_line {
 	uint8_t _padding1[3];
 #endif
 	SCCP_RWLIST_ENTRY (sccp_line_t) list;									/*!< global list entry */
+	sccp_line_t *hashNext;											/*!< Next Line in the same GLOB(lines) Name Index Bucket */
 	struct {
 		uint8_t numberOfActiveDevices;									/*!< Number of Active Devices */
 		uint8_t numberOfActiveChannels;									/*!< Number of Active Channels */
 		uint8_t numberOfHeldChannels;									/*!< Number of Hold Channels */
 		uint8_t numberOfDNDDevices;									/*!< Number of DND Devices */
 	} statistic;												/*!< Statistics for Line Structure */
+	struct {
+#ifndef SCCP_ATOMIC
+		sccp_mutex_t lock;										/*!< State Counter Lock */
+#endif
+		volatile CAS32_TYPE inuse;									/*!< Number of other non-idle Channels */
+		volatile CAS32_TYPE ringing;									/*!< Number of Ringing Channels */
+		volatile CAS32_TYPE connected;									/*!< Number of Connected Channels */
+		volatile CAS32_TYPE held;									/*!< Number of Held Channels */
+		volatile CAS32_TYPE dnd;									/*!< Number of Appearances (Line-Devices) in DND (Reject) */
+	} stateCounter;												/*!< Incrementally maintained Line State, updated on channel state transitions */
 
 	uint8_t incominglimit;											/*!< max incoming calls limit */
 	uint8_t secondary_dialtone_tone;									/*!< secondary dialtone tone */
@@ -97,6 +131,7 @@ struct sccp_line {
 	/* this is for reload routines */
 	boolean_t pendingDelete;										/*!< this bit will tell the scheduler to delete this line when unused */
 	boolean_t pendingUpdate;										/*!< this bit will tell the scheduler to update this line when unused */
+	uint64_t configHash;											/*!< Hash of the sccp.conf section this line was last built from (incremental reload) */
 };														/*!< SCCP Line Structure */
 
 /*!
@@ -132,10 +167,17 @@ struct sccp_linedevices {
 	char label[SCCP_MAX_LABEL];										/*!<  */
 
 	uint8_t lineInstance;											/*!< line instance of this->line on this->device */
+	boolean_t countedAsDND;											/*!< this appearance is accounted in line->stateCounter.dnd */
+	struct {
+		int newmsgs;											/*!< New Messages accounted in device->mwiState */
+		int oldmsgs;											/*!< Old Messages accounted in device->mwiState */
+		boolean_t detached;										/*!< removed from the line, no longer accounted */
+	} mwi;													/*!< Contribution of this line to the device MWI State */
 	boolean_t (*isPickupAllowed) (void);
 };														/*!< SCCP Line-Device Structure */
 
 SCCP_API void SCCP_CALL sccp_line_pre_reload(void);
+SCCP_API void SCCP_CALL sccp_line_prepareReload(linePtr l);
 SCCP_API void SCCP_CALL sccp_line_post_reload(void);
 
 /* live cycle */
@@ -150,6 +192,12 @@ SCCP_API void SCCP_CALL sccp_line_removeChannel(sccp_line_t * line, sccp_channel
 SCCP_API void SCCP_CALL sccp_line_clean(sccp_line_t * l, boolean_t remove_from_global);
 SCCP_API void SCCP_CALL sccp_line_kill_channels(sccp_line_t * l);
 
+/* state counters */
+SCCP_API void SCCP_CALL sccp_line_updateChannelStateCounters(channelPtr channel);
+SCCP_API void SCCP_CALL sccp_linedevice_updateDNDCounter(sccp_linedevices_t * ld);
+SCCP_API void SCCP_CALL sccp_line_getStateCounters(constLinePtr line, sccp_line_stateCounters_t * counters);
+SCCP_API void SCCP_CALL sccp_line_recountStateCounters(constLinePtr line, sccp_line_stateCounters_t * counters, int *skipped);
+
 #if UNUSEDCODE // 2015-11-01
 SCCP_API sccp_channelstate_t SCCP_CALL sccp_line_getDNDChannelState(sccp_line_t * line);
 #endif
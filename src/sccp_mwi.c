@@ -28,6 +28,8 @@ SCCP_FILE_VERSION(__FILE__, "");
 #ifndef CS_AST_HAS_EVENT
 #define SCCP_MWI_CHECK_INTERVAL 30
 #endif
+#define SCCP_MWI_HASH_SIZE SCCP_HASH_PRIME									/*!< Number of buckets in the mailbox@context hash table */
+#define SCCP_MWI_BULKCOUNT_DELAY 250										/*!< ms to wait before retrieving the initial counts of new subscriptions, so they are fetched together */
 
 /*!
  * \brief SCCP Mailbox Line Type Definition
@@ -65,6 +67,8 @@ struct sccp_mailbox_subscriber_list {
 
 	SCCP_LIST_HEAD (, sccp_mailboxLine_t) sccp_mailboxLine;
 	SCCP_LIST_ENTRY (sccp_mailbox_subscriber_list_t) list;
+	sccp_mailbox_subscriber_list_t *hashNext;								/*!< Next Subscription in the same Hash Bucket */
+	boolean_t pendingCount;											/*!< Initial Voicemail Count not yet retrieved */
 
 	/*!
 	 * \brief Current Voicemail Statistic Structure
@@ -97,9 +101,12 @@ void sccp_mwi_destroySubscription(sccp_mailbox_subscriber_list_t *subscription);
 void sccp_mwi_linecreatedEvent(const sccp_event_t * event);
 void sccp_mwi_deviceAttachedEvent(const sccp_event_t * event);
 void sccp_mwi_addMailboxSubscription(char *mailbox, char *context, sccp_line_t * line);
-void sccp_mwi_lineStatusChangedEvent(const sccp_event_t * event);
+static void sccp_mwi_updateDeviceLamp(sccp_device_t * device, boolean_t forceDisplay);
 
 static SCCP_LIST_HEAD (, sccp_mailbox_subscriber_list_t) sccp_mailbox_subscriptions;
+static sccp_mailbox_subscriber_list_t *sccp_mailbox_hashtable[SCCP_MWI_HASH_SIZE];				/*!< mailbox@context hash table, protected by the sccp_mailbox_subscriptions lock */
+static int sccp_mwi_pendingCounts = 0;										/*!< Number of Subscriptions waiting for their initial count */
+static int sccp_mwi_bulkCountSched = -1;									/*!< Scheduled bulk initial count retrieval */
 
 /*!
  * start mwi module.
@@ -107,11 +114,13 @@ static SCCP_LIST_HEAD (, sccp_mailbox_subscriber_list_t) sccp_mailbox_subscripti
 void sccp_mwi_module_start(void)
 {
 	SCCP_LIST_HEAD_INIT(&sccp_mailbox_subscriptions);
+	memset(sccp_mailbox_hashtable, 0, sizeof(sccp_mailbox_hashtable));
+	sccp_mwi_pendingCounts = 0;
+	sccp_mwi_bulkCountSched = -1;
 	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "SCCP: Starting MWI system\n");
 
 	sccp_event_subscribe(SCCP_EVENT_LINE_CREATED, sccp_mwi_linecreatedEvent, TRUE);
 	sccp_event_subscribe(SCCP_EVENT_DEVICE_ATTACHED, sccp_mwi_deviceAttachedEvent, TRUE);
-	sccp_event_subscribe(SCCP_EVENT_LINESTATUS_CHANGED, sccp_mwi_lineStatusChangedEvent, FALSE);
 }
 
 /*!
@@ -124,16 +133,72 @@ void sccp_mwi_module_stop(void)
 
 	sccp_event_unsubscribe(SCCP_EVENT_LINE_CREATED, sccp_mwi_linecreatedEvent);
 	sccp_event_unsubscribe(SCCP_EVENT_DEVICE_ATTACHED, sccp_mwi_deviceAttachedEvent);
-	sccp_event_unsubscribe(SCCP_EVENT_LINESTATUS_CHANGED, sccp_mwi_lineStatusChangedEvent);
 
 	SCCP_LIST_LOCK(&sccp_mailbox_subscriptions);
+	if (sccp_mwi_bulkCountSched > -1) {
+		sccp_mwi_bulkCountSched = SCCP_SCHED_DEL(sccp_mwi_bulkCountSched);
+	}
 	while ((subscription = SCCP_LIST_REMOVE_HEAD(&sccp_mailbox_subscriptions, list))) {
 		sccp_mwi_destroySubscription(subscription);
 	}
+	memset(sccp_mailbox_hashtable, 0, sizeof(sccp_mailbox_hashtable));
+	sccp_mwi_pendingCounts = 0;
 	SCCP_LIST_UNLOCK(&sccp_mailbox_subscriptions);
 	SCCP_LIST_HEAD_DESTROY(&sccp_mailbox_subscriptions);
 }
 
+/*!
+ * \brief Calculate the Hash Bucket for mailbox@context
+ */
+static unsigned int sccp_mwi_hashkey(const char *mailbox, const char *context)
+{
+	char key[SCCP_MAX_EXTENSION + SCCP_MAX_CONTEXT + 2];
+
+	snprintf(key, sizeof(key), "%s@%s", mailbox, context);
+	return sccp_strhash(key, SCCP_MWI_HASH_SIZE);
+}
+
+/*!
+ * \brief Find Mailbox Subscription by mailbox and context
+ * \note called with sccp_mailbox_subscriptions locked
+ */
+static sccp_mailbox_subscriber_list_t *sccp_mwi_findSubscription(const char *mailbox, const char *context)
+{
+	sccp_mailbox_subscriber_list_t *subscription = NULL;
+
+	for (subscription = sccp_mailbox_hashtable[sccp_mwi_hashkey(mailbox, context)]; subscription; subscription = subscription->hashNext) {
+		if (sccp_strequals(mailbox, subscription->mailbox) && sccp_strequals(context, subscription->context)) {
+			break;
+		}
+	}
+	return subscription;
+}
+
+/*!
+ * \brief Add / Remove Mailbox Subscription to/from the Hash Table
+ * \note called with sccp_mailbox_subscriptions locked
+ */
+static void sccp_mwi_hashInsert(sccp_mailbox_subscriber_list_t * subscription)
+{
+	unsigned int bucket = sccp_mwi_hashkey(subscription->mailbox, subscription->context);
+
+	subscription->hashNext = sccp_mailbox_hashtable[bucket];
+	sccp_mailbox_hashtable[bucket] = subscription;
+}
+
+static void sccp_mwi_hashRemove(sccp_mailbox_subscriber_list_t * subscription)
+{
+	sccp_mailbox_subscriber_list_t **entry = &sccp_mailbox_hashtable[sccp_mwi_hashkey(subscription->mailbox, subscription->context)];
+
+	for (; *entry; entry = &(*entry)->hashNext) {
+		if (*entry == subscription) {
+			*entry = subscription->hashNext;
+			subscription->hashNext = NULL;
+			break;
+		}
+	}
+}
+
 /*!
  * \brief Generic update mwi count
  * \param subscription Pointer to a mailbox subscription
@@ -163,6 +228,7 @@ static void sccp_mwi_updatecount(sccp_mailbox_subscriber_list_t * subscription)
 			SCCP_LIST_LOCK(&line->devices);
 			SCCP_LIST_TRAVERSE(&line->devices, lineDevice, list) {
 				if (lineDevice && lineDevice->device) {
+					sccp_mwi_updateLineDeviceCounts(lineDevice, FALSE);
 					sccp_mwi_setMWILineStatus(lineDevice);
 				} else {
 					pbx_log(LOG_ERROR, "error: null line device.\n");
@@ -291,6 +357,153 @@ int sccp_mwi_checksubscription(const void *ptr)
 }
 #endif
 
+/*!
+ * \brief Store the initial voicemail count of a pending subscription and update the subscribed lines when it differs
+ * \note called with sccp_mailbox_subscriptions locked
+ */
+static void sccp_mwi_setInitialCount(sccp_mailbox_subscriber_list_t * subscription, int newmsgs, int oldmsgs)
+{
+	if (!subscription->pendingCount) {
+		return;
+	}
+	subscription->pendingCount = FALSE;
+	sccp_mwi_pendingCounts--;
+
+	if (newmsgs != -1 && oldmsgs != -1) {
+		subscription->previousVoicemailStatistic.newmsgs = subscription->currentVoicemailStatistic.newmsgs;
+		subscription->previousVoicemailStatistic.oldmsgs = subscription->currentVoicemailStatistic.oldmsgs;
+		subscription->currentVoicemailStatistic.newmsgs = newmsgs;
+		subscription->currentVoicemailStatistic.oldmsgs = oldmsgs;
+		if (subscription->previousVoicemailStatistic.newmsgs != newmsgs || subscription->previousVoicemailStatistic.oldmsgs != oldmsgs) {
+			sccp_mwi_updatecount(subscription);
+		}
+	}
+}
+
+/*!
+ * \brief Retrieve the initial voicemail counts for all pending mailbox subscriptions in one pass
+ * \param ptr unused
+ *
+ * Scheduled by sccp_mwi_addMailboxSubscription when the first pending subscription is created, so that all subscriptions
+ * created during startup / reload are handled together. When the PBX keeps an MWI state cache, the whole cache is dumped
+ * once and matched against the hash table, only mailboxes missing from the cache fall back to a direct inbox count. These
+ * inbox counts are made with sccp_mailbox_subscriptions unlocked, as they can hit the voicemail storage backend.
+ *
+ * \called_from_asterisk
+ */
+static int sccp_mwi_fetchPendingCounts(const void *ptr)
+{
+	sccp_mailbox_subscriber_list_t *subscription = NULL;
+	int pending = 0, fromCache = 0, idx = 0, lookups = 0;
+	struct timeval start = pbx_tvnow();
+	struct {
+		char mailbox[60];
+		char context[60];
+		int newmsgs;
+		int oldmsgs;
+	} *inbox = NULL;
+
+	SCCP_LIST_LOCK(&sccp_mailbox_subscriptions);
+	sccp_mwi_bulkCountSched = -1;
+	pending = sccp_mwi_pendingCounts;
+	if (!GLOB(module_running) || !pending) {
+		SCCP_LIST_UNLOCK(&sccp_mailbox_subscriptions);
+		return 0;
+	}
+
+#if defined(CS_AST_HAS_STASIS)
+	struct ao2_container *mwi_cache = stasis_cache_dump(ast_mwi_state_cache(), ast_mwi_state_type());
+
+	if (mwi_cache) {
+		struct ao2_iterator iter = ao2_iterator_init(mwi_cache, 0);
+		struct stasis_message *msg = NULL;
+		char uniqueid[SCCP_MAX_EXTENSION + SCCP_MAX_CONTEXT + 2];
+		char *context = NULL;
+
+		while ((msg = ao2_iterator_next(&iter))) {
+			struct ast_mwi_state *mwi_state = stasis_message_data(msg);
+
+			if (mwi_state && !sccp_strlen_zero(mwi_state->uniqueid)) {
+				sccp_copy_string(uniqueid, mwi_state->uniqueid, sizeof(uniqueid));
+				if ((context = strchr(uniqueid, '@'))) {
+					*context++ = '\0';
+					if ((subscription = sccp_mwi_findSubscription(uniqueid, context)) && subscription->pendingCount) {
+						sccp_mwi_setInitialCount(subscription, mwi_state->new_msgs, mwi_state->old_msgs);
+						fromCache++;
+					}
+				}
+			}
+			ao2_ref(msg, -1);
+		}
+		ao2_iterator_destroy(&iter);
+		ao2_ref(mwi_cache, -1);
+	}
+#endif
+
+	SCCP_LIST_TRAVERSE(&sccp_mailbox_subscriptions, subscription, list) {
+		if (!subscription->pendingCount) {
+			continue;
+		}
+		int newmsgs = -1, oldmsgs = -1;
+
+#ifdef CS_AST_HAS_EVENT
+		struct ast_event *event = ast_event_get_cached(AST_EVENT_MWI,
+							       AST_EVENT_IE_MAILBOX, AST_EVENT_IE_PLTYPE_STR, subscription->mailbox,
+							       AST_EVENT_IE_CONTEXT, AST_EVENT_IE_PLTYPE_STR, subscription->context,
+							       AST_EVENT_IE_END);
+
+		if (event) {
+			newmsgs = pbx_event_get_ie_uint(event, AST_EVENT_IE_NEWMSGS);
+			oldmsgs = pbx_event_get_ie_uint(event, AST_EVENT_IE_OLDMSGS);
+			ast_event_destroy(event);
+			fromCache++;
+		} else
+#endif
+		if (!inbox && !(inbox = sccp_calloc(pending, sizeof *inbox))) {
+			pbx_log(LOG_ERROR, "SCCP: (mwi_fetchPendingCounts) Memory Allocation Error, skipping initial count\n");
+		} else if (lookups < pending) {							/* Fall back on checking the mailbox directly, after releasing the lock */
+			sccp_copy_string(inbox[lookups].mailbox, subscription->mailbox, sizeof(inbox[lookups].mailbox));
+			sccp_copy_string(inbox[lookups].context, subscription->context, sizeof(inbox[lookups].context));
+			lookups++;
+			continue;
+		}
+		sccp_mwi_setInitialCount(subscription, newmsgs, oldmsgs);
+	}
+	SCCP_LIST_UNLOCK(&sccp_mailbox_subscriptions);
+
+	if (lookups) {
+		char buffer[512];
+
+		for (idx = 0; idx < lookups; idx++) {
+			snprintf(buffer, 512, "%s@%s", inbox[idx].mailbox, inbox[idx].context);
+			if (pbx_app_inboxcount(buffer, &inbox[idx].newmsgs, &inbox[idx].oldmsgs) != 0) {
+				inbox[idx].newmsgs = inbox[idx].oldmsgs = -1;
+			}
+		}
+
+		/* the subscription may have been removed while unlocked, look it up again */
+		SCCP_LIST_LOCK(&sccp_mailbox_subscriptions);
+		for (idx = 0; idx < lookups; idx++) {
+			if ((subscription = sccp_mwi_findSubscription(inbox[idx].mailbox, inbox[idx].context)) && subscription->pendingCount) {
+				sccp_mwi_setInitialCount(subscription, inbox[idx].newmsgs, inbox[idx].oldmsgs);
+			}
+		}
+		/* subscriptions added while unlocked did not schedule their own retrieval */
+		if (GLOB(module_running) && sccp_mwi_pendingCounts && sccp_mwi_bulkCountSched < 0) {
+			if ((sccp_mwi_bulkCountSched = iPbx.sched_add(SCCP_MWI_BULKCOUNT_DELAY, sccp_mwi_fetchPendingCounts, NULL)) < 0) {
+				pbx_log(LOG_ERROR, "SCCP: (mwi_fetchPendingCounts) Error scheduling initial mailbox count retrieval.\n");
+			}
+		}
+		SCCP_LIST_UNLOCK(&sccp_mailbox_subscriptions);
+	}
+	if (inbox) {
+		sccp_free(inbox);
+	}
+
+	sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_2 "SCCP: (mwi_fetchPendingCounts) retrieved initial count for %d mailbox(es), %d from the pbx cache, in %ld ms\n", pending, fromCache, (long) ast_tvdiff_ms(pbx_tvnow(), start));
+	return 0;
+}
+
 /*!
  * \brief Free Mailbox Subscription
  */
@@ -338,13 +551,14 @@ void sccp_mwi_unsubscribeMailbox(sccp_mailbox_t * mailbox)
 	sccp_mailbox_subscriber_list_t *subscription = NULL;
 
 	SCCP_LIST_LOCK(&sccp_mailbox_subscriptions);
-	SCCP_LIST_TRAVERSE_SAFE_BEGIN(&sccp_mailbox_subscriptions, subscription, list) {
-		if (sccp_strequals(mailbox->mailbox, subscription->mailbox) && sccp_strequals(mailbox->context, subscription->context)) {
-			SCCP_LIST_REMOVE_CURRENT(list);
-			sccp_mwi_destroySubscription(subscription);
+	if ((subscription = sccp_mwi_findSubscription(mailbox->mailbox, mailbox->context))) {
+		sccp_mwi_hashRemove(subscription);
+		SCCP_LIST_REMOVE(&sccp_mailbox_subscriptions, subscription, list);
+		if (subscription->pendingCount) {
+			sccp_mwi_pendingCounts--;
 		}
+		sccp_mwi_destroySubscription(subscription);
 	}
-	SCCP_LIST_TRAVERSE_SAFE_END;
 	SCCP_LIST_UNLOCK(&sccp_mailbox_subscriptions);
 }
 
@@ -366,43 +580,12 @@ void sccp_mwi_deviceAttachedEvent(const sccp_event_t * event)
 	sccp_device_t *device = linedevice->device;
 
 	if (line && device) {
-		device->voicemailStatistic.oldmsgs += line->voicemailStatistic.oldmsgs;
-		device->voicemailStatistic.newmsgs += line->voicemailStatistic.newmsgs;
-		
-		sccp_mwi_setMWILineStatus(linedevice);								/* set mwi-line-status */
+		sccp_mwi_setMWILineStatus(linedevice);								/* set mwi-line-status (counts were already accounted by sccp_line_addDevice) */
 	} else {
 		pbx_log(LOG_ERROR, "get deviceAttachedEvent where one parameter is missing. device: %s, line: %s\n", DEV_ID_LOG(device), (line) ? line->name : "null");
 	}
 }
 
-/*!
- * \brief Line Status Changed Event
- * \param event SCCP Event
- */
-void sccp_mwi_lineStatusChangedEvent(const sccp_event_t * event)
-{
-	if (!event || !event->event.lineStatusChanged.optional_device) {
-		pbx_log(LOG_ERROR, "(lineStatusChangedEvent) event or device not provided\n");
-		return;
-	}
-
-	sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_2 "SCCP: (mwi_lineStatusChangedEvent) Get lineStatusChangedEvent\n");
-	/* these are the only events we are interested in */
-	if (	event->event.lineStatusChanged.state == SCCP_CHANNELSTATE_DOWN || \
-		event->event.lineStatusChanged.state == SCCP_CHANNELSTATE_ONHOOK || \
-		event->event.lineStatusChanged.state == SCCP_CHANNELSTATE_RINGING || \
-		event->event.lineStatusChanged.state == SCCP_CHANNELSTATE_OFFHOOK 
-	) {
-		if (event->event.lineStatusChanged.line && event->event.lineStatusChanged.optional_device) {
-			AUTO_RELEASE(sccp_linedevices_t, linedevice, sccp_linedevice_find(event->event.lineStatusChanged.optional_device, event->event.lineStatusChanged.line));
-			if (linedevice) {
-				sccp_mwi_setMWILineStatus(linedevice);
-			}
-		}
-		//sccp_mwi_check(event->event.lineStatusChanged.optional_device);
-	}
-}
-
 /*!
  * \brief Line Created Event
  * \param event SCCP Event
@@ -449,16 +632,12 @@ void sccp_mwi_addMailboxSubscription(char *mailbox, char *context, sccp_line_t *
 	sccp_mailboxLine_t *mailboxLine = NULL;
 
 	SCCP_LIST_LOCK(&sccp_mailbox_subscriptions);
-	SCCP_LIST_TRAVERSE(&sccp_mailbox_subscriptions, subscription, list) {
-		if (sccp_strequals(mailbox, subscription->mailbox) && sccp_strequals(context, subscription->context)) {
-			break;
-		}
-	}
-	SCCP_LIST_UNLOCK(&sccp_mailbox_subscriptions);
+	subscription = sccp_mwi_findSubscription(mailbox, context);
 
 	if (!subscription) {
 		subscription = sccp_calloc(sizeof *subscription, 1);
 		if (!subscription) {
+			SCCP_LIST_UNLOCK(&sccp_mailbox_subscriptions);
 			pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, line->name);
 			return;
 		}
@@ -468,38 +647,14 @@ void sccp_mwi_addMailboxSubscription(char *mailbox, char *context, sccp_line_t *
 		sccp_copy_string(subscription->context, context, sizeof(subscription->context));
 		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "SCCP: (mwi_addMailboxSubscription) creating subscription for: %s@%s\n", subscription->mailbox, subscription->context);
 
-		SCCP_LIST_LOCK(&sccp_mailbox_subscriptions);
 		SCCP_LIST_INSERT_HEAD(&sccp_mailbox_subscriptions, subscription, list);
-		SCCP_LIST_UNLOCK(&sccp_mailbox_subscriptions);
-
-		/* get initial value */
+		sccp_mwi_hashInsert(subscription);
 
-#ifdef CS_AST_HAS_EVENT
-		struct ast_event *event = ast_event_get_cached(AST_EVENT_MWI,
-							       AST_EVENT_IE_MAILBOX, AST_EVENT_IE_PLTYPE_STR, subscription->mailbox,
-							       AST_EVENT_IE_CONTEXT, AST_EVENT_IE_PLTYPE_STR, subscription->context,
-							       AST_EVENT_IE_END);
-
-		if (event) {
-			int newmsgs = pbx_event_get_ie_uint(event, AST_EVENT_IE_NEWMSGS);
-			int oldmsgs = pbx_event_get_ie_uint(event, AST_EVENT_IE_OLDMSGS);
-			if (newmsgs != -1 && oldmsgs != -1) {
-				subscription->currentVoicemailStatistic.newmsgs = newmsgs;
-				subscription->currentVoicemailStatistic.oldmsgs = oldmsgs;
-			}
-			ast_event_destroy(event);
-		} else
-#endif
-		{												/* Fall back on checking the mailbox directly */
-			char buffer[512];
-			int newmsgs = 0, oldmsgs = 0;
-
-			snprintf(buffer, 512, "%s@%s", subscription->mailbox, subscription->context);
-			if (pbx_app_inboxcount(buffer, &newmsgs, &oldmsgs) == 0) {
-				if (newmsgs != -1 && oldmsgs != -1) {
-					subscription->currentVoicemailStatistic.newmsgs = newmsgs;
-					subscription->currentVoicemailStatistic.oldmsgs = oldmsgs;
-				}
+		/* get initial value (together with all other new subscriptions) */
+		subscription->pendingCount = TRUE;
+		if (!sccp_mwi_pendingCounts++ && sccp_mwi_bulkCountSched < 0) {
+			if ((sccp_mwi_bulkCountSched = iPbx.sched_add(SCCP_MWI_BULKCOUNT_DELAY, sccp_mwi_fetchPendingCounts, NULL)) < 0) {
+				pbx_log(LOG_ERROR, "SCCP: (mwi_addMailboxSubscription) Error scheduling initial mailbox count retrieval.\n");
 			}
 		}
 
@@ -532,6 +687,7 @@ void sccp_mwi_addMailboxSubscription(char *mailbox, char *context, sccp_line_t *
 	}
 
 	/* we already have this subscription */
+	SCCP_LIST_LOCK(&subscription->sccp_mailboxLine);
 	SCCP_LIST_TRAVERSE(&subscription->sccp_mailboxLine, mailboxLine, list) {
 		if (line == mailboxLine->line) {
 			break;
@@ -540,20 +696,28 @@ void sccp_mwi_addMailboxSubscription(char *mailbox, char *context, sccp_line_t *
 
 	if (!mailboxLine) {
 		mailboxLine = sccp_calloc(sizeof *mailboxLine, 1);
-		if (!mailboxLine) {
-			pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, line->name);
-			return;
-		}
+		if (mailboxLine) {
+			mailboxLine->line = line;
 
-		mailboxLine->line = line;
+			line->voicemailStatistic.newmsgs = subscription->currentVoicemailStatistic.newmsgs;
+			line->voicemailStatistic.oldmsgs = subscription->currentVoicemailStatistic.oldmsgs;
+			if (subscription->currentVoicemailStatistic.newmsgs || subscription->currentVoicemailStatistic.oldmsgs) {
+				sccp_linedevices_t *lineDevice = NULL;
 
-		line->voicemailStatistic.newmsgs = subscription->currentVoicemailStatistic.newmsgs;
-		line->voicemailStatistic.oldmsgs = subscription->currentVoicemailStatistic.oldmsgs;
+				SCCP_LIST_LOCK(&line->devices);
+				SCCP_LIST_TRAVERSE(&line->devices, lineDevice, list) {
+					sccp_mwi_updateLineDeviceCounts(lineDevice, FALSE);
+				}
+				SCCP_LIST_UNLOCK(&line->devices);
+			}
 
-		SCCP_LIST_LOCK(&subscription->sccp_mailboxLine);
-		SCCP_LIST_INSERT_HEAD(&subscription->sccp_mailboxLine, mailboxLine, list);
-		SCCP_LIST_UNLOCK(&subscription->sccp_mailboxLine);
+			SCCP_LIST_INSERT_HEAD(&subscription->sccp_mailboxLine, mailboxLine, list);
+		} else {
+			pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, line->name);
+		}
 	}
+	SCCP_LIST_UNLOCK(&subscription->sccp_mailboxLine);
+	SCCP_LIST_UNLOCK(&sccp_mailbox_subscriptions);
 }
 
 /*!
@@ -564,11 +728,11 @@ void sccp_mwi_setMWILineStatus(sccp_linedevices_t * lineDevice)
 {
 	pbx_assert(lineDevice != NULL && lineDevice->device != NULL);
 	
-	sccp_msg_t *msg = NULL;
 	sccp_line_t *l = lineDevice->line;
 	sccp_device_t *d = lineDevice->device;
 	uint32_t instance = 0;
-	uint32_t status = 0, mask = 0, state = 0;
+	uint32_t status = 0, mask = 0, state = 0, mwilight = 0;
+	boolean_t sendLamp = FALSE;
 
 	/* when l is defined we are switching on/off the button icon, otherwise the main mwi light */
 	if (l) {
@@ -581,114 +745,190 @@ void sccp_mwi_setMWILineStatus(sccp_linedevices_t * lineDevice)
 
 	/* check if we need to update line status */
 	char binstr[41] = "";
-	sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_setMWILineStatus) instance: %d, mwilight:%d, mask:%s (%d)\n", DEV_ID_LOG(d), instance, d->mwilight, sccp_dec2binstr(binstr, 32, mask), mask);
-	sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_setMWILineStatus) state: %d. status:%s (%d) \n", DEV_ID_LOG(d), state, sccp_dec2binstr(binstr, 32, status), status);
+	sccp_mutex_lock(&d->mwiState.lock);
+	mwilight = d->mwilight;
 	if ( (d->mwilight & mask) != status) {
 		if (state) {			/* activate mwi line icon */
 			d->mwilight |= mask;
 		} else {			/* deactivate mwi line icon */
 			d->mwilight &= ~mask;
 		}
-		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_setMWILineStatus) new mwilight:%s value: %d\n", DEV_ID_LOG(lineDevice->device), sccp_dec2binstr(binstr, 32, d->mwilight), d->mwilight);
-		REQ(msg, SetLampMessage);
-		msg->data.SetLampMessage.lel_stimulus = htolel(SKINNY_STIMULUS_VOICEMAIL);
-		msg->data.SetLampMessage.lel_stimulusInstance = htolel(instance);
-		msg->data.SetLampMessage.lel_lampMode = state ? htolel(SKINNY_LAMP_ON) : htolel(SKINNY_LAMP_OFF);
-		sccp_dev_send(d, msg);
+		d->mwiState.lampUpdates++;
+		sendLamp = TRUE;
+	}
+	sccp_mutex_unlock(&d->mwiState.lock);
+
+	sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_setMWILineStatus) instance: %d, mwilight:%d, mask:%s (%d)\n", DEV_ID_LOG(d), instance, mwilight, sccp_dec2binstr(binstr, 32, mask), mask);
+	sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_setMWILineStatus) state: %d. status:%s (%d) \n", DEV_ID_LOG(d), state, sccp_dec2binstr(binstr, 32, status), status);
+	if (sendLamp) {
+		sccp_device_setLamp(d, SKINNY_STIMULUS_VOICEMAIL, instance, state ? SKINNY_LAMP_ON : SKINNY_LAMP_OFF);
 		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_setMWILineStatus) Turn %s the MWI on line %s (%d)\n", DEV_ID_LOG(d), state ? "ON" : "OFF", (l ? l->name : "unknown"), instance);
 	} else {
 		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_setMWILineStatus) Device already knows this state %s on line %s (%d). skipping update\n", DEV_ID_LOG(d), status ? "ON" : "OFF", (l ? l->name : "unknown"), instance);
 	}
 	if (sccp_device_getRegistrationState(d) == SKINNY_DEVICE_RS_OK) {
-		sccp_mwi_check(d); /* we need to check mwi status again, to enable/disable device mwi light */
+		sccp_mwi_updateDeviceLamp(d, FALSE);							/* update the device mwi light from the aggregated device state */
 	}
 }
 
 /*!
- * \brief Check MWI Status for Device
- * \param d SCCP Device
- * \note called by lineStatusChange
+ * \brief Account the voicemail counts of a line in the aggregated MWI state of the device it is attached to
+ * \param lineDevice SCCP LineDevice
+ * \param detach line is being removed from the device, remove its contribution
+ *
+ * \note idempotent: only the difference to what this lineDevice contributed before is applied
  */
-void sccp_mwi_check(sccp_device_t * d)
+void sccp_mwi_updateLineDeviceCounts(sccp_linedevices_t * lineDevice, boolean_t detach)
 {
-	uint32_t oldmsgs = 0, newmsgs = 0;
-	boolean_t suppress_lamp = FALSE;
-
-	AUTO_RELEASE(sccp_device_t, device , sccp_device_retain(d));
-	if (!device) {
-		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "SCCP: (mwi_check) called with NULL device!\n");
+	if (!lineDevice || !lineDevice->device || !lineDevice->line) {
 		return;
 	}
+	sccp_device_t *d = lineDevice->device;
+	int newmsgs = 0, oldmsgs = 0;
 
-	uint32_t instance = SCCP_FIRST_LINEINSTANCE;
-	for (instance = SCCP_FIRST_LINEINSTANCE; instance < device->lineButtons.size; instance++) {
-		if (device->lineButtons.instance[instance] && device->lineButtons.instance[instance]->line) {
-			sccp_line_t *line =  device->lineButtons.instance[instance]->line;
-			sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: Checking Line Instance: %d = %s, mwioncall: %s\n", DEV_ID_LOG(device), instance, line->name, device->mwioncall ? "On" : "Off");
-			if (!device->mwioncall) {									// check if mwi suppression is required
-				sccp_channel_t *c = NULL;
-				SCCP_LIST_LOCK(&line->channels);
-				SCCP_LIST_TRAVERSE(&line->channels, c, list) {
-					AUTO_RELEASE(sccp_device_t, tmpDevice , sccp_channel_getDevice(c));
-					if (tmpDevice && tmpDevice == device) {						// We have a channel belonging to our device (no remote shared line channel)
-						if ((c->state != SCCP_CHANNELSTATE_ONHOOK && c->state != SCCP_CHANNELSTATE_DOWN) || c->state == SCCP_CHANNELSTATE_RINGING) {
-							sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: we have an active channel, suppress mwi light\n", DEV_ID_LOG(device));
-							suppress_lamp = TRUE;
-						}
-					}
-				}
-				SCCP_LIST_UNLOCK(&line->channels);
-			}
-			/* pre-collect number of voicemails on device to be set later */
-			oldmsgs += line->voicemailStatistic.oldmsgs;
-			newmsgs += line->voicemailStatistic.newmsgs;
-			
-			sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_check) line %s voicemail count %d new/%d old (instance: %d)\n", DEV_ID_LOG(device), line->name, line->voicemailStatistic.newmsgs, line->voicemailStatistic.oldmsgs, instance);
+	sccp_mutex_lock(&d->mwiState.lock);
+	if (!lineDevice->mwi.detached) {
+		if (detach) {
+			lineDevice->mwi.detached = TRUE;
+		} else {
+			newmsgs = lineDevice->line->voicemailStatistic.newmsgs;
+			oldmsgs = lineDevice->line->voicemailStatistic.oldmsgs;
 		}
+		d->mwiState.newmsgs += newmsgs - lineDevice->mwi.newmsgs;
+		d->mwiState.oldmsgs += oldmsgs - lineDevice->mwi.oldmsgs;
+		lineDevice->mwi.newmsgs = newmsgs;
+		lineDevice->mwi.oldmsgs = oldmsgs;
+	}
+	sccp_mutex_unlock(&d->mwiState.lock);
+
+	if (detach && sccp_device_getRegistrationState(d) == SKINNY_DEVICE_RS_OK) {
+		sccp_mwi_updateDeviceLamp(d, FALSE);
 	}
+}
+
+/*!
+ * \brief Account a channel state transition in the number of active calls of its device
+ * \param channel SCCP Channel
+ * \param detach channel is leaving its current device (or being destroyed)
+ *
+ * When mwioncall is off, the device mwi lamp is suppressed while the device has an active call of its own. Instead of rescanning
+ * all line channels on each line status change, each channel is accounted once in device->mwiState.activeCalls and the device
+ * lamp is only re-evaluated when the first call starts or the last call ends.
+ *
+ * \note called from sccp_indicate (state transitions) and sccp_channel_setDevice (device changes)
+ */
+void sccp_mwi_updateActiveCall(channelPtr channel, boolean_t detach)
+{
+	if (!channel) {
+		return;
+	}
+	AUTO_RELEASE(sccp_device_t, d , sccp_channel_getDevice(channel));
+	if (!d) {
+		return;
+	}
+	boolean_t active = (!detach && channel->state != SCCP_CHANNELSTATE_ONHOOK && channel->state != SCCP_CHANNELSTATE_DOWN) ? TRUE : FALSE;
+	boolean_t changed = FALSE;
+
+	sccp_mutex_lock(&d->mwiState.lock);
+	if (active != channel->mwiActiveCall) {
+		d->mwiState.activeCalls += active ? 1 : -1;
+		channel->mwiActiveCall = active;
+		changed = (d->mwiState.activeCalls == (active ? 1 : 0)) ? TRUE : FALSE;			/* first call started / last call ended */
+	}
+	sccp_mutex_unlock(&d->mwiState.lock);
+
+	if (changed && !d->mwioncall && sccp_device_getRegistrationState(d) == SKINNY_DEVICE_RS_OK) {
+		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_updateActiveCall) %s active call, re-evaluate mwi light\n", DEV_ID_LOG(d), active ? "first" : "no more");
+		sccp_mwi_updateDeviceLamp(d, FALSE);
+	}
+}
+
+/*!
+ * \brief Set the device MWI light and voicemail display from the aggregated device MWI state
+ * \param device SCCP Device
+ * \param forceDisplay resend the voicemail display message, even if the counts did not change
+ *
+ * \note only sends a lamp message when the effective lamp state changes, redundant updates are counted in mwiState.lampUpdatesSuppressed
+ */
+static void sccp_mwi_updateDeviceLamp(sccp_device_t * device, boolean_t forceDisplay)
+{
+	int newmsgs = 0, oldmsgs = 0;
+	boolean_t suppress_lamp = FALSE;
+	boolean_t sendLamp = FALSE;
+	boolean_t countsChanged = FALSE;
+
+	sccp_mutex_lock(&device->mwiState.lock);
+	newmsgs = device->mwiState.newmsgs > 0 ? device->mwiState.newmsgs : 0;
+	oldmsgs = device->mwiState.oldmsgs > 0 ? device->mwiState.oldmsgs : 0;
+	if (!device->mwioncall && device->mwiState.activeCalls > 0) {
+		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: we have an active channel, suppress mwi light\n", DEV_ID_LOG(device));
+		suppress_lamp = TRUE;
+	}
+
 	/* check current device mwi light status*/
 	uint32_t devicemask = (1 << SCCP_DEVICE_MWILIGHT);
-	uint32_t devicestate = device->mwilight;
 	uint32_t devicenewstate = (((newmsgs && !suppress_lamp) ? 1 : 0) << SCCP_DEVICE_MWILIGHT);
 
-	//char binstr1[41] = "", binstr2[41] = "";
-	//sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_check) devicestate:%s, mask:%s\n", DEV_ID_LOG(device), sccp_dec2binstr(binstr1, 32, devicestate), sccp_dec2binstr(binstr2, 32, devicemask));
-	//sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_check) devicenewstate:%s\n", DEV_ID_LOG(device), sccp_dec2binstr(binstr1, 32, devicenewstate));
-
-	//if ((device->mwilight & newstate) != 0) {										/* needs update */
-	if ((devicestate & devicemask) != devicenewstate) {
-		//boolean_t devicelamp_active = FALSE;
-		if (device->mwilight & (1 << SCCP_DEVICE_MWILIGHT)) {
-			sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_check) De-activate\n", DEV_ID_LOG(device));
-			device->mwilight &= ~(1 << SCCP_DEVICE_MWILIGHT);								/* deactivate */
-		} else {
+	if ((device->mwilight & devicemask) != devicenewstate) {
+		if (devicenewstate) {
 			sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_check) Activate\n", DEV_ID_LOG(device));
-			device->mwilight |= (1 << SCCP_DEVICE_MWILIGHT);								/* activate */
-			//devicelamp_active = TRUE;
+			device->mwilight |= devicemask;									/* activate */
+		} else {
+			sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_check) De-activate\n", DEV_ID_LOG(device));
+			device->mwilight &= ~devicemask;								/* deactivate */
 		}
-		//sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_check) new device->mwilight:%s\n", DEV_ID_LOG(device), sccp_dec2binstr(binstr1, 32, device->mwilight));
-		sccp_msg_t *msg = NULL;
+		device->mwiState.lampUpdates++;
+		sendLamp = TRUE;
+	}
+	if (!sendLamp) {
+		device->mwiState.lampUpdatesSuppressed++;							/* counted once per update, here only */
+	}
+	if (device->voicemailStatistic.newmsgs != newmsgs || device->voicemailStatistic.oldmsgs != oldmsgs) {
+		device->voicemailStatistic.oldmsgs = oldmsgs;
+		device->voicemailStatistic.newmsgs = newmsgs;
+		countsChanged = TRUE;
+	}
+	sccp_mutex_unlock(&device->mwiState.lock);
 
-		REQ(msg, SetLampMessage);
-		msg->data.SetLampMessage.lel_stimulus = htolel(SKINNY_STIMULUS_VOICEMAIL);
-		msg->data.SetLampMessage.lel_stimulusInstance = 0;
-		msg->data.SetLampMessage.lel_lampMode = (device->mwilight & (1 << SCCP_DEVICE_MWILIGHT)) ? htolel(device->mwilamp) : htolel(SKINNY_LAMP_OFF);
-		//msg->data.SetLampMessage.lel_lampMode = devicelamp_active ? htolel(device->mwilamp) : htolel(SKINNY_LAMP_OFF);
-		sccp_dev_send(device, msg);
-		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_check) Turn %s the MWI light (newmsgs: %d->%d)\n", DEV_ID_LOG(device), (device->mwilight & (1 << SCCP_DEVICE_MWILIGHT)) ? "ON" : "OFF", newmsgs,  device->voicemailStatistic.newmsgs);
+	if (sendLamp) {
+		sccp_device_setLamp(device, SKINNY_STIMULUS_VOICEMAIL, 0, devicenewstate ? device->mwilamp : SKINNY_LAMP_OFF);
+		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_check) Turn %s the MWI light (newmsgs: %d)\n", DEV_ID_LOG(device), devicenewstate ? "ON" : "OFF", newmsgs);
 	}
+
 	/* we should check the display only once, maybe we need a priority stack -MC */
-	if (newmsgs > 0) {
-		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_check) Set Have Voicemail on Display\n", DEV_ID_LOG(device));
-		char buffer[StationMaxDisplayTextSize];
-		snprintf(buffer, StationMaxDisplayTextSize, "%s: (%u/%u)", SKINNY_DISP_YOU_HAVE_VOICEMAIL, newmsgs, oldmsgs);
-		sccp_device_addMessageToStack(device, SCCP_MESSAGE_PRIORITY_VOICEMAIL, buffer);
-	} else {
-		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_check) Remove Have Voicemail from Display\n", DEV_ID_LOG(device));
-		sccp_device_clearMessageFromStack(device, SCCP_MESSAGE_PRIORITY_VOICEMAIL);
+	if (countsChanged || forceDisplay) {
+		if (newmsgs > 0) {
+			sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_check) Set Have Voicemail on Display\n", DEV_ID_LOG(device));
+			char buffer[StationMaxDisplayTextSize];
+			snprintf(buffer, StationMaxDisplayTextSize, "%s: (%u/%u)", SKINNY_DISP_YOU_HAVE_VOICEMAIL, newmsgs, oldmsgs);
+			sccp_device_addMessageToStack(device, SCCP_MESSAGE_PRIORITY_VOICEMAIL, buffer);
+		} else {
+			sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_check) Remove Have Voicemail from Display\n", DEV_ID_LOG(device));
+			sccp_device_clearMessageFromStack(device, SCCP_MESSAGE_PRIORITY_VOICEMAIL);
+		}
+	}
+}
+
+/*!
+ * \brief Check MWI Status for Device
+ * \param d SCCP Device
+ * \note called after device registration, re-accounts all attached lines and forces the device lamp / display to the aggregated state
+ */
+void sccp_mwi_check(sccp_device_t * d)
+{
+	AUTO_RELEASE(sccp_device_t, device , sccp_device_retain(d));
+	if (!device) {
+		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "SCCP: (mwi_check) called with NULL device!\n");
+		return;
+	}
+
+	uint32_t instance = SCCP_FIRST_LINEINSTANCE;
+	for (instance = SCCP_FIRST_LINEINSTANCE; instance < device->lineButtons.size; instance++) {
+		if (device->lineButtons.instance[instance] && device->lineButtons.instance[instance]->line) {
+			sccp_mwi_updateLineDeviceCounts(device->lineButtons.instance[instance], FALSE);
+		}
 	}
-	device->voicemailStatistic.oldmsgs = oldmsgs;
-	device->voicemailStatistic.newmsgs = newmsgs;
+	sccp_mwi_updateDeviceLamp(device, TRUE);
 }
 
 /*!
@@ -729,6 +969,7 @@ int sccp_show_mwi_subscriptions(int fd, sccp_cli_totals_t *totals, struct manses
 #define CLI_AMI_TABLE_FIELDS 																\
  		CLI_AMI_TABLE_FIELD(Mailbox,		"-10.10",	s,	10,	subscription->mailbox)						\
  		CLI_AMI_TABLE_FIELD(LineName,		"-30.30",	s,	30,	linebuf)							\
+ 		CLI_AMI_TABLE_FIELD(Lines,		"5",		d,	5,	SCCP_LIST_GETSIZE(&subscription->sccp_mailboxLine))		\
  		CLI_AMI_TABLE_FIELD(Context,		"-15.15",	s,	15,	subscription->context)						\
  		CLI_AMI_TABLE_FIELD(New,		"3.3",		d,	3,	subscription->currentVoicemailStatistic.newmsgs)		\
  		CLI_AMI_TABLE_FIELD(Old,		"3.3",		d,	3,	subscription->currentVoicemailStatistic.oldmsgs)		\
@@ -738,6 +979,7 @@ int sccp_show_mwi_subscriptions(int fd, sccp_cli_totals_t *totals, struct manses
 #define CLI_AMI_TABLE_FIELDS 																\
  		CLI_AMI_TABLE_FIELD(Mailbox,		"-10.10",	s,	10,	subscription->mailbox)						\
  		CLI_AMI_TABLE_FIELD(LineName,		"-30.30",	s,	30,	linebuf)							\
+ 		CLI_AMI_TABLE_FIELD(Lines,		"5",		d,	5,	SCCP_LIST_GETSIZE(&subscription->sccp_mailboxLine))		\
  		CLI_AMI_TABLE_FIELD(Context,		"-15.15",	s,	15,	subscription->context)						\
  		CLI_AMI_TABLE_FIELD(New,		"3.3",		d,	3,	subscription->currentVoicemailStatistic.newmsgs)		\
  		CLI_AMI_TABLE_FIELD(Old,		"3.3",		d,	3,	subscription->currentVoicemailStatistic.oldmsgs)
@@ -38,6 +38,8 @@ SCCP_API void SCCP_CALL sccp_mwi_event(void *userdata, struct stasis_subscriptio
 SCCP_API int SCCP_CALL sccp_mwi_checksubscription(const void *ptr);
 #endif
 SCCP_API void SCCP_CALL sccp_mwi_setMWILineStatus(sccp_linedevices_t * lineDevice);
+SCCP_API void SCCP_CALL sccp_mwi_updateLineDeviceCounts(sccp_linedevices_t * lineDevice, boolean_t detach);
+SCCP_API void SCCP_CALL sccp_mwi_updateActiveCall(channelPtr channel, boolean_t detach);
 SCCP_API int SCCP_CALL sccp_show_mwi_subscriptions(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
 __END_C_EXTERN__
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -501,6 +501,7 @@ sccp_channel_t * sccp_pbx_hangup(sccp_channel_t * channel)
 		/* done - remove call from transferee, transferer */
 
 		sccp_line_removeChannel(l, c);
+		sccp_channel_removeFromIndex(c);								/* not every hangup path reaches sccp_channel_clean */
 
 		if (!d) {
 			/* channel is not answered, just ringin over all devices */
@@ -530,6 +531,7 @@ sccp_channel_t * sccp_pbx_hangup(sccp_channel_t * channel)
 		/* requesting statistics */
 		sccp_channel_StatisticsRequest(c);
 		sccp_channel_clean(c);
+		sccp_device_checkPendingUpdates(l);							/* reset devices which postponed their reload reset because of this call */
 		return c;								/* returning unretained so that sccp_wrapper_asterisk113_hangup can clear out the last reference */
 	}
 	return NULL;
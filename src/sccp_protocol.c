@@ -21,6 +21,46 @@
 
 SCCP_FILE_VERSION(__FILE__, "");
 
+#include "sccp_protocol_layouts.hh"
+
+/* =================================================================================================================== Dynamic Messages */
+/*!
+ * \brief Build a dynamic message, with the strings packed after the fixed part as described by the layout
+ * \param layoutId Dynamic Message Layout
+ * \param device SCCP Device (only used for layouts which need a locale conversion, may be NULL)
+ * \param strings layout->numStrings strings, NULL is send as an empty string
+ * \return SCCP Message of exactly the needed length, the caller fills in the fixed part
+ */
+static sccp_msg_t *sccp_protocol_encodeDynamic(sccp_dynamic_layout_id_t layoutId, constDevicePtr device, const char *const strings[])
+{
+	const sccp_dynamic_layout_t *layout = &sccp_dynamic_layouts[layoutId];
+	size_t len[SCCP_LAYOUT_MAX_STRINGS];
+	size_t pkt_len = layout->fixedSize + layout->trailer;
+	sccp_msg_t *msg = NULL;
+	char *ptr = NULL;
+	uint8_t i;
+
+	for (i = 0; i < layout->numStrings; i++) {
+		len[i] = strings[i] ? strlen(strings[i]) : 0;
+		pkt_len += len[i] + 1;
+	}
+	if (!(msg = sccp_build_packet(layout->messageId, pkt_len))) {
+		return NULL;
+	}
+	ptr = (char *) &msg->data + layout->fixedSize;
+	for (i = 0; i < layout->numStrings; i++) {
+		if (len[i]) {
+			if (layout->locale && device) {
+				device->copyStr2Locale(device, ptr, (ICONV_CONST char *) strings[i], len[i] + 1);
+			} else {
+				memcpy(ptr, strings[i], len[i]);
+			}
+		}
+		ptr += len[i] + 1;										/* terminator already zeroed by sccp_build_packet */
+	}
+	return msg;
+}
+
 /* CallInfo Message */
 
 /* =================================================================================================================== Send Messages */
@@ -78,73 +118,56 @@ static void sccp_protocol_sendCallInfoV7 (const sccp_callinfo_t * const ci, cons
 {
  	pbx_assert(device != NULL);
 	sccp_msg_t *msg = NULL;
-
-	unsigned int dataSize = 12;
-	char data[dataSize][StationMaxNameSize];
-	int data_len[dataSize];
-	unsigned int i = 0;
-	int dummy_len = 0;
-
-	memset(data, 0, dataSize * StationMaxNameSize);
-	
-	int originalCdpnRedirectReason = 0;
-	int lastRedirectingReason = 0;
-	sccp_callerid_presentation_t presentation = CALLERID_PRESENTATION_ALLOWED;
-	iCallInfo.Getter(ci,
-		SCCP_CALLINFO_CALLINGPARTY_NUMBER, &data[0],
-		SCCP_CALLINFO_CALLEDPARTY_NUMBER, &data[1],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_NUMBER, &data[2],
-		SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NUMBER, &data[3],
-		SCCP_CALLINFO_CALLINGPARTY_VOICEMAIL, &data[4],
-		SCCP_CALLINFO_CALLEDPARTY_VOICEMAIL, &data[5],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_VOICEMAIL, &data[6],
-		SCCP_CALLINFO_LAST_REDIRECTINGPARTY_VOICEMAIL, &data[7],
-		SCCP_CALLINFO_CALLINGPARTY_NAME, &data[8],
-		SCCP_CALLINFO_CALLEDPARTY_NAME, &data[9],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_NAME, &data[10],
-		SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NAME, &data[11],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON, &originalCdpnRedirectReason,
-		SCCP_CALLINFO_LAST_REDIRECT_REASON, &lastRedirectingReason,
-		SCCP_CALLINFO_PRESENTATION, &presentation,
-		SCCP_CALLINFO_KEY_SENTINEL);
-
-
-	for (i = 0; i < dataSize; i++) {
-		data_len[i] = strlen(data[i]);
-		dummy_len += data_len[i];
+	uint32_t generation = 0;
+
+	/* the strings and the ci derived fields only change with the callinfo generation, reuse the last encoding when possible */
+	if (!(msg = iCallInfo.GetEncoded(ci, SCCP_CALLINFO_ENCODING_V7, &generation))) {
+		char data[12][StationMaxNameSize];
+		const char *strings[12];
+		unsigned int i = 0;
+
+		memset(data, 0, sizeof(data));
+
+		int originalCdpnRedirectReason = 0;
+		int lastRedirectingReason = 0;
+		sccp_callerid_presentation_t presentation = CALLERID_PRESENTATION_ALLOWED;
+		iCallInfo.Getter(ci,
+			SCCP_CALLINFO_CALLINGPARTY_NUMBER, &data[0],
+			SCCP_CALLINFO_CALLEDPARTY_NUMBER, &data[1],
+			SCCP_CALLINFO_ORIG_CALLEDPARTY_NUMBER, &data[2],
+			SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NUMBER, &data[3],
+			SCCP_CALLINFO_CALLINGPARTY_VOICEMAIL, &data[4],
+			SCCP_CALLINFO_CALLEDPARTY_VOICEMAIL, &data[5],
+			SCCP_CALLINFO_ORIG_CALLEDPARTY_VOICEMAIL, &data[6],
+			SCCP_CALLINFO_LAST_REDIRECTINGPARTY_VOICEMAIL, &data[7],
+			SCCP_CALLINFO_CALLINGPARTY_NAME, &data[8],
+			SCCP_CALLINFO_CALLEDPARTY_NAME, &data[9],
+			SCCP_CALLINFO_ORIG_CALLEDPARTY_NAME, &data[10],
+			SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NAME, &data[11],
+			SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON, &originalCdpnRedirectReason,
+			SCCP_CALLINFO_LAST_REDIRECT_REASON, &lastRedirectingReason,
+			SCCP_CALLINFO_PRESENTATION, &presentation,
+			SCCP_CALLINFO_KEY_SENTINEL);
+
+		for (i = 0; i < ARRAY_LEN(strings); i++) {
+			strings[i] = data[i];
+		}
+		if (!(msg = sccp_protocol_encodeDynamic(SCCP_LAYOUT_CALLINFO_V7, device, strings))) {
+			return;
+		}
+		msg->data.CallInfoDynamicMessage.partyPIRestrictionBits = presentation ? 0x0 : 0xf;
+		msg->data.CallInfoDynamicMessage.lel_originalCdpnRedirectReason = htolel(originalCdpnRedirectReason);
+		msg->data.CallInfoDynamicMessage.lel_lastRedirectingReason = htolel(lastRedirectingReason);
+		iCallInfo.StoreEncoded(ci, SCCP_CALLINFO_ENCODING_V7, generation, msg);
 	}
-
-	int hdr_len = sizeof(msg->data.CallInfoDynamicMessage) + (dataSize - 3);
-	msg = sccp_build_packet(CallInfoDynamicMessage, hdr_len + dummy_len);
-
 	msg->data.CallInfoDynamicMessage.lel_lineInstance = htolel(lineInstance);
 	msg->data.CallInfoDynamicMessage.lel_callReference = htolel(callid);
 	msg->data.CallInfoDynamicMessage.lel_callType = htolel(calltype);
-	msg->data.CallInfoDynamicMessage.partyPIRestrictionBits = presentation ? 0x0 : 0xf;
 	//! note callSecurityStatus:
 	// when indicating ringout we should set SKINNY_CALLSECURITYSTATE_UNKNOWN
 	// when indicating connected we should set SKINNY_CALLSECURITYSTATE_NOTAUTHENTICATED
 	msg->data.CallInfoDynamicMessage.lel_callSecurityStatus = htolel(callsecurityState);
 	msg->data.CallInfoDynamicMessage.lel_callInstance = htolel(callInstance);
-	msg->data.CallInfoDynamicMessage.lel_originalCdpnRedirectReason = htolel(originalCdpnRedirectReason);
-	msg->data.CallInfoDynamicMessage.lel_lastRedirectingReason = htolel(lastRedirectingReason);
-
-	if (dummy_len) {
-		int bufferSize = dummy_len + dataSize;
-		char buffer[bufferSize];
-		int pos = 0;
-
-		memset(&buffer[0], 0, bufferSize);
-		for (i = 0; i < dataSize; i++) {
-			if (data_len[i]) {
-				memcpy(&buffer[pos], data[i], data_len[i]);
-				pos += data_len[i] + 1;
-			} else {
-				pos += 1;
-			}
-		}
-		memcpy(&msg->data.CallInfoDynamicMessage.dummy, &buffer[0], bufferSize);
-	}
 
 	//sccp_log((DEBUGCAT_CHANNEL | DEBUGCAT_LINE | DEBUGCAT_INDICATE)) (VERBOSE_PREFIX_3 "%s: Send callinfo(V7) for %s channel %d/%d on line instance %d\n", (device) ? device->id : "(null)", skinny_calltype2str(calltype), callid, callInstance, lineInstance);
 	//if ((GLOB(debug) & (DEBUGCAT_CHANNEL | DEBUGCAT_LINE | DEBUGCAT_INDICATE)) != 0) {
@@ -158,59 +181,55 @@ static void sccp_protocol_sendCallInfoV16 (const sccp_callinfo_t * const ci, con
 {
  	pbx_assert(device != NULL);
 	sccp_msg_t *msg = NULL;
-
-	unsigned int dataSize = 15;
-	char data[dataSize][StationMaxNameSize];
-	memset(data, 0, dataSize * StationMaxNameSize);
-
-	int originalCdpnRedirectReason = 0;
-	int lastRedirectingReason = 0;
-	sccp_callerid_presentation_t presentation = CALLERID_PRESENTATION_ALLOWED;
-	iCallInfo.Getter(ci,
-		SCCP_CALLINFO_CALLINGPARTY_NUMBER, &data[0],
-		SCCP_CALLINFO_ORIG_CALLINGPARTY_NUMBER, &data[1],
-		SCCP_CALLINFO_CALLEDPARTY_NUMBER, &data[2],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_NUMBER, &data[3],
-		SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NUMBER, &data[4],
-		SCCP_CALLINFO_CALLINGPARTY_VOICEMAIL, &data[5],
-		SCCP_CALLINFO_CALLEDPARTY_VOICEMAIL, &data[6],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_VOICEMAIL, &data[7],
-		SCCP_CALLINFO_LAST_REDIRECTINGPARTY_VOICEMAIL, &data[8],
-		SCCP_CALLINFO_CALLINGPARTY_NAME, &data[9],
-		SCCP_CALLINFO_CALLEDPARTY_NAME, &data[10],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_NAME, &data[11],
-		SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NAME, &data[12],
-		SCCP_CALLINFO_HUNT_PILOT_NUMBER, &data[13],
-		SCCP_CALLINFO_HUNT_PILOT_NAME, &data[14],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON, &originalCdpnRedirectReason,
-		SCCP_CALLINFO_LAST_REDIRECT_REASON, &lastRedirectingReason,
-		SCCP_CALLINFO_PRESENTATION, &presentation,
-		SCCP_CALLINFO_KEY_SENTINEL);
-
-	unsigned int field = 0;
-	int data_len = 0;
-	int dummy_len = 0;
-	uint8_t *dummy = sccp_calloc(sizeof(uint8_t), dataSize * StationMaxNameSize);
-	if (!dummy) {
-		return;
-	}
-	for (field = 0; field < dataSize; field++) {
-		data_len = strlen(data[field]) + 1; 		//add NULL terminator
-		memcpy(dummy + dummy_len, data[field], data_len);
-		dummy_len += data_len;
+	uint32_t generation = 0;
+
+	if (!(msg = iCallInfo.GetEncoded(ci, SCCP_CALLINFO_ENCODING_V16, &generation))) {
+		char data[15][StationMaxNameSize];
+		const char *strings[15];
+		unsigned int i = 0;
+
+		memset(data, 0, sizeof(data));
+
+		int originalCdpnRedirectReason = 0;
+		int lastRedirectingReason = 0;
+		sccp_callerid_presentation_t presentation = CALLERID_PRESENTATION_ALLOWED;
+		iCallInfo.Getter(ci,
+			SCCP_CALLINFO_CALLINGPARTY_NUMBER, &data[0],
+			SCCP_CALLINFO_ORIG_CALLINGPARTY_NUMBER, &data[1],
+			SCCP_CALLINFO_CALLEDPARTY_NUMBER, &data[2],
+			SCCP_CALLINFO_ORIG_CALLEDPARTY_NUMBER, &data[3],
+			SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NUMBER, &data[4],
+			SCCP_CALLINFO_CALLINGPARTY_VOICEMAIL, &data[5],
+			SCCP_CALLINFO_CALLEDPARTY_VOICEMAIL, &data[6],
+			SCCP_CALLINFO_ORIG_CALLEDPARTY_VOICEMAIL, &data[7],
+			SCCP_CALLINFO_LAST_REDIRECTINGPARTY_VOICEMAIL, &data[8],
+			SCCP_CALLINFO_CALLINGPARTY_NAME, &data[9],
+			SCCP_CALLINFO_CALLEDPARTY_NAME, &data[10],
+			SCCP_CALLINFO_ORIG_CALLEDPARTY_NAME, &data[11],
+			SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NAME, &data[12],
+			SCCP_CALLINFO_HUNT_PILOT_NUMBER, &data[13],
+			SCCP_CALLINFO_HUNT_PILOT_NAME, &data[14],
+			SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON, &originalCdpnRedirectReason,
+			SCCP_CALLINFO_LAST_REDIRECT_REASON, &lastRedirectingReason,
+			SCCP_CALLINFO_PRESENTATION, &presentation,
+			SCCP_CALLINFO_KEY_SENTINEL);
+
+		for (i = 0; i < ARRAY_LEN(strings); i++) {
+			strings[i] = data[i];
+		}
+		if (!(msg = sccp_protocol_encodeDynamic(SCCP_LAYOUT_CALLINFO_V16, device, strings))) {
+			return;
+		}
+		msg->data.CallInfoDynamicMessage.partyPIRestrictionBits		= presentation ? 0x0 : 0xf;
+		msg->data.CallInfoDynamicMessage.lel_originalCdpnRedirectReason	= htolel(originalCdpnRedirectReason);
+		msg->data.CallInfoDynamicMessage.lel_lastRedirectingReason	= htolel(lastRedirectingReason);
+		iCallInfo.StoreEncoded(ci, SCCP_CALLINFO_ENCODING_V16, generation, msg);
 	}
-	int hdr_len = sizeof(msg->data.CallInfoDynamicMessage) - 4;
-	msg = sccp_build_packet(CallInfoDynamicMessage, hdr_len + dummy_len);
 	msg->data.CallInfoDynamicMessage.lel_lineInstance		= htolel(lineInstance);
 	msg->data.CallInfoDynamicMessage.lel_callReference		= htolel(callid);
 	msg->data.CallInfoDynamicMessage.lel_callType			= htolel(calltype);
-	msg->data.CallInfoDynamicMessage.partyPIRestrictionBits		= presentation ? 0x0 : 0xf;
 	msg->data.CallInfoDynamicMessage.lel_callSecurityStatus		= htolel(callsecurityState);
 	msg->data.CallInfoDynamicMessage.lel_callInstance		= htolel(callInstance);
-	msg->data.CallInfoDynamicMessage.lel_originalCdpnRedirectReason	= htolel(originalCdpnRedirectReason);
-	msg->data.CallInfoDynamicMessage.lel_lastRedirectingReason	= htolel(lastRedirectingReason);
-	memcpy(&msg->data.CallInfoDynamicMessage.dummy, dummy, dummy_len);
-	sccp_free(dummy);
 	
 	//sccp_log((DEBUGCAT_CHANNEL | DEBUGCAT_LINE | DEBUGCAT_INDICATE)) (VERBOSE_PREFIX_3 "%s: Send callinfo(V20) for %s channel %d/%d on line instance %d\n", (device) ? device->id : "(null)", skinny_calltype2str(calltype), callid, callInstance, lineInstance);
 	//if ((GLOB(debug) & (DEBUGCAT_CHANNEL | DEBUGCAT_LINE | DEBUGCAT_INDICATE)) != 0) {
@@ -289,13 +308,12 @@ static void sccp_protocol_sendDynamicDisplayprompt(constDevicePtr device, uint8_
 {
 	sccp_msg_t *msg = NULL;
 
-	int msg_len = strlen(message);
-	int hdr_len = sizeof(msg->data.DisplayDynamicPromptStatusMessage) - 3;
-	msg = sccp_build_packet(DisplayDynamicPromptStatusMessage, hdr_len + msg_len);
+	if (!(msg = sccp_protocol_encodeDynamic(SCCP_LAYOUT_DISPLAYPROMPT, device, &message))) {
+		return;
+	}
 	msg->data.DisplayDynamicPromptStatusMessage.lel_messageTimeout = htolel(timeout);
 	msg->data.DisplayDynamicPromptStatusMessage.lel_callReference = htolel(callid);
 	msg->data.DisplayDynamicPromptStatusMessage.lel_lineInstance = htolel(lineInstance);
-	memcpy(&msg->data.DisplayDynamicPromptStatusMessage.dummy, message, msg_len);
 
 	sccp_dev_send(device, msg);
 	sccp_log((DEBUGCAT_DEVICE | DEBUGCAT_LINE)) (VERBOSE_PREFIX_3 "%s: Display prompt on line %d, callid %d, timeout %d\n", device->id, lineInstance, callid, timeout);
@@ -327,12 +345,10 @@ static void sccp_protocol_sendDynamicDisplayNotify(constDevicePtr device, uint8_
 {
 	sccp_msg_t *msg = NULL;
 
-	int msg_len = strlen(message);
-
-	int hdr_len = sizeof(msg->data.DisplayDynamicNotifyMessage) - 3;
-	msg = sccp_build_packet(DisplayDynamicNotifyMessage, hdr_len + msg_len);
+	if (!(msg = sccp_protocol_encodeDynamic(SCCP_LAYOUT_DISPLAYNOTIFY, device, &message))) {
+		return;
+	}
 	msg->data.DisplayDynamicNotifyMessage.lel_displayTimeout = htolel(timeout);
-	memcpy(&msg->data.DisplayDynamicNotifyMessage.dummy, message, msg_len);
 
 	sccp_dev_send(device, msg);
 	sccp_log((DEBUGCAT_DEVICE | DEBUGCAT_LINE)) (VERBOSE_PREFIX_3 "%s: Display notify timeout %d\n", device->id, timeout);
@@ -365,12 +381,11 @@ static void sccp_protocol_sendDynamicDisplayPriNotify(constDevicePtr device, uin
 {
 	sccp_msg_t *msg = NULL;
 
-	int msg_len = strlen(message);
-	int hdr_len = sizeof(msg->data.DisplayDynamicPriNotifyMessage) - 3;
-	msg = sccp_build_packet(DisplayDynamicPriNotifyMessage, hdr_len + msg_len);
+	if (!(msg = sccp_protocol_encodeDynamic(SCCP_LAYOUT_DISPLAYPRINOTIFY, device, &message))) {
+		return;
+	}
 	msg->data.DisplayDynamicPriNotifyMessage.lel_displayTimeout = htolel(timeout);
 	msg->data.DisplayDynamicPriNotifyMessage.lel_priority = htolel(priority);
-	memcpy(&msg->data.DisplayDynamicPriNotifyMessage.dummy, message, msg_len);
 
 	sccp_dev_send(device, msg);
 	sccp_log((DEBUGCAT_DEVICE | DEBUGCAT_LINE)) (VERBOSE_PREFIX_3 "%s: Display notify timeout %d\n", device->id, timeout);
@@ -1095,25 +1110,15 @@ static void sccp_protocol_sendLineStatRespV3(constDevicePtr d, uint32_t lineNumb
  */
 static void sccp_protocol_sendLineStatRespV17(constDevicePtr d, uint32_t lineNumber, char *dirNumber, char *fullyQualifiedDisplayName, char *displayName)
 {
-	int dirNumLen = dirNumber ? sccp_strlen(dirNumber): 0;
-	int fqdnLen = fullyQualifiedDisplayName ? sccp_strlen(fullyQualifiedDisplayName): 0;
-	int displayNameLen = displayName ? sccp_strlen(displayName): 0;
-	int dummyLen = dirNumLen + fqdnLen + displayNameLen;
+	const char *strings[] = {dirNumber, fullyQualifiedDisplayName, displayName};
+	sccp_msg_t *msg = NULL;
 
- 	int pktLen = SCCP_PACKET_HEADER + dummyLen;
-	sccp_msg_t *msg = sccp_build_packet(LineStatDynamicMessage, pktLen);
+	if (!(msg = sccp_protocol_encodeDynamic(SCCP_LAYOUT_LINESTAT_V17, d, strings))) {
+		return;
+	}
 	msg->data.LineStatDynamicMessage.lel_lineNumber = htolel(lineNumber);
 	//Bit-field: 1-Original Dialed 2-Redirected Dialed, 4-Calling line ID, 8-Calling name ID
 	msg->data.LineStatDynamicMessage.lel_lineType = htolel(15);
-	if (dummyLen) {
-		char *dummyPtr = msg->data.LineStatDynamicMessage.dummy;
-		d->copyStr2Locale(d, dummyPtr, dirNumber, dirNumLen+1);
-		dummyPtr += dirNumLen + 1;
-		d->copyStr2Locale(d, dummyPtr, fullyQualifiedDisplayName, fqdnLen+1);	
-		dummyPtr += fqdnLen + 1;
-		d->copyStr2Locale(d, dummyPtr, displayName, displayNameLen+1);
-		dummyPtr += displayNameLen + 1;
-	}
 	sccp_dev_send(d, msg);
 }
 /* done - sendLineStat */
@@ -1741,4 +1746,159 @@ gcc_inline const char *msgtype2str(sccp_mid_t msgId)
 	return "SCCP: Requested MessageId does not exist";
 }
 
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+#define NUM_BENCHMARK_LOOPS 100000
+
+/*!
+ * \brief Split the packed strings of a dynamic message, the inverse of sccp_protocol_encodeDynamic
+ * \return number of strings found within the message length
+ */
+static int sccp_protocol_decodeDynamic(sccp_dynamic_layout_id_t layoutId, constMessagePtr msg, const char *strings[])
+{
+	const sccp_dynamic_layout_t *layout = &sccp_dynamic_layouts[layoutId];
+	const char *ptr = (const char *) &msg->data + layout->fixedSize;
+	const char *end = (const char *) &msg->data + (letohl(msg->header.length) - 4);
+	const char *nul = NULL;
+	int i;
+
+	for (i = 0; i < layout->numStrings; i++) {
+		if (ptr >= end || !(nul = memchr(ptr, '\0', end - ptr))) {
+			break;
+		}
+		strings[i] = ptr;
+		ptr = nul + 1;
+	}
+	return i;
+}
+
+/* the pkt_len the hand written senders used to calculate */
+static size_t sccp_protocol_legacyDynamicLength(sccp_dynamic_layout_id_t layoutId, const char *const strings[])
+{
+	const sccp_msg_t *msg = NULL;
+	size_t sum = 0;
+	int i;
+
+	for (i = 0; i < sccp_dynamic_layouts[layoutId].numStrings; i++) {
+		sum += strlen(strings[i]);
+	}
+	switch (layoutId) {
+		case SCCP_LAYOUT_DISPLAYPROMPT:
+			return sizeof(msg->data.DisplayDynamicPromptStatusMessage) - 3 + sum;
+		case SCCP_LAYOUT_DISPLAYNOTIFY:
+			return sizeof(msg->data.DisplayDynamicNotifyMessage) - 3 + sum;
+		case SCCP_LAYOUT_DISPLAYPRINOTIFY:
+			return sizeof(msg->data.DisplayDynamicPriNotifyMessage) - 3 + sum;
+		case SCCP_LAYOUT_CALLINFO_V7:
+			return sizeof(msg->data.CallInfoDynamicMessage) + (12 - 3) + sum;
+		case SCCP_LAYOUT_CALLINFO_V16:
+			return sizeof(msg->data.CallInfoDynamicMessage) - 4 + sum + 15;
+		case SCCP_LAYOUT_LINESTAT_V17:
+			return SCCP_PACKET_HEADER + sum;
+		case SCCP_LAYOUT_SENTINEL:
+			break;
+	}
+	return 0;
+}
+
+static const char *const test_strings[2][SCCP_LAYOUT_MAX_STRINGS] = {
+	{"1000", "2000", "", "", "", "", "", "", "Alice", "Bob", "", "", "", "", ""},
+	{"0123456789012345678901234", "1001", "1002", "1003", "vm1000", "vm2000", "vm1002", "vm1003", "Alice Alpha", "Bob Bravo", "Charlie Charlie", "Delta Dawn", "8000", "Hunt Pilot", "Hunt Pilot Name"},
+};
+
+AST_TEST_DEFINE(sccp_protocol_dynamic_roundtrip)
+{
+	const char *decoded[SCCP_LAYOUT_MAX_STRINGS];
+	sccp_msg_t *msg = NULL, *legacy = NULL;
+	int layoutId, set, i;
+	enum ast_test_result_state res = AST_TEST_PASS;
+
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "dynamic_roundtrip";
+			info->category = "/channels/chan_sccp/protocol/";
+			info->summary = "chan-sccp-b dynamic message encoder round trip";
+			info->description = "dynamic messages decode to the strings they were encoded from, with the length the hand written senders produced";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	for (layoutId = 0; layoutId < SCCP_LAYOUT_SENTINEL; layoutId++) {
+		for (set = 0; set < (int) ARRAY_LEN(test_strings); set++) {
+			pbx_test_status_update(test, "%s, string set %d...\n", sccp_dynamic_layouts[layoutId].name, set);
+			msg = sccp_protocol_encodeDynamic(layoutId, NULL, test_strings[set]);
+			legacy = sccp_build_packet(sccp_dynamic_layouts[layoutId].messageId, sccp_protocol_legacyDynamicLength(layoutId, test_strings[set]));
+			pbx_test_validate_cleanup(test, msg && legacy, res, cleanup);
+			pbx_test_validate_cleanup(test, letohl(msg->header.lel_messageId) == sccp_dynamic_layouts[layoutId].messageId, res, cleanup);
+			pbx_test_validate_cleanup(test, msg->header.length == legacy->header.length, res, cleanup);
+			pbx_test_validate_cleanup(test, sccp_protocol_decodeDynamic(layoutId, msg, decoded) == sccp_dynamic_layouts[layoutId].numStrings, res, cleanup);
+			for (i = 0; i < sccp_dynamic_layouts[layoutId].numStrings; i++) {
+				pbx_test_validate_cleanup(test, sccp_strequals(decoded[i], test_strings[set][i]), res, cleanup);
+			}
+			sccp_free(msg);
+			sccp_free(legacy);
+		}
+	}
+
+	pbx_test_status_update(test, "Truncated message, only the complete strings are decoded...\n");
+	msg = sccp_protocol_encodeDynamic(SCCP_LAYOUT_CALLINFO_V16, NULL, test_strings[1]);
+	pbx_test_validate_cleanup(test, msg, res, cleanup);
+	msg->header.length = htolel(sccp_dynamic_layouts[SCCP_LAYOUT_CALLINFO_V16].fixedSize + 4 + strlen(test_strings[1][0]) + 1 + strlen(test_strings[1][1]));
+	pbx_test_validate_cleanup(test, sccp_protocol_decodeDynamic(SCCP_LAYOUT_CALLINFO_V16, msg, decoded) == 1, res, cleanup);
+
+cleanup:
+	if (msg) {
+		sccp_free(msg);
+	}
+	if (legacy) {
+		sccp_free(legacy);
+	}
+	return res;
+}
+
+AST_TEST_DEFINE(sccp_protocol_dynamic_benchmark)
+{
+	sccp_msg_t *msg = NULL;
+	struct timeval start;
+	long ms = 0;
+	int layoutId, loop;
+
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "dynamic_benchmark";
+			info->category = "/channels/chan_sccp/protocol/";
+			info->summary = "chan-sccp-b dynamic message encoder throughput";
+			info->description = "reports the encode throughput per dynamic message layout";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	for (layoutId = 0; layoutId < SCCP_LAYOUT_SENTINEL; layoutId++) {
+		start = pbx_tvnow();
+		for (loop = 0; loop < NUM_BENCHMARK_LOOPS; loop++) {
+			if ((msg = sccp_protocol_encodeDynamic(layoutId, NULL, test_strings[loop % 2]))) {
+				sccp_free(msg);
+			}
+		}
+		ms = ast_tvdiff_ms(pbx_tvnow(), start);
+		pbx_test_status_update(test, "%-24s %d messages in %ld ms (%ld msg/s)\n", sccp_dynamic_layouts[layoutId].name, NUM_BENCHMARK_LOOPS, ms, ms ? (NUM_BENCHMARK_LOOPS * 1000L) / ms : 0);
+	}
+	return AST_TEST_PASS;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_protocol_dynamic_roundtrip);
+	AST_TEST_REGISTER(sccp_protocol_dynamic_benchmark);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_protocol_dynamic_roundtrip);
+	AST_TEST_UNREGISTER(sccp_protocol_dynamic_benchmark);
+}
+#endif
+
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,60 @@
+/*!
+ * \file        sccp_protocol_layouts.hh
+ * \brief       SCCP Dynamic Message Layouts
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \remarks     Describes, once per protocol version, the packed string part of the dynamic messages. The fixed part is described by the
+ *              message structures in sccp_protocol.h. Only included by sccp_protocol.c.
+ */
+
+/*!
+ * \brief Dynamic Message Layouts
+ */
+typedef enum {
+	SCCP_LAYOUT_DISPLAYPROMPT,
+	SCCP_LAYOUT_DISPLAYNOTIFY,
+	SCCP_LAYOUT_DISPLAYPRINOTIFY,
+	SCCP_LAYOUT_CALLINFO_V7,
+	SCCP_LAYOUT_CALLINFO_V16,
+	SCCP_LAYOUT_LINESTAT_V17,
+	SCCP_LAYOUT_SENTINEL,
+} sccp_dynamic_layout_id_t;
+
+#define SCCP_LAYOUT_MAX_STRINGS 15										/*!< Highest numStrings in sccp_dynamic_layouts */
+
+/*!
+ * \brief Dynamic Message Layout Structure
+ * \note pkt_len = fixedSize + sum(strlen + 1) + trailer, the trailer keeps the lengths the hand written senders used to produce
+ */
+typedef struct sccp_dynamic_layout {
+	const char *const name;											/*!< Layout Name */
+	const sccp_mid_t messageId;										/*!< Skinny Message Id */
+	const uint8_t protocolVersion;										/*!< Lowest protocol version using this layout */
+	const uint8_t numStrings;										/*!< Number of packed, NULL terminated, strings */
+	const uint8_t trailer;											/*!< Extra zero bytes after the last string */
+	const boolean_t locale;											/*!< Convert the strings using device->copyStr2Locale */
+	const size_t fixedSize;											/*!< Offset of the packed strings in msg->data */
+} sccp_dynamic_layout_t;
+
+/* *INDENT-OFF* */
+static const sccp_dynamic_layout_t sccp_dynamic_layouts[SCCP_LAYOUT_SENTINEL] = {
+	/* message text */
+	[SCCP_LAYOUT_DISPLAYPROMPT]	= {"DisplayDynamicPromptStatus",	DisplayDynamicPromptStatusMessage,	0,	1,	0,	FALSE,	offsetof(sccp_data_t, DisplayDynamicPromptStatusMessage.dummy)},
+	[SCCP_LAYOUT_DISPLAYNOTIFY]	= {"DisplayDynamicNotify",		DisplayDynamicNotifyMessage,		0,	1,	0,	FALSE,	offsetof(sccp_data_t, DisplayDynamicNotifyMessage.dummy)},
+	[SCCP_LAYOUT_DISPLAYPRINOTIFY]	= {"DisplayDynamicPriNotify",		DisplayDynamicPriNotifyMessage,		0,	1,	0,	FALSE,	offsetof(sccp_data_t, DisplayDynamicPriNotifyMessage.dummy)},
+
+	/* callingParty, calledParty, originalCalledParty, lastRedirectingParty, cgpnVoiceMailbox, cdpnVoiceMailbox, originalCdpnVoiceMailbox,
+	 * lastRedirectingVoiceMailbox, callingPartyName, calledPartyName, originalCalledPartyName, lastRedirectingPartyName */
+	[SCCP_LAYOUT_CALLINFO_V7]	= {"CallInfoDynamic (V7)",		CallInfoDynamicMessage,			7,	12,	1,	FALSE,	offsetof(sccp_data_t, CallInfoDynamicMessage.dummy)},
+
+	/* callingParty, originalCallingParty, calledParty, originalCalledParty, lastRedirectingParty, cgpnVoiceMailbox, cdpnVoiceMailbox,
+	 * originalCdpnVoiceMailbox, lastRedirectingVoiceMailbox, callingPartyName, calledPartyName, originalCalledPartyName,
+	 * lastRedirectingPartyName, HuntPilotNumber, HuntPilotName */
+	[SCCP_LAYOUT_CALLINFO_V16]	= {"CallInfoDynamic (V16)",		CallInfoDynamicMessage,			16,	15,	0,	FALSE,	offsetof(sccp_data_t, CallInfoDynamicMessage.dummy)},
+
+	/* lineDirNumber, lineFullyQualifiedDisplayName, lineDisplayName */
+	[SCCP_LAYOUT_LINESTAT_V17]	= {"LineStatDynamic (V17)",		LineStatDynamicMessage,			17,	3,	1,	TRUE,	offsetof(sccp_data_t, LineStatDynamicMessage.dummy)},
+};
+/* *INDENT-ON* */
+
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,682 @@
+/*!
+ * \file        sccp_realtime.c
+ * \brief       SCCP Realtime Lookup Cache
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * Results of realtime device and line lookups are kept for GLOB(realtimecachettl) seconds. Lookups which did not return a row
+ * are remembered as negative entries, so that unknown devices retrying their registration and devicestate queries for unknown
+ * lines do not cause a database round trip each time.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_config.h"
+#include "sccp_device.h"
+#include "sccp_line.h"
+#include "sccp_realtime.h"
+#include "sccp_utils.h"
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#include <asterisk/cli.h>
+
+#ifdef CS_SCCP_REALTIME
+#define SCCP_REALTIME_CACHE_HASH_SIZE SCCP_HASH_PRIME								/*!< Number of buckets per table */
+#define SCCP_REALTIME_CACHE_MAX_ENTRIES 1024									/*!< Upper limit of cached entries per table */
+
+typedef struct sccp_realtime_cacheEntry sccp_realtime_cacheEntry_t;
+
+struct sccp_realtime_cacheEntry {
+	sccp_realtime_cacheEntry_t *hashNext;									/*!< Next Entry in the same Bucket */
+	char *name;												/*!< Lookup Key (name column) */
+	PBX_VARIABLE_TYPE *variables;										/*!< Cached Row, NULL for a negative entry */
+	time_t expires;												/*!< Time this entry has to be looked up again */
+};
+
+static struct sccp_realtime_cache {
+	const char *name;											/*!< Table Description */
+	sccp_mutex_t lock;											/*!< Protects buckets, entries and statistics */
+	sccp_realtime_cacheEntry_t *buckets[SCCP_REALTIME_CACHE_HASH_SIZE];
+	uint32_t entries;											/*!< Number of cached Entries */
+	uint32_t hits;												/*!< Lookups served from a positive Entry */
+	uint32_t negativeHits;											/*!< Lookups served from a negative Entry */
+	uint32_t misses;											/*!< Lookups sent to the database */
+	uint32_t expired;											/*!< Entries dropped because their ttl passed */
+} sccp_realtime_caches[SCCP_REALTIME_CACHE_SENTINEL] = {
+	[SCCP_REALTIME_CACHE_DEVICE] = {.name = "device"},
+	[SCCP_REALTIME_CACHE_LINE] = {.name = "line"},
+};
+
+static const char *sccp_realtime_tableName(sccp_realtime_cache_table_t table)
+{
+	return (table == SCCP_REALTIME_CACHE_DEVICE) ? GLOB(realtimedevicetable) : GLOB(realtimelinetable);
+}
+
+/*!
+ * \brief Duplicate a variable list, so that the cache and the caller each own a copy
+ */
+static PBX_VARIABLE_TYPE *sccp_realtime_variables_dup(const PBX_VARIABLE_TYPE *variables)
+{
+	PBX_VARIABLE_TYPE *out = NULL, *tmp = NULL, *new_var = NULL;
+	const PBX_VARIABLE_TYPE *v = NULL;
+
+	for (v = variables; v; v = v->next) {
+		if (!(new_var = pbx_variable_new(v->name, v->value, ""))) {
+			pbx_log(LOG_ERROR, "SCCP: (sccp_realtime) Error while creating new var structure\n");
+			if (out) {
+				pbx_variables_destroy(out);
+			}
+			return NULL;
+		}
+		if (!tmp) {
+			out = new_var;
+		} else {
+			tmp->next = new_var;
+		}
+		tmp = new_var;
+	}
+	return out;
+}
+
+static void sccp_realtime_cacheEntry_destroy(sccp_realtime_cacheEntry_t *entry)
+{
+	if (entry->variables) {
+		pbx_variables_destroy(entry->variables);
+	}
+	sccp_free(entry->name);
+	sccp_free(entry);
+}
+
+/*!
+ * \brief Remove all entries of a table
+ * \note cache->lock needs to be held
+ */
+static int sccp_realtime_cache_clear(struct sccp_realtime_cache *cache)
+{
+	sccp_realtime_cacheEntry_t *entry = NULL;
+	int bucket, removed = 0;
+
+	for (bucket = 0; bucket < SCCP_REALTIME_CACHE_HASH_SIZE; bucket++) {
+		while ((entry = cache->buckets[bucket])) {
+			cache->buckets[bucket] = entry->hashNext;
+			sccp_realtime_cacheEntry_destroy(entry);
+			removed++;
+		}
+	}
+	cache->entries = 0;
+	return removed;
+}
+
+/*!
+ * \brief Drop all expired entries of a table
+ * \note cache->lock needs to be held
+ */
+static void sccp_realtime_cache_purge(struct sccp_realtime_cache *cache, time_t now)
+{
+	sccp_realtime_cacheEntry_t *entry = NULL, **entryp = NULL;
+	int bucket;
+
+	for (bucket = 0; bucket < SCCP_REALTIME_CACHE_HASH_SIZE; bucket++) {
+		entryp = &cache->buckets[bucket];
+		while ((entry = *entryp)) {
+			if (entry->expires <= now) {
+				*entryp = entry->hashNext;
+				sccp_realtime_cacheEntry_destroy(entry);
+				cache->entries--;
+				cache->expired++;
+			} else {
+				entryp = &entry->hashNext;
+			}
+		}
+	}
+}
+
+/*!
+ * \brief Find a cached lookup result
+ * \param cache Realtime Table Cache
+ * \param name Value of the name column
+ * \param variables Copy of the cached row, NULL when a negative entry was found
+ * \return TRUE if the cache could answer the lookup
+ */
+static boolean_t sccp_realtime_cache_lookup(struct sccp_realtime_cache *cache, const char *name, PBX_VARIABLE_TYPE **variables)
+{
+	sccp_realtime_cacheEntry_t *entry = NULL, **entryp = NULL;
+	unsigned int hash = sccp_strhash(name, SCCP_REALTIME_CACHE_HASH_SIZE);
+	boolean_t found = FALSE;
+	time_t now = time(NULL);
+
+	*variables = NULL;
+	sccp_mutex_lock(&cache->lock);
+	for (entryp = &cache->buckets[hash]; (entry = *entryp); entryp = &entry->hashNext) {
+		if (sccp_strequals(entry->name, name)) {
+			if (entry->expires <= now) {
+				*entryp = entry->hashNext;
+				sccp_realtime_cacheEntry_destroy(entry);
+				cache->entries--;
+				cache->expired++;
+			} else if (entry->variables) {
+				*variables = sccp_realtime_variables_dup(entry->variables);
+				found = (*variables != NULL);
+			} else {
+				found = TRUE;
+			}
+			break;
+		}
+	}
+	if (found) {
+		if (*variables) {
+			cache->hits++;
+		} else {
+			cache->negativeHits++;
+		}
+	} else {
+		cache->misses++;
+	}
+	sccp_mutex_unlock(&cache->lock);
+	return found;
+}
+
+/*!
+ * \brief Store the result of a database lookup (variables == NULL stores a negative entry)
+ */
+static void sccp_realtime_cache_store(struct sccp_realtime_cache *cache, const char *name, const PBX_VARIABLE_TYPE *variables)
+{
+	sccp_realtime_cacheEntry_t *entry = NULL, **entryp = NULL;
+	unsigned int hash = sccp_strhash(name, SCCP_REALTIME_CACHE_HASH_SIZE);
+	time_t now = time(NULL);
+
+	if (!GLOB(realtimecachettl)) {
+		return;
+	}
+	if (!(entry = sccp_calloc(1, sizeof(sccp_realtime_cacheEntry_t)))) {
+		pbx_log(LOG_ERROR, "SCCP: (sccp_realtime) Unable to allocate cache entry for '%s'\n", name);
+		return;
+	}
+	if (!(entry->name = pbx_strdup(name)) || (variables && !(entry->variables = sccp_realtime_variables_dup(variables)))) {
+		sccp_realtime_cacheEntry_destroy(entry);
+		return;
+	}
+	entry->expires = now + GLOB(realtimecachettl);
+
+	sccp_mutex_lock(&cache->lock);
+	for (entryp = &cache->buckets[hash]; *entryp; entryp = &(*entryp)->hashNext) {			/* replace a previous result */
+		if (sccp_strequals((*entryp)->name, name)) {
+			sccp_realtime_cacheEntry_t *old = *entryp;
+
+			*entryp = old->hashNext;
+			sccp_realtime_cacheEntry_destroy(old);
+			cache->entries--;
+			break;
+		}
+	}
+	if (cache->entries >= SCCP_REALTIME_CACHE_MAX_ENTRIES) {
+		sccp_realtime_cache_purge(cache, now);
+	}
+	if (cache->entries < SCCP_REALTIME_CACHE_MAX_ENTRIES) {
+		entry->hashNext = cache->buckets[hash];
+		cache->buckets[hash] = entry;
+		cache->entries++;
+		entry = NULL;
+	}
+	sccp_mutex_unlock(&cache->lock);
+
+	if (entry) {												/* cache is full of live entries */
+		sccp_realtime_cacheEntry_destroy(entry);
+	}
+}
+
+/*!
+ * \brief start realtime cache
+ */
+void sccp_realtime_module_start(void)
+{
+	int table;
+
+	for (table = 0; table < SCCP_REALTIME_CACHE_SENTINEL; table++) {
+		pbx_mutex_init(&sccp_realtime_caches[table].lock);
+	}
+}
+
+/*!
+ * \brief stop realtime cache
+ */
+void sccp_realtime_module_stop(void)
+{
+	int table;
+
+	sccp_realtime_cache_flush();
+	for (table = 0; table < SCCP_REALTIME_CACHE_SENTINEL; table++) {
+		pbx_mutex_destroy(&sccp_realtime_caches[table].lock);
+	}
+}
+
+/*!
+ * \brief Load a row from a realtime table by name, using the lookup cache
+ * \param table Realtime Table
+ * \param name Value of the name column
+ * \return Variable list owned by the caller (to be freed with pbx_variables_destroy) or NULL if there is no such row
+ */
+PBX_VARIABLE_TYPE *sccp_realtime_load(sccp_realtime_cache_table_t table, const char *name)
+{
+	PBX_VARIABLE_TYPE *variables = NULL;
+	const char *tablename = NULL;
+
+	if (table >= SCCP_REALTIME_CACHE_SENTINEL || sccp_strlen_zero(name)) {
+		return NULL;
+	}
+	tablename = sccp_realtime_tableName(table);
+	if (sccp_strlen_zero(tablename)) {
+		return NULL;
+	}
+	if (sccp_realtime_cache_lookup(&sccp_realtime_caches[table], name, &variables)) {
+		sccp_log((DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: Realtime %s '%s' served from cache (%s)\n", sccp_realtime_caches[table].name, name, variables ? "found" : "not found");
+		return variables;
+	}
+	variables = pbx_load_realtime(tablename, "name", name, NULL);
+	sccp_realtime_cache_store(&sccp_realtime_caches[table], name, variables);
+	return variables;
+}
+
+/*!
+ * \brief Remove the entry for a single name from a table cache
+ */
+static void sccp_realtime_cache_remove(struct sccp_realtime_cache *cache, const char *name)
+{
+	sccp_realtime_cacheEntry_t *entry = NULL, **entryp = NULL;
+
+	sccp_mutex_lock(&cache->lock);
+	for (entryp = &cache->buckets[sccp_strhash(name, SCCP_REALTIME_CACHE_HASH_SIZE)]; (entry = *entryp); entryp = &entry->hashNext) {
+		if (sccp_strequals(entry->name, name)) {
+			*entryp = entry->hashNext;
+			sccp_realtime_cacheEntry_destroy(entry);
+			cache->entries--;
+			break;
+		}
+	}
+	sccp_mutex_unlock(&cache->lock);
+}
+
+/*!
+ * \brief Forget the cached result for a single name
+ */
+void sccp_realtime_cache_invalidate(sccp_realtime_cache_table_t table, const char *name)
+{
+	if (table >= SCCP_REALTIME_CACHE_SENTINEL || sccp_strlen_zero(name)) {
+		return;
+	}
+	sccp_realtime_cache_remove(&sccp_realtime_caches[table], name);
+}
+
+/*!
+ * \brief Remove all cached entries and reset the statistics
+ * \return Number of entries removed
+ */
+int sccp_realtime_cache_flush(void)
+{
+	struct sccp_realtime_cache *cache = NULL;
+	int table, removed = 0;
+
+	for (table = 0; table < SCCP_REALTIME_CACHE_SENTINEL; table++) {
+		cache = &sccp_realtime_caches[table];
+		sccp_mutex_lock(&cache->lock);
+		removed += sccp_realtime_cache_clear(cache);
+		cache->hits = cache->negativeHits = cache->misses = cache->expired = 0;
+		sccp_mutex_unlock(&cache->lock);
+	}
+	sccp_log((DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: Realtime cache flushed, %d entries removed\n", removed);
+	return removed;
+}
+
+#define SCCP_REALTIME_PRELOAD_CHUNK 32										/*!< Number of rows built by a single preload job */
+
+typedef struct sccp_realtime_preload sccp_realtime_preload_t;
+typedef struct sccp_realtime_preloadJob sccp_realtime_preloadJob_t;
+
+struct sccp_realtime_preload {
+	sccp_mutex_t lock;											/*!< Protects the counters below */
+	pbx_cond_t done;											/*!< Signalled when a job finishes */
+	int pending;												/*!< Jobs not finished yet */
+	int built;												/*!< Objects built */
+	int failed;												/*!< Objects which could not be built */
+};
+
+struct sccp_realtime_preloadJob {
+	sccp_realtime_preload_t *preload;
+	sccp_realtime_cache_table_t table;
+	int numrows;
+	char *names[SCCP_REALTIME_PRELOAD_CHUNK];
+	PBX_VARIABLE_TYPE *rows[SCCP_REALTIME_PRELOAD_CHUNK];
+};
+
+/*!
+ * \brief Build the devices or lines of a single preload job
+ * \note runs on the general threadpool, the job is freed when done
+ */
+static void *sccp_realtime_preloadJob_run(void *ptr)
+{
+	sccp_realtime_preloadJob_t *job = (sccp_realtime_preloadJob_t *) ptr;
+	sccp_realtime_preload_t *preload = job->preload;
+	int row, built = 0, failed = 0;
+
+	for (row = 0; row < job->numrows; row++) {
+		if (job->table == SCCP_REALTIME_CACHE_DEVICE) {
+			AUTO_RELEASE(sccp_device_t, d , sccp_device_find_byid(job->names[row], FALSE));
+
+			if (!d && (d = sccp_device_create(job->names[row]))) {
+				sccp_config_applyDeviceConfiguration(d, job->rows[row]);
+				sccp_config_restoreDeviceFeatureStatus(d);
+				sccp_device_addToGlobals(d);
+				d->realtime = TRUE;
+				built++;
+			} else if (!d) {
+				pbx_log(LOG_ERROR, "SCCP: Unable to build realtime device '%s'\n", job->names[row]);
+				failed++;
+			}
+		} else {
+			AUTO_RELEASE(sccp_line_t, l , sccp_line_find_byname(job->names[row], FALSE));
+
+			if (!l && (l = sccp_line_create(job->names[row]))) {
+				sccp_config_applyLineConfiguration(l, job->rows[row]);
+				l->realtime = TRUE;
+				sccp_line_addToGlobals(l);
+				built++;
+			} else if (!l) {
+				pbx_log(LOG_ERROR, "SCCP: Unable to build realtime line '%s'\n", job->names[row]);
+				failed++;
+			}
+		}
+		pbx_variables_destroy(job->rows[row]);
+		sccp_free(job->names[row]);
+	}
+	sccp_free(job);
+
+	sccp_mutex_lock(&preload->lock);
+	preload->built += built;
+	preload->failed += failed;
+	preload->pending--;
+	pbx_cond_signal(&preload->done);
+	sccp_mutex_unlock(&preload->lock);
+	return NULL;
+}
+
+/*!
+ * \brief Hand a preload job to the general threadpool, or build it directly if that is not possible
+ */
+static void sccp_realtime_preloadJob_dispatch(sccp_realtime_preloadJob_t *job)
+{
+	sccp_mutex_lock(&job->preload->lock);
+	job->preload->pending++;
+	sccp_mutex_unlock(&job->preload->lock);
+
+	if (!(GLOB(general_threadpool) && sccp_threadpool_add_work(GLOB(general_threadpool), (void *) sccp_realtime_preloadJob_run, (void *) job))) {
+		sccp_realtime_preloadJob_run(job);
+	}
+}
+
+/*!
+ * \brief Load all rows of a realtime table with a single query and build them in parallel
+ * \return number of rows found in the table
+ */
+static int sccp_realtime_preloadTable(sccp_realtime_preload_t *preload, sccp_realtime_cache_table_t table)
+{
+	const char *tablename = sccp_realtime_tableName(table);
+	struct ast_config *cfg = NULL;
+	sccp_realtime_preloadJob_t *job = NULL;
+	char *category = NULL;
+	int numrows = 0;
+
+	if (sccp_strlen_zero(tablename) || !pbx_check_realtime(tablename)) {
+		sccp_log((DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: Realtime table for %ss not configured, skipping preload\n", sccp_realtime_caches[table].name);
+		return 0;
+	}
+	if (!(cfg = pbx_load_realtime_multientry(tablename, "name LIKE", "%", SENTINEL))) {
+		return 0;
+	}
+	while ((category = pbx_category_browse(cfg, category))) {
+		PBX_VARIABLE_TYPE *row = NULL;
+
+		if (sccp_strlen_zero(category) || !(row = sccp_realtime_variables_dup(pbx_variable_browse(cfg, category)))) {
+			continue;
+		}
+		if (!job && !(job = sccp_calloc(1, sizeof(sccp_realtime_preloadJob_t)))) {
+			pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+			pbx_variables_destroy(row);
+			break;
+		}
+		if (!(job->names[job->numrows] = pbx_strdup(category))) {
+			pbx_variables_destroy(row);
+			continue;
+		}
+		job->preload = preload;
+		job->table = table;
+		job->rows[job->numrows++] = row;
+		numrows++;
+		if (job->numrows == SCCP_REALTIME_PRELOAD_CHUNK) {
+			sccp_realtime_preloadJob_dispatch(job);
+			job = NULL;
+		}
+	}
+	if (job) {
+		if (job->numrows) {
+			sccp_realtime_preloadJob_dispatch(job);
+		} else {
+			sccp_free(job);
+		}
+	}
+	pbx_config_destroy(cfg);
+	return numrows;
+}
+
+/*!
+ * \brief Wait for all jobs of a preload phase, reporting progress every second
+ */
+static void sccp_realtime_preloadWait(sccp_realtime_preload_t *preload, const char *what, int numrows)
+{
+	struct timeval tp;
+	struct timespec ts;
+
+	sccp_mutex_lock(&preload->lock);
+	while (preload->pending > 0) {
+		gettimeofday(&tp, NULL);
+		ts.tv_sec = tp.tv_sec + 1;
+		ts.tv_nsec = tp.tv_usec * 1000;
+		pbx_cond_timedwait(&preload->done, &preload->lock, &ts);
+		if (preload->pending > 0) {
+			pbx_log(LOG_NOTICE, "SCCP: Realtime preload: %d of %d %ss built\n", preload->built + preload->failed, numrows, what);
+		}
+	}
+	sccp_mutex_unlock(&preload->lock);
+}
+
+/*!
+ * \brief Build all realtime lines and devices before the listener is opened
+ *
+ * Lines are built first, so that the devices referring to them find them in memory. Each table is read with a single
+ * multientry query, the rows are then built in chunks on the general threadpool.
+ */
+void sccp_realtime_preload(void)
+{
+	sccp_realtime_preload_t preload = {.pending = 0};
+	struct timeval start = pbx_tvnow();
+	int numlines = 0, numdevices = 0, linesBuilt = 0;
+
+	pbx_mutex_init(&preload.lock);
+	pbx_cond_init(&preload.done, NULL);
+
+	pbx_log(LOG_NOTICE, "SCCP: Preloading realtime lines and devices\n");
+	numlines = sccp_realtime_preloadTable(&preload, SCCP_REALTIME_CACHE_LINE);
+	sccp_realtime_preloadWait(&preload, "line", numlines);
+	linesBuilt = preload.built;
+
+	preload.built = 0;
+	numdevices = sccp_realtime_preloadTable(&preload, SCCP_REALTIME_CACHE_DEVICE);
+	sccp_realtime_preloadWait(&preload, "device", numdevices);
+
+	pbx_log(LOG_NOTICE, "SCCP: Realtime preload built %d of %d lines and %d of %d devices (%d failed) in %ld ms\n", linesBuilt, numlines, preload.built, numdevices, preload.failed, (long) ast_tvdiff_ms(pbx_tvnow(), start));
+
+	pbx_cond_destroy(&preload.done);
+	pbx_mutex_destroy(&preload.lock);
+}
+
+/*!
+ * \brief Show Realtime Cache Statistics
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_show_realtime_cache(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	int table;
+	struct sccp_realtime_cache *cache = NULL;
+	uint32_t entries = 0, hits = 0, negativeHits = 0, misses = 0, expired = 0;
+
+#define CLI_AMI_TABLE_NAME RealtimeCache
+#define CLI_AMI_TABLE_PER_ENTRY_NAME RealtimeTable
+#define CLI_AMI_TABLE_ITERATOR for(table = 0; table < SCCP_REALTIME_CACHE_SENTINEL; table++)
+#define CLI_AMI_TABLE_BEFORE_ITERATION 														\
+		cache = &sccp_realtime_caches[table];											\
+		sccp_mutex_lock(&cache->lock);												\
+		entries = cache->entries;												\
+		hits = cache->hits;													\
+		negativeHits = cache->negativeHits;											\
+		misses = cache->misses;													\
+		expired = cache->expired;												\
+		sccp_mutex_unlock(&cache->lock);
+#define CLI_AMI_TABLE_FIELDS 															\
+ 		CLI_AMI_TABLE_FIELD(Type,		"-6.6",		s,	6,	cache->name)						\
+ 		CLI_AMI_TABLE_FIELD(Table,		"-20.20",	s,	20,	sccp_realtime_tableName(table))				\
+ 		CLI_AMI_TABLE_FIELD(TTL,		"5",		d,	5,	GLOB(realtimecachettl))					\
+ 		CLI_AMI_TABLE_FIELD(Entries,		"7",		u,	7,	entries)						\
+ 		CLI_AMI_TABLE_FIELD(Hits,		"8",		u,	8,	hits)							\
+ 		CLI_AMI_TABLE_FIELD(NegHits,		"8",		u,	8,	negativeHits)						\
+ 		CLI_AMI_TABLE_FIELD(Misses,		"8",		u,	8,	misses)							\
+ 		CLI_AMI_TABLE_FIELD(Expired,		"8",		u,	8,	expired)
+#include "sccp_cli_table.h"
+
+	if (s) {
+		totals->lines = local_line_total;
+		totals->tables = 1;
+	}
+	return RESULT_SUCCESS;
+}
+
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+AST_TEST_DEFINE(sccp_realtime_cache_test)
+{
+	int rc = AST_TEST_PASS;
+	struct sccp_realtime_cache *cache = NULL;
+	struct sccp_realtime_cache *live = &sccp_realtime_caches[SCCP_REALTIME_CACHE_DEVICE];
+	PBX_VARIABLE_TYPE *row = NULL, *variables = NULL;
+	uint16_t ttl = GLOB(realtimecachettl);
+	uint32_t misses = 0, negativeHits = 0;
+	int removed = 0;
+	const char *unknown = "SEPTESTUNKNOWN0";
+
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "cache";
+			info->category = "/channels/chan_sccp/realtime/";
+			info->summary = "chan-sccp-b realtime lookup cache test";
+			info->description = "stores positive and negative realtime results in a private cache, checks hits, expiry and clear. When the device table is configured in extconfig (for example the sqlite3 backend using conf/sqlite3.sql) an unknown device is looked up twice to verify that only the first lookup reaches the database";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	if (!(cache = sccp_calloc(1, sizeof(struct sccp_realtime_cache)))) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return AST_TEST_FAIL;
+	}
+	cache->name = "test";
+	pbx_mutex_init(&cache->lock);
+	GLOB(realtimecachettl) = 60;
+
+	pbx_test_status_update(test, "Store a positive and a negative entry...\n");
+	row = pbx_variable_new("description", "realtime cache test", "");
+	pbx_test_validate_cleanup(test, row != NULL, rc, cleanup);
+	sccp_realtime_cache_store(cache, "SEPTESTCACHED0", row);
+	sccp_realtime_cache_store(cache, unknown, NULL);
+	pbx_test_validate_cleanup(test, cache->entries == 2, rc, cleanup);
+
+	pbx_test_status_update(test, "Positive hit returns a copy of the row...\n");
+	pbx_test_validate_cleanup(test, sccp_realtime_cache_lookup(cache, "SEPTESTCACHED0", &variables), rc, cleanup);
+	pbx_test_validate_cleanup(test, variables != NULL && variables != row && sccp_strequals(variables->value, "realtime cache test"), rc, cleanup);
+	pbx_variables_destroy(variables);
+	variables = NULL;
+
+	pbx_test_status_update(test, "Negative hit...\n");
+	pbx_test_validate_cleanup(test, sccp_realtime_cache_lookup(cache, unknown, &variables), rc, cleanup);
+	pbx_test_validate_cleanup(test, variables == NULL, rc, cleanup);
+
+	pbx_test_status_update(test, "Names are case sensitive, like the database lookup...\n");
+	pbx_test_validate_cleanup(test, !sccp_realtime_cache_lookup(cache, "septestcached0", &variables), rc, cleanup);
+	pbx_test_validate_cleanup(test, cache->hits == 1 && cache->negativeHits == 1 && cache->misses == 1, rc, cleanup);
+
+	pbx_test_status_update(test, "Expired entries are dropped on lookup...\n");
+	cache->buckets[sccp_strhash(unknown, SCCP_REALTIME_CACHE_HASH_SIZE)]->expires = time(NULL) - 1;
+	pbx_test_validate_cleanup(test, !sccp_realtime_cache_lookup(cache, unknown, &variables), rc, cleanup);
+	pbx_test_validate_cleanup(test, cache->entries == 1 && cache->expired == 1, rc, cleanup);
+
+	pbx_test_status_update(test, "Remove a single entry...\n");
+	sccp_realtime_cache_remove(cache, "SEPTESTCACHED0");
+	pbx_test_validate_cleanup(test, cache->entries == 0, rc, cleanup);
+	sccp_realtime_cache_store(cache, unknown, NULL);
+
+	pbx_test_status_update(test, "Clear...\n");
+	sccp_mutex_lock(&cache->lock);
+	removed = sccp_realtime_cache_clear(cache);
+	sccp_mutex_unlock(&cache->lock);
+	pbx_test_validate_cleanup(test, removed == 1 && cache->entries == 0, rc, cleanup);
+
+	if (!sccp_strlen_zero(GLOB(realtimedevicetable)) && pbx_check_realtime(GLOB(realtimedevicetable))) {
+		pbx_test_status_update(test, "Lookup unknown device '%s' in realtime table '%s' twice...\n", unknown, GLOB(realtimedevicetable));
+		sccp_realtime_cache_invalidate(SCCP_REALTIME_CACHE_DEVICE, unknown);
+		misses = live->misses;
+		negativeHits = live->negativeHits;
+		variables = sccp_realtime_load(SCCP_REALTIME_CACHE_DEVICE, unknown);
+		pbx_test_validate_cleanup(test, variables == NULL, rc, cleanup);
+		variables = sccp_realtime_load(SCCP_REALTIME_CACHE_DEVICE, unknown);
+		pbx_test_validate_cleanup(test, variables == NULL, rc, cleanup);
+		pbx_test_validate_cleanup(test, live->misses - misses == 1 && live->negativeHits - negativeHits == 1, rc, cleanup);
+		sccp_realtime_cache_invalidate(SCCP_REALTIME_CACHE_DEVICE, unknown);
+	} else {
+		pbx_test_status_update(test, "Realtime device table not configured, skipping database lookup\n");
+	}
+
+cleanup:
+	if (row) {
+		pbx_variables_destroy(row);
+	}
+	if (variables) {
+		pbx_variables_destroy(variables);
+	}
+	sccp_mutex_lock(&cache->lock);
+	sccp_realtime_cache_clear(cache);
+	sccp_mutex_unlock(&cache->lock);
+	pbx_mutex_destroy(&cache->lock);
+	sccp_free(cache);
+	GLOB(realtimecachettl) = ttl;
+	return rc;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_realtime_cache_test);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_realtime_cache_test);
+}
+#endif
+#endif
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
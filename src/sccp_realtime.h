@@ -0,0 +1,30 @@
+/*!
+ * \file        sccp_realtime.h
+ * \brief       SCCP Realtime Lookup Cache Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ */
+#pragma once
+#include "sccp_cli.h"
+
+__BEGIN_C_EXTERN__
+#ifdef CS_SCCP_REALTIME
+/*!
+ * \brief Realtime tables served through the lookup cache
+ */
+typedef enum {
+	SCCP_REALTIME_CACHE_DEVICE,
+	SCCP_REALTIME_CACHE_LINE,
+	SCCP_REALTIME_CACHE_SENTINEL,
+} sccp_realtime_cache_table_t;
+
+SCCP_API void SCCP_CALL sccp_realtime_module_start(void);
+SCCP_API void SCCP_CALL sccp_realtime_module_stop(void);
+SCCP_API PBX_VARIABLE_TYPE * SCCP_CALL sccp_realtime_load(sccp_realtime_cache_table_t table, const char *name);
+SCCP_API void SCCP_CALL sccp_realtime_cache_invalidate(sccp_realtime_cache_table_t table, const char *name);
+SCCP_API int SCCP_CALL sccp_realtime_cache_flush(void);
+SCCP_API void SCCP_CALL sccp_realtime_preload(void);
+SCCP_API int SCCP_CALL sccp_show_realtime_cache(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+#endif
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -74,9 +74,15 @@ static struct sccp_refcount_obj_info {
 	[SCCP_REF_LINEDEVICE] = {NULL, "linedevice", DEBUGCAT_LINE},
 	[SCCP_REF_LINE] = {NULL, "line", DEBUGCAT_LINE},
 	[SCCP_REF_DEVICE] = {NULL, "device", DEBUGCAT_DEVICE},
+	[SCCP_REF_BUTTONINDEX] = {NULL, "buttonindex", DEBUGCAT_BUTTONTEMPLATE},
+	[SCCP_REF_DEVSTATE] = {NULL, "devstate", DEBUGCAT_FEATURE},
+	[SCCP_REF_DEVSTATEEXECUTOR] = {NULL, "devstateexec", DEBUGCAT_FEATURE},
 #if CS_TEST_FRAMEWORK
 	[SCCP_REF_TEST] = {NULL, "test", DEBUGCAT_HIGH},
 #endif
+#if CS_SCCP_STANDALONE
+	[SCCP_REF_BENCHMARK] = {NULL, "benchmark", DEBUGCAT_HIGH},
+#endif
 /* *INDENT-ON* */
 };
 
@@ -23,9 +23,15 @@ enum sccp_refcounted_types {
 	SCCP_REF_LINEDEVICE,
 	SCCP_REF_LINE,
 	SCCP_REF_DEVICE,
+	SCCP_REF_BUTTONINDEX,
+	SCCP_REF_DEVSTATE,
+	SCCP_REF_DEVSTATEEXECUTOR,
 #if CS_TEST_FRAMEWORK
 	SCCP_REF_TEST,
 #endif
+#if CS_SCCP_STANDALONE
+	SCCP_REF_BENCHMARK,
+#endif
 };
 
 enum sccp_refcount_runstate {
@@ -15,6 +15,7 @@
 SCCP_FILE_VERSION(__FILE__, "");
 
 #include "sccp_actions.h"
+#include "sccp_capture.h"
 #include "sccp_cli.h"
 #include "sccp_device.h"
 #include "sccp_netsock.h"
@@ -80,6 +81,8 @@ struct sccp_session {
 	struct sockaddr_storage ourip;										/*!< Our IP is for rtp use */
 	struct sockaddr_storage ourIPv4;
 	char designator[40];
+	sccp_capture_t *capture;										/*!< Session Capture (NULL when not capturing) */
+	boolean_t replay;											/*!< Replay Session, outbound messages are only counted */
 };														/*!< SCCP Session Structure */
 
 boolean_t sccp_session_getOurIP(constSessionPtr session, struct sockaddr_storage * const sockAddrStorage, int family)
@@ -274,6 +277,9 @@ static gcc_inline int process_buffer(sccp_session_t * s, sccp_msg_t *msg, unsign
 			res = -1;
 			break;
 		}
+		if (s->capture) {
+			sccp_capture_frame(s->capture, SCCP_CAPTURE_INBOUND, buffer, payload_len);
+		}
 		if (dont_expect(session_buffer2msg(s, buffer, payload_len, msg) != 0)) {
 			res = -2;
 			break;
@@ -517,6 +523,10 @@ static void destroy_session(sccp_session_t * s, uint8_t cleanupTime)
 		}
 		sccp_session_unlock(s);
 
+		if (!s->replay) {
+			sccp_capture_close(&s->capture);
+		}
+
 		/* destroying mutex and cleaning the session */
 		sccp_mutex_destroy(&s->lock);
 		sccp_free(s);
@@ -609,18 +619,11 @@ void *sccp_session_device_thread(void *session)
 	pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
 	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
 
+	s->capture = sccp_capture_open(&s->sin, s->protocolType);						/* file io stays off the accept thread */
+
 	while (s->fds[0].fd > 0 && !s->session_stop) {
 		if (s->device) {
 			sccp_device_t *d = s->device;
-			if (d->pendingUpdate || d->pendingDelete) {
-				pbx_rwlock_rdlock(&GLOB(lock));
-				boolean_t reload_in_progress = GLOB(reload_in_progress);
-				pbx_rwlock_unlock(&GLOB(lock));
-				if (reload_in_progress == FALSE) {
-					sccp_device_check_update(d);
-				}
-				continue;									// make sure  s->device is still valid
-			}
 			if ((d->active_channel ? TRUE : FALSE) != oncall) {
 				recalc_wait_time(s);
 				oncall = (d->active_channel) ? TRUE : FALSE;
@@ -1010,6 +1013,13 @@ int sccp_session_send2(constSessionPtr session, sccp_msg_t * msg)
 		return -1;
 	}
 
+	if (s && s->replay) {
+		sccp_capture_frame(s->capture, SCCP_CAPTURE_OUTBOUND, msg, letohl(msg->header.length) + 8);
+		res = letohl(msg->header.length) + 8;
+		sccp_free(msg);
+		return res;
+	}
+
 	if (!s || s->fds[0].fd <= 0) {
 		sccp_log((DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "SCCP: Tried to send packet over DOWN device.\n");
 		if (s) {
@@ -1040,6 +1050,9 @@ int sccp_session_send2(constSessionPtr session, sccp_msg_t * msg)
 	bytesSent = 0;
 	bufAddr = ((uint8_t *) msg);
 	bufLen = (ssize_t) (letohl(msg->header.length) + 8);
+	if (s->capture) {
+		sccp_capture_frame(s->capture, SCCP_CAPTURE_OUTBOUND, bufAddr, bufLen);
+	}
 	do {
 		pbx_mutex_lock(&s->write_lock);									/* prevent two threads writing at the same time. That should happen in a synchronized way */
 		res = send(mysocket, bufAddr + bytesSent, bufLen - bytesSent, 0);
@@ -1236,12 +1249,71 @@ gcc_inline sccp_device_t * const sccp_session_getDevice(constSessionPtr session,
 
 boolean_t sccp_session_isValid(constSessionPtr session)
 {
-	if (session && session->fds[0].fd > 0 && !session->session_stop && !sccp_netsock_is_any_addr(&session->ourip)) {
+	if (session && (session->fds[0].fd > 0 || session->replay) && !session->session_stop && !sccp_netsock_is_any_addr(&session->ourip)) {
 		return TRUE;
 	}
 	return FALSE;
 }
 
+/*!
+ * \brief Create a Session without a socket, used to replay captured frames
+ * \param peer Captured Device Address
+ * \param protocolType Captured Session Protocol Type
+ * \param counter Capture counting the messages sent to this session (owned by the caller)
+ * \return SCCP Session or NULL
+ */
+sccp_session_t *sccp_session_createReplay(const struct sockaddr_storage *peer, uint32_t protocolType, sccp_capture_t *counter)
+{
+	sccp_session_t *s;
+
+	if (!(s = sccp_create_session(-1))) {
+		return NULL;
+	}
+	s->replay = TRUE;
+	s->capture = counter;
+	s->protocolType = protocolType;
+	s->session_thread = AST_PTHREADT_NULL;
+	memcpy(&s->sin, peer, sizeof(s->sin));
+	sccp_session_set_ourip(s);
+	if (sccp_netsock_is_any_addr(&s->ourip)) {								/* captured network is not reachable from here */
+		struct sockaddr_in *in = (struct sockaddr_in *) &s->ourip;
+		in->sin_family = AF_INET;
+		in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		sccp_copy_string(s->designator, sccp_netsock_stringify(&s->ourip), sizeof(s->designator));
+	}
+	sccp_session_addToGlobals(s);
+	recalc_wait_time(s);
+	return s;
+}
+
+/*!
+ * \brief Feed one captured inbound frame through the session layer
+ * \param session Replay Session
+ * \param frame Raw frame (sccp_header_t + payload), may be modified
+ * \param len Number of bytes in frame
+ * \return 0 if the frame was handled, non zero if a live session would have been closed
+ */
+int sccp_session_replayFrame(sessionPtr session, unsigned char *frame, size_t len)
+{
+	sccp_msg_t msg = { {0,} };
+
+	if (!session || !session->replay || session->session_stop) {
+		return -1;
+	}
+	session->lastKeepAlive = time(0);
+	return process_buffer(session, &msg, frame, &len);
+}
+
+/*!
+ * \brief Destroy a Replay Session, cleaning up the device it registered
+ */
+void sccp_session_destroyReplay(sessionPtr session)
+{
+	if (session && session->replay) {
+		destroy_session(session, 0);
+	}
+}
+
 /* -------------------------------------------------------------------------------------------------------SHOW SESSIONS- */
 /*!
  * \brief Show Sessions
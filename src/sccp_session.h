@@ -9,6 +9,7 @@
  *              See the LICENSE file at the top of the source tree.
  */
 #pragma once
+#include "sccp_capture.h"
 #include "sccp_cli.h"
 struct sccp_session;
 
@@ -40,5 +41,9 @@ SCCP_API int SCCP_CALL sccp_cli_show_sessions(int fd, sccp_cli_totals_t *totals,
 
 SCCP_API boolean_t SCCP_CALL sccp_session_bind_and_listen(struct sockaddr_storage *bindaddr);
 SCCP_API void SCCP_CALL sccp_session_stop_accept_thread(void);
+
+SCCP_API sccp_session_t * SCCP_CALL sccp_session_createReplay(const struct sockaddr_storage *peer, uint32_t protocolType, sccp_capture_t *counter);
+SCCP_API int SCCP_CALL sccp_session_replayFrame(sessionPtr session, unsigned char *frame, size_t len);
+SCCP_API void SCCP_CALL sccp_session_destroyReplay(sessionPtr session);
 __END_C_EXTERN__
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -772,6 +772,45 @@ gcc_inline boolean_t sccp_strcaseequals(const char *data1, const char *data2)
 	return FALSE;
 }
 
+/*!
+ * \brief Simple (djb2) String Hash, shared by sccp_strhash and sccp_strcasehash
+ */
+static inline unsigned int __sccp_strhash(const char *str, unsigned int size, boolean_t nocase)
+{
+	unsigned int hash = 5381;
+	unsigned char c;
+
+	if (!str || !size) {
+		return 0;
+	}
+	while ((c = (unsigned char) *str++)) {
+		hash = ((hash << 5) + hash) + (nocase ? (unsigned char) tolower(c) : c);
+	}
+	return hash % size;
+}
+
+/*!
+ * \brief Simple (djb2) String Hash
+ * \param str String to be hashed
+ * \param size Number of hash buckets
+ * \return bucket index between 0 and size - 1
+ */
+gcc_inline unsigned int sccp_strhash(const char *str, unsigned int size)
+{
+	return __sccp_strhash(str, size, FALSE);
+}
+
+/*!
+ * \brief Simple (djb2) Case Insensitive String Hash
+ * \param str String to be hashed
+ * \param size Number of hash buckets
+ * \return bucket index between 0 and size - 1 (equal for strings that only differ in case)
+ */
+gcc_inline unsigned int sccp_strcasehash(const char *str, unsigned int size)
+{
+	return __sccp_strhash(str, size, TRUE);
+}
+
 int __PURE__ sccp_strIsNumeric(const char *s)
 {
 	if (*s) {
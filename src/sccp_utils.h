@@ -108,6 +108,8 @@ SCCP_INLINE SCCP_CALL size_t sccp_strlen(const char *data);
 SCCP_INLINE SCCP_CALL boolean_t sccp_strlen_zero(const char *data);
 SCCP_INLINE SCCP_CALL boolean_t sccp_strequals(const char *data1, const char *data2);
 SCCP_INLINE SCCP_CALL boolean_t sccp_strcaseequals(const char *data1, const char *data2);
+SCCP_INLINE SCCP_CALL unsigned int sccp_strhash(const char *str, unsigned int size);
+SCCP_INLINE SCCP_CALL unsigned int sccp_strcasehash(const char *str, unsigned int size);
 SCCP_API int __PURE__ SCCP_CALL sccp_strIsNumeric(const char *s);
 
 SCCP_API void SCCP_CALL sccp_free_ha(struct sccp_ha *ha);
@@ -0,0 +1,667 @@
+/*!
+ * \file        sccp_benchmark.c
+ * \brief       SCCP Core Microbenchmarks
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * Runs the hot primitives of the channel driver core (refcount, threadpool, event, vector/list, codec negotiation, acl and message
+ * handling) in a tight loop from 1, 2, 4 ... N threads, linked against the null pbx backend. Each benchmark / thread count pair is
+ * reported as one csv line on stdout:
+ *
+ *   benchmark,threads,ops,wall_ns,ns_per_op,ops_per_sec
+ *
+ * ops is the total over all threads, ns_per_op is the wall time per operation as seen by one thread (wall_ns * threads / ops), so
+ * a flat ns_per_op over the thread counts means perfect scaling. Progress and log output go to stderr.
+ *
+ * Usage: sccp_benchmark [-c configfile] [-t maxthreads] [-n iterations] [-b benchmark] [-l]
+ */
+
+#include "config.h"
+#include "common.h"
+#include "chan_sccp.h"
+#include "sccp_codec.h"
+#include "sccp_device.h"
+#include "sccp_event.h"
+#include "sccp_refcount.h"
+#include "sccp_session.h"
+#include "sccp_threadpool.h"
+#include "sccp_utils.h"
+#include "sccp_vector.h"
+#include "pbx_impl/null/null.h"
+#include <unistd.h>
+
+#define BENCH_MAX_THREADS 64
+#define BENCH_SHARED_OBJECTS 64											/*!< Number of elements in the shared vector / list / object pool */
+
+/*!
+ * \brief Benchmark Definition
+ */
+typedef struct sccp_bench {
+	const char *name;
+	const char *description;
+	boolean_t (*setup)(int threads);									/*!< Prepare the shared state for threads workers (optional) */
+	void (*run)(int thread, uint32_t iterations);								/*!< Worker body, called from each of the threads */
+	void (*settle)(uint64_t ops);										/*!< Wait for asynchronous work to complete, included in the timing (optional) */
+	void (*cleanup)(void);											/*!< Release the shared state (optional) */
+} sccp_bench_t;
+
+/*!
+ * \brief Benchmark Start Line, the workers are held by the gate until all of them exist and the barrier is sized
+ */
+typedef struct sccp_bench_start {
+	sccp_mutex_t gate;
+	pthread_barrier_t barrier;
+	boolean_t abort;											/*!< Not all workers could be started, skip the run */
+} sccp_bench_start_t;
+
+typedef struct sccp_bench_thread {
+	const sccp_bench_t *bench;
+	sccp_bench_start_t *start;
+	pthread_t thread;
+	uint32_t iterations;
+	int id;
+} sccp_bench_thread_t;
+
+static volatile int bench_sink;											/*!< Keeps the compiler from dropping the measured work */
+static volatile CAS32_TYPE bench_completed;								/*!< Asynchronous jobs / events completed */
+static sccp_mutex_t bench_lock;										/*!< Protects bench_completed when the atomics fall back to a mutex */
+
+static uint64_t sccp_bench_clockNs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static void sccp_bench_waitCompleted(uint64_t ops)
+{
+	while ((uint64_t) ATOMIC_FETCH(&bench_completed, &bench_lock) < ops) {
+		usleep(50);
+	}
+}
+
+/* =================================================================================================================== refcount */
+struct bench_object {
+	int id;
+};
+
+static struct bench_object *bench_objects[BENCH_MAX_THREADS];
+
+static boolean_t bench_refcount_setup(int threads)
+{
+	char id[REFCOUNT_INDENTIFIER_SIZE];
+	int i;
+
+	for (i = 0; i < threads; i++) {
+		snprintf(id, sizeof(id), "bench/%d", i);
+		if (!(bench_objects[i] = (struct bench_object *) sccp_refcount_object_alloc(sizeof(struct bench_object), SCCP_REF_BENCHMARK, id, NULL))) {
+			return FALSE;
+		}
+		bench_objects[i]->id = i;
+	}
+	return TRUE;
+}
+
+static void bench_refcount_cleanup(void)
+{
+	int i;
+
+	for (i = 0; i < BENCH_MAX_THREADS; i++) {
+		if (bench_objects[i]) {
+			sccp_refcount_release((const void **) &bench_objects[i], __FILE__, __LINE__, __PRETTY_FUNCTION__);
+		}
+	}
+}
+
+static void bench_refcount_retainRelease(struct bench_object *object, uint32_t iterations)
+{
+	struct bench_object *ref = NULL;
+	uint32_t loop;
+
+	for (loop = 0; loop < iterations; loop++) {
+		if ((ref = sccp_refcount_retain(object, __FILE__, __LINE__, __PRETTY_FUNCTION__))) {
+			sccp_refcount_release((const void **) &ref, __FILE__, __LINE__, __PRETTY_FUNCTION__);
+		}
+	}
+}
+
+/* all threads hammer the same object */
+static void bench_refcount_shared_run(int thread, uint32_t iterations)
+{
+	bench_refcount_retainRelease(bench_objects[0], iterations);
+}
+
+/* every thread has its own object, only the object lookup is shared */
+static void bench_refcount_private_run(int thread, uint32_t iterations)
+{
+	bench_refcount_retainRelease(bench_objects[thread], iterations);
+}
+
+/* =================================================================================================================== threadpool */
+static sccp_threadpool_t *bench_threadpool;
+
+static void *bench_threadpool_job(void *data)
+{
+	ATOMIC_INCR(&bench_completed, 1, &bench_lock);
+	return NULL;
+}
+
+static boolean_t bench_threadpool_setup(int threads)
+{
+	bench_completed = 0;
+	return (bench_threadpool = sccp_threadpool_init(THREADPOOL_MIN_SIZE)) != NULL;
+}
+
+static void bench_threadpool_run(int thread, uint32_t iterations)
+{
+	uint32_t loop;
+
+	for (loop = 0; loop < iterations; loop++) {
+		sccp_threadpool_add_work(bench_threadpool, bench_threadpool_job, NULL);
+	}
+}
+
+static void bench_threadpool_cleanup(void)
+{
+	sccp_threadpool_destroy(bench_threadpool);
+	bench_threadpool = NULL;
+}
+
+/* =================================================================================================================== event */
+/* LINE_CHANGED and LINE_DELETED have no subscribers in the core and carry no references, so the listeners below are the only ones */
+static void bench_event_listener(const sccp_event_t * event)
+{
+	ATOMIC_INCR(&bench_completed, 1, &bench_lock);
+}
+
+static boolean_t bench_event_sync_setup(int threads)
+{
+	bench_completed = 0;
+	return sccp_event_subscribe(SCCP_EVENT_LINE_CHANGED, bench_event_listener, FALSE);
+}
+
+static void bench_event_sync_cleanup(void)
+{
+	sccp_event_unsubscribe(SCCP_EVENT_LINE_CHANGED, bench_event_listener);
+}
+
+static boolean_t bench_event_async_setup(int threads)
+{
+	bench_completed = 0;
+	return sccp_event_subscribe(SCCP_EVENT_LINE_DELETED, bench_event_listener, TRUE);
+}
+
+static void bench_event_async_cleanup(void)
+{
+	sccp_event_unsubscribe(SCCP_EVENT_LINE_DELETED, bench_event_listener);
+}
+
+static void bench_event_fire(sccp_event_type_t type, uint32_t iterations)
+{
+	sccp_event_t event = {{{0}}};
+	uint32_t loop;
+
+	for (loop = 0; loop < iterations; loop++) {
+		event.type = type;
+		sccp_event_fire(&event);
+	}
+}
+
+static void bench_event_sync_run(int thread, uint32_t iterations)
+{
+	bench_event_fire(SCCP_EVENT_LINE_CHANGED, iterations);
+}
+
+static void bench_event_async_run(int thread, uint32_t iterations)
+{
+	bench_event_fire(SCCP_EVENT_LINE_DELETED, iterations);
+}
+
+/* =================================================================================================================== vector / list */
+static SCCP_VECTOR_RW(, int) bench_vector;
+
+struct bench_entry {
+	int id;
+	SCCP_LIST_ENTRY (struct bench_entry) list;
+};
+static SCCP_LIST_HEAD (, struct bench_entry) bench_list;
+static SCCP_RWLIST_HEAD (, struct bench_entry) bench_rwlist;
+static struct bench_entry bench_entries[BENCH_MAX_THREADS + BENCH_SHARED_OBJECTS];
+
+static boolean_t bench_vector_setup(int threads)
+{
+	int i;
+
+	if (SCCP_VECTOR_RW_INIT(&bench_vector, BENCH_SHARED_OBJECTS) != 0) {
+		return FALSE;
+	}
+	for (i = 0; i < BENCH_SHARED_OBJECTS; i++) {
+		SCCP_VECTOR_APPEND(&bench_vector, i);
+	}
+	return TRUE;
+}
+
+static void bench_vector_cleanup(void)
+{
+	SCCP_VECTOR_RW_FREE(&bench_vector);
+}
+
+/* lookup by value in the shared vector under the read lock, the way the event subscribers are searched */
+static void bench_vector_lookup_run(int thread, uint32_t iterations)
+{
+	uint32_t loop;
+	int *found = NULL;
+
+	for (loop = 0; loop < iterations; loop++) {
+		SCCP_VECTOR_RW_RDLOCK(&bench_vector);
+		found = SCCP_VECTOR_GET_CMP(&bench_vector, (int) (loop % BENCH_SHARED_OBJECTS), SCCP_VECTOR_ELEM_DEFAULT_CMP);
+		if (found) {
+			bench_sink = *found;
+		}
+		SCCP_VECTOR_RW_UNLOCK(&bench_vector);
+	}
+}
+
+/* append / unordered remove on a thread local vector */
+static void bench_vector_append_run(int thread, uint32_t iterations)
+{
+	SCCP_VECTOR(, int) vector;
+	uint32_t loop;
+
+	if (SCCP_VECTOR_INIT(&vector, BENCH_SHARED_OBJECTS) != 0) {
+		return;
+	}
+	for (loop = 0; loop < iterations; loop++) {
+		SCCP_VECTOR_APPEND(&vector, (int) loop);
+		if (SCCP_VECTOR_SIZE(&vector) == BENCH_SHARED_OBJECTS) {
+			bench_sink = SCCP_VECTOR_REMOVE_UNORDERED(&vector, loop % BENCH_SHARED_OBJECTS);
+			SCCP_VECTOR_RESET(&vector, SCCP_VECTOR_ELEM_CLEANUP_NOOP);
+		}
+	}
+	SCCP_VECTOR_FREE(&vector);
+}
+
+static boolean_t bench_list_setup(int threads)
+{
+	int i;
+
+	SCCP_LIST_HEAD_INIT(&bench_list);
+	SCCP_RWLIST_HEAD_INIT(&bench_rwlist);
+	memset(bench_entries, 0, sizeof(bench_entries));
+	for (i = 0; i < BENCH_SHARED_OBJECTS; i++) {
+		bench_entries[i].id = i;
+		SCCP_RWLIST_INSERT_TAIL(&bench_rwlist, &bench_entries[i], list);
+	}
+	return TRUE;
+}
+
+static void bench_list_cleanup(void)
+{
+	SCCP_LIST_HEAD_DESTROY(&bench_list);
+	SCCP_RWLIST_HEAD_DESTROY(&bench_rwlist);
+}
+
+/* insert / remove head on the shared mutex protected list, the threadpool job queue pattern */
+static void bench_list_queue_run(int thread, uint32_t iterations)
+{
+	struct bench_entry *entry = &bench_entries[BENCH_SHARED_OBJECTS + thread];
+	struct bench_entry *head = NULL;
+	uint32_t loop;
+
+	for (loop = 0; loop < iterations; loop++) {
+		SCCP_LIST_LOCK(&bench_list);
+		SCCP_LIST_INSERT_TAIL(&bench_list, entry, list);
+		head = SCCP_LIST_REMOVE_HEAD(&bench_list, list);
+		SCCP_LIST_UNLOCK(&bench_list);
+		entry = head;
+	}
+}
+
+/* traverse the shared rwlist under the read lock, the device / line lookup pattern */
+static void bench_list_traverse_run(int thread, uint32_t iterations)
+{
+	struct bench_entry *entry = NULL;
+	uint32_t loop;
+	int id;
+
+	for (loop = 0; loop < iterations; loop++) {
+		id = loop % BENCH_SHARED_OBJECTS;
+		SCCP_RWLIST_RDLOCK(&bench_rwlist);
+		SCCP_RWLIST_TRAVERSE(&bench_rwlist, entry, list) {
+			if (entry->id == id) {
+				bench_sink = entry->id;
+				break;
+			}
+		}
+		SCCP_RWLIST_UNLOCK(&bench_rwlist);
+	}
+}
+
+/* =================================================================================================================== codec */
+static const skinny_codec_t bench_preferences[SKINNY_MAX_CAPABILITIES] = {SKINNY_CODEC_G722_64K, SKINNY_CODEC_G711_ALAW_64K, SKINNY_CODEC_G711_ULAW_64K, SKINNY_CODEC_G729_A, SKINNY_CODEC_NONE};
+static const skinny_codec_t bench_capabilities[SKINNY_MAX_CAPABILITIES] = {SKINNY_CODEC_G711_ULAW_64K, SKINNY_CODEC_G711_ALAW_64K, SKINNY_CODEC_G729_A, SKINNY_CODEC_G729_AB, SKINNY_CODEC_G722_64K, SKINNY_CODEC_H264, SKINNY_CODEC_NONE};
+static const skinny_codec_t bench_remote[SKINNY_MAX_CAPABILITIES] = {SKINNY_CODEC_G729_AB, SKINNY_CODEC_G729_A, SKINNY_CODEC_G711_ULAW_64K, SKINNY_CODEC_NONE};
+
+/* reduce our capabilities by the remote set and pick the best joint codec, as done when a call is connected */
+static void bench_codec_run(int thread, uint32_t iterations)
+{
+	skinny_codec_t joint[SKINNY_MAX_CAPABILITIES];
+	uint32_t loop;
+
+	for (loop = 0; loop < iterations; loop++) {
+		memcpy(joint, bench_capabilities, sizeof(joint));
+		sccp_codec_reduceSet(joint, bench_remote);
+		bench_sink = sccp_codec_findBestJoint(bench_preferences, SKINNY_MAX_CAPABILITIES, joint, SKINNY_MAX_CAPABILITIES, bench_remote, SKINNY_MAX_CAPABILITIES);
+	}
+}
+
+/* =================================================================================================================== acl */
+static struct sccp_ha *bench_ha;
+static struct sockaddr_storage bench_addresses[BENCH_SHARED_OBJECTS];
+
+/* a deny all followed by a permit per /24, the last one matching, like a large device permit= list */
+static boolean_t bench_acl_setup(int threads)
+{
+	struct sockaddr_in *in = NULL;
+	char network[32];
+	int error = 0;
+	int i;
+
+	bench_ha = sccp_append_ha("deny", "0.0.0.0/0.0.0.0", NULL, &error);
+	for (i = 0; i < BENCH_SHARED_OBJECTS && !error; i++) {
+		snprintf(network, sizeof(network), "10.%d.%d.0/255.255.255.0", i / 16, i % 16);
+		bench_ha = sccp_append_ha("permit", network, bench_ha, &error);
+	}
+	for (i = 0; i < BENCH_SHARED_OBJECTS; i++) {
+		in = (struct sockaddr_in *) &bench_addresses[i];
+		in->sin_family = AF_INET;
+		in->sin_addr.s_addr = htonl(0x0a000000 | ((uint32_t) (i / 16) << 16) | ((uint32_t) (i % 16) << 8) | 42);
+	}
+	return bench_ha && !error;
+}
+
+static void bench_acl_run(int thread, uint32_t iterations)
+{
+	uint32_t loop;
+
+	for (loop = 0; loop < iterations; loop++) {
+		bench_sink = sccp_apply_ha(bench_ha, &bench_addresses[loop % BENCH_SHARED_OBJECTS]);
+	}
+}
+
+static void bench_acl_cleanup(void)
+{
+	sccp_free_ha(bench_ha);
+	bench_ha = NULL;
+}
+
+/* =================================================================================================================== messages */
+static sccp_session_t *bench_sessions[BENCH_MAX_THREADS];
+
+/* one socketless replay session per thread, what they send is dropped */
+static boolean_t bench_message_setup(int threads)
+{
+	struct sockaddr_storage peer = { 0 };
+	struct sockaddr_in *in = (struct sockaddr_in *) &peer;
+	int i;
+
+	in->sin_family = AF_INET;
+	in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	for (i = 0; i < threads; i++) {
+		in->sin_port = htons(20000 + i);
+		if (!(bench_sessions[i] = sccp_session_createReplay(&peer, SCCP_PROTOCOL, NULL))) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+static void bench_message_cleanup(void)
+{
+	int i;
+
+	for (i = 0; i < BENCH_MAX_THREADS; i++) {
+		if (bench_sessions[i]) {
+			sccp_session_destroyReplay(bench_sessions[i]);
+			bench_sessions[i] = NULL;
+		}
+	}
+}
+
+/* build a fixed size message and hand it to the session send path */
+static void bench_message_encode_run(int thread, uint32_t iterations)
+{
+	sccp_msg_t *msg = NULL;
+	uint32_t loop;
+
+	for (loop = 0; loop < iterations; loop++) {
+		REQ(msg, CallStateMessage);
+		if (!msg) {
+			continue;
+		}
+		msg->data.CallStateMessage.lel_callState = htolel(SKINNY_CALLSTATE_CONNECTED);
+		msg->data.CallStateMessage.lel_lineInstance = htolel(1);
+		msg->data.CallStateMessage.lel_callReference = htolel(loop);
+		msg->data.CallStateMessage.lel_visibility = htolel(SKINNY_CALLINFO_VISIBILITY_DEFAULT);
+		msg->data.CallStateMessage.precedence.lel_level = htolel(SKINNY_CALLPRIORITY_LOW);
+		sccp_session_send2(bench_sessions[thread], msg);
+	}
+}
+
+/* feed a keepalive frame through framing, header dissection and dispatch, the handler answers with a keepalive ack */
+static void bench_message_decode_run(int thread, uint32_t iterations)
+{
+	unsigned char frame[SCCP_PACKET_HEADER];
+	sccp_header_t header = {
+		.length = htolel(4),
+		.lel_protocolVer = 0,
+		.lel_messageId = htolel(KeepAliveMessage),
+	};
+	uint32_t loop;
+
+	for (loop = 0; loop < iterations; loop++) {
+		memcpy(frame, &header, sizeof(frame));
+		bench_sink = sccp_session_replayFrame(bench_sessions[thread], frame, sizeof(frame));
+	}
+}
+
+/* =================================================================================================================== harness */
+/* *INDENT-OFF* */
+static const sccp_bench_t benchmarks[] = {
+	{"refcount_shared",	"retain/release of one object shared by all threads",		bench_refcount_setup,		bench_refcount_shared_run,	NULL,				bench_refcount_cleanup},
+	{"refcount_private",	"retain/release of one object per thread",			bench_refcount_setup,		bench_refcount_private_run,	NULL,				bench_refcount_cleanup},
+	{"threadpool",		"enqueue of an empty job until the pool has run them all",	bench_threadpool_setup,		bench_threadpool_run,		sccp_bench_waitCompleted,	bench_threadpool_cleanup},
+	{"event_sync",		"sccp_event_fire to one synchronous subscriber",		bench_event_sync_setup,		bench_event_sync_run,		sccp_bench_waitCompleted,	bench_event_sync_cleanup},
+	{"event_async",		"sccp_event_fire to one threadpool subscriber until delivered",	bench_event_async_setup,	bench_event_async_run,		sccp_bench_waitCompleted,	bench_event_async_cleanup},
+	{"vector_lookup",	"SCCP_VECTOR_GET_CMP on a shared rw vector",			bench_vector_setup,		bench_vector_lookup_run,	NULL,				bench_vector_cleanup},
+	{"vector_append",	"SCCP_VECTOR_APPEND/REMOVE on a thread local vector",		NULL,				bench_vector_append_run,	NULL,				NULL},
+	{"list_queue",		"SCCP_LIST insert tail/remove head on a shared list",		bench_list_setup,		bench_list_queue_run,		NULL,				bench_list_cleanup},
+	{"list_traverse",	"SCCP_RWLIST traverse of a shared list under the read lock",	bench_list_setup,		bench_list_traverse_run,	NULL,				bench_list_cleanup},
+	{"codec_negotiate",	"sccp_codec_reduceSet + sccp_codec_findBestJoint",		NULL,				bench_codec_run,		NULL,				NULL},
+	{"acl_match",		"sccp_apply_ha against a 65 entry permit/deny list",		bench_acl_setup,		bench_acl_run,			NULL,				bench_acl_cleanup},
+	{"message_encode",	"build a CallStateMessage and send it on a session",		bench_message_setup,		bench_message_encode_run,	NULL,				bench_message_cleanup},
+	{"message_decode",	"frame, dissect and dispatch a KeepAliveMessage",		bench_message_setup,		bench_message_decode_run,	NULL,				bench_message_cleanup},
+};
+/* *INDENT-ON* */
+
+static void *sccp_bench_thread_run(void *data)
+{
+	sccp_bench_thread_t *worker = data;
+
+	pbx_mutex_lock(&worker->start->gate);
+	pbx_mutex_unlock(&worker->start->gate);
+	pthread_barrier_wait(&worker->start->barrier);
+	if (!worker->start->abort) {
+		worker->bench->run(worker->id, worker->iterations);
+	}
+	return NULL;
+}
+
+/*!
+ * \brief Run one benchmark with the given number of threads
+ * \return wall clock time in ns from the release of the threads until the last one finished (and the asynchronous work settled), 0 on failure
+ */
+static uint64_t sccp_bench_run(const sccp_bench_t *bench, int threads, uint32_t iterations)
+{
+	sccp_bench_thread_t workers[BENCH_MAX_THREADS];
+	sccp_bench_start_t startLine = { .abort = FALSE };
+	uint64_t start = 0, wall = 0;
+	int started = 0, i;
+
+	if (bench->setup && !bench->setup(threads)) {
+		fprintf(stderr, "%s: setup failed\n", bench->name);
+		if (bench->cleanup) {
+			bench->cleanup();
+		}
+		return 0;
+	}
+	pbx_mutex_init_notracking(&startLine.gate);
+	pbx_mutex_lock(&startLine.gate);
+	for (i = 0; i < threads; i++) {
+		workers[i].bench = bench;
+		workers[i].start = &startLine;
+		workers[i].iterations = iterations;
+		workers[i].id = i;
+		if (pbx_pthread_create(&workers[i].thread, NULL, sccp_bench_thread_run, &workers[i])) {
+			break;
+		}
+		started++;
+	}
+	pthread_barrier_init(&startLine.barrier, NULL, started + 1);
+	if (started < threads) {
+		fprintf(stderr, "%s: could only start %d of %d threads\n", bench->name, started, threads);
+		startLine.abort = TRUE;
+	}
+	pbx_mutex_unlock(&startLine.gate);
+
+	pthread_barrier_wait(&startLine.barrier);
+	start = sccp_bench_clockNs();
+	for (i = 0; i < started; i++) {
+		pthread_join(workers[i].thread, NULL);
+	}
+	if (!startLine.abort) {
+		if (bench->settle) {
+			bench->settle((uint64_t) threads * iterations);
+		}
+		wall = sccp_bench_clockNs() - start;
+	}
+	pthread_barrier_destroy(&startLine.barrier);
+	pbx_mutex_destroy(&startLine.gate);
+	if (bench->cleanup) {
+		bench->cleanup();
+	}
+	return wall;
+}
+
+static boolean_t sccp_bench_writeConfig(char *path, size_t pathLen)
+{
+	static const char config[] = "[general]\nbindaddr = 127.0.0.1\ndebug = none\n";
+	int fd;
+
+	snprintf(path, pathLen, "/tmp/sccp_benchmark.XXXXXX");
+	if ((fd = mkstemp(path)) < 0) {
+		return FALSE;
+	}
+	if (write(fd, config, sizeof(config) - 1) != (ssize_t) (sizeof(config) - 1)) {
+		close(fd);
+		unlink(path);
+		return FALSE;
+	}
+	close(fd);
+	return TRUE;
+}
+
+static void usage(const char *progname)
+{
+	fprintf(stderr, "Usage: %s [-c configfile] [-t maxthreads] [-n iterations] [-b benchmark] [-l]\n", progname);
+	fprintf(stderr, "  -c configfile  sccp configuration to load (default: a minimal generated [general] section)\n");
+	fprintf(stderr, "  -t maxthreads  run with 1, 2, 4 ... maxthreads threads (default: number of online cpus)\n");
+	fprintf(stderr, "  -n iterations  operations per thread and run (default 100000)\n");
+	fprintf(stderr, "  -b benchmark   only run the benchmarks whose name contains this string\n");
+	fprintf(stderr, "  -l             list the benchmarks and exit\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const char *configfile = NULL;
+	const char *filter = NULL;
+	char generated[64] = "";
+	uint32_t iterations = 100000;
+	uint64_t ops = 0, wall = 0;
+	long maxthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	int opt, threads, res = 0;
+	unsigned int b;
+
+	while ((opt = getopt(argc, argv, "c:t:n:b:lh")) != -1) {
+		switch (opt) {
+			case 'c':
+				configfile = optarg;
+				break;
+			case 't':
+				maxthreads = strtol(optarg, NULL, 10);
+				break;
+			case 'n':
+				iterations = (uint32_t) strtoul(optarg, NULL, 10);
+				break;
+			case 'b':
+				filter = optarg;
+				break;
+			case 'l':
+				for (b = 0; b < ARRAY_LEN(benchmarks); b++) {
+					printf("%-20s %s\n", benchmarks[b].name, benchmarks[b].description);
+				}
+				return 0;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (maxthreads < 1 || maxthreads > BENCH_MAX_THREADS || !iterations) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (!configfile) {
+		if (!sccp_bench_writeConfig(generated, sizeof(generated))) {
+			fprintf(stderr, "%s: could not write a temporary configuration\n", argv[0]);
+			return 1;
+		}
+		configfile = generated;
+	}
+	res = !sccp_null_load(configfile, FALSE);
+	if (!sccp_strlen_zero(generated)) {
+		unlink(generated);
+	}
+	if (res) {
+		fprintf(stderr, "%s: could not initialize the channel driver core with '%s'\n", argv[0], configfile);
+		return 1;
+	}
+	GLOB(debug) = 0;
+	pbx_mutex_init_notracking(&bench_lock);
+
+	printf("benchmark,threads,ops,wall_ns,ns_per_op,ops_per_sec\n");
+	for (b = 0; b < ARRAY_LEN(benchmarks); b++) {
+		const sccp_bench_t *bench = &benchmarks[b];
+
+		if (filter && !strstr(bench->name, filter)) {
+			continue;
+		}
+		fprintf(stderr, "%s: %s\n", bench->name, bench->description);
+		sccp_bench_run(bench, 1, iterations / 10 ? iterations / 10 : 1);			/* warm up caches, allocator and the threadpool */
+		for (threads = 1; threads <= maxthreads; threads = (threads * 2 > maxthreads && threads < maxthreads) ? (int) maxthreads : threads * 2) {
+			ops = (uint64_t) threads * iterations;
+			if (!(wall = sccp_bench_run(bench, threads, iterations))) {
+				res = 1;
+				break;
+			}
+			printf("%s,%d,%llu,%llu,%.1f,%.0f\n", bench->name, threads, (unsigned long long) ops, (unsigned long long) wall, (double) wall * threads / ops, ops * 1e9 / wall);
+			fflush(stdout);
+		}
+	}
+	sccp_null_unload();
+	pbx_mutex_destroy(&bench_lock);
+	return res;
+}
+
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,105 @@
+/*!
+ * \file        sccp_replay.c
+ * \brief       SCCP Session Capture Replay Harness
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * Replays capture files written by "sccp capture on" through the session layer and the message handlers of the channel driver core,
+ * linked against the null pbx backend, and reports the cpu time spent handling the inbound frames and the messages sent in return.
+ *
+ * Usage: sccp_replay [-c configfile] [-s speed] [-r repeat] capturefile...
+ *
+ * Example, recording a registration storm on a live system and replaying it against the same configuration:
+ *   asterisk -rx "sccp capture on /var/tmp/sccpcap"
+ *   (restart or power cycle the phones, wait for them to register)
+ *   asterisk -rx "sccp capture off"
+ *   cd /var/tmp/sccpcap && sccp_replay -c /etc/asterisk/sccp.conf -r 10 *.sccpcap
+ *
+ * Built with ./configure --enable-standalone (see src/standalone/Makefile.am).
+ */
+
+#include "config.h"
+#include "common.h"
+#include "chan_sccp.h"
+#include "sccp_actions.h"
+#include "sccp_capture.h"
+#include "sccp_session.h"
+#include "pbx_impl/null/null.h"
+#include <unistd.h>
+
+static void usage(const char *progname)
+{
+	fprintf(stderr, "Usage: %s [-c configfile] [-s speed] [-r repeat] capturefile...\n", progname);
+	fprintf(stderr, "  -c configfile  sccp configuration the captured devices register against (default ./sccp.conf)\n");
+	fprintf(stderr, "  -s speed       0 (default) replays as fast as possible, 1.0 reproduces the captured pacing\n");
+	fprintf(stderr, "  -r repeat      replay the capture files this many times (default 1)\n");
+}
+
+static void print_stats(int run, const sccp_capture_replay_stats_t *stats)
+{
+	int slot;
+
+	printf("--- replay run %d ---\n", run);
+	printf("sessions:            %u\n", stats->sessions);
+	printf("inbound frames:      %u (%u refused)\n", stats->inFrames, stats->failedFrames);
+	printf("outbound frames:     %u (%u in the captures), %llu bytes\n", stats->outFrames, stats->capturedOutFrames, (unsigned long long) stats->outBytes);
+	printf("captured span:       %.3f s\n", stats->capturedUs / 1e6);
+	printf("replay wall time:    %.3f s\n", stats->wallNs / 1e9);
+	printf("handler cpu time:    %.3f ms (%.1f us/frame, max %.1f us)\n", stats->handlerCpuNs / 1e6, stats->inFrames ? stats->handlerCpuNs / 1e3 / stats->inFrames : 0.0, stats->handlerMaxNs / 1e3);
+	printf("process cpu time:    %.3f ms\n", stats->processCpuNs / 1e6);
+	printf("outbound messages:\n");
+	for (slot = 0; slot < SCCP_CAPTURE_MESSAGE_SLOTS; slot++) {
+		if (stats->outMessages[slot]) {
+			sccp_mid_t mid = sccp_capture_messageId(slot);
+			printf("  0x%04X %-45s %u\n", mid, msgtype2str(mid), stats->outMessages[slot]);
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	sccp_capture_replay_stats_t stats;
+	sccp_cli_totals_t totals = { 0 };
+	const char *configfile = "sccp.conf";
+	double speed = 0;
+	int repeat = 1;
+	int opt, run, res = 0;
+
+	while ((opt = getopt(argc, argv, "c:s:r:h")) != -1) {
+		switch (opt) {
+			case 'c':
+				configfile = optarg;
+				break;
+			case 's':
+				speed = atof(optarg);
+				break;
+			case 'r':
+				repeat = (int) strtol(optarg, NULL, 10);
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (optind >= argc || repeat < 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	/* load without listening: the replay sessions are fed from the capture files */
+	if (!sccp_null_load(configfile, FALSE)) {
+		fprintf(stderr, "%s: could not initialize the channel driver core with '%s'\n", argv[0], configfile);
+		return 1;
+	}
+	for (run = 1; run <= repeat && !res; run++) {
+		sccp_message_stats_reset();
+		if ((res = sccp_capture_replay(&argv[optind], argc - optind, speed, &stats)) == 0) {
+			print_stats(run, &stats);
+			sccp_show_message_stats(STDOUT_FILENO, &totals, NULL, NULL, 0, NULL);
+		}
+	}
+	sccp_null_unload();
+	return res ? 1 : 0;
+}
+
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,62 @@
+/*!
+ * \file        sccp_standalone.c
+ * \brief       SCCP Standalone Host
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ *
+ * Runs the channel driver core on top of the null pbx backend: loads the configuration, starts listening for phones and keeps
+ * running until it receives SIGINT or SIGTERM. Phones (or contrib/sccp_loadgen) can register, place calls between the
+ * configured lines, hold and hang up, without an asterisk process around the driver.
+ *
+ * Usage: sccp_standalone [-c configfile]
+ */
+
+#include <signal.h>
+#include "config.h"
+#include "common.h"
+#include "chan_sccp.h"
+#include "pbx_impl/null/null.h"
+#include <unistd.h>
+
+static void usage(const char *progname)
+{
+	fprintf(stderr, "Usage: %s [-c configfile]\n", progname);
+	fprintf(stderr, "  -c configfile  sccp configuration to load (default ./sccp.conf)\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const char *configfile = "sccp.conf";
+	sigset_t sigs;
+	int opt, sig = 0;
+
+	while ((opt = getopt(argc, argv, "c:h")) != -1) {
+		switch (opt) {
+			case 'c':
+				configfile = optarg;
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+
+	/* block the termination signals before any thread is started, so that only sigwait() below receives them */
+	sigemptyset(&sigs);
+	sigaddset(&sigs, SIGINT);
+	sigaddset(&sigs, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	if (!sccp_null_load(configfile, TRUE)) {
+		fprintf(stderr, "%s: could not load '%s'\n", argv[0], configfile);
+		return 1;
+	}
+	fprintf(stderr, "%s: running, press ctrl-c to stop\n", argv[0]);
+	sigwait(&sigs, &sig);
+	fprintf(stderr, "%s: stopping (%d channels open, %d scheduled tasks)\n", argv[0], sccp_null_channel_count(), sccp_null_sched_pending());
+	sccp_null_unload();
+	return 0;
+}
+
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;